@@ -0,0 +1,372 @@
+#include "core/math/math.hpp"
+#include "core/ds/msqueue.hpp"
+#include "core/object.hpp"
+#include "core/log.hpp"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+using namespace scsr;
+
+/// Microbenchmarks for scsr.core, results are written as JSON.
+///
+///   core_bench [--out FILE] [--filter SUBSTRING] [--samples N]
+///
+/// Each case runs in batches for at least `MinSampleTime`, the report keeps the
+/// median and minimum nanoseconds per operation over all samples.
+
+using BenchClock = std::chrono::steady_clock;
+
+static constexpr f64 MinSampleTime = 0.05;
+
+/// Keep the compiler from discarding a computed value
+template <typename T>
+static inline void KeepAlive(const T& value)
+{
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+struct BenchResult
+{
+    std::string name;
+    std::string params;
+    f64 median;
+    f64 min;
+    usize samples;
+};
+
+struct BenchContext
+{
+    std::string filter;
+    usize samples = 7;
+    std::vector<BenchResult> results;
+
+    bool Enabled(const std::string& name) const
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    void Record(const std::string& name, const std::string& params, std::vector<f64> nsPerOp)
+    {
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        results.push_back({ name, params, nsPerOp[nsPerOp.size() / 2], nsPerOp.front(), nsPerOp.size() });
+        std::fprintf(stderr, "%-32s %-24s %12.2f ns/op\n", name.c_str(), params.c_str(), nsPerOp[nsPerOp.size() / 2]);
+    }
+
+    /// Time `fn(iterations)` which performs `iterations` operations
+    template <typename Fn>
+    void Run(const std::string& name, const std::string& params, Fn&& fn)
+    {
+        if (!Enabled(name)) { return; }
+
+        /// Grow the batch until it takes long enough to time reliably
+        usize iterations = 1;
+        while (true)
+        {
+            auto start = BenchClock::now();
+            fn(iterations);
+            f64 elapsed = std::chrono::duration<f64>(BenchClock::now() - start).count();
+            if (elapsed >= MinSampleTime || iterations >= (usize(1) << 40)) { break; }
+            iterations *= elapsed > 0.0 ? Clamp<usize>(static_cast<usize>(MinSampleTime / elapsed * 1.2) + 1, 2, 16) : 16;
+        }
+
+        std::vector<f64> nsPerOp;
+        for (usize i = 0; i < samples; ++i)
+        {
+            auto start = BenchClock::now();
+            fn(iterations);
+            f64 elapsed = std::chrono::duration<f64, std::nano>(BenchClock::now() - start).count();
+            nsPerOp.push_back(elapsed / iterations);
+        }
+        Record(name, params, std::move(nsPerOp));
+    }
+};
+
+static Mat4 RandomMat4(u32 seed)
+{
+    Mat4 mat;
+    for (i32 i = 0; i < 16; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        mat.data[i] = static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24) * 2.0f - 1.0f;
+    }
+    /// Diagonally dominant so it is always invertible
+    for (i32 i = 0; i < 4; ++i)
+    {
+        mat.data[i * 5] += 4.0f;
+    }
+    return mat;
+}
+
+static void BenchMath(BenchContext& ctx)
+{
+    Mat4 a = RandomMat4(1);
+    Mat4 b = RandomMat4(2);
+    ctx.Run("mat4_multiply", "", [&](usize n) {
+        Mat4 acc = a;
+        for (usize i = 0; i < n; ++i)
+        {
+            acc = acc * b;
+            KeepAlive(acc);
+            acc = a;
+        }
+    });
+    ctx.Run("mat4_inverse", "", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            KeepAlive(a);
+            Mat4 inv = a.Inversed();
+            KeepAlive(inv);
+        }
+    });
+
+    Quat q0 = Quat::FromRotationEuler(Vec3(0.3f, 1.1f, -0.4f));
+    Quat q1 = Quat::FromRotationEuler(Vec3(-1.2f, 0.2f, 2.0f));
+    ctx.Run("quat_slerp", "", [&](usize n) {
+        f32 t = 0.0f;
+        for (usize i = 0; i < n; ++i)
+        {
+            KeepAlive(q0);
+            Quat q = Slerp(q0, q1, t);
+            KeepAlive(q);
+            t = t < 1.0f ? t + 0.001f : 0.0f;
+        }
+    });
+    ctx.Run("quat_to_mat3", "", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            KeepAlive(q0);
+            Mat3 m = q0.ToMat3();
+            KeepAlive(m);
+        }
+    });
+
+    std::vector<Vec3> vectors(1024);
+    for (usize i = 0; i < vectors.size(); ++i)
+    {
+        vectors[i] = Vec3(1.0f + i, 2.0f - i * 0.5f, 0.25f * i + 1.0f);
+    }
+    ctx.Run("vec3_normalize", "", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            Vec3 v = Normalized(vectors[i & 1023]);
+            KeepAlive(v);
+        }
+    });
+    ctx.Run("vec4_normalize", "", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            Vec4 v(vectors[i & 1023], 1.0f);
+            v.Normalize();
+            KeepAlive(v);
+        }
+    });
+}
+
+/// Items per second through one queue shared by `producers` and `consumers` threads
+static void BenchQueue(BenchContext& ctx, usize producers, usize consumers)
+{
+    std::string params = fmt::format("p{}_c{}", producers, consumers);
+    ctx.Run("msqueue_throughput", params, [&](usize n) {
+        MSQueue<u64> queue;
+        std::atomic<usize> consumed = 0;
+        std::vector<std::thread> threads;
+
+        for (usize p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p] {
+                usize begin = n * p / producers;
+                usize end = n * (p + 1) / producers;
+                for (usize i = begin; i < end; ++i)
+                {
+                    queue.Enqueue(i);
+                }
+            });
+        }
+        for (usize c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&] {
+                u64 value;
+                while (consumed.load(std::memory_order_relaxed) < n)
+                {
+                    if (queue.Dequeue(value))
+                    {
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    });
+}
+
+/// Cost per callback invocation, `callbacks` listeners on one event type
+static void BenchDispatch(BenchContext& ctx, usize callbacks)
+{
+    World world;
+    usize counter = 0;
+    for (usize i = 0; i < callbacks; ++i)
+    {
+        world.RegisterEvent<KeyboardPressedEvent>([&counter](Event, Storage&) { ++counter; });
+    }
+
+    Event event;
+    event.keyboardPressed = KeyboardPressedEvent { .keyCode = KeyboardKeyCode::KeyA, .repeat = 0 };
+    ctx.Run("event_dispatch", fmt::format("callbacks{}", callbacks), [&](usize n) {
+        /// One event reaches every callback, round up to whole events
+        usize events = (n + callbacks - 1) / callbacks;
+        for (usize i = 0; i < events; ++i)
+        {
+            world.eventHandler.Send(event);
+        }
+        world.eventHandler.Dispatch();
+        KeepAlive(counter);
+    });
+}
+
+template <usize N>
+struct BenchObject
+{
+    usize value = N;
+};
+
+template <usize... Is>
+static void RegisterBenchObjects(World& world, std::index_sequence<Is...>)
+{
+    (world.RegisterObject<BenchObject<Is>>(), ...);
+}
+
+static void BenchStorage(BenchContext& ctx)
+{
+    World world;
+    RegisterBenchObjects(world, std::make_index_sequence<64>());
+
+    ctx.Run("storage_get_object", "objects64", [&](usize n) {
+        usize sum = 0;
+        for (usize i = 0; i < n; ++i)
+        {
+            sum += world.storage.GetObject<BenchObject<37>>().value;
+            KeepAlive(sum);
+        }
+    });
+}
+
+static void BenchLogger(BenchContext& ctx)
+{
+    /// Messages below the filter level return before formatting
+    Logger filtered("bench_filtered", Level::Error);
+    ctx.Run("logger_log", "filtered", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            filtered.Log(Level::Info, __FILE__, __LINE__, "frame {} took {} ms", i, 16.6);
+        }
+    });
+
+    if (!ctx.Enabled("logger_log")) { return; }
+
+    /// Written messages go through stdout, silence it for the rest of the run
+#if defined(_WIN32)
+    std::FILE* null = std::freopen("NUL", "w", stdout);
+#else
+    std::FILE* null = std::freopen("/dev/null", "w", stdout);
+#endif
+    if (!null) { return; }
+
+    Logger written("bench_written", Level::None);
+    ctx.Run("logger_log", "written", [&](usize n) {
+        for (usize i = 0; i < n; ++i)
+        {
+            written.Log(Level::Info, __FILE__, __LINE__, "frame {} took {} ms", i, 16.6);
+        }
+    });
+}
+
+static std::string ToJson(const BenchContext& ctx)
+{
+    std::string json = "{\n";
+#ifdef SCSR_AVX2
+    json += "  \"avx2\": true,\n";
+#else
+    json += "  \"avx2\": false,\n";
+#endif
+    json += fmt::format("  \"threads\": {},\n", std::thread::hardware_concurrency());
+    json += fmt::format("  \"samples\": {},\n", ctx.samples);
+    json += "  \"results\": [\n";
+    for (usize i = 0; i < ctx.results.size(); ++i)
+    {
+        const auto& r = ctx.results[i];
+        json += fmt::format(
+            "    {{ \"name\": \"{}\", \"params\": \"{}\", \"ns_per_op\": {:.3f}, \"min_ns_per_op\": {:.3f}, \"ops_per_sec\": {:.1f} }}{}\n",
+            r.name, r.params, r.median, r.min, 1e9 / r.median, i + 1 < ctx.results.size() ? "," : "");
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchContext ctx;
+    std::string out = "core_bench.json";
+
+    for (i32 i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue) { out = argv[++i]; }
+        else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) { ctx.filter = argv[++i]; }
+        else if (std::strcmp(argv[i], "--samples") == 0 && hasValue) { ctx.samples = Max<usize>(1, std::strtoull(argv[++i], nullptr, 10)); }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--out FILE] [--filter SUBSTRING] [--samples N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    BenchMath(ctx);
+
+    usize hardware = Max<usize>(2, std::thread::hardware_concurrency());
+    for (usize threads = 1; threads * 2 <= hardware; threads *= 2)
+    {
+        BenchQueue(ctx, threads, threads);
+    }
+    if (hardware > 2)
+    {
+        BenchQueue(ctx, hardware - 1, 1);
+    }
+
+    for (usize callbacks : { 1, 16, 256 })
+    {
+        BenchDispatch(ctx, callbacks);
+    }
+    BenchStorage(ctx);
+    /// Last, it may redirect stdout
+    BenchLogger(ctx);
+
+    std::FILE* file = std::fopen(out.c_str(), "w");
+    if (!file)
+    {
+        std::fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    std::string json = ToJson(ctx);
+    std::fwrite(json.data(), 1, json.size(), file);
+    std::fclose(file);
+    std::fprintf(stderr, "results written to %s\n", out.c_str());
+    return 0;
+}
\ No newline at end of file
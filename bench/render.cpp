@@ -0,0 +1,345 @@
+#include "graphics/pipeline.hpp"
+#include "graphics/gltf.hpp"
+#include "graphics/image_io.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/log.hpp"
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+using namespace scsr;
+
+/// Renders fixed scenes offscreen along scripted camera paths and reports JSON.
+///
+///   render_bench [--frames N] [--warmup N] [--scene NAME] [--out FILE] [--dump DIR] [--rate 1|2|4]
+///
+/// Run from the repository root so the meshes under assets/ are found,
+/// scenes whose assets are missing are skipped.
+
+struct BenchScene
+{
+    std::string name;
+    Mesh mesh;
+};
+
+struct BenchPath
+{
+    std::string name;
+    /// Camera position for `t` in [0, 1], the camera always looks at the origin
+    Vec3 (*position)(f32 t);
+};
+
+struct BenchResolution
+{
+    i32 width;
+    i32 height;
+};
+
+struct LitVaryings
+{
+    Vec3 normal;
+};
+
+/// Center the mesh on the origin and scale it into the unit sphere
+static void Normalize(Mesh& mesh)
+{
+    if (mesh.vertices.empty()) { return; }
+
+    Vec3 lo = mesh.vertices.front().pos.xyz();
+    Vec3 hi = lo;
+    for (const auto& vtx : mesh.vertices)
+    {
+        for (i32 i = 0; i < 3; ++i)
+        {
+            lo.data[i] = Min(lo.data[i], vtx.pos.data[i]);
+            hi.data[i] = Max(hi.data[i], vtx.pos.data[i]);
+        }
+    }
+    Vec3 center = (lo + hi) * 0.5f;
+    f32 radius = Max(Length(hi - lo) * 0.5f, 1e-6f);
+    for (auto& vtx : mesh.vertices)
+    {
+        vtx.pos = Vec4((vtx.pos.xyz() - center) / radius, 1.0f);
+    }
+}
+
+static void PushTriangle(Mesh& mesh, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+    Vec3 normal = Normalized(Cross(b - a, c - a));
+    for (const Vec3& p : { a, b, c })
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(p, 1.0f);
+        vtx.normal = normal;
+        mesh.vertices.push_back(vtx);
+    }
+}
+
+/// Finely tessellated sphere, stresses the vertex stage and tiny triangles
+static Mesh MakeDenseSphere(i32 stacks, i32 slices)
+{
+    Mesh mesh;
+    auto point = [&](i32 i, i32 j) {
+        f32 theta = PI * i / stacks;
+        f32 phi = 2.0f * PI * j / slices;
+        return Vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+    mesh.vertices.reserve(static_cast<usize>(stacks) * slices * 6);
+    for (i32 i = 0; i < stacks; ++i)
+    {
+        for (i32 j = 0; j < slices; ++j)
+        {
+            Vec3 p00 = point(i, j), p01 = point(i, j + 1);
+            Vec3 p10 = point(i + 1, j), p11 = point(i + 1, j + 1);
+            PushTriangle(mesh, p00, p01, p11);
+            PushTriangle(mesh, p00, p11, p10);
+        }
+    }
+    return mesh;
+}
+
+/// Stacked quads drawn back to front, every layer passes the depth test.
+/// Kept small enough to stay inside the frustum at the end of the dolly,
+/// triangles crossing it are discarded rather than clipped.
+static Mesh MakeOverdrawStack(i32 layers)
+{
+    Mesh mesh;
+    const f32 e = 0.65f;
+    for (i32 i = 0; i < layers; ++i)
+    {
+        f32 z = -0.5f + static_cast<f32>(i) / layers;
+        Vec3 a(0.0f, -e, z), b(e, 0.0f, z), c(0.0f, e, z), d(-e, 0.0f, z);
+        /// Both windings so the layer survives face culling from either side
+        PushTriangle(mesh, a, b, c);
+        PushTriangle(mesh, a, c, d);
+        PushTriangle(mesh, a, c, b);
+        PushTriangle(mesh, a, d, c);
+    }
+    return mesh;
+}
+
+static std::vector<BenchScene> LoadScenes()
+{
+    std::vector<BenchScene> scenes;
+
+    Mesh head("assets/meshes/african_head.obj");
+    if (!head.vertices.empty())
+    {
+        Normalize(head);
+        scenes.push_back({ "african_head", std::move(head) });
+    }
+    else
+    {
+        LOG_WARN("assets/meshes/african_head.obj not found, scene skipped");
+    }
+
+    GLTF katana("assets/meshes/Katana.glb");
+    katana.Load();
+    Mesh katanaMesh = katana.ToMesh();
+    if (!katanaMesh.vertices.empty())
+    {
+        Normalize(katanaMesh);
+        scenes.push_back({ "katana", std::move(katanaMesh) });
+    }
+    else
+    {
+        LOG_WARN("assets/meshes/Katana.glb not found, scene skipped");
+    }
+
+    scenes.push_back({ "dense_sphere", MakeDenseSphere(256, 512) });
+    scenes.push_back({ "overdraw", MakeOverdrawStack(32) });
+    return scenes;
+}
+
+static const BenchPath s_Paths[] = {
+    { "orbit", [](f32 t) {
+        f32 angle = 2.0f * PI * t;
+        return Vec3(std::sin(angle) * 3.0f, 0.8f, std::cos(angle) * 3.0f);
+    } },
+    { "dolly", [](f32 t) {
+        return Vec3(0.0f, 0.0f, 6.0f - 3.8f * t);
+    } },
+};
+
+static const BenchResolution s_Resolutions[] = {
+    { 320, 240 },
+    { 800, 600 },
+    { 1920, 1080 },
+};
+
+using BenchClock = std::chrono::steady_clock;
+
+static f64 Percentile(const std::vector<f64>& sorted, f64 p)
+{
+    usize idx = static_cast<usize>(p * (sorted.size() - 1) + 0.5);
+    return sorted[Min(idx, sorted.size() - 1)];
+}
+
+static nlohmann::json Run(BenchScene& scene, const BenchPath& path, BenchResolution res,
+    usize frames, usize warmup, const std::string& dumpDir, ShadingRate rate)
+{
+    auto image = MakeRef<Image>(ImageProp { .width = res.width, .height = res.height });
+    auto camera = MakeRef<Camera>(Radians(45.0f), static_cast<f32>(res.width) / res.height, 0.1f, 100.0f);
+
+    Pipeline pipeline;
+    pipeline.SetCamera(camera);
+    PipelineState state;
+    state.shadingRate = rate;
+    pipeline.SetState(state);
+    pipeline.SetShader(Shader<LitVaryings> {
+        .vertex = [&](const Vertex& vtx, LitVaryings& out) -> Vec4 {
+            out.normal = vtx.normal;
+            return camera->GetProjection() * camera->GetView() * vtx.pos;
+        },
+        .pixel = [](const LitVaryings& in) -> Vec4 {
+            f32 theta = Abs(Dot(in.normal, Vec3::Z()));
+            return Vec4(Vec3::ONE() * theta, 1.0f);
+        },
+    });
+
+    std::vector<f64> frameTimes;
+    frameTimes.reserve(frames);
+    f64 clearTime = 0.0;
+
+    for (usize i = 0; i < warmup + frames; ++i)
+    {
+        if (i == warmup)
+        {
+            pipeline.ResetStats();
+        }
+
+        f32 t = frames > 1 ? static_cast<f32>(i < warmup ? 0 : i - warmup) / (frames - 1) : 0.0f;
+        Vec3 position = path.position(t);
+        camera->SetOrientation(Normalized(-position), Vec3::Y());
+        camera->SetPosition(position);
+
+        auto start = BenchClock::now();
+        image->Clear();
+        auto cleared = BenchClock::now();
+        pipeline.Perform(image, scene.mesh);
+        auto end = BenchClock::now();
+
+        if (i >= warmup)
+        {
+            clearTime += std::chrono::duration<f64, std::milli>(cleared - start).count();
+            frameTimes.push_back(std::chrono::duration<f64, std::milli>(end - start).count());
+        }
+    }
+
+    if (!dumpDir.empty())
+    {
+        WriteImage(dumpDir + "/" + scene.name + "_" + path.name + "_" + std::to_string(res.width) + "x"
+            + std::to_string(res.height) + ".ppm", *image);
+    }
+
+    const PipelineStats& stats = pipeline.GetStats();
+    f64 total = 0.0;
+    for (f64 ms : frameTimes) { total += ms; }
+    std::vector<f64> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    f64 seconds = total / 1000.0;
+    f64 count = static_cast<f64>(frames);
+
+    return {
+        { "scene", scene.name },
+        { "path", path.name },
+        { "width", res.width },
+        { "height", res.height },
+        { "triangles", scene.mesh.vertices.size() / 3 },
+        { "frame_ms", {
+            { "mean", total / count },
+            { "p50", Percentile(sorted, 0.50) },
+            { "p90", Percentile(sorted, 0.90) },
+            { "p99", Percentile(sorted, 0.99) },
+            { "min", sorted.front() },
+            { "max", sorted.back() },
+        } },
+        { "triangles_per_sec", stats.triangles / seconds },
+        { "pixels_per_sec", stats.pixels / seconds },
+        { "per_frame", {
+            { "triangles_kept", stats.trianglesKept / count },
+            { "trapezoids", stats.trapezoids / count },
+            { "pixels_shaded", stats.pixels / count },
+            { "pixels_covered", stats.pixelsCovered / count },
+        } },
+        { "stages_ms", {
+            { "clear", clearTime / count },
+            { "buffer", stats.bufferTime / count },
+            { "vertex", stats.vertexTime / count },
+            { "pixel", stats.pixelTime / count },
+        } },
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    usize frames = 120;
+    usize warmup = 10;
+    std::string only;
+    std::string out;
+    std::string dumpDir;
+    ShadingRate rate = ShadingRate::Rate1x1;
+
+    for (i32 i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && hasValue) { frames = Max<usize>(1, std::strtoull(argv[++i], nullptr, 10)); }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) { warmup = std::strtoull(argv[++i], nullptr, 10); }
+        else if (std::strcmp(argv[i], "--scene") == 0 && hasValue) { only = argv[++i]; }
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) { out = argv[++i]; }
+        else if (std::strcmp(argv[i], "--dump") == 0 && hasValue) { dumpDir = argv[++i]; }
+        else if (std::strcmp(argv[i], "--rate") == 0 && hasValue)
+        {
+            i32 size = std::atoi(argv[++i]);
+            rate = size >= 4 ? ShadingRate::Rate4x4 : size >= 2 ? ShadingRate::Rate2x2 : ShadingRate::Rate1x1;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--frames N] [--warmup N] [--scene NAME] [--out FILE] [--dump DIR] [--rate 1|2|4]\n";
+            return 1;
+        }
+    }
+
+    nlohmann::json report;
+    report["frames"] = frames;
+    report["warmup"] = warmup;
+    report["threads"] = ThreadPool::Instance().Concurrency();
+    report["shading_rate"] = static_cast<i32>(rate);
+#ifdef SCSR_AVX2
+    report["avx2"] = true;
+#else
+    report["avx2"] = false;
+#endif
+    report["results"] = nlohmann::json::array();
+
+    for (auto& scene : LoadScenes())
+    {
+        if (!only.empty() && scene.name != only) { continue; }
+        for (const auto& path : s_Paths)
+        {
+            for (const auto& res : s_Resolutions)
+            {
+                report["results"].push_back(Run(scene, path, res, frames, warmup, dumpDir, rate));
+                std::cerr << scene.name << " " << path.name << " " << res.width << "x" << res.height << " done\n";
+            }
+        }
+    }
+
+    if (out.empty())
+    {
+        std::cout << report.dump(2) << std::endl;
+    }
+    else
+    {
+        std::ofstream file(out);
+        file << report.dump(2) << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "graphics/frame_capture.hpp"
+#include "graphics/image_io.hpp"
+#include "graphics/light.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/format.hpp"
+#include "core/log.hpp"
+
+#include <json.hpp>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace scsr;
+
+/// Replays a frame captured with `FrameCapture` and reports JSON.
+///
+///   replay_bench CAPTURE [--iterations N] [--warmup N] [--out FILE] [--overdraw PATH]
+///
+/// Every draw is timed over all iterations. Draws the runtime shaded with
+/// its clustered lights are replayed with them, any other draw with a
+/// stand-in shader, its "shader" is "stand-in" in the report and its times
+/// do not reflect the cost of its own shader. Overdraw counts the triangle
+/// pixels written per pixel of each target, `--overdraw` writes them as heat
+/// maps with `{}` in `PATH` replaced by the target index.
+
+/// Heat map colors by writes, the last one for anything above
+static const u32 s_HeatColors[] = {
+    0x000000FFu, 0x0000A0FFu, 0x00A0A0FFu, 0x00C000FFu, 0xC0C000FFu, 0xE08000FFu, 0xE00000FFu, 0xFFFFFFFFu,
+};
+static constexpr usize HeatLevels = sizeof(s_HeatColors) / sizeof(s_HeatColors[0]);
+
+static f64 Percentile(const std::vector<f64>& sorted, f64 p)
+{
+    usize idx = static_cast<usize>(p * (sorted.size() - 1) + 0.5);
+    return sorted[Min(idx, sorted.size() - 1)];
+}
+
+static nlohmann::json OverdrawReport(const std::vector<u32>& counts)
+{
+    usize covered = 0;
+    usize written = 0;
+    u32 most = 0;
+    std::vector<usize> histogram(HeatLevels, 0);
+    for (u32 count : counts)
+    {
+        covered += count > 0;
+        written += count;
+        most = Max(most, count);
+        ++histogram[Min<usize>(count, HeatLevels - 1)];
+    }
+    return {
+        { "pixels", counts.size() },
+        { "covered", covered },
+        { "written", written },
+        { "mean_per_pixel", counts.empty() ? 0.0 : static_cast<f64>(written) / counts.size() },
+        { "mean_per_covered", covered == 0 ? 0.0 : static_cast<f64>(written) / covered },
+        { "max", most },
+        /// Pixels written 0, 1, ... times, the last bucket holds the rest
+        { "histogram", histogram },
+    };
+}
+
+/// The shading of the runtime, by the lights and clusters captured with the draw
+static FrameReplay::ShaderBinder LitShader()
+{
+    auto lights = MakeRef<LightList>();
+    return [lights](Pipeline& pipeline, const CapturedDraw& draw, const std::vector<u8>& uniforms) {
+        if (!lights->Deserialize(uniforms)) { return false; }
+        struct LitVaryings { Vec3 normal; Vec3 viewPos; };
+        pipeline.SetShader(Shader<LitVaryings> {
+            .vertex = [&camera = draw.camera](const Vertex& vtx, LitVaryings& out) -> Vec4 {
+                Vec4 viewPos = camera.view * vtx.pos;
+                out.normal = (camera.view * Vec4(vtx.normal, 0.0f)).xyz();
+                out.viewPos = viewPos.xyz();
+                return camera.projection * viewPos;
+            },
+            .pixel = [lights](const LitVaryings& in) -> Vec4 {
+                return Vec4(lights->Shade(Normalized(in.normal), in.viewPos), 1.0f);
+            },
+        });
+        return true;
+    };
+}
+
+static bool WriteHeatMap(const std::string& path, const std::vector<u32>& counts, const ImageProp& prop)
+{
+    Image image(ImageProp { .width = prop.width, .height = prop.height });
+    for (usize i = 0; i < counts.size(); ++i)
+    {
+        image.Data()[i] = s_HeatColors[Min<usize>(counts[i], HeatLevels - 1)];
+    }
+    return WriteImage(path, image);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string capturePath;
+    usize iterations = 20;
+    usize warmup = 2;
+    std::string out;
+    std::string overdrawPath;
+
+    for (i32 i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--iterations") == 0 && hasValue) { iterations = Max<usize>(1, std::strtoull(argv[++i], nullptr, 10)); }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) { warmup = std::strtoull(argv[++i], nullptr, 10); }
+        else if (std::strcmp(argv[i], "--out") == 0 && hasValue) { out = argv[++i]; }
+        else if (std::strcmp(argv[i], "--overdraw") == 0 && hasValue) { overdrawPath = argv[++i]; }
+        else if (argv[i][0] != '-' && capturePath.empty()) { capturePath = argv[i]; }
+        else
+        {
+            capturePath.clear();
+            break;
+        }
+    }
+    if (capturePath.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " CAPTURE [--iterations N] [--warmup N] [--out FILE] [--overdraw PATH]\n";
+        return 1;
+    }
+
+    if (!overdrawPath.empty() && !FormatsNumber(overdrawPath))
+    {
+        std::cerr << "overdraw path " << overdrawPath << " is not a valid pattern\n";
+        return 1;
+    }
+
+    FrameCapture capture;
+    if (!capture.Load(capturePath))
+    {
+        std::cerr << "could not load " << capturePath << "\n";
+        return 1;
+    }
+
+    Pipeline pipeline;
+    FrameReplay replay(capture);
+    replay.SetShader(LightList::ShaderId, LitShader());
+    const usize drawCount = capture.Draws().size();
+    /// Per draw times of every iteration, then the whole frame
+    std::vector<std::vector<f64>> drawTimes(drawCount);
+    std::vector<f64> frameTimes;
+    std::vector<ReplayDrawStats> stats;
+    for (usize i = 0; i < warmup + iterations; ++i)
+    {
+        replay.Run(pipeline, stats);
+        if (i < warmup) { continue; }
+        f64 frame = 0.0;
+        for (usize d = 0; d < drawCount; ++d)
+        {
+            drawTimes[d].push_back(stats[d].ms);
+            frame += stats[d].ms;
+        }
+        frameTimes.push_back(frame);
+    }
+
+    nlohmann::json report;
+    report["capture"] = capturePath;
+    report["iterations"] = iterations;
+    report["warmup"] = warmup;
+    report["threads"] = ThreadPool::Instance().Concurrency();
+#ifdef SCSR_AVX2
+    report["avx2"] = true;
+#else
+    report["avx2"] = false;
+#endif
+    std::sort(frameTimes.begin(), frameTimes.end());
+    report["frame_ms"] = {
+        { "p50", Percentile(frameTimes, 0.50) },
+        { "min", frameTimes.front() },
+        { "max", frameTimes.back() },
+    };
+
+    /// Counters do not change between iterations, the last run is reported
+    report["draws"] = nlohmann::json::array();
+    for (usize d = 0; d < drawCount; ++d)
+    {
+        const CapturedDraw& draw = capture.Draws()[d];
+        std::vector<f64>& times = drawTimes[d];
+        std::sort(times.begin(), times.end());
+        report["draws"].push_back({
+            { "index", d },
+            { "target", draw.target },
+            { "topology", static_cast<u32>(draw.mesh.topology) },
+            { "vertices", draw.mesh.vertices.size() },
+            { "shader", stats[d].standIn ? "stand-in" : "lit" },
+            { "blend", static_cast<i32>(draw.state.blend) },
+            { "shading_rate", static_cast<i32>(draw.state.shadingRate) },
+            { "triangles", stats[d].triangles },
+            { "triangles_kept", stats[d].trianglesKept },
+            { "pixels_written", stats[d].pixels },
+            { "pixels_shaded", stats[d].shaded },
+            { "ms", {
+                { "p50", Percentile(times, 0.50) },
+                { "p90", Percentile(times, 0.90) },
+                { "min", times.front() },
+                { "max", times.back() },
+            } },
+        });
+    }
+
+    std::vector<std::vector<u32>> counts;
+    replay.Overdraw(pipeline, counts);
+    report["targets"] = nlohmann::json::array();
+    for (usize t = 0; t < counts.size(); ++t)
+    {
+        const ImageProp& prop = capture.Targets()[t].prop;
+        report["targets"].push_back({
+            { "width", prop.width },
+            { "height", prop.height },
+            { "hdr", prop.hdr },
+            { "overdraw", OverdrawReport(counts[t]) },
+        });
+        if (!overdrawPath.empty())
+        {
+            std::string path = fmt::format(fmt::runtime(overdrawPath), t);
+            if (!WriteHeatMap(path, counts[t], prop))
+            {
+                LOG_WARN("Could not write {}", path);
+            }
+        }
+    }
+
+    if (out.empty())
+    {
+        std::cout << report.dump(2) << std::endl;
+    }
+    else
+    {
+        std::ofstream file(out);
+        file << report.dump(2) << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "math/math.hpp"            // IWYU pragma: export
 
+#include "task/thread_pool.hpp"     // IWYU pragma: export
+
 #include "io.hpp"                   // IWYU pragma: export
 #include "log.hpp"                  // IWYU pragma: export
 #include "type.hpp"                 // IWYU pragma: export
@@ -15,9 +17,28 @@
 
 #include "graphics/window.hpp"      // IWYU pragma: export
 #include "graphics/pipeline.hpp"    // IWYU pragma: export
-#include "graphics/image.hpp"       // IWYU pragma: export 
+#include "graphics/image.hpp"       // IWYU pragma: export
+#include "graphics/blit.hpp"        // IWYU pragma: export
+#include "graphics/blend.hpp"       // IWYU pragma: export
+#include "graphics/post.hpp"        // IWYU pragma: export
+#include "graphics/line.hpp"        // IWYU pragma: export
+#include "graphics/debug_draw.hpp"  // IWYU pragma: export
+#include "graphics/image_io.hpp"    // IWYU pragma: export
 #include "graphics/obj_loader.hpp"  // IWYU pragma: export
 #include "graphics/vertex.hpp"      // IWYU pragma: export
+#include "graphics/shader.hpp"      // IWYU pragma: export
+#include "graphics/shading_rate.hpp" // IWYU pragma: export
 #include "graphics/swapchain.hpp"   // IWYU pragma: export
+#include "graphics/damage.hpp"      // IWYU pragma: export
+#include "graphics/render_graph.hpp" // IWYU pragma: export
+#include "graphics/dynamic_resolution.hpp" // IWYU pragma: export
 #include "graphics/camera.hpp"      // IWYU pragma: export
-
+#include "graphics/light.hpp"       // IWYU pragma: export
+#include "graphics/static_batch.hpp" // IWYU pragma: export
+#include "graphics/point_cloud.hpp" // IWYU pragma: export
+#include "graphics/particle.hpp"    // IWYU pragma: export
+#include "graphics/sprite.hpp"      // IWYU pragma: export
+#include "graphics/bvh.hpp"         // IWYU pragma: export
+#include "graphics/ray_tracer.hpp"  // IWYU pragma: export
+#include "graphics/overlay.hpp"     // IWYU pragma: export
+#include "graphics/frame_capture.hpp" // IWYU pragma: export
\ No newline at end of file
@@ -31,6 +31,7 @@ enum class EventType
     WindowFocusGained,
     WindowFocusLost,
     WindowClose,
+    WindowExposed,
     KeyboardPressed,
     KeyboardReleased,
     MouseMotion,
@@ -141,6 +142,16 @@ struct WindowCloseEvent
     static EventType Type() { return EventType::WindowClose; }
 };
 
+/// The window contents were lost and must be presented again
+struct WindowExposeEvent
+{
+    EventCategory category = EventCategory::ECWindow;
+    EventType type = EventType::WindowExposed;
+    u32 windowID;
+
+    static EventType Type() { return EventType::WindowExposed; }
+};
+
 struct KeyboardPressedEvent
 {
     EventCategory category = EventCategory::ECKeyboard;
@@ -231,6 +242,7 @@ struct Event
         WindowFocusGainedEvent windowFocusGained;
         WindowFocusLostEvent windowFocusLost;
         WindowCloseEvent windowClose;
+        WindowExposeEvent windowExpose;
 
         KeyboardPressedEvent keyboardPressed;
         KeyboardReleasedEvent keyboardReleased;
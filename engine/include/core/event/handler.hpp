@@ -21,7 +21,11 @@ public:
     EventHandler(World& world);
 
     void Poll();
+    /// Block until an event is pending or `timeoutMs` passed, for idling
+    void Wait(u32 timeoutMs);
     void Dispatch();
+    /// Queue an event raised by the engine itself, handled on the next `Dispatch`
+    void Send(const Event& event);
     void SetFilter(u16 filter);
     void SetCallback(EventType type, std::function<void(Event, Storage&)> callback);
 private:
@@ -81,6 +81,10 @@ std::string FormatKeyBoardKeyCode(i32 code);
 std::string FormatMouseButtonCode(u8 code);
 std::string FormatEvent(const Event& event);
 
+/// True when `pattern` formats with a single number, as numbered output paths
+/// like `frame{}.ppm` do. Checked once up front, formatting a bad one throws.
+bool FormatsNumber(const std::string& pattern);
+
 constexpr std::string FormatMath(const Vec2& vec)
 {
     return "Vec2: (" + std::to_string(vec.x) + ", " + std::to_string(vec.y) + ")";
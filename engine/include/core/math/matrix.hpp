@@ -348,12 +348,14 @@ struct Mat4
             m03, m13, m23, m33
         );
     }
+    /// Products of 2x2 minors of the top and bottom two rows
     float Determinant() const
     {
-        return m00 * (m11 * m22 * m33 + m12 * m23 * m31 + m13 * m21 * m32 - m13 * m22 * m31 - m11 * m23 * m32 - m12 * m21 * m33) -
-               m01 * (m10 * m22 * m33 + m12 * m23 * m30 + m13 * m20 * m32 - m13 * m22 * m30 - m10 * m23 * m32 - m12 * m20 * m33) +
-               m02 * (m10 * m21 * m33 + m11 * m23 * m30 + m13 * m20 * m31 - m13 * m21 * m30 - m10 * m23 * m31 - m11 * m20 * m33) -
-               m03 * (m10 * m21 * m32 + m11 * m22 * m30 + m12 * m20 * m31 - m12 * m21 * m30 - m10 * m22 * m31 - m11 * m20 * m32);
+        float s0 = m00 * m11 - m10 * m01, s1 = m00 * m12 - m10 * m02, s2 = m00 * m13 - m10 * m03;
+        float s3 = m01 * m12 - m11 * m02, s4 = m01 * m13 - m11 * m03, s5 = m02 * m13 - m12 * m03;
+        float c0 = m20 * m31 - m30 * m21, c1 = m20 * m32 - m30 * m22, c2 = m20 * m33 - m30 * m23;
+        float c3 = m21 * m32 - m31 * m22, c4 = m21 * m33 - m31 * m23, c5 = m22 * m33 - m32 * m23;
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
     }
     float Trace() const
     {
@@ -361,29 +363,33 @@ struct Mat4
     }
     Mat4 Inversed() const
     {
-        float det = Determinant();
+        float s0 = m00 * m11 - m10 * m01, s1 = m00 * m12 - m10 * m02, s2 = m00 * m13 - m10 * m03;
+        float s3 = m01 * m12 - m11 * m02, s4 = m01 * m13 - m11 * m03, s5 = m02 * m13 - m12 * m03;
+        float c0 = m20 * m31 - m30 * m21, c1 = m20 * m32 - m30 * m22, c2 = m20 * m33 - m30 * m23;
+        float c3 = m21 * m32 - m31 * m22, c4 = m21 * m33 - m31 * m23, c5 = m22 * m33 - m32 * m23;
+        float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
         if (det == 0) return Mat4::NANM();
         float invDet = 1.0f / det;
         return Mat4(
-            (m11 * m22 * m33 + m12 * m23 * m31 + m13 * m21 * m32 - m13 * m22 * m31 - m11 * m23 * m32 - m12 * m21 * m33) * invDet,
-            (m03 * m22 * m31 + m01 * m23 * m32 + m02 * m21 * m33 - m02 * m22 * m31 - m03 * m23 * m32 - m01 * m21 * m33) * invDet,
-            (m03 * m12 * m31 + m01 * m13 * m32 + m02 * m11 * m33 - m02 * m12 * m31 - m03 * m13 * m32 - m01 * m11 * m33) * invDet,
-            (m03 * m12 * m21 + m01 * m13 * m22 + m02 * m11 * m23 - m02 * m12 * m21 - m03 * m13 * m22 - m01 * m11 * m23) * invDet,
-
-            (m10 * m22 * m33 + m12 * m23 * m30 + m13 * m20 * m32 - m13 * m22 * m30 - m10 * m23 * m32 - m12 * m20 * m33) * invDet,
-            (m02 * m22 * m30 + m00 * m23 * m32 + m03 * m20 * m32 - m03 * m22 * m30 - m02 * m23 * m32 - m00 * m20 * m33) * invDet,
-            (m03 * m12 * m30 + m00 * m13 * m32 + m02 * m10 * m33 - m02 * m12 * m30 - m03 * m13 * m32 - m00 * m10 * m33) * invDet,
-            (m02 * m12 * m30 + m00 * m13 * m32 + m02 * m10 * m33 - m02 * m12 * m30 - m03 * m13 * m32 - m00 * m10 * m33) * invDet,
-
-            (m10 * m21 * m33 + m11 * m23 * m30 + m13 * m20 * m31 - m13 * m21 * m30 - m10 * m23 * m31 - m11 * m20 * m33) * invDet,
-            (m03 * m21 * m30 + m01 * m23 * m31 + m03 * m20 * m31 - m03 * m21 * m30 - m01 * m23 * m30 - m01 * m20 * m33) * invDet,
-            (m03 * m11 * m30 + m01 * m13 * m31 + m03 * m10 * m33 - m03 * m11 * m30 - m01 * m13 * m30 - m01 * m10 * m33) * invDet,
-            (m03 * m11 * m20 + m01 * m13 * m21 + m02 * m10 * m23 - m02 * m11 * m20 - m03 * m13 * m21 - m01 * m10 * m23) * invDet,
-
-            (m10 * m21 * m32 + m11 * m22 * m30 + m12 * m20 * m31 - m12 * m21 * m30 - m10 * m22 * m31 - m11 * m20 * m32) * invDet,
-            (m02 * m21 * m30 + m00 * m22 * m31 + m01 * m20 * m32 - m01 * m21 * m30 - m02 * m22 * m31 - m00 * m20 * m32) * invDet,
-            (m03 * m11 * m30 + m01 * m12 * m31 + m02 * m10 * m32 - m02 * m11 * m30 - m03 * m12 * m31 - m01 * m10 * m32) * invDet,
-            (m02 * m11 * m20 + m00 * m12 * m21 + m01 * m10 * m22 - m01 * m11 * m20 - m02 * m12 * m21 - m00 * m10 * m22) * invDet
+            ( m11 * c5 - m12 * c4 + m13 * c3) * invDet,
+            (-m01 * c5 + m02 * c4 - m03 * c3) * invDet,
+            ( m31 * s5 - m32 * s4 + m33 * s3) * invDet,
+            (-m21 * s5 + m22 * s4 - m23 * s3) * invDet,
+
+            (-m10 * c5 + m12 * c2 - m13 * c1) * invDet,
+            ( m00 * c5 - m02 * c2 + m03 * c1) * invDet,
+            (-m30 * s5 + m32 * s2 - m33 * s1) * invDet,
+            ( m20 * s5 - m22 * s2 + m23 * s1) * invDet,
+
+            ( m10 * c4 - m11 * c2 + m13 * c0) * invDet,
+            (-m00 * c4 + m01 * c2 - m03 * c0) * invDet,
+            ( m30 * s4 - m31 * s2 + m33 * s0) * invDet,
+            (-m20 * s4 + m21 * s2 - m23 * s0) * invDet,
+
+            (-m10 * c3 + m11 * c1 - m12 * c0) * invDet,
+            ( m00 * c3 - m01 * c1 + m02 * c0) * invDet,
+            (-m30 * s3 + m31 * s1 - m32 * s0) * invDet,
+            ( m20 * s3 - m21 * s1 + m22 * s0) * invDet
         );
     }
     void Inverse()
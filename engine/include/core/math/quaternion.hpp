@@ -233,8 +233,8 @@ inline Quat Nlerp(const Quat& q0, const Quat& q1, f32 t)
 /// Slerp will fallback to Nlerp two quaternions are close enough
 inline Quat Slerp(const Quat& q0, const Quat& q1, f32 t)
 {
-    RT_ASSERT(!q0.IsNormalized(), "Quat q0 not normalied");
-    RT_ASSERT(!q1.IsNormalized(), "Quat q1 not normalied");
+    RT_ASSERT(q0.IsNormalized(), "Quat q0 not normalied");
+    RT_ASSERT(q1.IsNormalized(), "Quat q1 not normalied");
 
     const f32 threshold = 0.9995f;
     f32 dot = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
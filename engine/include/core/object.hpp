@@ -103,6 +103,7 @@ struct Storage
             LOG_WARN("Object <{}> already registered, reset", typeid(T).name());
             it->second.Reset();
             it->second.object = new T(std::forward<Args>(args)...);
+            MarkRegistered(idx);
             return;
         }
         else
@@ -112,6 +113,7 @@ struct Storage
                 ObjectInfo([](void* obj) { delete static_cast<T*>(obj); })
             );
             newIt.first->second.object = new T(std::forward<Args>(args)...);
+            MarkRegistered(idx);
             LOG_INFO("Object <{}> registered (immediate construct)", typeid(T).name());
         }
     }
@@ -142,15 +144,38 @@ struct Storage
         return *static_cast<T*>(it->second.object);
     }
 
+    ~Storage()
+    {
+        // Destroy in reverse registration order, later objects may still use earlier ones
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            objects.erase(*it);
+        }
+    }
+
     std::map<ObjectIndex, ObjectInfo> objects;
+    /// Indices of `objects` in the order they were registered, the index
+    /// itself is assigned on first use of the type and says nothing about it
+    std::vector<ObjectIndex> order;
     std::vector<NormalSystemForm> systems;
     std::vector<Plugin> plugins;
+
+private:
+    /// A replaced object may use ones registered since, it moves to the end
+    void MarkRegistered(ObjectIndex idx)
+    {
+        std::erase(order, idx);
+        order.push_back(idx);
+    }
 };
 
 struct Ticker
 {
     usize tick = 0;
+    /// Duration of the last tick in whole milliseconds
     usize delta = 0;
+    /// Same, not truncated
+    f64 frameTime = 0.0;
 };
 
 struct World
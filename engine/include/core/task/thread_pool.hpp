@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/type.hpp"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace scsr
+{
+
+/// Fixed size pool of worker threads.
+/// The calling thread always takes part in `ParallelFor`, so it is safe
+/// to call from inside a job and a pool without workers runs inline.
+class ThreadPool
+{
+    PIN(ThreadPool)
+    SIG(ThreadPool)
+public:
+    /// Range job, called with [begin, end)
+    using RangeFn = std::function<void(usize, usize)>;
+
+    /// Shared pool sized to the hardware, the caller counts as one thread
+    static ThreadPool& Instance()
+    {
+        static ThreadPool instance(std::thread::hardware_concurrency());
+        return instance;
+    }
+
+    explicit ThreadPool(usize threadCount);
+    ~ThreadPool();
+
+    /// Workers plus the calling thread
+    usize Concurrency() const { return m_Workers.size() + 1; }
+
+    void Submit(std::function<void()> job);
+    /// Split [0, count) into chunks of at least `grain` and block until all are done
+    void ParallelFor(usize count, usize grain, const RangeFn& fn);
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_Workers;
+    std::deque<std::function<void()>> m_Jobs;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    bool m_Running = true;
+};
+
+}
\ No newline at end of file
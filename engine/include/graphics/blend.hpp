@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+namespace scsr
+{
+
+/// How a shaded pixel combines with the color already in the image,
+/// `a` is the source alpha
+enum class BlendMode
+{
+    /// src, the default
+    Opaque,
+    /// src * a + dst * (1 - a)
+    Alpha,
+    /// src + dst * (1 - a), for colors already multiplied by their alpha
+    Premultiplied,
+    /// src * a + dst
+    Additive,
+    /// src * dst
+    Multiply,
+};
+
+/// Blend `count` pixels of `src` into `dst` in place, both in `format`.
+/// Channels are 8-bit fixed point and saturate at 255, the alpha channel
+/// is blended with a factor of 1 instead of `a`.
+void BlendPixels(const u32* src, u32* dst, usize count, BlendMode mode, PixelFormat format);
+
+/// Blend one float color, unclamped for HDR targets. The alpha channel is
+/// blended like in `BlendPixels`.
+inline Color BlendColor(const Color& src, const Color& dst, BlendMode mode)
+{
+    f32 a = src.w;
+    switch (mode)
+    {
+    case BlendMode::Alpha:         return Color(src.xyz() * a + dst.xyz() * (1.0f - a), a + dst.w * (1.0f - a));
+    case BlendMode::Premultiplied: return src + dst * (1.0f - a);
+    case BlendMode::Additive:      return Color(src.xyz() * a + dst.xyz(), a + dst.w);
+    case BlendMode::Multiply:      return Color(src.x * dst.x, src.y * dst.y, src.z * dst.z, src.w * dst.w);
+    case BlendMode::Opaque:
+    default:                       return src;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+namespace scsr
+{
+
+enum class BlitFilter
+{
+    Nearest,
+    Bilinear,
+};
+
+/// A view of packed 32-bit pixels, pitch counted in pixels
+struct PixelView
+{
+    u32* data;
+    i32 width;
+    i32 height;
+    i32 pitch;
+    PixelFormat format;
+};
+
+inline PixelView MakePixelView(Image& image)
+{
+    return { image.Data(), image.Width(), image.Height(), image.Width(), image.Format() };
+}
+
+/// Copy `src` into `dst` reordering channels, sizes must match.
+/// Rows are split across `ThreadPool::Instance()`.
+void ConvertPixels(const PixelView& src, const PixelView& dst);
+
+/// Stretch `src` over the whole of `dst` reordering channels.
+/// Rows are split across `ThreadPool::Instance()`.
+void ScalePixels(const PixelView& src, const PixelView& dst, BlitFilter filter);
+
+/// Pack `count` colors into `format` on the calling thread, clamped and rounded
+/// like `PackColor`. With `srgb` the color channels are encoded through a
+/// lookup table, alpha stays linear.
+void PackColors(const Color* colors, u32* out, usize count, PixelFormat format, bool srgb = false);
+
+/// Linear value of an 8-bit sRGB channel, the inverse of the `srgb` encoding of `PackColors`
+f32 SrgbToLinear(u8 value);
+
+/// Reorder the channels of `count` pixels on the calling thread, `in` may equal `out`
+void SwizzlePixels(const u32* in, u32* out, usize count, PixelFormat src, PixelFormat dst);
+
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/obj_loader.hpp"
+
+#include <atomic>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace scsr
+{
+
+struct Ray
+{
+    Vec3 origin;
+    /// Need not be normalized, hit distances are in multiples of it
+    Vec3 direction;
+    f32 tMax = std::numeric_limits<f32>::infinity();
+};
+
+struct RayHit
+{
+    f32 t = std::numeric_limits<f32>::infinity();
+    /// Triangle in `Bvh` order, ~0u for a miss
+    u32 triangle = ~0u;
+    /// Barycentrics of the second and third vertex
+    f32 u = 0.0f;
+    f32 v = 0.0f;
+
+    bool Valid() const { return triangle != ~0u; }
+};
+
+/// Eight rays side by side, one per SIMD lane
+struct RayPacket
+{
+    static constexpr usize Size = 8;
+
+    alignas(32) f32 ox[Size], oy[Size], oz[Size];
+    alignas(32) f32 dx[Size], dy[Size], dz[Size];
+    alignas(32) f32 tMax[Size];
+
+    void Set(usize lane, const Ray& ray);
+};
+
+/// Closest hits of a `RayPacket`, misses have `triangle` ~0u
+struct PacketHit
+{
+    alignas(32) f32 t[RayPacket::Size];
+    alignas(32) u32 triangle[RayPacket::Size];
+    alignas(32) f32 u[RayPacket::Size];
+    alignas(32) f32 v[RayPacket::Size];
+
+    RayHit Get(usize lane) const { return { t[lane], triangle[lane], u[lane], v[lane] }; }
+};
+
+/// 32 bytes, two per cache line
+struct BvhNode
+{
+    Vec3 min;
+    /// Left child of an inner node, the right one follows it. First
+    /// triangle of a leaf.
+    u32 index;
+    Vec3 max;
+    /// Triangles of a leaf, 0 for inner nodes
+    u16 count;
+    /// Axis inner nodes were split along, children are ordered along it
+    u16 axis;
+
+    bool IsLeaf() const { return count > 0; }
+};
+
+/// Where a `Bvh` triangle came from
+struct BvhPrimitive
+{
+    u32 mesh;
+    /// Triangle of the mesh, see `TriangleIndices`
+    u32 triangle;
+};
+
+/// Bounding volume hierarchy over the triangles of meshes, for ray casts.
+///
+/// Built top down with the surface area heuristic over binned centroids.
+/// Large nodes bin their triangles across `ThreadPool::Instance()` and
+/// subtrees are built in parallel. Rays are cast one at a time or in
+/// packets of eight, testing boxes and triangles for all lanes at once
+/// with AVX2.
+class Bvh
+{
+public:
+    /// Leaves hold at most this many triangles
+    static constexpr u32 MaxLeafSize = 4;
+    static constexpr u32 SahBins = 16;
+    /// Nodes with more triangles are binned and split in parallel
+    static constexpr u32 ParallelThreshold = 4096;
+    /// Nodes this deep are split at the median instead of by SAH, which
+    /// bounds the depth by this plus log2 of the triangle count
+    static constexpr u32 SahMaxDepth = 32;
+
+    /// Replace the hierarchy with one over the triangle topologies of
+    /// `meshes`, other topologies are skipped
+    void Build(std::span<const Mesh* const> meshes);
+
+    /// Closest hit along `ray` within `tMax`
+    RayHit Intersect(const Ray& ray) const;
+    /// Whether anything is hit along `ray` within `tMax`
+    bool Occluded(const Ray& ray) const;
+
+    /// Closest hits of the lanes set in `mask`
+    void Intersect(const RayPacket& packet, u32 mask, PacketHit& hit) const;
+    /// Lanes of `mask` that hit anything
+    u32 Occluded(const RayPacket& packet, u32 mask) const;
+
+    /// Interpolated vertex normal of a hit, not normalized
+    Vec3 Normal(const RayHit& hit) const;
+    const BvhPrimitive& Primitive(u32 triangle) const { return m_Primitives[triangle]; }
+
+    usize TriangleCount() const { return m_Triangles.size(); }
+    const std::vector<BvhNode>& Nodes() const { return m_Nodes; }
+    bool Empty() const { return m_Triangles.empty(); }
+private:
+    /// Set up for Möller-Trumbore
+    struct Triangle
+    {
+        Vec3 v0;
+        Vec3 e1;
+        Vec3 e2;
+    };
+
+    struct BuildItem
+    {
+        Vec3 min;
+        Vec3 max;
+        Vec3 centroid;
+    };
+
+    void Subdivide(u32 node, u32 first, u32 count, u32 depth, std::vector<BuildItem>& items);
+    /// Make `node` an inner node over the triangles already ordered so the
+    /// first `leftCount` go left, and build both children
+    void SplitNode(u32 node, u32 first, u32 count, u32 leftCount, i32 axis, u32 depth, std::vector<BuildItem>& items);
+
+    std::vector<BvhNode> m_Nodes;
+    std::vector<Triangle> m_Triangles;
+    /// Vertex normals, three per triangle
+    std::vector<Vec3> m_Normals;
+    std::vector<BvhPrimitive> m_Primitives;
+
+    /// During `Build`, triangle indices and the next free node
+    std::vector<u32> m_Order;
+    std::atomic<u32> m_NodeCount = 0;
+};
+
+}
\ No newline at end of file
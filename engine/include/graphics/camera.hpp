@@ -19,6 +19,8 @@ public:
     const Vec3& GetUp() const { return m_Up; }
     const Mat4& GetProjection() const { return m_Projection; }
     const Mat4& GetView() const { return m_View; }
+    f32 GetNearClip() const { return m_NearClip; }
+    f32 GetFarClip() const { return m_FarClip; }
 private:
     void UpdateProjection();
     void UpdateView();
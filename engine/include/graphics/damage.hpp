@@ -0,0 +1,49 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+#include <deque>
+
+namespace scsr
+{
+
+/// Screen regions that changed, per frame, for redrawing only what is stale.
+///
+/// With several swapchain images an acquired image holds an older frame,
+/// `Accumulated` returns everything changed since then, see `Swapchain::ImageAge`.
+class DamageHistory
+{
+public:
+    /// Frames kept, older images are redrawn whole
+    static constexpr usize MaxAge = 8;
+
+    /// Starts fully damaged, nothing has been drawn yet
+    DamageHistory() { MarkAll(); }
+
+    void Mark(const Rect& rect) { m_Current.rect = Union(m_Current.rect, rect); }
+    void MarkAll() { m_Current.full = true; }
+
+    /// Nothing changed in the current frame
+    bool IsClean() const { return !m_Current.full && m_Current.rect.Empty(); }
+
+    /// Damage of the current frame and the `age - 1` frames before it within
+    /// `bounds`, what an image written `age` frames ago lacks. Age 0 means the
+    /// content is unknown and the result is `bounds`.
+    Rect Accumulated(usize age, const Rect& bounds) const;
+
+    /// Close the current frame, call once it has been rendered
+    void EndFrame();
+private:
+    struct Frame
+    {
+        Rect rect;
+        bool full = false;
+    };
+
+    Frame m_Current;
+    /// Most recent first
+    std::deque<Frame> m_History;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/image.hpp"
+#include "graphics/line.hpp"
+#include "graphics/obj_loader.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+/// World space lines collected over a frame and drawn in one batch.
+/// Lines are depth tested against what the pipeline rendered but do not write depth.
+class DebugDraw
+{
+public:
+    void Line(const Vec3& a, const Vec3& b, const Color& color);
+    /// Axis aligned box
+    void Box(const Vec3& min, const Vec3& max, const Color& color);
+    /// Three great circles of `segments` lines each
+    void Sphere(const Vec3& center, f32 radius, const Color& color, i32 segments = 24);
+    /// Edges of the volume seen through `viewProjection`
+    void Frustum(const Mat4& viewProjection, const Color& color);
+    /// One line of `length` along each vertex normal
+    void Normals(const Mesh& mesh, f32 length, const Color& color);
+
+    /// Clip, project and draw every queued line into `image`, then drop them.
+    /// Lines are transformed and drawn in row bands across `ThreadPool::Instance()`.
+    void Flush(Image& image, const Mat4& viewProjection);
+    void Clear() { m_Lines.clear(); }
+
+    usize LineCount() const { return m_Lines.size(); }
+
+    /// Keeps lines lying on surfaces visible
+    void SetDepthBias(f32 bias) { m_DepthBias = bias; }
+private:
+    struct WorldLine
+    {
+        Vec3 a;
+        Vec3 b;
+        Color color;
+    };
+
+    std::vector<WorldLine> m_Lines;
+    /// Projected lines of the current flush, clipped away ones removed
+    std::vector<ScreenLine> m_ScreenLines;
+    std::vector<u8> m_Visible;
+    f32 m_DepthBias = 1e-4f;
+};
+
+}
\ No newline at end of file
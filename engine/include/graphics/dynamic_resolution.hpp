@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+namespace scsr
+{
+
+struct DynamicResolutionProp
+{
+    /// Frame time budget in milliseconds
+    f64 targetMs = 1000.0 / 60.0;
+    /// Bounds of the render size relative to the output size, per axis
+    f32 minScale = 0.5f;
+    f32 maxScale = 1.0f;
+    /// Weight of the newest frame in the smoothed frame time
+    f64 smoothing = 0.1;
+    /// Frames to wait after a change before measuring again
+    usize cooldown = 8;
+};
+
+/// Picks the internal render size from measured frame times.
+/// Frames over budget shrink both axes so the pixel count follows the
+/// budget, frames well under it grow them back in small steps.
+/// Sizes are rounded to multiples of 8 to limit how often they change.
+class DynamicResolution
+{
+public:
+    DynamicResolution(ImageProp output, DynamicResolutionProp prop = {});
+
+    /// Feed the time of the last frame, returns true when `RenderProp` changed
+    bool Update(f64 frameMs);
+
+    ImageProp RenderProp() const { return m_Render; }
+    const ImageProp& OutputProp() const { return m_Output; }
+    f32 Scale() const { return m_Scale; }
+    /// Smoothed frame time in milliseconds
+    f64 AverageMs() const { return m_AverageMs; }
+private:
+    ImageProp MakeRenderProp(f32 scale) const;
+
+    ImageProp m_Output;
+    ImageProp m_Render;
+    DynamicResolutionProp m_Prop;
+    f32 m_Scale;
+    f64 m_AverageMs = 0.0;
+    usize m_Cooldown = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/image.hpp"
+#include "graphics/obj_loader.hpp"
+#include "graphics/pipeline.hpp"
+#include "graphics/shading_rate.hpp"
+#include "graphics/vertex.hpp"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace scsr
+{
+
+class Camera;
+
+/// Start of a frame capture file, followed by the targets and then the draws
+struct FrameCaptureHeader
+{
+    static constexpr u32 Magic = 0x43465353; // "SSFC"
+    static constexpr u32 Version = 2;
+
+    u32 magic = Magic;
+    u32 version = Version;
+    u32 targetCount = 0;
+    u32 rateCount = 0;
+    u32 uniformCount = 0;
+    u32 drawCount = 0;
+};
+
+/// A render target as the first draw of the frame found it
+struct CapturedTarget
+{
+    ImageProp prop;
+    std::vector<u32> pixels;
+    /// Empty unless `prop.hdr`
+    std::vector<Color> hdr;
+    std::vector<f32> depth;
+};
+
+/// The camera a draw was made with, what the shaders of the runtime read
+struct CapturedCamera
+{
+    Mat4 view;
+    Mat4 projection;
+    Vec3 position;
+    Vec3 front;
+    Vec3 up;
+};
+
+/// A bound `ShadingRateImage`, tiles row by row
+struct CapturedRates
+{
+    i32 width = 0;
+    i32 height = 0;
+    std::vector<ShadingRate> tiles;
+};
+
+/// Everything one `Pipeline::Perform` consumed
+struct CapturedDraw
+{
+    /// Index into `FrameCapture::Targets`
+    u32 target = 0;
+    /// Index into `FrameCapture::Rates`, ~0u without a rate image
+    u32 rates = ~0u;
+    /// Replay shader id given to `FrameCapture::SetShader`, 0 without one
+    u32 shader = 0;
+    /// Index into `FrameCapture::Uniforms`, ~0u without uniforms
+    u32 uniforms = ~0u;
+    PipelineState state;
+    CapturedCamera camera;
+    /// Only the vertices and the topology are captured
+    Mesh mesh;
+};
+
+/// Records the draw stream of one frame so it can be replayed offline.
+///
+/// Bind it with `Pipeline::SetCapture`, then every `Perform` between
+/// `Begin` and `End` stores its state, camera and vertices. A target is
+/// copied when it is first drawn to, after the clears of the frame. Shaders
+/// are code and are not captured. The application tags draws with a shader
+/// id and the bytes its shader reads, the replay binds what it registered
+/// under that id, see `FrameReplay::SetShader`.
+class FrameCapture
+{
+public:
+    /// Forget the last capture and record the draws from now on
+    void Begin();
+    /// Tag the draws recorded from now until the next `Begin` with `shader`
+    /// and the `uniforms` it reads besides the vertices and the camera
+    void SetShader(u32 shader, std::vector<u8> uniforms = {});
+    void End() { m_Recording = false; }
+    bool IsRecording() const { return m_Recording; }
+
+    /// Called by the pipeline for every draw while recording
+    void RecordDraw(const Image& target, const Mesh& mesh, const PipelineState& state, const Camera& camera,
+        const ShadingRateImage* rates);
+
+    const std::vector<CapturedTarget>& Targets() const { return m_Targets; }
+    const std::vector<CapturedRates>& Rates() const { return m_Rates; }
+    const std::vector<std::vector<u8>>& Uniforms() const { return m_Uniforms; }
+    const std::vector<CapturedDraw>& Draws() const { return m_Draws; }
+
+    /// Write in the format `Load` reads, native byte order and layouts
+    bool Save(const std::string& path) const;
+    /// False when the file is missing, truncated or from another version
+    bool Load(const std::string& path);
+private:
+    std::vector<CapturedTarget> m_Targets;
+    /// A rate image is stored again only when it changed since the last draw
+    std::vector<CapturedRates> m_Rates;
+    /// Stored once per `SetShader`, shared by the draws after it
+    std::vector<std::vector<u8>> m_Uniforms;
+    std::vector<CapturedDraw> m_Draws;
+    /// Images seen while recording, same order as `m_Targets`
+    std::vector<const Image*> m_Images;
+    u32 m_Shader = 0;
+    u32 m_CurrentUniforms = ~0u;
+    bool m_Recording = false;
+};
+
+/// Timing and cost of one replayed draw
+struct ReplayDrawStats
+{
+    f64 ms = 0.0;
+    usize triangles = 0;
+    usize trianglesKept = 0;
+    /// Pixels written, a pixel written twice counts twice
+    usize pixels = 0;
+    /// Pixel shader invocations
+    usize shaded = 0;
+    /// Replayed with the stand-in shader, the costs of shading differ
+    bool standIn = false;
+};
+
+/// Re-executes a captured frame, e.g. to profile a slow frame repeatedly.
+///
+/// Targets are restored from the capture before every run and each draw is
+/// made with its captured state, camera, rate image and the shader
+/// registered under its shader id. Draws without one are made with a
+/// stand-in that transforms by the captured matrices and shades by the view
+/// space normal, so geometry and coverage match the capture while colors
+/// and the cost per shaded pixel do not.
+class FrameReplay
+{
+public:
+    /// Sets the shader of `draw` on `pipeline` with the uniform bytes
+    /// captured with it, false when it cannot read them
+    using ShaderBinder = std::function<bool(Pipeline& pipeline, const CapturedDraw& draw, const std::vector<u8>& uniforms)>;
+
+    explicit FrameReplay(const FrameCapture& capture);
+
+    /// Replay the draws tagged with `shader` through `bind`, called before
+    /// each of them. Draws with an id nothing is registered under, or whose
+    /// uniforms `bind` rejects, use the stand-in.
+    void SetShader(u32 shader, ShaderBinder bind) { m_Shaders[shader] = std::move(bind); }
+
+    /// Replay every draw once, `stats` gets one entry per draw. The pipeline
+    /// keeps the last shader bound and its stats are reset for every draw.
+    void Run(Pipeline& pipeline, std::vector<ReplayDrawStats>& stats);
+    /// Replay counting the triangle pixels written, `counts` gets one
+    /// counter per pixel of each target, see `Pipeline::SetOverdrawCounts`
+    void Overdraw(Pipeline& pipeline, std::vector<std::vector<u32>>& counts);
+
+    /// The target as the last run left it
+    const Ref<Image>& Target(u32 index) const { return m_Targets[index]; }
+private:
+    /// Targets as captured
+    void Restore();
+    /// Returns false when the stand-in shader was bound
+    bool Bind(Pipeline& pipeline, const CapturedDraw& draw);
+
+    const FrameCapture& m_Capture;
+    std::vector<Ref<Image>> m_Targets;
+    std::vector<Ref<ShadingRateImage>> m_Rates;
+    Ref<Camera> m_Camera;
+    std::unordered_map<u32, ShaderBinder> m_Shaders;
+    /// Draw being replayed, read by the stand-in shader
+    const CapturedDraw* m_Draw = nullptr;
+    bool m_StandInBound = false;
+};
+
+}
\ No newline at end of file
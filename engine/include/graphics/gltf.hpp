@@ -2,6 +2,8 @@
 
 #include "core/type.hpp"
 #include "core/math/math.hpp"
+#include "graphics/obj_loader.hpp"
+#include "graphics/static_batch.hpp"
 
 #include <string>
 #include <vector>
@@ -38,7 +40,9 @@ struct GLTFBufferView
 {
     u32 buffer;
     u32 byterLength;
-    u32 byteOffset;
+    u32 byteOffset = 0;
+    /// 0 when elements are tightly packed
+    u32 byteStride = 0;
     u32 target;
 };
 
@@ -59,26 +63,29 @@ struct GLTFAccessor
     Type type;
     u32 count;
     u32 bufferView;
-    u32 byteOffset;
+    u32 byteOffset = 0;
     Vec3 min;
     Vec3 max;
 };
 
 struct GLTFMesh
 {
+    /// Accessor index of a missing attribute or index buffer
+    static constexpr u32 None = static_cast<u32>(-1);
+
     struct Primitive
     {
         struct Attribute
         {
-            u32 normal;
-            u32 position;
-            u32 texcoord_0;
+            u32 normal = None;
+            u32 position = None;
+            u32 texcoord_0 = None;
         };
 
-        u32 material;
-        u32 mode;
+        u32 material = None;
+        u32 mode = 4; // TRIANGLES
         Attribute attributes;
-        u32 indices;
+        u32 indices = None;
     };
 
     std::string name;
@@ -88,11 +95,13 @@ struct GLTFMesh
 struct GLTFNode
 {
     std::string name;
-    Vec3 translation;
-    Quat rotation;
-    Vec3 scale;
+    Vec3 translation = Vec3::ZERO();
+    Quat rotation = Quat(1.0f, 0.0f, 0.0f, 0.0f);
+    Vec3 scale = Vec3::ONE();
     u32 mesh;
     std::vector<u32> children;
+    /// `extras.static`, the node never moves, its children inherit it
+    bool isStatic = false;
 };
 
 class GLTF
@@ -110,8 +119,25 @@ public:
     const std::vector<GLTFBufferView>& BufferViews() const { return m_bufferViews; }
     const std::vector<GLTFAccessor>& Accessors() const { return m_accessors; }
     const std::vector<GLTFMesh>& Meshes() const { return m_meshes; }
+
+    /// Flatten the triangle primitives of every scene into one world space
+    /// triangle list, strips and fans are expanded
+    Mesh ToMesh() const;
+    /// Flatten every scene into world space meshes keeping the primitive modes.
+    /// Primitives of a list mode share one mesh per mode, each strip, fan and
+    /// line loop gets its own. Static nodes are left out without `withStatic`.
+    std::vector<Mesh> ToMeshes(bool withStatic = true) const;
+    /// Add the primitives of static nodes to `batcher` in world space, keyed by material
+    void AddStatic(StaticBatcher& batcher) const;
 private:
+    void AppendNode(std::vector<Mesh>& meshes, u32 nodeIdx, const Mat4& parent, bool withStatic, bool parentStatic) const;
+    void AddStaticNode(StaticBatcher& batcher, u32 nodeIdx, const Mat4& parent, bool parentStatic) const;
+    void AppendPrimitive(std::vector<Mesh>& meshes, const GLTFMesh::Primitive& primitive, const Mat4& transform) const;
+    /// Pointer to element `idx` of `accessor` in the binary chunk and its stride
+    const u8* AccessorData(u32 accessor, u32 idx, u32 elementSize) const;
+
     std::string m_path;
+    std::vector<u8> m_binary;
 
     std::vector<GLTFScene> m_scenes;
     std::vector<GLTFNode> m_nodes;
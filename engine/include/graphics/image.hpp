@@ -6,19 +6,91 @@
 namespace scsr
 {
 
+/// Packed 32-bit pixel layouts, named from the most significant byte
+enum class PixelFormat
+{
+    RGBA8888,   // 0xRRGGBBAA, what `ColorToHex` produces
+    ARGB8888,   // 0xAARRGGBB, also XRGB8888
+    ABGR8888,   // 0xAABBGGRR, also XBGR8888
+    BGRA8888,   // 0xBBGGRRAA
+};
+
+/// Bit offset of each channel inside a packed pixel
+struct PixelLayout
+{
+    u32 r, g, b, a;
+};
+
+constexpr PixelLayout GetPixelLayout(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::ARGB8888: return { 16, 8, 0, 24 };
+    case PixelFormat::ABGR8888: return { 0, 8, 16, 24 };
+    case PixelFormat::BGRA8888: return { 8, 16, 24, 0 };
+    case PixelFormat::RGBA8888:
+    default:                    return { 24, 16, 8, 0 };
+    }
+}
+
+inline u32 PackColor(const Color& color, PixelFormat format)
+{
+    PixelLayout layout = GetPixelLayout(format);
+    u32 r = static_cast<u32>(Clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 g = static_cast<u32>(Clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 b = static_cast<u32>(Clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 a = static_cast<u32>(Clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return (r << layout.r) | (g << layout.g) | (b << layout.b) | (a << layout.a);
+}
+
+/// Pixels [x0, x1) x [y0, y1)
+struct Rect
+{
+    i32 x0 = 0;
+    i32 y0 = 0;
+    i32 x1 = 0;
+    i32 y1 = 0;
+
+    bool Empty() const { return x0 >= x1 || y0 >= y1; }
+    i32 Width() const { return x1 - x0; }
+    i32 Height() const { return y1 - y0; }
+
+    bool operator==(const Rect&) const = default;
+};
+
+inline Rect Union(const Rect& a, const Rect& b)
+{
+    if (a.Empty()) { return b; }
+    if (b.Empty()) { return a; }
+    return { Min(a.x0, b.x0), Min(a.y0, b.y0), Max(a.x1, b.x1), Max(a.y1, b.y1) };
+}
+
+inline Rect Intersect(const Rect& a, const Rect& b)
+{
+    return { Max(a.x0, b.x0), Max(a.y0, b.y0), Min(a.x1, b.x1), Min(a.y1, b.y1) };
+}
+
 struct ImageProp
 {
     i32 width;
     i32 height;
+    PixelFormat format = PixelFormat::RGBA8888;
+    /// Also keep unclamped float colors, the pipeline shades into those
+    /// instead of the packed pixels, see `PostChain`
+    bool hdr = false;
 };
 
 class Image
 {
 public:
     Image(ImageProp prop);
+    /// Render into caller owned pixels, rows must be tightly packed
+    Image(ImageProp prop, u32* pixels);
     ~Image();
 
     void Clear();
+    /// Clear color and depth inside `rect` only
+    void Clear(const Rect& rect);
     void Resize(ImageProp prop);
 
     void SetPixel(i32 x, i32 y, u32 color);
@@ -37,16 +109,25 @@ public:
     void ClearDepth();
 
     u32* Data() { return m_Data; }
+    const u32* Data() const { return m_Data; }
+    f32* DepthData() { return m_DepthBuffer; }
+    const f32* DepthData() const { return m_DepthBuffer; }
+    /// Linear float colors of an `ImageProp::hdr` image, null otherwise
+    Color* HdrData() { return m_HdrData; }
+    const Color* HdrData() const { return m_HdrData; }
     i32 Width() const { return m_Prop.width; }
     i32 Height() const { return m_Prop.height; }
-    void* SurfaceHandle() const { return m_Surface; }
+    PixelFormat Format() const { return m_Prop.format; }
+    const ImageProp& Prop() const { return m_Prop; }
+    Rect Bounds() const { return { 0, 0, m_Prop.width, m_Prop.height }; }
 private:
     void Create();
     void Release();
 
-    u32* m_Data;
-    f32* m_DepthBuffer;
-    void* m_Surface;
+    u32* m_Data = nullptr;
+    f32* m_DepthBuffer = nullptr;
+    Color* m_HdrData = nullptr;
+    bool m_OwnsData = true;
     ImageProp m_Prop;
 };
 
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/blit.hpp"
+
+#include <string>
+
+namespace scsr
+{
+
+/// Write pixels to `path`, binary PPM for a `.ppm` extension and PNG otherwise.
+/// Alpha is dropped for PPM. Returns false when the file cannot be written.
+bool WriteImage(const std::string& path, const PixelView& view);
+
+inline bool WriteImage(const std::string& path, Image& image)
+{
+    return WriteImage(path, MakePixelView(image));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+class Camera;
+
+struct PointLight
+{
+    Vec3 position;
+    /// Distance where the light fades out completely, it is culled beyond
+    f32 radius = 1.0f;
+    Vec3 color = Vec3::ONE();
+    f32 intensity = 1.0f;
+};
+
+/// Smooth falloff reaching exactly zero at `radius`, so culled lights
+/// contribute nothing anyway
+inline f32 LightFalloff(f32 distance, f32 radius)
+{
+    f32 ratio = distance / radius;
+    f32 window = Clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+    return window * window / (distance * distance + 1.0f);
+}
+
+/// Indices of the lights reaching one cluster
+struct LightSpan
+{
+    const u32* indices = nullptr;
+    u32 count = 0;
+
+    const u32* begin() const { return indices; }
+    const u32* end() const { return indices + count; }
+};
+
+/// Point lights of a scene, binned into clusters of screen tiles by depth
+/// slices once per frame so a pixel only visits the lights near it.
+///
+/// `Build` with the camera of the frame before drawing, pixel shaders then
+/// call `Shade`, or `Find` with their view space position and `ViewLight`.
+class LightList
+{
+public:
+    /// Pixels per side of a cluster tile
+    static constexpr i32 TileSize = 32;
+    /// Slices between the near and far plane, exponentially spaced
+    static constexpr i32 DepthSlices = 16;
+    /// Frame capture shader id of draws shaded by `Shade`, their uniforms
+    /// are the `Serialize` bytes, see `FrameCapture::SetShader`
+    static constexpr u32 ShaderId = 1;
+
+    /// Returns the index of the light
+    u32 Add(const PointLight& light);
+    void Clear();
+
+    /// World space lights, edits take effect on the next `Build`
+    std::vector<PointLight>& Lights() { return m_Lights; }
+    const std::vector<PointLight>& Lights() const { return m_Lights; }
+
+    /// Light from the camera along the view direction, not clustered, so
+    /// surfaces no light reaches stay visible
+    void SetFillLight(f32 intensity) { m_FillLight = intensity; }
+    f32 FillLight() const { return m_FillLight; }
+
+    /// Assign the lights to the clusters of a `width` x `height` frame seen by `camera`
+    void Build(const Camera& camera, i32 width, i32 height);
+
+    /// Lights reaching the view space point `viewPos`, a point inside the frustum
+    LightSpan Find(const Vec3& viewPos) const;
+    /// Light `index` with its position in view space, as of the last `Build`
+    const PointLight& ViewLight(u32 index) const { return m_ViewLights[index]; }
+    /// Lambert shading of the view space point `viewPos` with the unit
+    /// `normal` by the fill light and the lights reaching it
+    Vec3 Shade(const Vec3& normal, const Vec3& viewPos) const;
+
+    /// The fill light and the result of the last `Build` as bytes, all
+    /// `Shade` reads, e.g. to replay a frame capture with
+    std::vector<u8> Serialize() const;
+    /// Restore what `Serialize` wrote, false when `data` is not such bytes.
+    /// The world space lights are kept, another `Build` clusters them again.
+    bool Deserialize(const std::vector<u8>& data);
+
+    i32 TilesX() const { return m_TilesX; }
+    i32 TilesY() const { return m_TilesY; }
+    /// Light references over all clusters
+    usize AssignedCount() const;
+private:
+    /// Inclusive cluster ranges touched by a light, empty when `z0 > z1`
+    struct LightBounds
+    {
+        i32 x0, y0, z0;
+        i32 x1, y1, z1;
+    };
+
+    struct ClusterRange
+    {
+        u32 offset;
+        u32 count;
+    };
+
+    LightBounds Bound(const PointLight& light) const;
+    /// Fill the clusters of one tile row in one depth slice
+    void AssignRow(i32 z, i32 y);
+    /// View depth where slice `z` begins
+    f32 SliceDepth(i32 z) const;
+
+    std::vector<PointLight> m_Lights;
+    std::vector<PointLight> m_ViewLights;
+    std::vector<LightBounds> m_Bounds;
+
+    i32 m_Width = 0;
+    i32 m_Height = 0;
+    i32 m_TilesX = 0;
+    i32 m_TilesY = 0;
+    /// Projection scale of x and y, view to NDC at depth 1
+    f32 m_ScaleX = 1.0f;
+    f32 m_ScaleY = 1.0f;
+    f32 m_Near = 0.1f;
+    f32 m_Far = 100.0f;
+    /// `slice = log(depth) * m_SliceScale + m_SliceBias`
+    f32 m_SliceScale = 0.0f;
+    f32 m_SliceBias = 0.0f;
+    f32 m_FillLight = 0.0f;
+
+    std::vector<ClusterRange> m_Clusters;
+    /// Light indices per depth slice and tile row, written by one worker each
+    std::vector<std::vector<u32>> m_RowIndices;
+};
+
+}
\ No newline at end of file
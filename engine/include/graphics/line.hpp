@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/image.hpp"
+
+#include <span>
+
+namespace scsr
+{
+
+/// A segment in screen space, `z` is the depth tested against the image
+struct ScreenLine
+{
+    Vec3 p0;
+    Vec3 p1;
+    /// In the target format
+    u32 color;
+    /// Written instead of `color` to HDR targets, see `Image::HdrData`
+    Color linear;
+};
+
+/// Clip a clip space segment to the view volume the pipeline accepts,
+/// false when nothing is left
+bool ClipLine(Vec4& a, Vec4& b);
+
+/// Clip space to pixel coordinates and NDC depth, same viewport as `Pipeline`
+Vec3 ClipToScreen(const Vec4& clip, i32 width, i32 height);
+
+/// Draw the part of `line` inside `clip`, one horizontal span per row.
+/// A pixel passes when its depth is below the stored one plus `depthBias`.
+/// Disjoint clip rectangles may be drawn concurrently.
+void RasterizeLine(Image& image, const ScreenLine& line, const Rect& clip,
+    bool depthWrite, f32 depthBias = 0.0f);
+/// Same without depth test or write, into the packed pixels only like `Image::SetPixel`
+void RasterizeLine(Image& image, const ScreenLine& line, const Rect& clip);
+
+/// Draw `lines` in row bands across `ThreadPool::Instance()`. Each band
+/// draws the lines crossing it in order, so the image matches drawing them
+/// one after another.
+void RasterizeLines(Image& image, std::span<const ScreenLine> lines, const Rect& clip,
+    bool depthWrite, f32 depthBias = 0.0f);
+
+}
\ No newline at end of file
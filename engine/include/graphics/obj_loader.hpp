@@ -22,6 +22,59 @@ struct Face
 	}
 };
 
+/// How consecutive `Mesh::vertices` form primitives, values match glTF primitive modes
+enum class Topology : u32
+{
+    Points = 0,
+    Lines = 1,
+    /// A line strip closed back to the first vertex
+    LineLoop = 2,
+    LineStrip = 3,
+    Triangles = 4,
+    TriangleStrip = 5,
+    TriangleFan = 6,
+};
+
+/// Primitives formed by `vertexCount` vertices
+inline usize PrimitiveCount(Topology topology, usize vertexCount)
+{
+    switch (topology)
+    {
+    case Topology::Points: return vertexCount;
+    case Topology::Lines: return vertexCount / 2;
+    case Topology::LineLoop: return vertexCount >= 2 ? vertexCount : 0;
+    case Topology::LineStrip: return vertexCount >= 2 ? vertexCount - 1 : 0;
+    case Topology::Triangles: return vertexCount / 3;
+    case Topology::TriangleStrip:
+    case Topology::TriangleFan: return vertexCount >= 3 ? vertexCount - 2 : 0;
+    }
+    return 0;
+}
+
+/// Vertex indices of triangle `t` of a triangle topology. Every other strip
+/// triangle swaps two vertices so all of them keep the winding of the first
+inline void TriangleIndices(Topology topology, usize t, usize out[3])
+{
+    switch (topology)
+    {
+    case Topology::TriangleStrip:
+        out[0] = t;
+        out[1] = t + 1 + t % 2;
+        out[2] = t + 2 - t % 2;
+        break;
+    case Topology::TriangleFan:
+        out[0] = t + 1;
+        out[1] = t + 2;
+        out[2] = 0;
+        break;
+    default:
+        out[0] = t * 3;
+        out[1] = t * 3 + 1;
+        out[2] = t * 3 + 2;
+        break;
+    }
+}
+
 struct Mesh
 {
     Mesh() = default;
@@ -85,6 +138,7 @@ struct Mesh
     }
 
 	std::vector<Vertex> vertices;
+    Topology topology = Topology::Triangles;
     std::vector<Vec3> positions;
 	std::vector<Vec3> normals;
 	std::vector<Vec2> uvs;
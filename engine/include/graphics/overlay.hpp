@@ -0,0 +1,139 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+#include "graphics/sprite.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace scsr
+{
+
+/// Printable ASCII of a TrueType font, rasterized once into a `SpriteAtlas`
+/// so text is drawn as sprites from then on
+class GlyphAtlas
+{
+public:
+    static constexpr char FirstChar = ' ';
+    static constexpr char LastChar = '~';
+    /// Pixels per atlas row
+    static constexpr i32 AtlasWidth = 256;
+
+    struct Glyph
+    {
+        /// Atlas region, ~0u for glyphs without pixels like space
+        u32 region = ~0u;
+        /// Top left of the bitmap relative to the pen on the baseline
+        i32 x0 = 0;
+        i32 y0 = 0;
+        /// Pen movement to the next glyph
+        i32 advance = 0;
+    };
+
+    /// Rasterize the font at `path` with `pixelHeight` from ascent to descent,
+    /// white with coverage as alpha. False when the file is not a font.
+    bool Load(const std::string& path, f32 pixelHeight);
+    bool IsLoaded() const { return m_Atlas != nullptr; }
+
+    /// Characters outside the range show as '?'
+    const Glyph& Get(char c) const;
+    i32 Ascent() const { return m_Ascent; }
+    i32 LineHeight() const { return m_LineHeight; }
+
+    /// Width of `text` on one line in pixels
+    i32 Measure(std::string_view text) const;
+    /// Queue `text` with the top of its line at `y`, returns the pen position after it
+    i32 AddText(SpriteBatch& batch, std::string_view text, i32 x, i32 y, i32 layer = 0) const;
+
+    const Ref<SpriteAtlas>& Atlas() const { return m_Atlas; }
+private:
+    Ref<SpriteAtlas> m_Atlas;
+    std::vector<Glyph> m_Glyphs;
+    i32 m_Ascent = 0;
+    i32 m_LineHeight = 0;
+};
+
+struct OverlayProp
+{
+    /// Top left corner of the panel
+    i32 x = 8;
+    i32 y = 8;
+    /// Frame time graph, one column per frame of history
+    i32 graphHeight = 40;
+    /// Frame time at the top of the graph
+    f64 graphMaxMs = 1000.0 / 30.0;
+    /// Frames within it are green, within twice it yellow, slower red
+    f64 budgetMs = 1000.0 / 60.0;
+};
+
+/// Frame time, named stage times and counters drawn over a finished frame.
+///
+/// Text comes from a `GlyphAtlas` through a `SpriteBatch`, the panel and
+/// the frame time graph are constant color spans blended with `BlendPixels`.
+/// Without a loaded font only the graph is drawn.
+class PerfOverlay
+{
+public:
+    /// Frames in the graph
+    static constexpr usize HistorySize = 120;
+
+    explicit PerfOverlay(Ref<GlyphAtlas> font, const OverlayProp& prop = {});
+
+    /// Record the time spent on a frame, frames per second are measured
+    /// between calls
+    void AddFrame(f64 ms);
+    /// Shown under the frame time until `ClearStats`, setting a name again
+    /// replaces its value
+    void SetTime(std::string_view name, f64 ms);
+    void SetCounter(std::string_view name, u64 value);
+    void ClearStats() { m_Stats.clear(); }
+
+    /// Draw into the packed pixels of `target`
+    void Draw(Image& target);
+    /// What the last `Draw` cost
+    f64 DrawMs() const { return m_DrawMs; }
+    /// Pixels the last `Draw` touched, empty before the first. The panel
+    /// never shrinks, so these cover every panel drawn before as well.
+    /// Safe to call while another thread draws.
+    Rect Bounds() const;
+
+    OverlayProp& Prop() { return m_Prop; }
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stat
+    {
+        std::string name;
+        f64 ms = 0.0;
+        u64 count = 0;
+        bool time = false;
+    };
+
+    Stat& FindStat(std::string_view name);
+    /// Blend one RGBA8888 color over `rect`
+    void Fill(Image& target, const Rect& rect, u32 color);
+
+    Ref<GlyphAtlas> m_Font;
+    Ref<SpriteBatch> m_Batch;
+    OverlayProp m_Prop;
+
+    /// Ring buffer, `m_Frames` counts every frame ever added
+    f64 m_History[HistorySize] = {};
+    usize m_Frames = 0;
+    Clock::time_point m_LastFrame;
+    f64 m_Interval = 0.0;
+
+    std::vector<Stat> m_Stats;
+    std::vector<std::string> m_Lines;
+    /// One row of the fill color in the target format
+    std::vector<u32> m_Span;
+    f64 m_DrawMs = 0.0;
+    Rect m_Bounds;
+    mutable std::mutex m_BoundsMutex;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/blend.hpp"
+#include "graphics/image.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+/// Where new particles start, every value is picked uniformly within
+/// +-spread around it
+struct ParticleEmitter
+{
+    Vec3 position = Vec3::ZERO();
+    Vec3 positionSpread = Vec3::ZERO();
+    Vec3 velocity = Vec3::ZERO();
+    Vec3 velocitySpread = Vec3::ZERO();
+    /// Seconds
+    f32 lifetime = 1.0f;
+    f32 lifetimeSpread = 0.0f;
+    /// RGBA8888, like packed shader output
+    u32 color = 0xFFFFFFFF;
+};
+
+struct ParticleDrawProp
+{
+    /// Edge of the square billboard in world units, at least one pixel is drawn
+    f32 size = 0.02f;
+    BlendMode blend = BlendMode::Additive;
+    /// Hidden behind the depth already in the target, depth is never written
+    bool depthTest = true;
+    /// Alpha goes down with the remaining lifetime
+    bool fade = true;
+};
+
+/// World space box that every particle started by `emitter` stays in while
+/// `ParticleSystem::Update(dt)` moves it under `gravity`, grown by the
+/// billboard `size` so the drawn squares fit too
+void ParticleReach(const ParticleEmitter& emitter, const Vec3& gravity, f32 dt, f32 size, Vec3& min, Vec3& max);
+
+/// Particles as structure of arrays, alive ones first
+struct ParticleArrays
+{
+    std::vector<f32> x, y, z;
+    std::vector<f32> vx, vy, vz;
+    /// Seconds left and one over the lifetime it started with
+    std::vector<f32> life;
+    std::vector<f32> invLifetime;
+    std::vector<u32> color;
+
+    void Resize(usize size);
+};
+
+/// A pool of simple particles under gravity, drawn as screen aligned squares.
+///
+/// Emission, integration and the compaction of dead particles work on eight
+/// particles at once with AVX2, in chunks across `ThreadPool::Instance()`.
+/// Drawing skips the triangle pipeline: particles are projected and binned
+/// into bands of rows, then every band is filled by one job in emission order,
+/// so blending needs no locks and the result does not depend on the threads.
+class ParticleSystem
+{
+public:
+    /// Particles per job
+    static constexpr usize ParticleGrain = 16384;
+    /// Rows per band when drawing
+    static constexpr i32 BandRows = 32;
+
+    explicit ParticleSystem(usize capacity);
+
+    /// Start up to `count` particles, fewer when the pool is full.
+    /// Returns how many were started.
+    usize Emit(const ParticleEmitter& emitter, usize count);
+    /// Move particles by `dt` seconds and drop the ones that died
+    void Update(f32 dt);
+    void Clear() { m_Count = 0; }
+
+    void SetGravity(const Vec3& gravity) { m_Gravity = gravity; }
+    const Vec3& GetGravity() const { return m_Gravity; }
+
+    usize Count() const { return m_Count; }
+    usize Capacity() const { return m_Capacity; }
+    /// The first `Count` entries are alive
+    const ParticleArrays& Particles() const { return m_Particles; }
+
+    /// Blend the particles into `target`, HDR targets through `HdrData`.
+    /// Returns how many were on screen.
+    usize Draw(Image& target, const Mat4& view, const Mat4& projection, const ParticleDrawProp& prop = {});
+private:
+    /// Pixels covered by a particle and its color in target format
+    struct Billboard
+    {
+        i16 x0, y0, x1, y1;
+        f32 depth;
+        u32 color;
+    };
+
+    void DrawBand(Image& target, i32 band, usize chunks, const ParticleDrawProp& prop) const;
+
+    ParticleArrays m_Particles;
+    /// Survivors are packed here, then swapped with `m_Particles`
+    ParticleArrays m_Scratch;
+    usize m_Count = 0;
+    usize m_Capacity = 0;
+    Vec3 m_Gravity = Vec3(0.0f, -9.81f, 0.0f);
+    u32 m_Seed = 0x9E3779B9u;
+
+    /// Alive particles per chunk, filled by `Update`
+    std::vector<usize> m_ChunkAlive;
+    /// Billboards per chunk and band, chunk major
+    std::vector<std::vector<Billboard>> m_Bins;
+};
+
+}
\ No newline at end of file
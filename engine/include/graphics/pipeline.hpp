@@ -6,6 +6,10 @@
 #include "graphics/obj_loader.hpp"
 #include "graphics/vertex.hpp"
 #include "graphics/camera.hpp"
+#include "graphics/shader.hpp"
+#include "graphics/blend.hpp"
+#include "graphics/line.hpp"
+#include "graphics/shading_rate.hpp"
 
 #include <functional>
 #include <span>
@@ -14,10 +18,52 @@
 namespace scsr
 {
 
+class FrameCapture;
+
+/// Geometry stage output of one range of triangles, see `DrawBuffer`
+struct GeometryChunk
+{
+    std::vector<Plane> planes;
+    std::vector<f32> depths;
+    std::vector<Trapezoid> trapezoids;
+    std::vector<SmallTriangle> smallTriangles;
+    std::vector<ScreenLine> lines;
+    usize kept = 0;
+
+    void Clear()
+    {
+        planes.clear();
+        depths.clear();
+        trapezoids.clear();
+        smallTriangles.clear();
+        lines.clear();
+        kept = 0;
+    }
+};
+
 struct DrawBuffer
 {
     std::vector<Vertex> vertices;
+    /// Vertex shader outputs, one per vertex
+    std::vector<Varyings> varyings;
+    /// Strips, fans, lines and points shade each vertex once up front,
+    /// set for vertices inside the view volume
+    std::vector<u8> visible;
+    /// Three shaded vertices per triangle of a strip or fan, trapezoids point into them
+    std::vector<Vertex> assembled;
+    std::vector<Varyings> assembledVaryings;
+    /// Per triangle depth, 1/w and varying/w planes, see `Pipeline::PlaneStride`
+    std::vector<Plane> planes;
+    /// Per triangle mean depth, orders blended triangles
+    std::vector<f32> depths;
     std::vector<Trapezoid> trapezoids;
+    /// Triangles of at most `SmallTriangle::MaxSize` pixels across, drawn
+    /// after the trapezoids, only for opaque draws writing depth
+    std::vector<SmallTriangle> smallTriangles;
+    /// Line and point primitives, and triangle edges in wireframe mode
+    std::vector<ScreenLine> lines;
+    /// Filled by the workers of the geometry stage, merged above in submission order
+    std::vector<GeometryChunk> chunks;
 };
 
 enum class FaceCullMode
@@ -29,42 +75,150 @@ enum class FaceCullMode
 
 struct PipelineState {
     FaceCullMode cullMode = FaceCullMode::CCW;
+    /// Encode shaded colors to sRGB when packing, packed shader output is kept as is
+    bool srgb = false;
+    /// Non opaque modes draw the triangles of each call back to front,
+    /// separate calls are not reordered and should be submitted far to near
+    BlendMode blend = BlendMode::Opaque;
+    bool depthWrite = true;
+    /// Draw triangle edges in `wireframeColor` instead of shading them
+    bool wireframe = false;
+    Color wireframeColor = Color(1.0f, 1.0f, 1.0f, 1.0f);
+    /// Coarse shading for the whole draw, combined with the rate image by taking the coarser
+    ShadingRate shadingRate = ShadingRate::Rate1x1;
+    /// Only pixels inside `scissor` are touched, e.g. to redraw a damaged region
+    bool scissorTest = false;
+    Rect scissor;
+};
+
+/// Counters and stage times in milliseconds, accumulated by `Perform` until `ResetStats`
+struct PipelineStats
+{
+    usize drawCalls = 0;
+    /// Triangles of any triangle topology, lines and points are not counted
+    usize triangles = 0;
+    /// Triangles left after clipping and face culling
+    usize trianglesKept = 0;
+    usize trapezoids = 0;
+    /// Triangles drawn without trapezoids, see `SmallTriangle`
+    usize smallTriangles = 0;
+    /// Pixel shader invocations
+    usize pixels = 0;
+    /// Pixels written, more than `pixels` with coarse shading
+    usize pixelsCovered = 0;
+
+    f64 bufferTime = 0.0;
+    f64 vertexTime = 0.0;
+    f64 pixelTime = 0.0;
 };
 
 enum class PrimitiveResult
 {
     Discard,
-    Keep,
-    Split
+    Keep
 };
 
-using VertexChanging = std::function<Vec4(Vertex&)>;
-using PixelShading =  std::function<Vec4(Vertex&)>;
-
 class Pipeline
 {
 public:
     Pipeline();
 
     void SetCamera(Ref<Camera>& camera) { m_Camera = camera; }
-    void SetVertexChanging(VertexChanging changing) { m_VertexChanging = changing; }
-    void SetFragmentShading(PixelShading shading) { m_PixelShading = shading; }
 
-    void Perform(Ref<Image> image, Mesh& mesh);
+    /// Bind a shader pair, only its declared varyings are interpolated
+    template <typename V>
+    void SetShader(const Shader<V>& shader)
+    {
+        m_VertexShader = shader.EraseVertex();
+        m_PixelShader = shader.ErasePixel();
+        m_PackedPixelShader = shader.ErasePacked();
+        m_VaryingCount = Shader<V>::VaryingCount;
+    }
+
+    /// Per tile shading rates, must match the size of the target image, null disables
+    void SetShadingRateImage(Ref<ShadingRateImage> rates) { m_ShadingRateImage = rates; }
+
+    /// Record every draw while the capture is recording, null disables
+    void SetCapture(Ref<FrameCapture> capture) { m_Capture = capture; }
+    /// One counter per pixel of the target, incremented by every triangle
+    /// pixel written. Ignored for targets of another size, null disables.
+    void SetOverdrawCounts(std::vector<u32>* counts) { m_OverdrawCounts = counts; }
+
+    /// Primitives per geometry stage job, the image does not depend on it
+    void SetGeometryGrain(usize grain) { m_GeometryGrain = Max<usize>(grain, 1); }
+
+    void SetState(const PipelineState& state) { m_State = state; }
+    const PipelineState& GetState() const { return m_State; }
+
+    void Perform(Ref<Image> image, const Mesh& mesh);
+
+    const PipelineStats& GetStats() const { return m_Stats; }
+    void ResetStats() { m_Stats = {}; }
 private:
-    PrimitiveResult PrimitiveGeneration(Ref<Image> image, std::span<Vertex> vtxs);
-    void PrimitiveAssembly(std::span<Vertex> vtxs);
-    void Rasterize(Ref<Image> image, const Trapezoid& trap) const;
+    /// Called concurrently for separate chunks, the shaders must be safe to share
+    PrimitiveResult PrimitiveGeneration(const Image& image, std::span<Vertex> vtxs, std::span<Varyings> varyings,
+        GeometryChunk& out) const;
+    /// Homogeneous culling, perspective divide and viewport of a shaded vertex,
+    /// false when it is outside the view volume
+    bool ProjectVertex(const Image& image, Vertex& vtx) const;
+    /// Face culling and assembly of a projected triangle
+    PrimitiveResult PrimitiveSetup(std::span<Vertex> vtxs, std::span<Varyings> varyings, GeometryChunk& out) const;
+    /// Triangles from 3 vertices, lines from 2 and points from 1, in screen space
+    void PrimitiveAssembly(std::span<Vertex> vtxs, std::span<Varyings> varyings, GeometryChunk& out) const;
+    /// Run the vertex shader once per draw buffer vertex, projected unless drawing lines
+    void ShadeVertices(const Image& image, bool project);
+    /// Call `fn(chunk, first, last)` for ranges of `count` primitives in
+    /// parallel, returns the number of chunks used
+    template <typename ChunkFn>
+    usize ForEachChunk(usize count, ChunkFn&& fn);
+    /// Lines and points take the color of their first vertex
+    void ShadeFlat(const Varyings& varyings, ScreenLine& line) const;
+    /// Concatenate the first `count` chunks into the draw buffer
+    void MergeGeometry(usize count);
+    void Rasterize(Image& image, const Trapezoid& trap);
+    void Rasterize(Image& image, const SmallTriangle& tri);
+    /// Shade and store the pixels of `primitive` in rows [top, bottom), `span(y)`
+    /// gives the covered pixels [begin, end) of row y
+    template <typename SpanFn>
+    void ShadeSpans(Image& image, u32 primitive, i32 top, i32 bottom, SpanFn&& span);
+    /// Pack a batch of shaded pixels of row `y` and store them
+    void FlushPixels(Image& image, i32 y, const i32* xs, const Color* colors, u32* packed, usize count) const;
+
+    /// Planes per triangle: depth, 1/w, then one per varying
+    usize PlaneStride() const { return m_VaryingCount + 2; }
 
-    // void DrawScanline(Ref<Image> image, const Trapezoid& trap) const;
-    
     Ref<Camera> m_Camera;
-    VertexChanging m_VertexChanging;
-    PixelShading m_PixelShading;
+    VertexShader m_VertexShader;
+    PixelShader m_PixelShader;
+    PackedPixelShader m_PackedPixelShader;
+    usize m_VaryingCount = 0;
+    usize m_GeometryGrain = 1024;
+    /// `PipelineState::wireframeColor` in the target format
+    u32 m_WireframeColor = 0;
+    PixelFormat m_TargetFormat = PixelFormat::RGBA8888;
+    bool m_TargetHdr = false;
 
     DrawBuffer m_DrawBuffer;
 
+    /// Shaded blocks of the current block row for 2x2 and 4x4 rates,
+    /// entries are valid while their stamp matches
+    struct BlockCache
+    {
+        std::vector<u32> stamps;
+        std::vector<Color> colors;
+        std::vector<u32> packed;
+        u32 stamp = 0;
+        i32 row = -1;
+    };
+    BlockCache m_BlockCaches[2];
+    Ref<ShadingRateImage> m_ShadingRateImage;
+    Ref<FrameCapture> m_Capture;
+    std::vector<u32>* m_OverdrawCounts = nullptr;
+    /// `m_OverdrawCounts` when it fits the current target
+    u32* m_Overdraw = nullptr;
+
     PipelineState m_State;
+    PipelineStats m_Stats;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/image.hpp"
+
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace scsr
+{
+
+/// A colored point, also the record of a point cloud file
+struct CloudPoint
+{
+    Vec3 position;
+    /// RGBA8888, like packed shader output
+    u32 color;
+};
+
+/// Start of a point cloud file, followed by `count` tightly packed `CloudPoint`s
+struct PointCloudHeader
+{
+    static constexpr u32 Magic = 0x43505353; // "SSPC"
+    static constexpr u32 Version = 1;
+
+    u32 magic = Magic;
+    u32 version = Version;
+    u64 count = 0;
+};
+
+/// Write `points` in the format `PointCloudReader` reads
+bool WritePointCloud(const std::string& path, std::span<const CloudPoint> points);
+
+/// Reads a point cloud file in chunks so it never has to fit in memory
+class PointCloudReader
+{
+public:
+    explicit PointCloudReader(const std::string& path);
+
+    /// False when the file is missing or not a point cloud
+    bool IsOpen() const { return m_Open; }
+    u64 Count() const { return m_Header.count; }
+
+    /// Replace `out` with up to `maxPoints` of the next points, false once all were read
+    bool Read(std::vector<CloudPoint>& out, usize maxPoints);
+    /// Start over from the first point
+    void Rewind();
+private:
+    std::ifstream m_File;
+    PointCloudHeader m_Header;
+    u64 m_Next = 0;
+    bool m_Open = false;
+};
+
+/// Draws points straight into a frame, bypassing the triangle pipeline.
+///
+/// Every pixel holds depth and color packed in 64 bits, depth in the high
+/// half, so a depth tested write is one atomic minimum and all cores splat
+/// into the same frame without locks. Points are projected eight at a time
+/// with AVX2. Call `Begin`, any number of `Splat`s, then `Resolve`.
+class PointSplatter
+{
+public:
+    /// Points per job of `Splat`
+    static constexpr usize PointGrain = 16384;
+    /// Points read per chunk by `SplatFile`
+    static constexpr usize StreamChunk = 1 << 20;
+
+    /// Start a frame over `target`, points behind its depth are hidden
+    void Begin(const Image& target);
+    /// Splat points transformed by `viewProjection` as disks of `radius`
+    /// pixels, 0 for single pixels. Returns the points inside the view.
+    usize Splat(std::span<const CloudPoint> points, const Mat4& viewProjection, i32 radius = 0);
+    /// Splat a whole file, a pool job reads the next chunk while the current one is drawn
+    usize SplatFile(PointCloudReader& reader, const Mat4& viewProjection, i32 radius = 0);
+    /// Write the splatted colors and depths into the image given to `Begin`
+    void Resolve(Image& target) const;
+private:
+    /// Depth ordered like its packed value, see `DepthKey`
+    std::vector<u64> m_Buffer;
+    i32 m_Width = 0;
+    i32 m_Height = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+enum class ToneMapper
+{
+    /// c / (1 + c)
+    Reinhard,
+    /// Filmic fit of the ACES reference curve
+    Aces,
+};
+
+struct PostProp
+{
+    f32 exposure = 1.0f;
+    ToneMapper toneMapper = ToneMapper::Aces;
+    /// Glow around colors brighter than `bloomThreshold`, blurred at half resolution
+    bool bloom = true;
+    f32 bloomThreshold = 1.0f;
+    f32 bloomIntensity = 0.3f;
+    /// Blur radius in half resolution pixels
+    i32 bloomRadius = 6;
+    bool fxaa = true;
+    /// Encode the result as sRGB, see `PackColors`
+    bool srgb = false;
+};
+
+/// Turns the float colors of an HDR image into displayable pixels: bloom,
+/// tone mapping and FXAA. Every stage is a full screen pass over SIMD spans,
+/// split into row bands across `ThreadPool::Instance()`.
+class PostChain
+{
+public:
+    PostChain(PostProp prop = {});
+
+    void SetProp(const PostProp& prop);
+    const PostProp& GetProp() const { return m_Prop; }
+
+    /// Read `HdrData` of `hdr` and write the packed pixels of `out`, sizes
+    /// must match. Both may be the same image.
+    void Process(const Image& hdr, Image& out);
+private:
+    /// Downsample to half resolution keeping what is above the threshold
+    void BrightPass(const Image& hdr);
+    /// Separable gaussian over the bright pass, in place
+    void Blur();
+    /// Add the bloom, expose and map into `m_Mapped` and `m_Luma`, or
+    /// straight into `out` without FXAA
+    void ToneMap(const Image& hdr, Image& out);
+    void Fxaa(Image& out);
+
+    PostProp m_Prop;
+    std::vector<f32> m_Weights;
+
+    i32 m_HalfWidth = 0;
+    i32 m_HalfHeight = 0;
+    std::vector<Color> m_Bloom;
+    std::vector<Color> m_BloomScratch;
+
+    std::vector<Color> m_Mapped;
+    /// One column of padding on each side, clamped to the edge pixel
+    std::vector<f32> m_Luma;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/bvh.hpp"
+#include "graphics/image.hpp"
+
+namespace scsr
+{
+
+class Camera;
+
+/// Ray from the near to the far plane through pixel position (x, y), so
+/// hits in front of the far plane have t in [0, 1].
+/// `inverseViewProjection` is `Inverse(projection * view)`.
+Ray ScreenRay(const Mat4& inverseViewProjection, f32 x, f32 y, i32 width, i32 height);
+
+struct RayTraceProp
+{
+    /// Direction the light travels in, world space
+    Vec3 lightDirection = Vec3(-0.4f, -1.0f, -0.6f);
+    Vec3 lightColor = Vec3::ONE();
+    Vec3 ambient = Vec3(0.1f, 0.1f, 0.12f);
+    Vec3 albedo = Vec3(0.8f, 0.8f, 0.8f);
+    Color background = Color(0.0f, 0.0f, 0.0f, 1.0f);
+    /// Cast a shadow ray per lit pixel
+    bool shadows = true;
+};
+
+/// Renders a `Bvh` with primary and shadow rays instead of rasterizing,
+/// for reference images and scenes where exact shadows matter.
+///
+/// The region is cut into tiles spread over `ThreadPool::Instance()`, every
+/// row of a tile casts packets of eight rays. Pixels get Lambert shading
+/// from one directional light and the NDC depth of their hit, like the
+/// pipeline would write.
+class RayTracer
+{
+public:
+    static constexpr i32 TileSize = 16;
+
+    RayTraceProp& Prop() { return m_Prop; }
+    const RayTraceProp& Prop() const { return m_Prop; }
+
+    /// Trace the pixels of `region` in `target`, HDR targets through
+    /// `HdrData`. Returns how many primary rays hit.
+    usize Render(const Bvh& bvh, const Camera& camera, Image& target, const Rect& region);
+private:
+    RayTraceProp m_Prop;
+};
+
+}
\ No newline at end of file
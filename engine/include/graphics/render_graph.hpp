@@ -0,0 +1,117 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace scsr
+{
+
+/// Handle of an image in a `RenderGraph`, valid until the next `Reset`
+struct RenderResource
+{
+    u32 index = ~0u;
+
+    bool Valid() const { return index != ~0u; }
+};
+
+class RenderGraph;
+
+struct RenderPassProp
+{
+    std::string name;
+    std::vector<RenderResource> reads;
+    std::vector<RenderResource> writes;
+    /// Kept even when nothing reads what it writes
+    bool sideEffects = false;
+};
+
+/// A frame described as passes over images, built anew every frame.
+///
+/// Passes run in declaration order per resource: a pass sees what earlier
+/// passes wrote to the images it reads. Passes whose results are never used
+/// are culled, passes without a dependency between them run in parallel on
+/// the thread pool, and transient images whose lifetimes do not overlap share
+/// one allocation. Parallel passes must not share other state, such as a
+/// `Pipeline`.
+class RenderGraph
+{
+public:
+    using PassFn = std::function<void(const RenderGraph&)>;
+
+    /// An image owned outside the graph, e.g. the swapchain image.
+    /// Passes writing it are always kept.
+    RenderResource Import(const std::string& name, Ref<Image> image);
+    /// An image living for this frame only. Its contents are undefined
+    /// until a pass writes it, the first writer must clear it.
+    RenderResource CreateTransient(const std::string& name, const ImageProp& prop);
+
+    void AddPass(RenderPassProp prop, PassFn fn);
+
+    /// Cull, order and allocate, done by `Execute` when needed
+    void Compile();
+    void Execute();
+    /// Drop passes and resources, pooled transient images are kept for reuse
+    void Reset();
+
+    /// The image behind `resource`, valid while executing
+    Ref<Image> Get(RenderResource resource) const;
+
+    /// Pass indices in execution order, culled passes left out
+    const std::vector<u32>& Order() const { return m_Order; }
+    bool IsCulled(u32 pass) const { return m_Passes[pass].culled; }
+    /// Passes with the same level run in parallel
+    u32 Level(u32 pass) const { return m_Passes[pass].level; }
+    const std::string& PassName(u32 pass) const { return m_Passes[pass].prop.name; }
+    /// Milliseconds the pass took in the last `Execute`
+    f64 PassTime(u32 pass) const { return m_Passes[pass].time; }
+    /// Pooled images backing the transients
+    usize PooledImageCount() const { return m_Pool.size(); }
+private:
+    struct Resource
+    {
+        std::string name;
+        ImageProp prop;
+        Ref<Image> image;
+        bool imported = false;
+        /// Levels of the first and last pass using it
+        u32 firstLevel = ~0u;
+        u32 lastLevel = 0;
+    };
+
+    struct Pass
+    {
+        RenderPassProp prop;
+        PassFn fn;
+        std::vector<u32> dependencies;
+        bool culled = false;
+        u32 level = 0;
+        f64 time = 0.0;
+    };
+
+    struct PooledImage
+    {
+        Ref<Image> image;
+        /// Level after which it is free again in the frame being compiled
+        u32 busyUntil = 0;
+        bool used = false;
+        /// Frames since it last backed a transient
+        usize idleFrames = 0;
+    };
+
+    void Cull();
+    void Schedule();
+    void Allocate();
+
+    std::vector<Resource> m_Resources;
+    std::vector<Pass> m_Passes;
+    std::vector<u32> m_Order;
+    bool m_Compiled = false;
+
+    std::vector<PooledImage> m_Pool;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/vertex.hpp"
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+namespace scsr
+{
+
+/// Most floats a shader may pass from the vertex to the pixel stage
+static constexpr usize MaxVaryings = 16;
+
+/// Vertex shader outputs, interpolated perspective-correctly for the pixel shader.
+/// Only the first `count` floats declared by the bound shader are valid.
+struct Varyings
+{
+    f32 data[MaxVaryings];
+};
+
+/// Returns the clip space position and writes the varyings of one vertex
+using VertexShader = std::function<Vec4(const Vertex&, Varyings&)>;
+using PixelShader = std::function<Vec4(const Varyings&)>;
+/// Pixel shader returning an already packed `PixelFormat::RGBA8888` color
+using PackedPixelShader = std::function<u32(const Varyings&)>;
+
+/// A shader pair passing `V` between stages, `V` is a plain struct of floats
+/// such as `struct { Vec3 normal; Vec2 uv; }` and sets how many floats the
+/// raster stage interpolates.
+template <typename V>
+struct Shader
+{
+    static_assert(std::is_trivially_copyable_v<V>, "Varyings must be trivially copyable");
+    static_assert(sizeof(V) % sizeof(f32) == 0, "Varyings must be made of floats");
+    static_assert(sizeof(V) <= sizeof(Varyings), "Too many varyings, see MaxVaryings");
+
+    static constexpr usize VaryingCount = sizeof(V) / sizeof(f32);
+
+    std::function<Vec4(const Vertex&, V&)> vertex;
+    std::function<Vec4(const V&)> pixel;
+    /// Optional, used instead of `pixel` when set
+    std::function<u32(const V&)> packed;
+
+    VertexShader EraseVertex() const
+    {
+        return [vertex = vertex](const Vertex& vtx, Varyings& out) {
+            V varyings;
+            Vec4 position = vertex(vtx, varyings);
+            std::memcpy(out.data, &varyings, sizeof(V));
+            return position;
+        };
+    }
+
+    PixelShader ErasePixel() const
+    {
+        return [pixel = pixel](const Varyings& in) {
+            V varyings;
+            std::memcpy(&varyings, in.data, sizeof(V));
+            return pixel(varyings);
+        };
+    }
+
+    PackedPixelShader ErasePacked() const
+    {
+        if (!packed) { return nullptr; }
+        return [packed = packed](const Varyings& in) {
+            V varyings;
+            std::memcpy(&varyings, in.data, sizeof(V));
+            return packed(varyings);
+        };
+    }
+};
+
+/// Shader without varyings, e.g. flat colored geometry
+struct NoVaryings {};
+
+template <>
+struct Shader<NoVaryings>
+{
+    static constexpr usize VaryingCount = 0;
+
+    std::function<Vec4(const Vertex&)> vertex;
+    std::function<Vec4()> pixel;
+    std::function<u32()> packed;
+
+    VertexShader EraseVertex() const
+    {
+        return [vertex = vertex](const Vertex& vtx, Varyings&) { return vertex(vtx); };
+    }
+
+    PixelShader ErasePixel() const
+    {
+        return [pixel = pixel](const Varyings&) { return pixel(); };
+    }
+
+    PackedPixelShader ErasePacked() const
+    {
+        if (!packed) { return nullptr; }
+        return [packed = packed](const Varyings&) { return packed(); };
+    }
+};
+
+}
\ No newline at end of file
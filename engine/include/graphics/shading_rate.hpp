@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "graphics/image.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+/// Pixels per side of a block sharing one pixel shader invocation
+enum class ShadingRate : u8
+{
+    Rate1x1 = 1,
+    Rate2x2 = 2,
+    Rate4x4 = 4,
+};
+
+/// The coarser of two rates
+inline ShadingRate CombineRates(ShadingRate a, ShadingRate b)
+{
+    return static_cast<u8>(a) > static_cast<u8>(b) ? a : b;
+}
+
+/// Shading rate per screen tile, covering an image of a given size
+class ShadingRateImage
+{
+public:
+    /// Pixels per side of a tile, a multiple of every block size
+    static constexpr i32 TileSize = 16;
+
+    ShadingRateImage(i32 width, i32 height);
+
+    void Resize(i32 width, i32 height);
+    void Fill(ShadingRate rate);
+    void SetTile(i32 tileX, i32 tileY, ShadingRate rate);
+
+    /// Rate by distance, tiles whose nearest depth is beyond `depth2x2` or
+    /// `depth4x4` are shaded coarsely. Use the depth of the previous frame.
+    void FromDepth(const Image& image, f32 depth2x2, f32 depth4x4);
+
+    ShadingRate At(i32 x, i32 y) const { return m_Rates[static_cast<usize>(y / TileSize) * m_TilesX + x / TileSize]; }
+    /// Tiles of the tile row holding pixel row `y`
+    const ShadingRate* Row(i32 y) const { return m_Rates.data() + static_cast<usize>(y / TileSize) * m_TilesX; }
+
+    i32 Width() const { return m_Width; }
+    i32 Height() const { return m_Height; }
+    i32 TilesX() const { return m_TilesX; }
+    i32 TilesY() const { return m_TilesY; }
+private:
+    i32 m_Width = 0;
+    i32 m_Height = 0;
+    i32 m_TilesX = 0;
+    i32 m_TilesY = 0;
+    std::vector<ShadingRate> m_Rates;
+};
+
+}
\ No newline at end of file
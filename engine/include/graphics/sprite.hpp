@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/blend.hpp"
+#include "graphics/blit.hpp"
+#include "graphics/image.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+/// Rectangles of one image that sprites are cut from
+class SpriteAtlas
+{
+public:
+    explicit SpriteAtlas(Ref<Image> image);
+
+    /// Returns the id sprites refer to `rect` by, clipped to the image
+    u32 AddRegion(const Rect& rect);
+    const Rect& Region(u32 id) const { return m_Regions[id]; }
+    usize RegionCount() const { return m_Regions.size(); }
+
+    const Image& GetImage() const { return *m_Image; }
+private:
+    Ref<Image> m_Image;
+    std::vector<Rect> m_Regions;
+};
+
+struct Sprite
+{
+    /// Region of the atlas
+    u32 region = 0;
+    /// Top left corner on the target in pixels
+    Vec2 position = Vec2::ZERO();
+    /// Size on the target in pixels, zero keeps the size of the region
+    Vec2 size = Vec2::ZERO();
+    /// Higher layers cover lower ones, equal layers keep the order they were added in
+    i32 layer = 0;
+    BlitFilter filter = BlitFilter::Nearest;
+    BlendMode blend = BlendMode::Alpha;
+};
+
+/// Draws 2D sprites straight into the pixels of an image, for HUDs and
+/// other screen space content that needs no perspective.
+///
+/// Sprites are collected over a frame and drawn by `Flush`, sorted by
+/// layer. Every sprite is an axis aligned rectangle, so each row is one
+/// span sampled from the atlas with AVX2 gathers, or copied when unscaled,
+/// then blended with `BlendPixels`. Rows are split into bands across
+/// `ThreadPool::Instance()`, a band draws all its sprites in order.
+class SpriteBatch
+{
+public:
+    /// Rows per band
+    static constexpr i32 BandRows = 32;
+
+    explicit SpriteBatch(Ref<SpriteAtlas> atlas);
+
+    void Add(const Sprite& sprite);
+    usize Count() const { return m_Sprites.size(); }
+
+    /// Draw the sprites added since the last flush into the packed pixels
+    /// of `target`, then forget them
+    void Flush(Image& target);
+private:
+    /// A sprite mapped to the target: covered pixels and where their
+    /// centers fall in the region, in region pixels
+    struct Placement
+    {
+        Rect target;
+        Rect source;
+        f32 u0, du;
+        f32 v0, dv;
+        /// Unscaled and aligned to pixels, rows are copied from the atlas
+        bool copy;
+        BlitFilter filter;
+        BlendMode blend;
+    };
+
+    void DrawBand(Image& target, i32 band) const;
+
+    Ref<SpriteAtlas> m_Atlas;
+    std::vector<Sprite> m_Sprites;
+    std::vector<Placement> m_Placements;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/type.hpp"
+#include "core/math/math.hpp"
+#include "graphics/obj_loader.hpp"
+
+#include <vector>
+
+namespace scsr
+{
+
+/// World space geometry of static meshes sharing a key, drawn with one `Perform`
+struct StaticBatch
+{
+    /// Key the meshes were added with, e.g. a material or pipeline state
+    u32 key = 0;
+    /// Triangles, lines or points, strips and fans are expanded
+    Mesh mesh;
+    /// World space bounds of the vertices
+    Vec3 min;
+    Vec3 max;
+};
+
+/// Merges meshes that never move into a few large draws at load time.
+///
+/// Meshes are transformed into world space once and concatenated per key and
+/// list topology, a batch is cut before it grows past `MaxBatchVertices` so
+/// its bounds stay useful for culling. Batches are rebuilt only by `Update`
+/// after meshes were added or removed.
+class StaticBatcher
+{
+public:
+    using Handle = u32;
+    /// Batches grow up to this many vertices, a larger mesh gets its own
+    static constexpr usize MaxBatchVertices = 3 * 16384;
+
+    Handle Add(Mesh mesh, const Mat4& transform, u32 key = 0);
+    void Remove(Handle handle);
+    void Clear();
+
+    /// Rebuild the batches if the static set changed, true when it did
+    bool Update();
+    /// As of the last `Update`
+    const std::vector<StaticBatch>& Batches() const { return m_Batches; }
+    /// Meshes in the static set
+    usize MeshCount() const { return m_Count; }
+private:
+    struct Entry
+    {
+        Mesh mesh;
+        Mat4 transform;
+        u32 key = 0;
+        bool alive = false;
+    };
+
+    /// Where the vertices of an entry go
+    struct Placement
+    {
+        u32 entry;
+        u32 batch;
+        usize offset;
+        usize count;
+    };
+
+    std::vector<Entry> m_Entries;
+    /// Slots of removed entries, reused by `Add`
+    std::vector<Handle> m_Free;
+    usize m_Count = 0;
+    bool m_Dirty = false;
+
+    std::vector<StaticBatch> m_Batches;
+};
+
+}
\ No newline at end of file
@@ -3,30 +3,117 @@
 #include "image.hpp"
 #include "window.hpp"
 
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <functional>
+#include <condition_variable>
 
 namespace scsr
 {
 
+/// A ring of images shared by a render thread and the presenting thread.
+///
+/// With more than one image, write commands run on a dedicated render
+/// thread so frame N+1 is written while frame N is being presented.
+/// `maxFramesInFlight` bounds how many frames may be queued or written
+/// ahead of the presented one, which bounds latency. It is limited to
+/// `count - 2`, so pipelining needs at least three images.
 class Swapchain
 {
     PIN(Swapchain)
     SIG(Swapchain)
 public:
-    using WriteCommand = std::function<void(Ref<Image>)>;
+    /// Runs on the render thread, writes the acquired image
+    using WriteCommand = std::function<void(Ref<Image>, usize)>;
+    /// Runs on the thread calling `AcquireAndWrite`, before the frame is handed
+    /// to the render thread. Use it to snapshot state into per-image slots.
+    using UpdateCommand = std::function<void(usize)>;
 
-    Swapchain(ImageProp prop, usize count);
+    Swapchain(ImageProp prop, usize count, usize maxFramesInFlight = 1);
+    ~Swapchain();
 
     void PushWriteCommand(WriteCommand command);
+    void PushUpdateCommand(UpdateCommand command);
 
+    /// Acquire a free image and queue it for writing.
+    /// Blocks while `maxFramesInFlight` frames are already queued or being written.
     void AcquireAndWrite();
+    /// Present the latest written image and release the previously presented one.
+    /// Keeps the previous image on screen if no new frame finished yet.
     void Present(Window& window);
+    /// Show the last presented image again, e.g. after the window was exposed.
+    /// False when there is none or it was lost with the window surface.
+    bool Represent(Window& window);
+    /// No frame is being written or waiting to be presented
+    bool IsIdle();
+    /// Block until every queued frame has been written
+    void WaitIdle();
+    /// Without a render thread, write straight into the surface of `window`
+    /// whenever it matches the image size, presenting is then only a flip.
+    /// Pipelined swapchains always copy: the surface is what the window
+    /// shows, a render thread would overwrite it while it is presented.
+    void BindWindow(Window& window) { m_Window = &window; }
+
+    /// Images take `prop` the next time they are acquired, frames already
+    /// written keep their size and are scaled when presented
+    void Resize(ImageProp prop);
+    ImageProp GetImageProp();
+    /// Frames since the image at `index` was last written: 1 when it holds the
+    /// previous frame, 0 when its content is unknown. Valid from acquiring the
+    /// image until it is written, i.e. in update and write commands.
+    usize ImageAge(usize index) const { return m_Ages[index]; }
+
+    usize ImageCount() const { return m_Images.size(); }
+    usize MaxFramesInFlight() const { return m_MaxFramesInFlight; }
 private:
-    std::vector<Ref<Image>> m_FrontBuffer;
-    std::vector<Ref<Image>> m_BackBuffer;
+    enum class ImageState
+    {
+        Free,
+        Writing,
+        Ready,
+        Presenting,
+    };
+
+    static constexpr usize InvalidIndex = static_cast<usize>(-1);
+
+    void Write(Ref<Image> image, usize index);
+    /// Apply `m_Prop` to a free image, true when it was resized
+    bool ResizeImage(usize index);
+    /// Record that the image at `index` is written as the next frame
+    void MarkAcquired(usize index, bool invalidated);
+    void RenderLoop();
 
+    std::vector<Ref<Image>> m_Images;
+    /// Size of newly acquired images, guarded by `m_Mutex`
+    ImageProp m_Prop;
+    std::vector<ImageState> m_States;
+    /// Image written last without a render thread, may alias a window surface
+    Ref<Image> m_SerialTarget;
+    /// Written since the last serial present
+    bool m_SerialPending = false;
+
+    /// Frame number each image was last written in, 0 for never
+    std::vector<usize> m_Written;
+    std::vector<usize> m_Ages;
+    usize m_Frame = 1;
+    Window* m_Window = nullptr;
+
+    std::deque<usize> m_PendingQueue;
+    std::deque<usize> m_ReadyQueue;
+    usize m_Presenting = InvalidIndex;
+    usize m_NextAcquire = 0;
+    usize m_InFlight = 0;
+    usize m_MaxFramesInFlight;
+
+    std::vector<UpdateCommand> m_UpdateCommands;
     std::vector<WriteCommand> m_WriteCommands;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::thread m_RenderThread;
+    bool m_Running = false;
 };
 
 }
\ No newline at end of file
@@ -12,7 +12,6 @@ namespace scsr
 class Vertex
 {
 public:
-    static Vertex FromInterpolation(const Vertex& v1, const Vertex& v2, f32 t);
     Vec2i ScreenPos() const;
 
     Vec4 pos;
@@ -27,26 +26,68 @@ struct Edge {
     Vertex* v2 = nullptr;
 };
 
+/// f(x, y) = a * x + b * y + c over screen space, set up once per triangle
+struct Plane
+{
+    f32 a;
+    f32 b;
+    f32 c;
+
+    /// Plane through the values `f0..f2` at the screen positions of `v0..v2`,
+    /// `invArea` is the reciprocal of the doubled signed triangle area
+    static Plane FromTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+        f32 f0, f32 f1, f32 f2, f32 invArea);
+
+    f32 At(f32 x, f32 y) const { return a * x + b * y + c; }
+};
+
 struct Trapezoid
 {
     f32 top;
     f32 bottom;
     Edge left;
     Edge right;
+    /// Index of the triangle setup, its planes, in the draw buffer
+    u32 primitive = 0;
 
     static std::pair<std::pair<Trapezoid, Trapezoid>, u32> FromPrimitive(Vertex& v1, Vertex& v2, Vertex& v3);
-    std::pair<Vertex, Vertex> LineYEnds(f32 y) const; 
+    /// X of the left and right edges at `y`
+    std::pair<f32, f32> LineXEnds(f32 y) const;
 };
 
+/// Pixels [x, x + width) of row `y` covered by a trapezoid
 struct Scanline
 {
-    Vertex start;
-    Vertex step;
     i32 x;
     i32 y;
     i32 width;
 
     static Scanline FromTrapezoid(const Trapezoid& trap, i32 y);
 };
+
+/// A triangle whose pixel centers fit in a `MaxSize` square block, tested per
+/// pixel against its edge functions instead of being split into trapezoids
+struct SmallTriangle
+{
+    static constexpr i32 MaxSize = 4;
+
+    /// Top left pixel of the block
+    i32 x;
+    i32 y;
+    /// Edge functions e = c + a * column + b * row over the block, positive inside
+    f32 a[3];
+    f32 b[3];
+    f32 c[3];
+    /// Centers on the edge are covered for right and bottom edges, like `Scanline`
+    bool inclusive[3];
+    /// Index of the triangle setup, its planes, in the draw buffer
+    u32 primitive = 0;
+
+    /// `doubleArea` is the signed doubled area of the triangle, not 0
+    static SmallTriangle FromPrimitive(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+        i32 x, i32 y, f32 doubleArea);
+    /// One mask per block row, bit i set when pixel `x + i` is covered
+    void Coverage(u32 rows[MaxSize]) const;
+};
     
 };
\ No newline at end of file
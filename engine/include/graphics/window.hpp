@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/type.hpp"
+#include "graphics/blit.hpp"
 
 #include <string>
 
@@ -18,20 +19,42 @@ struct WindowProp
     std::string title;
     i32 width;
     i32 height;
+    /// No SDL video, frames are presented into an offscreen image
+    bool headless = false;
 };
 
 class Window
-{   
+{
     SIG(Window)
 public:
     Window(WindowProp prop);
     ~Window();
 
+    /// Copy `image` to the window surface, scaled when the sizes differ.
+    /// An image from `SurfaceImage` is already in place and only flipped.
     void OnUpdate(Ref<Image> image);
+    /// Write the last presented frame to `path`, see `WriteImage`
+    bool SaveFrame(const std::string& path);
+
+    /// An image over the window surface pixels for rendering in place,
+    /// null when the surface size differs from `prop` or cannot be aliased.
+    /// The image takes the surface pixel format and is invalidated by a resize.
+    Ref<Image> SurfaceImage(const ImageProp& prop);
+
+    void SetPresentFilter(BlitFilter filter) { m_PresentFilter = filter; }
+    BlitFilter GetPresentFilter() const { return m_PresentFilter; }
+
+    bool IsHeadless() const { return m_Prop.headless; }
+    /// Current client area size in pixels, changes when the window is resized
+    Vec2i GetSize() const;
 private:
+
     bool m_Status = false;
     void* m_NativeHandle;
     WindowProp m_Prop;
+    BlitFilter m_PresentFilter = BlitFilter::Nearest;
+    Ref<Image> m_SurfaceImage;
+    Ref<Image> m_Offscreen;
 };
 
 }
\ No newline at end of file
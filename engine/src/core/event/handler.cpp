@@ -59,6 +59,9 @@ void EventHandler::Poll()
                     case SDL_WINDOWEVENT_CLOSE:
                         event.windowClose = WindowCloseEvent { .windowID = sdlEvent.window.windowID };
                         break;
+                    case SDL_WINDOWEVENT_EXPOSED:
+                        event.windowExpose = WindowExposeEvent { .windowID = sdlEvent.window.windowID };
+                        break;
                     default:
                         continue;
                 }
@@ -91,6 +94,12 @@ void EventHandler::Poll()
     }
 }
 
+void EventHandler::Wait(u32 timeoutMs)
+{
+    /// Leaves the event queued for the next `Poll`
+    SDL_WaitEventTimeout(nullptr, static_cast<int>(timeoutMs));
+}
+
 void EventHandler::Dispatch()
 {
     Event event;
@@ -110,6 +119,11 @@ void EventHandler::Dispatch()
     } 
 }
 
+void EventHandler::Send(const Event& event)
+{
+    m_EventQueue.Enqueue(event);
+}
+
 void EventHandler::SetFilter(u16 filter)
 {
     m_Filter = filter;
@@ -132,6 +146,4 @@ bool IsKeyDown(KeyboardKeyCode code)
     return false;
 }
 
-}
-
-
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "core/format.hpp"
 
+#include <fmt/format.h>
+
 namespace scsr
 {
 
@@ -137,6 +139,9 @@ std::string FormatEvent(const Event& event)
     case EventType::WindowClose:
         format += "WindowClose windowID: " + std::to_string(event.windowClose.windowID);
         break;
+    case EventType::WindowExposed:
+        format += "WindowExposed windowID: " + std::to_string(event.windowExpose.windowID);
+        break;
     case EventType::KeyboardPressed:
         format += "KeyboardPressed keyCode: " + FormatKeyBoardKeyCode((KeyboardKeyCode)event.keyboardPressed.keyCode)
             + " repeat: " + std::to_string(event.keyboardPressed.repeat);
@@ -169,4 +174,17 @@ std::string FormatEvent(const Event& event)
     return format;
 }
 
+bool FormatsNumber(const std::string& pattern)
+{
+    try
+    {
+        (void)fmt::format(fmt::runtime(pattern), usize { 0 });
+        return true;
+    }
+    catch (const fmt::format_error&)
+    {
+        return false;
+    }
+}
+
 }
\ No newline at end of file
@@ -49,6 +49,7 @@ void World::Run()
 
         std::chrono::duration<f64> elapsed = std::chrono::high_resolution_clock::now() - start;
         storage.GetObject<Ticker>().delta = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        storage.GetObject<Ticker>().frameTime = elapsed.count() * 1000.0;
         ++(storage.GetObject<Ticker>().tick);
         
         FrameMark;
@@ -0,0 +1,119 @@
+#include "core/task/thread_pool.hpp"
+
+#include <atomic>
+#include <algorithm>
+
+namespace scsr
+{
+
+ThreadPool::ThreadPool(usize threadCount)
+{
+    // The thread calling ParallelFor does work too
+    usize workerCount = threadCount > 1 ? threadCount - 1 : 0;
+    m_Workers.reserve(workerCount);
+    for (usize i = 0; i < workerCount; ++i)
+    {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+    if (m_Workers.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+    m_Cond.notify_one();
+}
+
+void ThreadPool::ParallelFor(usize count, usize grain, const RangeFn& fn)
+{
+    if (count == 0) { return; }
+
+    grain = std::max<usize>(grain, 1);
+    usize chunkCount = (count + grain - 1) / grain;
+    if (m_Workers.empty() || chunkCount == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    struct State
+    {
+        std::atomic<usize> next = 0;
+        std::atomic<usize> done = 0;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    auto state = MakeRef<State>();
+
+    /// Helpers that start late find no chunk left and never touch `fn`
+    auto work = [state, &fn, count, grain, chunkCount]() {
+        usize chunk;
+        while ((chunk = state->next.fetch_add(1)) < chunkCount)
+        {
+            usize begin = chunk * grain;
+            fn(begin, std::min(begin + grain, count));
+            if (state->done.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cond.notify_all();
+            }
+        }
+    };
+
+    usize helperCount = std::min(m_Workers.size(), chunkCount - 1);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (usize i = 0; i < helperCount; ++i)
+        {
+            m_Jobs.emplace_back(work);
+        }
+    }
+    m_Cond.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cond.wait(lock, [&] { return state->done.load() == chunkCount; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_Jobs.empty() || !m_Running; });
+            if (m_Jobs.empty())
+            {
+                return;
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+        job();
+    }
+}
+
+}
\ No newline at end of file
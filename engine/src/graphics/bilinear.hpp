@@ -0,0 +1,77 @@
+#pragma once
+
+#include "core/math/math.hpp"
+#include "core/type.hpp"
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+/// Bilinear filtering of packed pixels, shared by `ScalePixels` and the
+/// sprite sampler so both round the same way
+namespace scsr
+{
+
+/// Bilinear weights are 7-bit so 16-bit lanes hold (b - a) * w without overflow
+inline constexpr i32 WeightBits = 7;
+inline constexpr i32 WeightOne = 1 << WeightBits;
+
+inline u32 LerpPixel(u32 a, u32 b, i32 w)
+{
+    u32 result = 0;
+    for (u32 shift = 0; shift < 32; shift += 8)
+    {
+        i32 ca = (a >> shift) & 0xFF;
+        i32 cb = (b >> shift) & 0xFF;
+        result |= static_cast<u32>((ca + (((cb - ca) * w) >> WeightBits)) & 0xFF) << shift;
+    }
+    return result;
+}
+
+/// Left sample and weight of the right one at `s` pixels from the left edge
+/// of a row `size` wide, pixel centers are at half pixels
+inline void BilinearTap(f32 s, i32 size, i32& s0, i32& s1, i32& w)
+{
+    s = Clamp(s - 0.5f, 0.0f, static_cast<f32>(size - 1));
+    s0 = static_cast<i32>(s);
+    s1 = Min(s0 + 1, size - 1);
+    w = static_cast<i32>((s - s0) * WeightOne + 0.5f);
+}
+
+#ifdef SCSR_AVX2
+/// Per 16-bit channel lerp, `w` holds a weight per channel
+inline __m256i Lerp16(__m256i a, __m256i b, __m256i w)
+{
+    __m256i diff = _mm256_mullo_epi16(_mm256_sub_epi16(b, a), w);
+    return _mm256_add_epi16(a, _mm256_srai_epi16(diff, WeightBits));
+}
+
+/// Eight samples between columns `i0` and `i1` of `row0` and `row1`, mixed
+/// across by the 32-bit weights `w` and down by `wy` in every 16-bit lane
+inline __m256i BilinearGather8(const u32* row0, const u32* row1, __m256i i0, __m256i i1, __m256i w, __m256i wy)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    /// Spread each pixel's 32-bit weight over its four 16-bit channels
+    const __m256i spreadLo = _mm256_setr_epi8(
+        0, 1, 0, 1, 0, 1, 0, 1, 4, 5, 4, 5, 4, 5, 4, 5,
+        0, 1, 0, 1, 0, 1, 0, 1, 4, 5, 4, 5, 4, 5, 4, 5);
+    const __m256i spreadHi = _mm256_setr_epi8(
+        8, 9, 8, 9, 8, 9, 8, 9, 12, 13, 12, 13, 12, 13, 12, 13,
+        8, 9, 8, 9, 8, 9, 8, 9, 12, 13, 12, 13, 12, 13, 12, 13);
+    __m256i wLo = _mm256_shuffle_epi8(w, spreadLo);
+    __m256i wHi = _mm256_shuffle_epi8(w, spreadHi);
+
+    __m256i a = _mm256_i32gather_epi32(reinterpret_cast<const int*>(row0), i0, 4);
+    __m256i b = _mm256_i32gather_epi32(reinterpret_cast<const int*>(row0), i1, 4);
+    __m256i c = _mm256_i32gather_epi32(reinterpret_cast<const int*>(row1), i0, 4);
+    __m256i d = _mm256_i32gather_epi32(reinterpret_cast<const int*>(row1), i1, 4);
+
+    __m256i topLo = Lerp16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero), wLo);
+    __m256i topHi = Lerp16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero), wHi);
+    __m256i bottomLo = Lerp16(_mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero), wLo);
+    __m256i bottomHi = Lerp16(_mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero), wHi);
+    return _mm256_packus_epi16(Lerp16(topLo, bottomLo, wy), Lerp16(topHi, bottomHi, wy));
+}
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "graphics/blend.hpp"
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+/// Exact round(x / 255) for x up to 255 * 255
+static inline u32 Div255(u32 x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+template <BlendMode Mode>
+static inline u32 BlendChannel(u32 s, u32 d, u32 a, u32 factor)
+{
+    if constexpr (Mode == BlendMode::Alpha) { return Div255(s * factor + d * (255 - a)); }
+    else if constexpr (Mode == BlendMode::Premultiplied) { return Min<u32>(s + Div255(d * (255 - a)), 255); }
+    else if constexpr (Mode == BlendMode::Additive) { return Min<u32>(Div255(s * factor) + d, 255); }
+    else if constexpr (Mode == BlendMode::Multiply) { return Div255(s * d); }
+    else { return s; }
+}
+
+#ifdef SCSR_AVX2
+static inline __m256i Div255(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+/// Four pixels widened to 16-bit channels. Products stay below 2^16 so the
+/// wrapping multiplies are exact, overflow past 255 is saturated by the final pack.
+template <BlendMode Mode>
+static inline __m256i BlendWide(__m256i s, __m256i d, __m256i broadcast, __m256i alphaLanes)
+{
+    const __m256i full = _mm256_set1_epi16(255);
+    __m256i a = _mm256_shuffle_epi8(s, broadcast);
+    __m256i factor = _mm256_or_si256(a, alphaLanes);
+    __m256i inv = _mm256_sub_epi16(full, a);
+
+    if constexpr (Mode == BlendMode::Alpha)
+    {
+        return Div255(_mm256_add_epi16(_mm256_mullo_epi16(s, factor), _mm256_mullo_epi16(d, inv)));
+    }
+    else if constexpr (Mode == BlendMode::Premultiplied)
+    {
+        return _mm256_add_epi16(s, Div255(_mm256_mullo_epi16(d, inv)));
+    }
+    else if constexpr (Mode == BlendMode::Additive)
+    {
+        return _mm256_add_epi16(Div255(_mm256_mullo_epi16(s, factor)), d);
+    }
+    else if constexpr (Mode == BlendMode::Multiply)
+    {
+        return Div255(_mm256_mullo_epi16(s, d));
+    }
+    else
+    {
+        return s;
+    }
+}
+#endif
+
+template <BlendMode Mode>
+static void BlendSpan(const u32* src, u32* dst, usize count, u32 alphaShift)
+{
+    usize i = 0;
+#ifdef SCSR_AVX2
+    /// Per 16-bit channel, the bytes of its pixel's alpha and whether it is the alpha itself
+    const u8 k = static_cast<u8>(alphaShift / 8 * 2);
+    const __m256i broadcast = _mm256_setr_epi8(
+        k, k + 1, k, k + 1, k, k + 1, k, k + 1, k + 8, k + 9, k + 8, k + 9, k + 8, k + 9, k + 8, k + 9,
+        k, k + 1, k, k + 1, k, k + 1, k, k + 1, k + 8, k + 9, k + 8, k + 9, k + 8, k + 9, k + 8, k + 9);
+    alignas(32) i16 lanes[16] = {};
+    for (i32 p = 0; p < 4; ++p)
+    {
+        lanes[p * 4 + alphaShift / 8] = 255;
+    }
+    const __m256i alphaLanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i lo = BlendWide<Mode>(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), broadcast, alphaLanes);
+        __m256i hi = BlendWide<Mode>(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), broadcast, alphaLanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        u32 a = (src[i] >> alphaShift) & 0xFF;
+        u32 result = 0;
+        for (u32 shift = 0; shift < 32; shift += 8)
+        {
+            u32 factor = shift == alphaShift ? 255 : a;
+            result |= BlendChannel<Mode>((src[i] >> shift) & 0xFF, (dst[i] >> shift) & 0xFF, a, factor) << shift;
+        }
+        dst[i] = result;
+    }
+}
+
+void BlendPixels(const u32* src, u32* dst, usize count, BlendMode mode, PixelFormat format)
+{
+    u32 alphaShift = GetPixelLayout(format).a;
+    switch (mode)
+    {
+    case BlendMode::Opaque:         BlendSpan<BlendMode::Opaque>(src, dst, count, alphaShift); break;
+    case BlendMode::Alpha:          BlendSpan<BlendMode::Alpha>(src, dst, count, alphaShift); break;
+    case BlendMode::Premultiplied:  BlendSpan<BlendMode::Premultiplied>(src, dst, count, alphaShift); break;
+    case BlendMode::Additive:       BlendSpan<BlendMode::Additive>(src, dst, count, alphaShift); break;
+    case BlendMode::Multiply:       BlendSpan<BlendMode::Multiply>(src, dst, count, alphaShift); break;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "graphics/blit.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/assert.hpp"
+#include "bilinear.hpp"
+
+#include <Tracy.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+/// Linear to 8-bit sRGB, indexed by the linear value scaled to `SrgbLutSize - 1`
+static constexpr i32 SrgbLutSize = 4096;
+
+static const i32* SrgbLut()
+{
+    static const std::array<i32, SrgbLutSize> lut = [] {
+        std::array<i32, SrgbLutSize> table;
+        for (i32 i = 0; i < SrgbLutSize; ++i)
+        {
+            f32 linear = static_cast<f32>(i) / (SrgbLutSize - 1);
+            f32 srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+            table[i] = static_cast<i32>(srgb * 255.0f + 0.5f);
+        }
+        return table;
+    }();
+    return lut.data();
+}
+
+/// For each destination byte of a pixel, the source byte it comes from
+struct Swizzle
+{
+    u8 from[4];
+    bool identity;
+};
+
+static Swizzle MakeSwizzle(PixelFormat src, PixelFormat dst)
+{
+    PixelLayout s = GetPixelLayout(src);
+    PixelLayout d = GetPixelLayout(dst);
+
+    Swizzle swizzle;
+    swizzle.from[d.r / 8] = static_cast<u8>(s.r / 8);
+    swizzle.from[d.g / 8] = static_cast<u8>(s.g / 8);
+    swizzle.from[d.b / 8] = static_cast<u8>(s.b / 8);
+    swizzle.from[d.a / 8] = static_cast<u8>(s.a / 8);
+    swizzle.identity = src == dst;
+    return swizzle;
+}
+
+static inline u32 SwizzlePixel(u32 pixel, const Swizzle& swizzle)
+{
+    return ((pixel >> (swizzle.from[0] * 8)) & 0xFF)
+        | (((pixel >> (swizzle.from[1] * 8)) & 0xFF) << 8)
+        | (((pixel >> (swizzle.from[2] * 8)) & 0xFF) << 16)
+        | (((pixel >> (swizzle.from[3] * 8)) & 0xFF) << 24);
+}
+
+#ifdef SCSR_AVX2
+static inline __m256i SwizzleMask(const Swizzle& swizzle)
+{
+    alignas(32) u8 mask[32];
+    for (i32 i = 0; i < 32; ++i)
+    {
+        mask[i] = static_cast<u8>((i & ~3 & 15) + swizzle.from[i & 3]);
+    }
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(mask));
+}
+#endif
+
+static usize RowGrain(i32 height)
+{
+    usize threads = ThreadPool::Instance().Concurrency();
+    return std::max<usize>(8, static_cast<usize>(height) / (threads * 4));
+}
+
+void ConvertPixels(const PixelView& src, const PixelView& dst)
+{
+    ZoneScopedN("Convert pixels");
+    RT_ASSERT(src.width == dst.width && src.height == dst.height, "ConvertPixels needs equal sizes");
+
+    Swizzle swizzle = MakeSwizzle(src.format, dst.format);
+    ThreadPool::Instance().ParallelFor(dst.height, RowGrain(dst.height), [&](usize begin, usize end) {
+#ifdef SCSR_AVX2
+        const __m256i mask = SwizzleMask(swizzle);
+#endif
+        for (usize y = begin; y < end; ++y)
+        {
+            const u32* in = src.data + y * src.pitch;
+            u32* out = dst.data + y * dst.pitch;
+            if (swizzle.identity)
+            {
+                std::memcpy(out, in, dst.width * sizeof(u32));
+                continue;
+            }
+
+            i32 x = 0;
+#ifdef SCSR_AVX2
+            for (; x + 8 <= dst.width; x += 8)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_shuffle_epi8(pixels, mask));
+            }
+#endif
+            for (; x < dst.width; ++x)
+            {
+                out[x] = SwizzlePixel(in[x], swizzle);
+            }
+        }
+    });
+}
+
+static void ScaleNearest(const PixelView& src, const PixelView& dst, const Swizzle& swizzle)
+{
+    /// Sample the source pixel under each destination pixel center
+    std::vector<i32> columns(dst.width);
+    for (i32 x = 0; x < dst.width; ++x)
+    {
+        columns[x] = static_cast<i32>((2 * static_cast<i64>(x) + 1) * src.width / (2 * static_cast<i64>(dst.width)));
+    }
+
+    ThreadPool::Instance().ParallelFor(dst.height, RowGrain(dst.height), [&](usize begin, usize end) {
+#ifdef SCSR_AVX2
+        const __m256i mask = SwizzleMask(swizzle);
+#endif
+        for (usize y = begin; y < end; ++y)
+        {
+            i32 sy = static_cast<i32>((2 * static_cast<i64>(y) + 1) * src.height / (2 * static_cast<i64>(dst.height)));
+            const u32* in = src.data + sy * src.pitch;
+            u32* out = dst.data + y * dst.pitch;
+
+            i32 x = 0;
+#ifdef SCSR_AVX2
+            for (; x + 8 <= dst.width; x += 8)
+            {
+                __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.data() + x));
+                __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(in), index, 4);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_shuffle_epi8(pixels, mask));
+            }
+#endif
+            for (; x < dst.width; ++x)
+            {
+                out[x] = SwizzlePixel(in[columns[x]], swizzle);
+            }
+        }
+    });
+}
+
+/// Source position of the center of destination pixel `d`
+static inline f32 SourceCenter(i32 d, i32 dstSize, i32 srcSize)
+{
+    return (static_cast<f32>(d) + 0.5f) * srcSize / dstSize;
+}
+
+static void ScaleBilinear(const PixelView& src, const PixelView& dst, const Swizzle& swizzle)
+{
+    std::vector<i32> left(dst.width);
+    std::vector<i32> right(dst.width);
+    std::vector<i32> weights(dst.width);
+    for (i32 x = 0; x < dst.width; ++x)
+    {
+        BilinearTap(SourceCenter(x, dst.width, src.width), src.width, left[x], right[x], weights[x]);
+    }
+
+    ThreadPool::Instance().ParallelFor(dst.height, RowGrain(dst.height), [&](usize begin, usize end) {
+#ifdef SCSR_AVX2
+        const __m256i mask = SwizzleMask(swizzle);
+#endif
+        for (usize y = begin; y < end; ++y)
+        {
+            i32 sy0, sy1, wy;
+            BilinearTap(SourceCenter(static_cast<i32>(y), dst.height, src.height), src.height, sy0, sy1, wy);
+            const u32* row0 = src.data + sy0 * src.pitch;
+            const u32* row1 = src.data + sy1 * src.pitch;
+            u32* out = dst.data + y * dst.pitch;
+
+            i32 x = 0;
+#ifdef SCSR_AVX2
+            const __m256i wv = _mm256_set1_epi16(static_cast<i16>(wy));
+            for (; x + 8 <= dst.width; x += 8)
+            {
+                __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left.data() + x));
+                __m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right.data() + x));
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights.data() + x));
+                __m256i pixels = BilinearGather8(row0, row1, i0, i1, w, wv);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_shuffle_epi8(pixels, mask));
+            }
+#endif
+            for (; x < dst.width; ++x)
+            {
+                u32 top = LerpPixel(row0[left[x]], row0[right[x]], weights[x]);
+                u32 bottom = LerpPixel(row1[left[x]], row1[right[x]], weights[x]);
+                out[x] = SwizzlePixel(LerpPixel(top, bottom, wy), swizzle);
+            }
+        }
+    });
+}
+
+void ScalePixels(const PixelView& src, const PixelView& dst, BlitFilter filter)
+{
+    ZoneScopedN("Scale pixels");
+    if (src.width == dst.width && src.height == dst.height)
+    {
+        ConvertPixels(src, dst);
+        return;
+    }
+    if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0) { return; }
+
+    Swizzle swizzle = MakeSwizzle(src.format, dst.format);
+    switch (filter)
+    {
+    case BlitFilter::Nearest:   ScaleNearest(src, dst, swizzle); break;
+    case BlitFilter::Bilinear:  ScaleBilinear(src, dst, swizzle); break;
+    }
+}
+
+void SwizzlePixels(const u32* in, u32* out, usize count, PixelFormat src, PixelFormat dst)
+{
+    Swizzle swizzle = MakeSwizzle(src, dst);
+    if (swizzle.identity)
+    {
+        if (in != out) { std::memmove(out, in, count * sizeof(u32)); }
+        return;
+    }
+
+    usize i = 0;
+#ifdef SCSR_AVX2
+    const __m256i mask = SwizzleMask(swizzle);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(pixels, mask));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = SwizzlePixel(in[i], swizzle);
+    }
+}
+
+void PackColors(const Color* colors, u32* out, usize count, PixelFormat format, bool srgb)
+{
+    const i32* lut = srgb ? SrgbLut() : nullptr;
+    usize i = 0;
+#ifdef SCSR_AVX2
+    /// Two colors per register, channels come out in memory order R, G, B, A
+    const __m256i mask = SwizzleMask(MakeSwizzle(PixelFormat::ABGR8888, format));
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    const __m256 lutScale = _mm256_set1_ps(static_cast<f32>(SrgbLutSize - 1));
+
+    auto convert = [&](const Color* color) {
+        __m256 v = _mm256_loadu_ps(reinterpret_cast<const f32*>(color));
+        v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+        /// Truncating after +0.5 rounds like `PackColor`
+        __m256i linear = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, scale), half));
+        if (!lut) { return linear; }
+        __m256i index = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, lutScale), half));
+        __m256i encoded = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), index, 4);
+        return _mm256_blend_epi32(encoded, linear, 0x88);
+    };
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i ab = _mm256_packs_epi32(convert(colors + i), convert(colors + i + 2));
+        __m256i cd = _mm256_packs_epi32(convert(colors + i + 4), convert(colors + i + 6));
+        /// Packing works per 128-bit lane, restore the pixel order
+        __m256i pixels = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(pixels, mask));
+    }
+#endif
+    PixelLayout layout = GetPixelLayout(format);
+    for (; i < count; ++i)
+    {
+        const Color& color = colors[i];
+        u32 rgb[3];
+        for (i32 c = 0; c < 3; ++c)
+        {
+            f32 v = Clamp(color.data[c], 0.0f, 1.0f);
+            rgb[c] = lut ? static_cast<u32>(lut[static_cast<i32>(v * (SrgbLutSize - 1) + 0.5f)])
+                         : static_cast<u32>(v * 255.0f + 0.5f);
+        }
+        u32 a = static_cast<u32>(Clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+        out[i] = (rgb[0] << layout.r) | (rgb[1] << layout.g) | (rgb[2] << layout.b) | (a << layout.a);
+    }
+}
+
+f32 SrgbToLinear(u8 value)
+{
+    static const std::array<f32, 256> lut = [] {
+        std::array<f32, 256> table;
+        for (i32 i = 0; i < 256; ++i)
+        {
+            f32 srgb = static_cast<f32>(i) / 255.0f;
+            table[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+    return lut[value];
+}
+
+}
\ No newline at end of file
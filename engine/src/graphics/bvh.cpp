@@ -0,0 +1,542 @@
+#include "graphics/bvh.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <numeric>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+static_assert(sizeof(BvhNode) == 32, "Nodes are kept at half a cache line");
+
+/// Traversal holds at most one node per level plus one, `Subdivide` keeps
+/// trees over less than 2^32 triangles within `SahMaxDepth` + 31 levels
+static constexpr usize StackSize = Bvh::SahMaxDepth + 33;
+/// Items per job when a large node is binned in parallel
+static constexpr usize BinGrain = 16384;
+/// Barycentric slack, rays would slip through rounding gaps on shared edges
+static constexpr f32 EdgeEpsilon = 1e-5f;
+
+static inline f32 HalfArea(const Vec3& min, const Vec3& max)
+{
+    Vec3 e = max - min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+/// Distance where `ray` enters the box, infinity when it misses it before `tMax`
+static inline f32 BoxEntry(const Vec3& min, const Vec3& max, const Vec3& origin, const Vec3& invDir, f32 tMax)
+{
+    f32 tx0 = (min.x - origin.x) * invDir.x, tx1 = (max.x - origin.x) * invDir.x;
+    f32 ty0 = (min.y - origin.y) * invDir.y, ty1 = (max.y - origin.y) * invDir.y;
+    f32 tz0 = (min.z - origin.z) * invDir.z, tz1 = (max.z - origin.z) * invDir.z;
+    f32 tNear = Max(Max(Min(tx0, tx1), Min(ty0, ty1)), Max(Min(tz0, tz1), 0.0f));
+    f32 tFar = Min(Min(Max(tx0, tx1), Max(ty0, ty1)), Min(Max(tz0, tz1), tMax));
+    return tNear <= tFar ? tNear : F32INF;
+}
+
+void RayPacket::Set(usize lane, const Ray& ray)
+{
+    ox[lane] = ray.origin.x;
+    oy[lane] = ray.origin.y;
+    oz[lane] = ray.origin.z;
+    dx[lane] = ray.direction.x;
+    dy[lane] = ray.direction.y;
+    dz[lane] = ray.direction.z;
+    tMax[lane] = ray.tMax;
+}
+
+void Bvh::Build(std::span<const Mesh* const> meshes)
+{
+    ZoneScoped;
+    std::vector<Triangle> triangles;
+    std::vector<Vec3> normals;
+    std::vector<BvhPrimitive> primitives;
+    std::vector<BuildItem> items;
+    for (u32 m = 0; m < meshes.size(); ++m)
+    {
+        const Mesh& mesh = *meshes[m];
+        if (mesh.topology != Topology::Triangles && mesh.topology != Topology::TriangleStrip && mesh.topology != Topology::TriangleFan)
+        {
+            continue;
+        }
+        const usize count = PrimitiveCount(mesh.topology, mesh.vertices.size());
+        for (usize t = 0; t < count; ++t)
+        {
+            usize index[3];
+            TriangleIndices(mesh.topology, t, index);
+            const Vertex* v[3] = { &mesh.vertices[index[0]], &mesh.vertices[index[1]], &mesh.vertices[index[2]] };
+            Vec3 p0 = v[0]->pos.xyz(), p1 = v[1]->pos.xyz(), p2 = v[2]->pos.xyz();
+            triangles.push_back({ p0, p1 - p0, p2 - p0 });
+            normals.insert(normals.end(), { v[0]->normal, v[1]->normal, v[2]->normal });
+            primitives.push_back({ m, static_cast<u32>(t) });
+            Vec3 min = Min(Min(p0, p1), p2);
+            Vec3 max = Max(Max(p0, p1), p2);
+            items.push_back({ min, max, (min + max) * 0.5f });
+        }
+    }
+
+    const u32 n = static_cast<u32>(triangles.size());
+    m_Nodes.clear();
+    m_Triangles.clear();
+    m_Normals.clear();
+    m_Primitives.clear();
+    if (n == 0) { return; }
+
+    m_Order.resize(n);
+    std::iota(m_Order.begin(), m_Order.end(), 0u);
+    /// A binary tree with one triangle per leaf at most, plus the unused slot after the root
+    m_Nodes.resize(2 * static_cast<usize>(n));
+    m_NodeCount = 1;
+    {
+        ZoneScopedN("Subdivide");
+        Subdivide(0, 0, n, 0, items);
+    }
+    m_Nodes.resize(m_NodeCount);
+
+    /// Leaves refer to consecutive triangles
+    m_Triangles.resize(n);
+    m_Normals.resize(3 * static_cast<usize>(n));
+    m_Primitives.resize(n);
+    ThreadPool::Instance().ParallelFor(n, BinGrain, [&](usize begin, usize end) {
+        for (usize i = begin; i < end; ++i)
+        {
+            u32 from = m_Order[i];
+            m_Triangles[i] = triangles[from];
+            m_Primitives[i] = primitives[from];
+            for (usize k = 0; k < 3; ++k)
+            {
+                m_Normals[i * 3 + k] = normals[from * 3 + k];
+            }
+        }
+    });
+    m_Order = {};
+}
+
+void Bvh::Subdivide(u32 index, u32 first, u32 count, u32 depth, std::vector<BuildItem>& items)
+{
+    struct Bin
+    {
+        Vec3 min = Vec3::INF();
+        Vec3 max = Vec3::Splat(-F32INF);
+        u32 count = 0;
+    };
+    struct Bounds
+    {
+        Vec3 min = Vec3::INF();
+        Vec3 max = Vec3::Splat(-F32INF);
+        Vec3 centroidMin = Vec3::INF();
+        Vec3 centroidMax = Vec3::Splat(-F32INF);
+    };
+    const bool parallel = count > ParallelThreshold;
+    const u32* order = m_Order.data() + first;
+
+    /// Small nodes loop inline, large ones split the loop over the pool and merge under a lock
+    std::mutex mutex;
+    auto forItems = [&](auto&& fn) {
+        if (!parallel)
+        {
+            fn(0, count);
+            return;
+        }
+        ThreadPool::Instance().ParallelFor(count, BinGrain, fn);
+    };
+
+    Bounds bounds;
+    forItems([&](usize begin, usize end) {
+        Bounds local;
+        for (usize i = begin; i < end; ++i)
+        {
+            const BuildItem& item = items[order[i]];
+            local.min = Min(local.min, item.min);
+            local.max = Max(local.max, item.max);
+            local.centroidMin = Min(local.centroidMin, item.centroid);
+            local.centroidMax = Max(local.centroidMax, item.centroid);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        bounds.min = Min(bounds.min, local.min);
+        bounds.max = Max(bounds.max, local.max);
+        bounds.centroidMin = Min(bounds.centroidMin, local.centroidMin);
+        bounds.centroidMax = Max(bounds.centroidMax, local.centroidMax);
+    });
+
+    BvhNode& node = m_Nodes[index];
+    node.min = bounds.min;
+    node.max = bounds.max;
+    node.axis = 0;
+    auto makeLeaf = [&] {
+        node.index = first;
+        node.count = static_cast<u16>(count);
+    };
+    if (count <= MaxLeafSize)
+    {
+        makeLeaf();
+        return;
+    }
+
+    u32* begin = m_Order.data() + first;
+    const Vec3 extent = bounds.centroidMax - bounds.centroidMin;
+    if (depth >= SahMaxDepth)
+    {
+        /// Lopsided SAH splits could go on for as many levels as there are
+        /// triangles, deep nodes are halved along the widest centroid axis
+        const i32 axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        std::nth_element(begin, begin + count / 2, begin + count, [&](u32 a, u32 b) {
+            return items[a].centroid.data[axis] < items[b].centroid.data[axis];
+        });
+        SplitNode(index, first, count, count / 2, axis, depth, items);
+        return;
+    }
+
+    /// Bin centroids along every axis
+    Vec3 scale;
+    for (i32 a = 0; a < 3; ++a)
+    {
+        scale.data[a] = extent.data[a] > 0.0f ? SahBins / extent.data[a] : 0.0f;
+    }
+    auto binOf = [&](const Vec3& centroid, i32 axis) {
+        return Min(static_cast<u32>((centroid.data[axis] - bounds.centroidMin.data[axis]) * scale.data[axis]), SahBins - 1);
+    };
+    Bin bins[3][SahBins];
+    forItems([&](usize begin, usize end) {
+        Bin local[3][SahBins];
+        for (usize i = begin; i < end; ++i)
+        {
+            const BuildItem& item = items[order[i]];
+            for (i32 a = 0; a < 3; ++a)
+            {
+                Bin& bin = local[a][binOf(item.centroid, a)];
+                bin.min = Min(bin.min, item.min);
+                bin.max = Max(bin.max, item.max);
+                ++bin.count;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (i32 a = 0; a < 3; ++a)
+        {
+            for (u32 b = 0; b < SahBins; ++b)
+            {
+                bins[a][b].min = Min(bins[a][b].min, local[a][b].min);
+                bins[a][b].max = Max(bins[a][b].max, local[a][b].max);
+                bins[a][b].count += local[a][b].count;
+            }
+        }
+    });
+
+    /// Sweep the planes between bins from both sides
+    f32 bestCost = F32INF;
+    i32 bestAxis = -1;
+    u32 bestSplit = 0;
+    for (i32 a = 0; a < 3; ++a)
+    {
+        if (scale.data[a] == 0.0f) { continue; }
+        f32 leftCost[SahBins - 1];
+        Bin sweep;
+        for (u32 b = 0; b + 1 < SahBins; ++b)
+        {
+            sweep.min = Min(sweep.min, bins[a][b].min);
+            sweep.max = Max(sweep.max, bins[a][b].max);
+            sweep.count += bins[a][b].count;
+            leftCost[b] = sweep.count ? sweep.count * HalfArea(sweep.min, sweep.max) : 0.0f;
+        }
+        sweep = {};
+        for (u32 b = SahBins - 1; b > 0; --b)
+        {
+            sweep.min = Min(sweep.min, bins[a][b].min);
+            sweep.max = Max(sweep.max, bins[a][b].max);
+            sweep.count += bins[a][b].count;
+            f32 cost = leftCost[b - 1] + (sweep.count ? sweep.count * HalfArea(sweep.min, sweep.max) : 0.0f);
+            if (sweep.count > 0 && sweep.count < count && cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = a;
+                bestSplit = b;
+            }
+        }
+    }
+
+    /// Splitting costs a box test, keep small nodes whose split does not pay off
+    const f32 leafCost = count * HalfArea(bounds.min, bounds.max);
+    if (bestAxis < 0 || (bestCost >= leafCost && count <= 4 * MaxLeafSize))
+    {
+        if (count <= 0xFFFF)
+        {
+            makeLeaf();
+            return;
+        }
+    }
+
+    u32 leftCount = count / 2;
+    if (bestAxis >= 0)
+    {
+        u32* middle = std::partition(begin, begin + count, [&](u32 i) { return binOf(items[i].centroid, bestAxis) < bestSplit; });
+        leftCount = static_cast<u32>(middle - begin);
+    }
+    SplitNode(index, first, count, leftCount, Max(bestAxis, 0), depth, items);
+}
+
+void Bvh::SplitNode(u32 index, u32 first, u32 count, u32 leftCount, i32 axis, u32 depth, std::vector<BuildItem>& items)
+{
+    const u32 left = m_NodeCount.fetch_add(2);
+    BvhNode& node = m_Nodes[index];
+    node.index = left;
+    node.count = 0;
+    node.axis = static_cast<u16>(axis);
+    if (count > ParallelThreshold)
+    {
+        ThreadPool::Instance().ParallelFor(2, 1, [&](usize b, usize e) {
+            for (usize child = b; child < e; ++child)
+            {
+                Subdivide(left + static_cast<u32>(child), child ? first + leftCount : first, child ? count - leftCount : leftCount,
+                    depth + 1, items);
+            }
+        });
+    }
+    else
+    {
+        Subdivide(left, first, leftCount, depth + 1, items);
+        Subdivide(left + 1, first + leftCount, count - leftCount, depth + 1, items);
+    }
+}
+
+/// Möller-Trumbore, true and the hit when closer than `hit.t`
+static inline bool IntersectTriangle(const Vec3& v0, const Vec3& e1, const Vec3& e2, const Ray& ray, u32 triangle, RayHit& hit)
+{
+    Vec3 p = Cross(ray.direction, e2);
+    f32 det = Dot(e1, p);
+    if (det == 0.0f) { return false; }
+    f32 inv = 1.0f / det;
+    Vec3 s = ray.origin - v0;
+    f32 u = Dot(s, p) * inv;
+    if (u < -EdgeEpsilon || u > 1.0f + EdgeEpsilon) { return false; }
+    Vec3 q = Cross(s, e1);
+    f32 v = Dot(ray.direction, q) * inv;
+    if (v < -EdgeEpsilon || u + v > 1.0f + EdgeEpsilon) { return false; }
+    f32 t = Dot(e2, q) * inv;
+    if (!(t > 0.0f && t < hit.t)) { return false; }
+    hit = { t, triangle, u, v };
+    return true;
+}
+
+template <bool AnyHit>
+static RayHit Traverse(const std::vector<BvhNode>& nodes, const auto& triangles, const Ray& ray)
+{
+    RayHit hit;
+    hit.t = ray.tMax;
+    if (nodes.empty()) { return hit; }
+    const Vec3 invDir(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+    if (BoxEntry(nodes[0].min, nodes[0].max, ray.origin, invDir, hit.t) == F32INF) { return hit; }
+
+    u32 stack[StackSize];
+    usize size = 0;
+    stack[size++] = 0;
+    while (size > 0)
+    {
+        const BvhNode& node = nodes[stack[--size]];
+        if (node.IsLeaf())
+        {
+            for (u32 i = node.index; i < node.index + node.count; ++i)
+            {
+                if (IntersectTriangle(triangles[i].v0, triangles[i].e1, triangles[i].e2, ray, i, hit) && AnyHit) { return hit; }
+            }
+            continue;
+        }
+        f32 left = BoxEntry(nodes[node.index].min, nodes[node.index].max, ray.origin, invDir, hit.t);
+        f32 right = BoxEntry(nodes[node.index + 1].min, nodes[node.index + 1].max, ray.origin, invDir, hit.t);
+        /// Nearer child on top
+        u32 near = node.index, far = node.index + 1;
+        if (right < left)
+        {
+            std::swap(near, far);
+            std::swap(left, right);
+        }
+        if (right != F32INF) { stack[size++] = far; }
+        if (left != F32INF) { stack[size++] = near; }
+    }
+    return hit;
+}
+
+RayHit Bvh::Intersect(const Ray& ray) const
+{
+    RayHit hit = Traverse<false>(m_Nodes, m_Triangles, ray);
+    if (!hit.Valid()) { hit.t = F32INF; }
+    return hit;
+}
+
+bool Bvh::Occluded(const Ray& ray) const
+{
+    return Traverse<true>(m_Nodes, m_Triangles, ray).Valid();
+}
+
+#ifdef SCSR_AVX2
+/// Packet traversal, closest hits or with `AnyHit` only which lanes hit
+template <bool AnyHit>
+static u32 TraversePacket(const std::vector<BvhNode>& nodes, const auto& triangles, const RayPacket& packet, u32 mask, PacketHit* out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 low = _mm256_set1_ps(-EdgeEpsilon);
+    const __m256 high = _mm256_set1_ps(1.0f + EdgeEpsilon);
+    const __m256 ox = _mm256_load_ps(packet.ox), oy = _mm256_load_ps(packet.oy), oz = _mm256_load_ps(packet.oz);
+    const __m256 dx = _mm256_load_ps(packet.dx), dy = _mm256_load_ps(packet.dy), dz = _mm256_load_ps(packet.dz);
+    const __m256 ix = _mm256_div_ps(one, dx), iy = _mm256_div_ps(one, dy), iz = _mm256_div_ps(one, dz);
+    /// Lanes outside `mask` get a negative distance that no box or triangle passes
+    alignas(32) u32 lanes[8];
+    for (u32 lane = 0; lane < 8; ++lane)
+    {
+        lanes[lane] = (mask >> lane) & 1 ? ~0u : 0u;
+    }
+    const __m256 active = _mm256_load_ps(reinterpret_cast<const f32*>(lanes));
+    __m256 tBest = _mm256_blendv_ps(_mm256_set1_ps(-1.0f), _mm256_load_ps(packet.tMax), active);
+    __m256i triangle = _mm256_set1_epi32(-1);
+    __m256 hitU = zero, hitV = zero;
+    u32 occluded = 0;
+
+    auto boxMask = [&](const BvhNode& node) {
+        __m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.x), ox), ix);
+        __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.x), ox), ix);
+        __m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.y), oy), iy);
+        __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.y), oy), iy);
+        __m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.min.z), oz), iz);
+        __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.max.z), oz), iz);
+        __m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx0, tx1), _mm256_min_ps(ty0, ty1)), _mm256_max_ps(_mm256_min_ps(tz0, tz1), zero));
+        __m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx0, tx1), _mm256_max_ps(ty0, ty1)), _mm256_min_ps(_mm256_max_ps(tz0, tz1), tBest));
+        return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+    };
+
+    /// Children are visited in the order the first active ray meets them
+    const u32 lead = std::countr_zero(mask);
+    const bool negative[3] = { packet.dx[lead] < 0.0f, packet.dy[lead] < 0.0f, packet.dz[lead] < 0.0f };
+
+    if (nodes.empty() || boxMask(nodes[0]) == 0) { mask = 0; }
+    u32 stack[StackSize];
+    usize size = 0;
+    if (mask) { stack[size++] = 0; }
+    while (size > 0)
+    {
+        const BvhNode& node = nodes[stack[--size]];
+        if (!node.IsLeaf())
+        {
+            u32 near = node.index, far = node.index + 1;
+            if (negative[node.axis]) { std::swap(near, far); }
+            if (boxMask(nodes[far])) { stack[size++] = far; }
+            if (boxMask(nodes[near])) { stack[size++] = near; }
+            continue;
+        }
+        for (u32 i = node.index; i < node.index + node.count; ++i)
+        {
+            const auto& tri = triangles[i];
+            const __m256 e1x = _mm256_set1_ps(tri.e1.x), e1y = _mm256_set1_ps(tri.e1.y), e1z = _mm256_set1_ps(tri.e1.z);
+            const __m256 e2x = _mm256_set1_ps(tri.e2.x), e2y = _mm256_set1_ps(tri.e2.y), e2z = _mm256_set1_ps(tri.e2.z);
+            /// p = d x e2, det = e1 . p
+            __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+            __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+            __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+            __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+            __m256 inv = _mm256_div_ps(one, det);
+            __m256 sx = _mm256_sub_ps(ox, _mm256_set1_ps(tri.v0.x));
+            __m256 sy = _mm256_sub_ps(oy, _mm256_set1_ps(tri.v0.y));
+            __m256 sz = _mm256_sub_ps(oz, _mm256_set1_ps(tri.v0.z));
+            __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inv);
+            /// q = s x e1
+            __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+            __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+            __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+            __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv);
+            __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv);
+
+            __m256 hit = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+            hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, low, _CMP_GE_OQ), _mm256_cmp_ps(u, high, _CMP_LE_OQ)));
+            hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, low, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), high, _CMP_LE_OQ)));
+            hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, tBest, _CMP_LT_OQ)));
+            u32 hits = static_cast<u32>(_mm256_movemask_ps(hit));
+            if (hits == 0) { continue; }
+            if constexpr (AnyHit)
+            {
+                /// Occluded lanes are done, no box passes them anymore
+                occluded |= hits;
+                tBest = _mm256_blendv_ps(tBest, _mm256_set1_ps(-1.0f), hit);
+                if (occluded == mask) { return occluded; }
+            }
+            else
+            {
+                tBest = _mm256_blendv_ps(tBest, t, hit);
+                hitU = _mm256_blendv_ps(hitU, u, hit);
+                hitV = _mm256_blendv_ps(hitV, v, hit);
+                triangle = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(triangle), _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<i32>(i))), hit));
+            }
+        }
+    }
+    if constexpr (!AnyHit)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out->triangle), triangle);
+        _mm256_store_ps(out->u, hitU);
+        _mm256_store_ps(out->v, hitV);
+        /// Misses keep an infinite distance like `Intersect`
+        __m256 missed = _mm256_castsi256_ps(_mm256_cmpeq_epi32(triangle, _mm256_set1_epi32(-1)));
+        _mm256_store_ps(out->t, _mm256_blendv_ps(tBest, _mm256_set1_ps(F32INF), missed));
+    }
+    return occluded;
+}
+#endif
+
+void Bvh::Intersect(const RayPacket& packet, u32 mask, PacketHit& hit) const
+{
+#ifdef SCSR_AVX2
+    if (mask)
+    {
+        TraversePacket<false>(m_Nodes, m_Triangles, packet, mask, &hit);
+        return;
+    }
+#endif
+    for (usize lane = 0; lane < RayPacket::Size; ++lane)
+    {
+        RayHit result;
+        if ((mask >> lane) & 1)
+        {
+            result = Intersect(Ray { Vec3(packet.ox[lane], packet.oy[lane], packet.oz[lane]),
+                Vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]), packet.tMax[lane] });
+        }
+        hit.t[lane] = result.t;
+        hit.triangle[lane] = result.triangle;
+        hit.u[lane] = result.u;
+        hit.v[lane] = result.v;
+    }
+}
+
+u32 Bvh::Occluded(const RayPacket& packet, u32 mask) const
+{
+#ifdef SCSR_AVX2
+    return mask ? TraversePacket<true>(m_Nodes, m_Triangles, packet, mask, nullptr) : 0;
+#else
+    u32 occluded = 0;
+    for (usize lane = 0; lane < RayPacket::Size; ++lane)
+    {
+        if (((mask >> lane) & 1) && Occluded(Ray { Vec3(packet.ox[lane], packet.oy[lane], packet.oz[lane]),
+            Vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]), packet.tMax[lane] }))
+        {
+            occluded |= 1u << lane;
+        }
+    }
+    return occluded;
+#endif
+}
+
+Vec3 Bvh::Normal(const RayHit& hit) const
+{
+    const Vec3* n = m_Normals.data() + static_cast<usize>(hit.triangle) * 3;
+    Vec3 normal = n[0] * (1.0f - hit.u - hit.v) + n[1] * hit.u + n[2] * hit.v;
+    if (Dot(normal, normal) > 0.0f) { return normal; }
+    /// Meshes without normals shade flat
+    const Triangle& tri = m_Triangles[hit.triangle];
+    return Cross(tri.e1, tri.e2);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "graphics/damage.hpp"
+
+namespace scsr
+{
+
+Rect DamageHistory::Accumulated(usize age, const Rect& bounds) const
+{
+    if (age == 0 || age - 1 > m_History.size()) { return bounds; }
+
+    Frame total = m_Current;
+    for (usize i = 0; i + 1 < age; ++i)
+    {
+        total.rect = Union(total.rect, m_History[i].rect);
+        total.full |= m_History[i].full;
+    }
+    return total.full ? bounds : Intersect(total.rect, bounds);
+}
+
+void DamageHistory::EndFrame()
+{
+    m_History.push_front(m_Current);
+    if (m_History.size() > MaxAge)
+    {
+        m_History.pop_back();
+    }
+    m_Current = {};
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "graphics/debug_draw.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <cmath>
+
+namespace scsr
+{
+
+/// Lines per transform job
+static constexpr usize LineGrain = 256;
+
+void DebugDraw::Line(const Vec3& a, const Vec3& b, const Color& color)
+{
+    m_Lines.push_back({ a, b, color });
+}
+
+void DebugDraw::Box(const Vec3& min, const Vec3& max, const Color& color)
+{
+    Vec3 c[8];
+    for (i32 i = 0; i < 8; ++i)
+    {
+        c[i] = Vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+    }
+    /// Corners differing in one bit share an edge
+    for (i32 i = 0; i < 8; ++i)
+    {
+        for (i32 bit = 1; bit < 8; bit <<= 1)
+        {
+            if (!(i & bit)) { Line(c[i], c[i | bit], color); }
+        }
+    }
+}
+
+void DebugDraw::Sphere(const Vec3& center, f32 radius, const Color& color, i32 segments)
+{
+    segments = Max(segments, 3);
+    for (i32 i = 0; i < segments; ++i)
+    {
+        f32 a0 = 2.0f * PI * i / segments;
+        f32 a1 = 2.0f * PI * (i + 1) / segments;
+        f32 c0 = std::cos(a0) * radius, s0 = std::sin(a0) * radius;
+        f32 c1 = std::cos(a1) * radius, s1 = std::sin(a1) * radius;
+        Line(center + Vec3(c0, s0, 0.0f), center + Vec3(c1, s1, 0.0f), color);
+        Line(center + Vec3(c0, 0.0f, s0), center + Vec3(c1, 0.0f, s1), color);
+        Line(center + Vec3(0.0f, c0, s0), center + Vec3(0.0f, c1, s1), color);
+    }
+}
+
+void DebugDraw::Frustum(const Mat4& viewProjection, const Color& color)
+{
+    Mat4 inverse = viewProjection.Inversed();
+    Vec3 c[8];
+    for (i32 i = 0; i < 8; ++i)
+    {
+        Vec4 p = inverse * Vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+        c[i] = p.xyz() / p.w;
+    }
+    for (i32 i = 0; i < 8; ++i)
+    {
+        for (i32 bit = 1; bit < 8; bit <<= 1)
+        {
+            if (!(i & bit)) { Line(c[i], c[i | bit], color); }
+        }
+    }
+}
+
+void DebugDraw::Normals(const Mesh& mesh, f32 length, const Color& color)
+{
+    for (const auto& vtx : mesh.vertices)
+    {
+        Vec3 p = vtx.pos.xyz();
+        Line(p, p + vtx.normal * length, color);
+    }
+}
+
+void DebugDraw::Flush(Image& image, const Mat4& viewProjection)
+{
+    ZoneScopedN("DebugDraw::Flush");
+    const usize count = m_Lines.size();
+    m_ScreenLines.resize(count);
+    m_Visible.resize(count);
+
+    auto& pool = ThreadPool::Instance();
+    {
+        ZoneScopedN("Debug Transform");
+        pool.ParallelFor(count, LineGrain, [&](usize begin, usize end) {
+            for (usize i = begin; i < end; ++i)
+            {
+                const WorldLine& line = m_Lines[i];
+                Vec4 a = viewProjection * Vec4(line.a, 1.0f);
+                Vec4 b = viewProjection * Vec4(line.b, 1.0f);
+                m_Visible[i] = ClipLine(a, b);
+                if (!m_Visible[i]) { continue; }
+                m_ScreenLines[i] = {
+                    ClipToScreen(a, image.Width(), image.Height()),
+                    ClipToScreen(b, image.Width(), image.Height()),
+                    PackColor(line.color, image.Format()),
+                    line.color,
+                };
+            }
+        });
+    }
+
+    /// Compact in order, draws stay deterministic
+    usize visible = 0;
+    for (usize i = 0; i < count; ++i)
+    {
+        if (m_Visible[i]) { m_ScreenLines[visible++] = m_ScreenLines[i]; }
+    }
+    m_ScreenLines.resize(visible);
+
+    {
+        ZoneScopedN("Debug Raster");
+        RasterizeLines(image, m_ScreenLines, image.Bounds(), false, m_DepthBias);
+    }
+
+    m_Lines.clear();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "graphics/dynamic_resolution.hpp"
+#include "core/assert.hpp"
+
+#include <cmath>
+
+namespace scsr
+{
+
+/// Below this fraction of the budget the resolution grows
+static constexpr f64 GrowThreshold = 0.85;
+/// Above this fraction it shrinks
+static constexpr f64 ShrinkThreshold = 1.02;
+/// Largest relative change of one step, growing is slower than shrinking
+static constexpr f32 MaxShrink = 0.75f;
+static constexpr f32 GrowStep = 1.05f;
+static constexpr i32 SizeAlignment = 8;
+
+DynamicResolution::DynamicResolution(ImageProp output, DynamicResolutionProp prop) :
+    m_Output(output),
+    m_Prop(prop),
+    m_Scale(prop.maxScale)
+{
+    RT_ASSERT(prop.minScale > 0.0f && prop.minScale <= prop.maxScale, "Invalid dynamic resolution bounds");
+    m_Render = MakeRenderProp(m_Scale);
+}
+
+bool DynamicResolution::Update(f64 frameMs)
+{
+    m_AverageMs = m_AverageMs > 0.0 ? m_AverageMs + (frameMs - m_AverageMs) * m_Prop.smoothing : frameMs;
+    if (m_Cooldown > 0)
+    {
+        --m_Cooldown;
+        return false;
+    }
+
+    f64 load = m_AverageMs / m_Prop.targetMs;
+    f32 scale = m_Scale;
+    if (load > ShrinkThreshold)
+    {
+        /// Pixel count scales with the area, so the axes shrink by the square root
+        scale *= Max(static_cast<f32>(std::sqrt(1.0 / load)), MaxShrink);
+    }
+    else if (load < GrowThreshold)
+    {
+        scale *= GrowStep;
+    }
+    scale = Clamp(scale, m_Prop.minScale, m_Prop.maxScale);
+
+    ImageProp render = MakeRenderProp(scale);
+    m_Scale = scale;
+    if (render.width == m_Render.width && render.height == m_Render.height)
+    {
+        return false;
+    }
+
+    m_Render = render;
+    m_Cooldown = m_Prop.cooldown;
+    /// Frame times measured at the old size no longer apply
+    m_AverageMs = 0.0;
+    return true;
+}
+
+ImageProp DynamicResolution::MakeRenderProp(f32 scale) const
+{
+    auto align = [scale](i32 size) {
+        i32 scaled = static_cast<i32>(size * scale + 0.5f);
+        return Max(scaled / SizeAlignment * SizeAlignment, SizeAlignment);
+    };
+    /// Full scale keeps the exact output size so presenting needs no scaling
+    ImageProp prop = m_Output;
+    if (scale != 1.0f)
+    {
+        prop.width = align(m_Output.width);
+        prop.height = align(m_Output.height);
+    }
+    return prop;
+}
+
+}
\ No newline at end of file
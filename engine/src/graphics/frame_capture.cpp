@@ -0,0 +1,430 @@
+#include "graphics/frame_capture.hpp"
+#include "graphics/camera.hpp"
+#include "core/log.hpp"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <type_traits>
+
+namespace scsr
+{
+
+/// Fixed size part of a target, followed by its pixels, HDR colors and depth
+struct TargetRecord
+{
+    ImageProp prop;
+};
+
+/// Fixed size part of a rate image, followed by its tiles
+struct RatesRecord
+{
+    i32 width;
+    i32 height;
+    u64 tileCount;
+};
+
+/// Size of a uniform block, followed by its bytes
+struct UniformsRecord
+{
+    u64 size;
+};
+
+/// Fixed size part of a draw, followed by its vertices
+struct DrawRecord
+{
+    u32 target;
+    u32 rates;
+    u32 shader;
+    u32 uniforms;
+    Topology topology;
+    u64 vertexCount;
+    PipelineState state;
+    CapturedCamera camera;
+};
+
+static_assert(std::is_trivially_copyable_v<TargetRecord> && std::is_trivially_copyable_v<DrawRecord>
+    && std::is_trivially_copyable_v<Vertex> && std::is_trivially_copyable_v<Color>, "Captures are written as raw bytes");
+
+/// Larger sides only come from corrupt files
+static constexpr i32 MaxTargetSize = 1 << 15;
+
+template <typename T>
+static void WriteRaw(std::ofstream& file, const T* data, usize count)
+{
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+static bool ReadRaw(std::ifstream& file, T* data, usize count)
+{
+    file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(file);
+}
+
+/// Fills `out` with `count` values, false when the file ends first
+template <typename T>
+static bool ReadArray(std::ifstream& file, std::vector<T>& out, usize count)
+{
+    out.resize(count);
+    return ReadRaw(file, out.data(), count);
+}
+
+static usize PixelCount(const ImageProp& prop)
+{
+    return static_cast<usize>(prop.width) * prop.height;
+}
+
+/// Enums are read as raw bytes, values outside them only come from corrupt files
+static bool IsValid(ShadingRate rate)
+{
+    return rate == ShadingRate::Rate1x1 || rate == ShadingRate::Rate2x2 || rate == ShadingRate::Rate4x4;
+}
+
+static bool IsValid(const DrawRecord& record)
+{
+    const PipelineState& state = record.state;
+    return static_cast<u32>(record.topology) <= static_cast<u32>(Topology::TriangleFan)
+        && static_cast<u32>(state.cullMode) <= static_cast<u32>(FaceCullMode::CW)
+        && static_cast<u32>(state.blend) <= static_cast<u32>(BlendMode::Multiply) && IsValid(state.shadingRate);
+}
+
+void FrameCapture::Begin()
+{
+    m_Targets.clear();
+    m_Rates.clear();
+    m_Uniforms.clear();
+    m_Draws.clear();
+    m_Images.clear();
+    m_Shader = 0;
+    m_CurrentUniforms = ~0u;
+    m_Recording = true;
+}
+
+void FrameCapture::SetShader(u32 shader, std::vector<u8> uniforms)
+{
+    m_Shader = shader;
+    m_CurrentUniforms = ~0u;
+    if (!uniforms.empty())
+    {
+        m_Uniforms.push_back(std::move(uniforms));
+        m_CurrentUniforms = static_cast<u32>(m_Uniforms.size() - 1);
+    }
+}
+
+void FrameCapture::RecordDraw(const Image& target, const Mesh& mesh, const PipelineState& state, const Camera& camera,
+    const ShadingRateImage* rates)
+{
+    ZoneScoped;
+    /// An image resized since it was first seen is another target
+    u32 index = 0;
+    while (index < m_Images.size()
+        && (m_Images[index] != &target || m_Targets[index].prop.width != target.Width() || m_Targets[index].prop.height != target.Height()))
+    {
+        ++index;
+    }
+    if (index == m_Images.size())
+    {
+        m_Images.push_back(&target);
+        CapturedTarget& copy = m_Targets.emplace_back();
+        copy.prop = target.Prop();
+        const usize count = PixelCount(copy.prop);
+        copy.pixels.assign(target.Data(), target.Data() + count);
+        if (target.HdrData())
+        {
+            copy.hdr.assign(target.HdrData(), target.HdrData() + count);
+        }
+        copy.depth.assign(target.DepthData(), target.DepthData() + count);
+    }
+
+    CapturedDraw& draw = m_Draws.emplace_back();
+    draw.target = index;
+    if (rates)
+    {
+        const ShadingRate* tiles = rates->Row(0);
+        const usize tileCount = static_cast<usize>(rates->TilesX()) * rates->TilesY();
+        bool same = !m_Rates.empty() && m_Rates.back().width == rates->Width() && m_Rates.back().height == rates->Height()
+            && std::equal(tiles, tiles + tileCount, m_Rates.back().tiles.begin());
+        if (!same)
+        {
+            m_Rates.push_back(CapturedRates { rates->Width(), rates->Height(), std::vector<ShadingRate>(tiles, tiles + tileCount) });
+        }
+        draw.rates = static_cast<u32>(m_Rates.size() - 1);
+    }
+    draw.shader = m_Shader;
+    draw.uniforms = m_CurrentUniforms;
+    draw.state = state;
+    draw.camera = CapturedCamera {
+        .view = camera.GetView(),
+        .projection = camera.GetProjection(),
+        .position = camera.GetPosition(),
+        .front = camera.GetFront(),
+        .up = camera.GetUp(),
+    };
+    draw.mesh.topology = mesh.topology;
+    draw.mesh.vertices = mesh.vertices;
+}
+
+bool FrameCapture::Save(const std::string& path) const
+{
+    ZoneScoped;
+    std::ofstream file(path, std::ios::binary);
+    if (!file) { return false; }
+    FrameCaptureHeader header;
+    header.targetCount = static_cast<u32>(m_Targets.size());
+    header.rateCount = static_cast<u32>(m_Rates.size());
+    header.uniformCount = static_cast<u32>(m_Uniforms.size());
+    header.drawCount = static_cast<u32>(m_Draws.size());
+    WriteRaw(file, &header, 1);
+    for (const CapturedTarget& target : m_Targets)
+    {
+        TargetRecord record { target.prop };
+        WriteRaw(file, &record, 1);
+        WriteRaw(file, target.pixels.data(), target.pixels.size());
+        WriteRaw(file, target.hdr.data(), target.hdr.size());
+        WriteRaw(file, target.depth.data(), target.depth.size());
+    }
+    for (const CapturedRates& rates : m_Rates)
+    {
+        RatesRecord record { rates.width, rates.height, rates.tiles.size() };
+        WriteRaw(file, &record, 1);
+        WriteRaw(file, rates.tiles.data(), rates.tiles.size());
+    }
+    for (const std::vector<u8>& uniforms : m_Uniforms)
+    {
+        UniformsRecord record { uniforms.size() };
+        WriteRaw(file, &record, 1);
+        WriteRaw(file, uniforms.data(), uniforms.size());
+    }
+    for (const CapturedDraw& draw : m_Draws)
+    {
+        DrawRecord record { draw.target, draw.rates, draw.shader, draw.uniforms, draw.mesh.topology, draw.mesh.vertices.size(), draw.state, draw.camera };
+        WriteRaw(file, &record, 1);
+        WriteRaw(file, draw.mesh.vertices.data(), draw.mesh.vertices.size());
+    }
+    return static_cast<bool>(file);
+}
+
+bool FrameCapture::Load(const std::string& path)
+{
+    ZoneScoped;
+    m_Targets.clear();
+    m_Rates.clear();
+    m_Uniforms.clear();
+    m_Draws.clear();
+    m_Images.clear();
+    m_Recording = false;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) { return false; }
+    /// Bounds the counts read before allocating
+    const u64 size = static_cast<u64>(file.tellg());
+    file.seekg(0);
+    FrameCaptureHeader header;
+    if (!ReadRaw(file, &header, 1) || header.magic != FrameCaptureHeader::Magic || header.version != FrameCaptureHeader::Version)
+    {
+        LOG_WARN("{} is not a frame capture", path);
+        return false;
+    }
+
+    auto fail = [&](const char* what) {
+        LOG_WARN("Frame capture {} has a bad {}", path, what);
+        m_Targets.clear();
+        m_Rates.clear();
+        m_Uniforms.clear();
+        m_Draws.clear();
+        return false;
+    };
+    for (u32 i = 0; i < header.targetCount; ++i)
+    {
+        TargetRecord record;
+        if (!ReadRaw(file, &record, 1)) { return fail("target"); }
+        const ImageProp& prop = record.prop;
+        if (prop.width <= 0 || prop.height <= 0 || prop.width > MaxTargetSize || prop.height > MaxTargetSize
+            || PixelCount(prop) > size / sizeof(u32))
+        {
+            return fail("target");
+        }
+        CapturedTarget& target = m_Targets.emplace_back();
+        target.prop = prop;
+        const usize count = PixelCount(prop);
+        if (!ReadArray(file, target.pixels, count) || !ReadArray(file, target.hdr, prop.hdr ? count : 0)
+            || !ReadArray(file, target.depth, count))
+        {
+            return fail("target");
+        }
+    }
+    for (u32 i = 0; i < header.rateCount; ++i)
+    {
+        RatesRecord record;
+        if (!ReadRaw(file, &record, 1) || record.width <= 0 || record.height <= 0
+            || record.width > MaxTargetSize || record.height > MaxTargetSize)
+        {
+            return fail("rate image");
+        }
+        CapturedRates& rates = m_Rates.emplace_back(CapturedRates { record.width, record.height });
+        const usize tileCount = static_cast<usize>((record.width + ShadingRateImage::TileSize - 1) / ShadingRateImage::TileSize)
+            * ((record.height + ShadingRateImage::TileSize - 1) / ShadingRateImage::TileSize);
+        if (record.tileCount != tileCount || !ReadArray(file, rates.tiles, tileCount)
+            || !std::all_of(rates.tiles.begin(), rates.tiles.end(), [](ShadingRate rate) { return IsValid(rate); }))
+        {
+            return fail("rate image");
+        }
+    }
+    for (u32 i = 0; i < header.uniformCount; ++i)
+    {
+        UniformsRecord record;
+        if (!ReadRaw(file, &record, 1) || record.size > size || !ReadArray(file, m_Uniforms.emplace_back(), record.size))
+        {
+            return fail("uniform block");
+        }
+    }
+    for (u32 i = 0; i < header.drawCount; ++i)
+    {
+        DrawRecord record;
+        if (!ReadRaw(file, &record, 1) || !IsValid(record) || record.target >= m_Targets.size()
+            || (record.rates != ~0u && record.rates >= m_Rates.size())
+            || (record.uniforms != ~0u && record.uniforms >= m_Uniforms.size()))
+        {
+            return fail("draw");
+        }
+        CapturedDraw& draw = m_Draws.emplace_back();
+        draw.target = record.target;
+        draw.rates = record.rates;
+        draw.shader = record.shader;
+        draw.uniforms = record.uniforms;
+        draw.state = record.state;
+        draw.camera = record.camera;
+        draw.mesh.topology = record.topology;
+        if (record.vertexCount > size / sizeof(Vertex) || !ReadArray(file, draw.mesh.vertices, record.vertexCount))
+        {
+            return fail("draw");
+        }
+    }
+    return true;
+}
+
+FrameReplay::FrameReplay(const FrameCapture& capture) :
+    m_Capture(capture),
+    m_Camera(MakeRef<Camera>(Radians(45.0f), 1.0f, 0.1f, 100.0f))
+{
+    for (const CapturedTarget& target : capture.Targets())
+    {
+        m_Targets.push_back(MakeRef<Image>(target.prop));
+    }
+    for (const CapturedRates& rates : capture.Rates())
+    {
+        auto image = MakeRef<ShadingRateImage>(rates.width, rates.height);
+        for (i32 ty = 0; ty < image->TilesY(); ++ty)
+        {
+            for (i32 tx = 0; tx < image->TilesX(); ++tx)
+            {
+                image->SetTile(tx, ty, rates.tiles[static_cast<usize>(ty) * image->TilesX() + tx]);
+            }
+        }
+        m_Rates.push_back(image);
+    }
+}
+
+void FrameReplay::Restore()
+{
+    ZoneScoped;
+    const auto& targets = m_Capture.Targets();
+    for (usize i = 0; i < targets.size(); ++i)
+    {
+        Image& image = *m_Targets[i];
+        std::copy(targets[i].pixels.begin(), targets[i].pixels.end(), image.Data());
+        if (image.HdrData())
+        {
+            std::copy(targets[i].hdr.begin(), targets[i].hdr.end(), image.HdrData());
+        }
+        std::copy(targets[i].depth.begin(), targets[i].depth.end(), image.DepthData());
+    }
+    /// Bound anew by the first draw of the run
+    m_StandInBound = false;
+}
+
+bool FrameReplay::Bind(Pipeline& pipeline, const CapturedDraw& draw)
+{
+    m_Draw = &draw;
+    /// Face culling reads the camera front
+    m_Camera->SetPosition(draw.camera.position);
+    m_Camera->SetOrientation(draw.camera.front, draw.camera.up);
+    pipeline.SetCamera(m_Camera);
+    pipeline.SetState(draw.state);
+    pipeline.SetShadingRateImage(draw.rates != ~0u ? m_Rates[draw.rates] : nullptr);
+
+    static const std::vector<u8> NoUniforms;
+    const std::vector<u8>& uniforms = draw.uniforms != ~0u ? m_Capture.Uniforms()[draw.uniforms] : NoUniforms;
+    if (auto it = m_Shaders.find(draw.shader); it != m_Shaders.end() && it->second(pipeline, draw, uniforms))
+    {
+        m_StandInBound = false;
+        return true;
+    }
+    if (m_StandInBound) { return false; }
+
+    struct ReplayVaryings { Vec3 normal; };
+    pipeline.SetShader(Shader<ReplayVaryings> {
+        .vertex = [this](const Vertex& vtx, ReplayVaryings& out) -> Vec4 {
+            const CapturedCamera& camera = m_Draw->camera;
+            Vec4 viewPos = camera.view * vtx.pos;
+            out.normal = (camera.view * Vec4(vtx.normal, 0.0f)).xyz();
+            return camera.projection * viewPos;
+        },
+        .pixel = [](const ReplayVaryings& in) -> Vec4 {
+            f32 facing = Abs(in.normal.z) / Max(Length(in.normal), 1e-6f);
+            return Vec4(Vec3::ONE() * facing, 1.0f);
+        },
+    });
+    m_StandInBound = true;
+    return false;
+}
+
+void FrameReplay::Run(Pipeline& pipeline, std::vector<ReplayDrawStats>& stats)
+{
+    ZoneScoped;
+    Restore();
+    stats.clear();
+    for (const CapturedDraw& draw : m_Capture.Draws())
+    {
+        const bool standIn = !Bind(pipeline, draw);
+        pipeline.ResetStats();
+        auto start = std::chrono::steady_clock::now();
+        pipeline.Perform(m_Targets[draw.target], draw.mesh);
+        f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const PipelineStats& drawStats = pipeline.GetStats();
+        stats.push_back(ReplayDrawStats {
+            .ms = ms,
+            .triangles = drawStats.triangles,
+            .trianglesKept = drawStats.trianglesKept,
+            .pixels = drawStats.pixelsCovered,
+            .shaded = drawStats.pixels,
+            .standIn = standIn,
+        });
+    }
+    m_Draw = nullptr;
+}
+
+void FrameReplay::Overdraw(Pipeline& pipeline, std::vector<std::vector<u32>>& counts)
+{
+    ZoneScoped;
+    Restore();
+    const auto& targets = m_Capture.Targets();
+    counts.resize(targets.size());
+    for (usize i = 0; i < targets.size(); ++i)
+    {
+        counts[i].assign(PixelCount(targets[i].prop), 0);
+    }
+    for (const CapturedDraw& draw : m_Capture.Draws())
+    {
+        Bind(pipeline, draw);
+        pipeline.SetOverdrawCounts(&counts[draw.target]);
+        pipeline.Perform(m_Targets[draw.target], draw.mesh);
+    }
+    pipeline.SetOverdrawCounts(nullptr);
+    m_Draw = nullptr;
+}
+
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "graphics/gltf.hpp"
+#include "core/math/ext.hpp"
+#include "core/log.hpp"
 
 #include <json.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace scsr
@@ -38,13 +42,19 @@ void GLTF::Load()
         GLBChunk chunk;
         in.read(reinterpret_cast<byte*>(&chunk.chunkLength), sizeof(u32));
         in.read(reinterpret_cast<byte*>(&chunk.chunkType), sizeof(u32));
-        if (chunk.chunkType != Bin) { continue; } // Not BIN chunk
+        if (in.fail()) { break; }
+        if (chunk.chunkType != Bin) { in.seekg(chunk.chunkLength, std::ios::cur); continue; } // Not BIN chunk
         chunk.chunkData.resize(chunk.chunkLength);
         in.read(reinterpret_cast<byte*>(chunk.chunkData.data()), chunk.chunkLength);
 
         chunks.push_back(chunk);
     }
 
+    if (!chunks.empty())
+    {
+        m_binary = std::move(chunks.front().chunkData);
+    }
+
     nlohmann::json gltf = nlohmann::json::parse(json);
 
     if (gltf.contains("scenes")) {
@@ -84,6 +94,7 @@ void GLTF::Load()
             if (bufferView.contains("buffer")) { bv.buffer = bufferView["buffer"]; }
             if (bufferView.contains("byteLength")) { bv.byterLength = bufferView["byteLength"]; }
             if (bufferView.contains("byteOffset")) { bv.byteOffset = bufferView["byteOffset"]; }
+            if (bufferView.contains("byteStride")) { bv.byteStride = bufferView["byteStride"]; }
             if (bufferView.contains("target")) { bv.target = bufferView["target"]; }
             m_bufferViews.push_back(bv);
         }
@@ -140,6 +151,9 @@ void GLTF::Load()
                 auto scale = node["scale"];
                 n.scale = { scale[0], scale[1], scale[2] };
             }
+            if (node.contains("extras") && node["extras"].contains("static") && node["extras"]["static"].is_boolean()) {
+                n.isStatic = node["extras"]["static"];
+            }
             if (node.contains("mesh")) { n.mesh = node["mesh"]; }
             else { n.mesh = -1; }
             if (node.contains("children")) {
@@ -183,4 +197,176 @@ void GLTF::Load()
     in.close();
 }
 
+const u8* GLTF::AccessorData(u32 accessor, u32 idx, u32 elementSize) const
+{
+    const auto& a = m_accessors[accessor];
+    const auto& view = m_bufferViews[a.bufferView];
+    u32 stride = view.byteStride ? view.byteStride : elementSize;
+    usize offset = static_cast<usize>(view.byteOffset) + a.byteOffset + static_cast<usize>(idx) * stride;
+    if (offset + elementSize > m_binary.size()) { return nullptr; }
+    return m_binary.data() + offset;
+}
+
+void GLTF::AppendPrimitive(std::vector<Mesh>& meshes, const GLTFMesh::Primitive& primitive, const Mat4& transform) const
+{
+    /// Only FLOAT vertex attributes for now
+    if (primitive.mode > static_cast<u32>(Topology::TriangleFan) || primitive.attributes.position == GLTFMesh::None) { return; }
+
+    const Topology topology = static_cast<Topology>(primitive.mode);
+    const usize listStride = topology == Topology::Triangles ? 3 : topology == Topology::Lines ? 2 : 1;
+    const bool list = topology == Topology::Points || topology == Topology::Lines || topology == Topology::Triangles;
+    auto found = std::find_if(meshes.begin(), meshes.end(), [topology](const Mesh& m) { return m.topology == topology; });
+    if (!list || found == meshes.end())
+    {
+        meshes.emplace_back().topology = topology;
+        found = meshes.end() - 1;
+    }
+    Mesh& mesh = *found;
+    const usize first = mesh.vertices.size();
+
+    u32 count = m_accessors[primitive.attributes.position].count;
+    if (primitive.indices != GLTFMesh::None)
+    {
+        count = m_accessors[primitive.indices].count;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 idx = i;
+        if (primitive.indices != GLTFMesh::None)
+        {
+            const auto& accessor = m_accessors[primitive.indices];
+            u32 size = accessor.componentType == 5121 ? 1 : accessor.componentType == 5123 ? 2 : 4;
+            const u8* data = AccessorData(primitive.indices, i, size);
+            if (!data) { break; }
+            idx = 0;
+            std::memcpy(&idx, data, size);
+        }
+
+        Vertex vtx {};
+        Vec3 position;
+        const u8* data = AccessorData(primitive.attributes.position, idx, sizeof(Vec3));
+        if (!data) { break; }
+        std::memcpy(&position, data, sizeof(Vec3));
+        vtx.pos = transform * Vec4(position, 1.0f);
+
+        if (primitive.attributes.normal != GLTFMesh::None)
+        {
+            Vec3 normal;
+            if ((data = AccessorData(primitive.attributes.normal, idx, sizeof(Vec3))))
+            {
+                std::memcpy(&normal, data, sizeof(Vec3));
+                vtx.normal = Normalized((transform * Vec4(normal, 0.0f)).xyz());
+            }
+        }
+        if (primitive.attributes.texcoord_0 != GLTFMesh::None)
+        {
+            if ((data = AccessorData(primitive.attributes.texcoord_0, idx, sizeof(Vec2))))
+            {
+                std::memcpy(&vtx.uv, data, sizeof(Vec2));
+            }
+        }
+        mesh.vertices.push_back(vtx);
+    }
+
+    /// Lists are merged, a partial primitive would shift the ones after it
+    usize added = mesh.vertices.size() - first;
+    if (list && added % listStride != 0)
+    {
+        LOG_WARN("glTF {} has a truncated primitive list", m_path);
+        mesh.vertices.resize(mesh.vertices.size() - added % listStride);
+    }
+    if (mesh.vertices.empty())
+    {
+        meshes.erase(found);
+    }
+}
+
+void GLTF::AppendNode(std::vector<Mesh>& meshes, u32 nodeIdx, const Mat4& parent, bool withStatic, bool parentStatic) const
+{
+    const auto& node = m_nodes[nodeIdx];
+    Mat4 transform = parent * FromScaleRotationTranslation(node.scale, node.rotation, node.translation);
+    bool isStatic = parentStatic || node.isStatic;
+
+    if (node.mesh < m_meshes.size() && (withStatic || !isStatic))
+    {
+        for (const auto& primitive : m_meshes[node.mesh].primitives)
+        {
+            AppendPrimitive(meshes, primitive, transform);
+        }
+    }
+    for (u32 child : node.children)
+    {
+        AppendNode(meshes, child, transform, withStatic, isStatic);
+    }
+}
+
+void GLTF::AddStaticNode(StaticBatcher& batcher, u32 nodeIdx, const Mat4& parent, bool parentStatic) const
+{
+    const auto& node = m_nodes[nodeIdx];
+    Mat4 transform = parent * FromScaleRotationTranslation(node.scale, node.rotation, node.translation);
+    bool isStatic = parentStatic || node.isStatic;
+
+    if (node.mesh < m_meshes.size() && isStatic)
+    {
+        for (const auto& primitive : m_meshes[node.mesh].primitives)
+        {
+            std::vector<Mesh> parts;
+            AppendPrimitive(parts, primitive, transform);
+            for (Mesh& part : parts)
+            {
+                batcher.Add(std::move(part), Mat4::IDENTITY(), primitive.material);
+            }
+        }
+    }
+    for (u32 child : node.children)
+    {
+        AddStaticNode(batcher, child, transform, isStatic);
+    }
+}
+
+Mesh GLTF::ToMesh() const
+{
+    Mesh mesh;
+    for (const Mesh& part : ToMeshes())
+    {
+        if (part.topology < Topology::Triangles) { continue; }
+        usize count = PrimitiveCount(part.topology, part.vertices.size());
+        for (usize t = 0; t < count; ++t)
+        {
+            usize indices[3];
+            TriangleIndices(part.topology, t, indices);
+            for (usize i : indices)
+            {
+                mesh.vertices.push_back(part.vertices[i]);
+            }
+        }
+    }
+    return mesh;
+}
+
+std::vector<Mesh> GLTF::ToMeshes(bool withStatic) const
+{
+    std::vector<Mesh> meshes;
+    for (const auto& scene : m_scenes)
+    {
+        for (u32 node : scene.nodes)
+        {
+            AppendNode(meshes, node, Mat4::IDENTITY(), withStatic, false);
+        }
+    }
+    return meshes;
+}
+
+void GLTF::AddStatic(StaticBatcher& batcher) const
+{
+    for (const auto& scene : m_scenes)
+    {
+        for (u32 node : scene.nodes)
+        {
+            AddStaticNode(batcher, node, Mat4::IDENTITY(), false);
+        }
+    }
+}
+
 }
\ No newline at end of file
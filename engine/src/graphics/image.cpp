@@ -1,9 +1,13 @@
 #include "graphics/image.hpp"
+#include "graphics/line.hpp"
 #include "core/math/math.hpp"
+#include "core/assert.hpp"
 
-#include <SDL.h>
 #include <Tracy.hpp>
 
+#include <cstring>
+#include <algorithm>
+
 namespace scsr
 {
 
@@ -13,6 +17,14 @@ Image::Image(ImageProp prop) :
     Create();
 }
 
+Image::Image(ImageProp prop, u32* pixels) :
+    m_Data(pixels),
+    m_OwnsData(false),
+    m_Prop(prop)
+{
+    Create();
+}
+
 Image::~Image()
 {
     Release();
@@ -23,10 +35,32 @@ void Image::Clear()
     ZoneScopedN("Image Clear");
     std::memset(m_Data, 0, m_Prop.width * m_Prop.height * 4);
     std::fill(m_DepthBuffer, m_DepthBuffer + m_Prop.width * m_Prop.height, 1.0f);
+    if (m_HdrData)
+    {
+        std::memset(static_cast<void*>(m_HdrData), 0, sizeof(Color) * m_Prop.width * m_Prop.height);
+    }
+}
+
+void Image::Clear(const Rect& rect)
+{
+    ZoneScopedN("Image Clear");
+    Rect clip = Intersect(rect, Bounds());
+    if (clip.Empty()) { return; }
+    for (i32 y = clip.y0; y < clip.y1; ++y)
+    {
+        usize row = static_cast<usize>(y) * m_Prop.width;
+        std::fill(m_Data + row + clip.x0, m_Data + row + clip.x1, 0u);
+        std::fill(m_DepthBuffer + row + clip.x0, m_DepthBuffer + row + clip.x1, 1.0f);
+        if (m_HdrData)
+        {
+            std::fill(m_HdrData + row + clip.x0, m_HdrData + row + clip.x1, Color(0.0f, 0.0f, 0.0f, 0.0f));
+        }
+    }
 }
 
 void Image::Resize(ImageProp prop)
 {
+    RT_ASSERT(m_OwnsData, "Cannot resize an image over external pixels");
     Release();
     m_Prop = prop;
     Create();
@@ -46,28 +80,14 @@ void Image::SetPixel(Vec2i p, u32 color)
 void Image::SetLine(i32 x0, i32 y0, i32 x1, i32 y1, u32 color)
 {
     ZoneScoped;
-    i32 dx = Abs(x1 - x0);
-    i32 dy = Abs(y1 - y0);
-    i32 sx = x0 < x1 ? 1 : -1;
-    i32 sy = y0 < y1 ? 1 : -1;
-    i32 err = dx - dy;
-
-    while (true)
-    {
-        SetPixel(x0, y0, color);
-        if (x0 == x1 && y0 == y1) { break; }
-        i32 e2 = 2 * err;
-        if (e2 > -dy)
-        {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx)
-        {
-            err += dx;
-            y0 += sy;
-        }
-    }
+    /// Through the pixel centers, the parts outside the image are dropped
+    const ScreenLine line {
+        Vec3(static_cast<f32>(x0) + 0.5f, static_cast<f32>(y0) + 0.5f, 0.0f),
+        Vec3(static_cast<f32>(x1) + 0.5f, static_cast<f32>(y1) + 0.5f, 0.0f),
+        color,
+        Color(),
+    };
+    RasterizeLine(*this, line, Bounds());
 }
 
 void Image::SetLine(Vec2i p0, Vec2i p1, u32 color)
@@ -104,28 +124,37 @@ void Image::TestDepthAndSetPixel(Vec2i p, f32 depth, u32 color)
 
 void Image::Create()
 {
-    m_Data = new u32[m_Prop.width * m_Prop.height];
-    m_Surface = SDL_CreateRGBSurfaceFrom(
-        m_Data,
-        m_Prop.width, m_Prop.height, 32, m_Prop.width * 4,
-        0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF
-    );
+    if (m_OwnsData)
+    {
+        m_Data = new u32[m_Prop.width * m_Prop.height];
+    }
 
     m_DepthBuffer = new f32[m_Prop.width * m_Prop.height];
     std::fill(m_DepthBuffer, m_DepthBuffer + m_Prop.width * m_Prop.height, 1.0f);
+
+    if (m_Prop.hdr)
+    {
+        m_HdrData = new Color[m_Prop.width * m_Prop.height];
+        std::memset(static_cast<void*>(m_HdrData), 0, sizeof(Color) * m_Prop.width * m_Prop.height);
+    }
 }
 
 void Image::Release()
 {
-    if (m_Surface)
+    if (m_Data && m_OwnsData)
     {
-        SDL_FreeSurface(static_cast<SDL_Surface*>(m_Surface));
-        m_Surface = nullptr;
+        delete [] m_Data;
     }
-    if (m_Data)
+    m_Data = nullptr;
+    if (m_DepthBuffer)
     {
-        delete [] m_Data;
-        m_Data = nullptr;
+        delete [] m_DepthBuffer;
+        m_DepthBuffer = nullptr;
+    }
+    if (m_HdrData)
+    {
+        delete [] m_HdrData;
+        m_HdrData = nullptr;
     }
 }
 
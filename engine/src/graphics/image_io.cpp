@@ -0,0 +1,61 @@
+#include "graphics/image_io.hpp"
+#include "core/log.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <Tracy.hpp>
+
+#include <vector>
+#include <fstream>
+
+namespace scsr
+{
+
+static bool EndsWith(const std::string& str, const std::string& suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool WriteImage(const std::string& path, const PixelView& view)
+{
+    ZoneScopedN("Write image");
+
+    /// ABGR8888 is R, G, B, A in memory on little endian, the byte order both writers expect
+    std::vector<u32> pixels(static_cast<usize>(view.width) * view.height);
+    ConvertPixels(view, PixelView { pixels.data(), view.width, view.height, view.width, PixelFormat::ABGR8888 });
+
+    bool written = false;
+    if (EndsWith(path, ".ppm"))
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (file.is_open())
+        {
+            file << "P6\n" << view.width << " " << view.height << "\n255\n";
+            std::vector<u8> row(static_cast<usize>(view.width) * 3);
+            for (i32 y = 0; y < view.height; ++y)
+            {
+                const u8* in = reinterpret_cast<const u8*>(pixels.data() + static_cast<usize>(y) * view.width);
+                for (i32 x = 0; x < view.width; ++x)
+                {
+                    row[x * 3 + 0] = in[x * 4 + 0];
+                    row[x * 3 + 1] = in[x * 4 + 1];
+                    row[x * 3 + 2] = in[x * 4 + 2];
+                }
+                file.write(reinterpret_cast<const char*>(row.data()), row.size());
+            }
+            written = file.good();
+        }
+    }
+    else
+    {
+        written = stbi_write_png(path.c_str(), view.width, view.height, 4, pixels.data(), view.width * 4) != 0;
+    }
+
+    if (!written)
+    {
+        LOG_WARN("Failed to write image {}", path);
+    }
+    return written;
+}
+
+}
\ No newline at end of file
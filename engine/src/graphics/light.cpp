@@ -0,0 +1,341 @@
+#include "graphics/light.hpp"
+#include "graphics/camera.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace scsr
+{
+
+/// Lights transformed per job
+static constexpr usize LightGrain = 256;
+/// Larger frames only come from corrupt bytes
+static constexpr i32 MaxFrameSize = 1 << 15;
+
+/// Fixed size part of the `Serialize` bytes, followed by the view space
+/// lights, the clusters, and the light count and indices of every row
+struct LightListRecord
+{
+    f32 fillLight;
+    i32 width;
+    i32 height;
+    f32 scaleX;
+    f32 scaleY;
+    f32 nearClip;
+    f32 farClip;
+    f32 sliceScale;
+    f32 sliceBias;
+    u32 lightCount;
+};
+
+static_assert(std::is_trivially_copyable_v<LightListRecord> && std::is_trivially_copyable_v<PointLight>,
+    "Light lists are serialized as raw bytes");
+
+template <typename T>
+static void Append(std::vector<u8>& out, const T* data, usize count)
+{
+    const u8* bytes = reinterpret_cast<const u8*>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+/// Read `count` values at `offset` and move past them, false when `data` ends first
+template <typename T>
+static bool Take(const std::vector<u8>& data, usize& offset, T* out, usize count)
+{
+    if (count > (data.size() - offset) / sizeof(T)) { return false; }
+    std::memcpy(out, data.data() + offset, count * sizeof(T));
+    offset += count * sizeof(T);
+    return true;
+}
+
+u32 LightList::Add(const PointLight& light)
+{
+    m_Lights.push_back(light);
+    return static_cast<u32>(m_Lights.size() - 1);
+}
+
+void LightList::Clear()
+{
+    m_Lights.clear();
+}
+
+void LightList::Build(const Camera& camera, i32 width, i32 height)
+{
+    ZoneScoped;
+    m_Width = width;
+    m_Height = height;
+    m_TilesX = (width + TileSize - 1) / TileSize;
+    m_TilesY = (height + TileSize - 1) / TileSize;
+
+    const Mat4& projection = camera.GetProjection();
+    m_ScaleX = projection.m00;
+    m_ScaleY = projection.m11;
+    m_Near = camera.GetNearClip();
+    m_Far = camera.GetFarClip();
+    f32 logRange = std::log(m_Far / m_Near);
+    m_SliceScale = DepthSlices / logRange;
+    m_SliceBias = -DepthSlices * std::log(m_Near) / logRange;
+
+    const Mat4& view = camera.GetView();
+    m_ViewLights.resize(m_Lights.size());
+    m_Bounds.resize(m_Lights.size());
+    ThreadPool::Instance().ParallelFor(m_Lights.size(), LightGrain, [&](usize begin, usize end) {
+        for (usize i = begin; i < end; ++i)
+        {
+            PointLight light = m_Lights[i];
+            light.position = (view * Vec4(light.position, 1.0f)).xyz();
+            m_ViewLights[i] = light;
+            m_Bounds[i] = Bound(light);
+        }
+    });
+
+    /// One job per tile row of a slice, each writes only its own index list
+    usize rows = static_cast<usize>(DepthSlices) * m_TilesY;
+    m_Clusters.resize(rows * m_TilesX);
+    m_RowIndices.resize(rows);
+    ThreadPool::Instance().ParallelFor(rows, 1, [&](usize begin, usize end) {
+        for (usize row = begin; row < end; ++row)
+        {
+            AssignRow(static_cast<i32>(row / m_TilesY), static_cast<i32>(row % m_TilesY));
+        }
+    });
+}
+
+LightSpan LightList::Find(const Vec3& viewPos) const
+{
+    if (m_Clusters.empty()) { return {}; }
+
+    /// Clamped, points on the frustum edges may round outside
+    f32 depth = Max(-viewPos.z, m_Near);
+    f32 screenX = (m_ScaleX * viewPos.x / depth + 1.0f) * 0.5f * m_Width;
+    f32 screenY = (1.0f - m_ScaleY * viewPos.y / depth) * 0.5f * m_Height;
+    i32 x = Clamp(static_cast<i32>(screenX) / TileSize, 0, m_TilesX - 1);
+    i32 y = Clamp(static_cast<i32>(screenY) / TileSize, 0, m_TilesY - 1);
+    i32 z = Clamp(static_cast<i32>(std::floor(std::log(depth) * m_SliceScale + m_SliceBias)), 0, DepthSlices - 1);
+
+    usize row = static_cast<usize>(z) * m_TilesY + y;
+    const ClusterRange& range = m_Clusters[row * m_TilesX + x];
+    return { m_RowIndices[row].data() + range.offset, range.count };
+}
+
+Vec3 LightList::Shade(const Vec3& normal, const Vec3& viewPos) const
+{
+    Vec3 color = Vec3::ONE() * (Abs(normal.z) * m_FillLight);
+    for (u32 index : Find(viewPos))
+    {
+        const PointLight& light = m_ViewLights[index];
+        Vec3 toLight = light.position - viewPos;
+        f32 distance = Max(Length(toLight), 1e-4f);
+        f32 lambert = Max(Dot(normal, toLight) / distance, 0.0f);
+        color += light.color * (light.intensity * lambert * LightFalloff(distance, light.radius));
+    }
+    return color;
+}
+
+std::vector<u8> LightList::Serialize() const
+{
+    ZoneScoped;
+    LightListRecord record {
+        .fillLight = m_FillLight,
+        .width = m_Width,
+        .height = m_Height,
+        .scaleX = m_ScaleX,
+        .scaleY = m_ScaleY,
+        .nearClip = m_Near,
+        .farClip = m_Far,
+        .sliceScale = m_SliceScale,
+        .sliceBias = m_SliceBias,
+        .lightCount = static_cast<u32>(m_ViewLights.size()),
+    };
+    std::vector<u8> out;
+    Append(out, &record, 1);
+    Append(out, m_ViewLights.data(), m_ViewLights.size());
+    Append(out, m_Clusters.data(), m_Clusters.size());
+    for (const std::vector<u32>& indices : m_RowIndices)
+    {
+        u32 count = static_cast<u32>(indices.size());
+        Append(out, &count, 1);
+        Append(out, indices.data(), indices.size());
+    }
+    return out;
+}
+
+bool LightList::Deserialize(const std::vector<u8>& data)
+{
+    ZoneScoped;
+    usize offset = 0;
+    LightListRecord record;
+    if (!Take(data, offset, &record, 1) || record.width < 0 || record.height < 0
+        || record.width > MaxFrameSize || record.height > MaxFrameSize)
+    {
+        return false;
+    }
+    /// Before the first `Build` the frame is empty and no rows follow
+    const i32 tilesX = (record.width + TileSize - 1) / TileSize;
+    const i32 tilesY = (record.height + TileSize - 1) / TileSize;
+    const usize rows = static_cast<usize>(DepthSlices) * tilesY;
+    std::vector<PointLight> viewLights(Min<usize>(record.lightCount, data.size() / sizeof(PointLight)));
+    std::vector<ClusterRange> clusters(rows * tilesX);
+    std::vector<std::vector<u32>> rowIndices(rows);
+    if (viewLights.size() != record.lightCount || !Take(data, offset, viewLights.data(), viewLights.size())
+        || !Take(data, offset, clusters.data(), clusters.size()))
+    {
+        return false;
+    }
+    for (usize row = 0; row < rows; ++row)
+    {
+        u32 count;
+        if (!Take(data, offset, &count, 1) || count > data.size() / sizeof(u32)) { return false; }
+        std::vector<u32>& indices = rowIndices[row];
+        indices.resize(count);
+        if (!Take(data, offset, indices.data(), count)) { return false; }
+        for (u32 index : indices)
+        {
+            if (index >= record.lightCount) { return false; }
+        }
+        for (i32 x = 0; x < tilesX; ++x)
+        {
+            const ClusterRange& range = clusters[row * tilesX + x];
+            if (range.offset > count || range.count > count - range.offset) { return false; }
+        }
+    }
+    if (offset != data.size() || (!clusters.empty() && !(record.nearClip > 0.0f && record.farClip > record.nearClip)))
+    {
+        return false;
+    }
+
+    m_FillLight = record.fillLight;
+    m_Width = record.width;
+    m_Height = record.height;
+    m_TilesX = tilesX;
+    m_TilesY = tilesY;
+    m_ScaleX = record.scaleX;
+    m_ScaleY = record.scaleY;
+    m_Near = record.nearClip;
+    m_Far = record.farClip;
+    m_SliceScale = record.sliceScale;
+    m_SliceBias = record.sliceBias;
+    m_ViewLights = std::move(viewLights);
+    m_Clusters = std::move(clusters);
+    m_RowIndices = std::move(rowIndices);
+    m_Bounds.clear();
+    return true;
+}
+
+usize LightList::AssignedCount() const
+{
+    usize count = 0;
+    for (const ClusterRange& range : m_Clusters)
+    {
+        count += range.count;
+    }
+    return count;
+}
+
+LightList::LightBounds LightList::Bound(const PointLight& light) const
+{
+    const LightBounds empty { 0, 0, 1, -1, -1, 0 };
+    f32 depth = -light.position.z;
+    f32 nearest = depth - light.radius;
+    f32 farthest = depth + light.radius;
+    if (farthest < m_Near || nearest > m_Far) { return empty; }
+
+    auto slice = [&](f32 d) {
+        return Clamp(static_cast<i32>(std::floor(std::log(d) * m_SliceScale + m_SliceBias)), 0, DepthSlices - 1);
+    };
+    LightBounds bounds { 0, 0, 0, m_TilesX - 1, m_TilesY - 1, slice(Min(farthest, m_Far)) };
+
+    /// Reaching past the near plane, the projection is unbounded
+    if (nearest <= m_Near) { return bounds; }
+    bounds.z0 = slice(nearest);
+
+    /// NDC extent of the light's view space box, each side is widest at the
+    /// nearest depth when it lies away from the axis and at the farthest otherwise
+    f32 lo[2] = { light.position.x - light.radius, light.position.y - light.radius };
+    f32 hi[2] = { light.position.x + light.radius, light.position.y + light.radius };
+    f32 scale[2] = { m_ScaleX, m_ScaleY };
+    f32 ndcLo[2], ndcHi[2];
+    for (i32 i = 0; i < 2; ++i)
+    {
+        ndcLo[i] = scale[i] * lo[i] / (lo[i] < 0.0f ? nearest : farthest);
+        ndcHi[i] = scale[i] * hi[i] / (hi[i] > 0.0f ? nearest : farthest);
+        if (ndcHi[i] < -1.0f || ndcLo[i] > 1.0f) { return empty; }
+    }
+
+    /// Screen y grows downwards
+    auto tile = [](f32 screen, i32 tiles) { return Clamp(static_cast<i32>(std::floor(screen / TileSize)), 0, tiles - 1); };
+    bounds.x0 = tile((ndcLo[0] + 1.0f) * 0.5f * m_Width, m_TilesX);
+    bounds.x1 = tile((ndcHi[0] + 1.0f) * 0.5f * m_Width, m_TilesX);
+    bounds.y0 = tile((1.0f - ndcHi[1]) * 0.5f * m_Height, m_TilesY);
+    bounds.y1 = tile((1.0f - ndcLo[1]) * 0.5f * m_Height, m_TilesY);
+    return bounds;
+}
+
+void LightList::AssignRow(i32 z, i32 y)
+{
+    usize row = static_cast<usize>(z) * m_TilesY + y;
+    std::vector<u32>& indices = m_RowIndices[row];
+    ClusterRange* clusters = m_Clusters.data() + row * m_TilesX;
+    indices.clear();
+
+    /// Lights whose screen and depth bounds overlap this row
+    thread_local std::vector<u32> candidates;
+    candidates.clear();
+    for (u32 i = 0; i < m_Bounds.size(); ++i)
+    {
+        const LightBounds& b = m_Bounds[i];
+        if (z >= b.z0 && z <= b.z1 && y >= b.y0 && y <= b.y1)
+        {
+            candidates.push_back(i);
+        }
+    }
+
+    /// View space box of each cluster, the frustum piece spans both depths
+    f32 d0 = SliceDepth(z);
+    f32 d1 = SliceDepth(z + 1);
+    f32 ndcTop = 1.0f - 2.0f * (y * TileSize) / m_Height;
+    f32 ndcBottom = 1.0f - 2.0f * Min((y + 1) * TileSize, m_Height) / m_Height;
+    f32 yLo = Min(ndcBottom * d0, ndcBottom * d1) / m_ScaleY;
+    f32 yHi = Max(ndcTop * d0, ndcTop * d1) / m_ScaleY;
+
+    for (i32 x = 0; x < m_TilesX; ++x)
+    {
+        f32 ndcLeft = 2.0f * (x * TileSize) / m_Width - 1.0f;
+        f32 ndcRight = 2.0f * Min((x + 1) * TileSize, m_Width) / m_Width - 1.0f;
+        Vec3 boxLo(Min(ndcLeft * d0, ndcLeft * d1) / m_ScaleX, yLo, -d1);
+        Vec3 boxHi(Max(ndcRight * d0, ndcRight * d1) / m_ScaleX, yHi, -d0);
+
+        clusters[x].offset = static_cast<u32>(indices.size());
+        for (u32 index : candidates)
+        {
+            const LightBounds& b = m_Bounds[index];
+            if (x < b.x0 || x > b.x1) { continue; }
+
+            /// Sphere against box, distance from the center to the nearest box point
+            const PointLight& light = m_ViewLights[index];
+            f32 distance2 = 0.0f;
+            for (i32 i = 0; i < 3; ++i)
+            {
+                f32 p = light.position.data[i];
+                f32 d = Clamp(p, boxLo.data[i], boxHi.data[i]) - p;
+                distance2 += d * d;
+            }
+            if (distance2 <= light.radius * light.radius)
+            {
+                indices.push_back(index);
+            }
+        }
+        clusters[x].count = static_cast<u32>(indices.size()) - clusters[x].offset;
+    }
+}
+
+f32 LightList::SliceDepth(i32 z) const
+{
+    return m_Near * std::pow(m_Far / m_Near, static_cast<f32>(z) / DepthSlices);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "graphics/line.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace scsr
+{
+
+/// Rows per band of `RasterizeLines`
+static constexpr i32 BandRows = 16;
+
+bool ClipLine(Vec4& a, Vec4& b)
+{
+    /// Liang-Barsky against -w <= x, y, z <= w, distances are positive inside
+    auto distances = [](const Vec4& p, f32 out[6]) {
+        out[0] = p.w + p.x; out[1] = p.w - p.x;
+        out[2] = p.w + p.y; out[3] = p.w - p.y;
+        out[4] = p.w + p.z; out[5] = p.w - p.z;
+    };
+    f32 da[6], db[6];
+    distances(a, da);
+    distances(b, db);
+
+    f32 t0 = 0.0f;
+    f32 t1 = 1.0f;
+    for (i32 i = 0; i < 6; ++i)
+    {
+        if (da[i] < 0.0f && db[i] < 0.0f) { return false; }
+        if (da[i] < 0.0f) { t0 = Max(t0, da[i] / (da[i] - db[i])); }
+        else if (db[i] < 0.0f) { t1 = Min(t1, da[i] / (da[i] - db[i])); }
+    }
+    if (t0 > t1) { return false; }
+
+    Vec4 delta = b - a;
+    Vec4 start = a + delta * t0;
+    b = a + delta * t1;
+    a = start;
+    return a.w > 0.0f && b.w > 0.0f;
+}
+
+Vec3 ClipToScreen(const Vec4& clip, i32 width, i32 height)
+{
+    f32 rhw = 1.0f / clip.w;
+    return Vec3(
+        (clip.x * rhw + 1.0f) * 0.5f * width,
+        (1.0f - clip.y * rhw) * 0.5f * height,
+        clip.z * rhw
+    );
+}
+
+template <bool DepthTest>
+static void Rasterize(Image& image, const ScreenLine& line, const Rect& clip, bool depthWrite, f32 depthBias)
+{
+    Vec3 p0 = line.p0;
+    Vec3 p1 = line.p1;
+    if (p0.y > p1.y) { std::swap(p0, p1); }
+
+    const i32 width = image.Width();
+    const Rect bounds = Intersect(clip, image.Bounds());
+    i32 first = Max(static_cast<i32>(std::floor(p0.y)), bounds.y0);
+    i32 last = Min(static_cast<i32>(std::floor(p1.y)), bounds.y1 - 1);
+    if (first > last) { return; }
+
+    f32 dx = p1.x - p0.x;
+    f32 dy = p1.y - p0.y;
+    f32 dz = p1.z - p0.z;
+    /// Depth steps along the major axis
+    bool xMajor = Abs(dx) >= Abs(dy);
+    f32 dzdx = Abs(dx) > 1e-6f ? dz / dx : 0.0f;
+    f32 dxdy = dy > 1e-6f ? dx / dy : 0.0f;
+
+    u32* pixels = image.Data();
+    f32* depths = image.DepthData();
+    Color* hdr = DepthTest ? image.HdrData() : nullptr;
+    for (i32 y = first; y <= last; ++y)
+    {
+        /// The piece of the segment inside this row
+        f32 ya = Max(p0.y, static_cast<f32>(y));
+        f32 yb = Min(p1.y, static_cast<f32>(y + 1));
+        f32 xa = dy > 1e-6f ? p0.x + (ya - p0.y) * dxdy : p0.x;
+        f32 xb = dy > 1e-6f ? p0.x + (yb - p0.y) * dxdy : p1.x;
+        if (xa > xb) { std::swap(xa, xb); }
+
+        i32 begin = Max(static_cast<i32>(std::floor(xa)), bounds.x0);
+        /// Half open, a span ending on a pixel edge stops before that pixel
+        i32 end = Min(Max(static_cast<i32>(std::ceil(xb)) - 1, static_cast<i32>(std::floor(xa))), bounds.x1 - 1);
+        if (begin > end) { continue; }
+
+        usize row = static_cast<usize>(y) * width;
+        if constexpr (!DepthTest)
+        {
+            std::fill(pixels + row + begin, pixels + row + end + 1, line.color);
+            continue;
+        }
+
+        f32 z;
+        if (xMajor)
+        {
+            z = p0.z + (static_cast<f32>(begin) + 0.5f - p0.x) * dzdx;
+        }
+        else
+        {
+            f32 t = Clamp((static_cast<f32>(y) + 0.5f - p0.y) / dy, 0.0f, 1.0f);
+            z = p0.z + dz * t;
+        }
+        f32 step = xMajor ? dzdx : 0.0f;
+        for (i32 x = begin; x <= end; ++x, z += step)
+        {
+            usize index = row + x;
+            if (z < depths[index] + depthBias)
+            {
+                if (hdr) { hdr[index] = line.linear; }
+                else { pixels[index] = line.color; }
+                if (depthWrite) { depths[index] = z; }
+            }
+        }
+    }
+}
+
+void RasterizeLine(Image& image, const ScreenLine& line, const Rect& clip, bool depthWrite, f32 depthBias)
+{
+    Rasterize<true>(image, line, clip, depthWrite, depthBias);
+}
+
+void RasterizeLine(Image& image, const ScreenLine& line, const Rect& clip)
+{
+    Rasterize<false>(image, line, clip, false, 0.0f);
+}
+
+void RasterizeLines(Image& image, std::span<const ScreenLine> lines, const Rect& clip, bool depthWrite, f32 depthBias)
+{
+    ZoneScoped;
+    const Rect bounds = Intersect(clip, image.Bounds());
+    if (lines.empty() || bounds.Empty()) { return; }
+
+    /// Bin the lines by the bands they cross, counting first so every bin
+    /// keeps the submission order
+    const i32 bandCount = (bounds.Height() + BandRows - 1) / BandRows;
+    auto bandRange = [&](const ScreenLine& line, i32& first, i32& last) {
+        i32 top = static_cast<i32>(std::floor(Min(line.p0.y, line.p1.y)));
+        i32 bottom = static_cast<i32>(std::floor(Max(line.p0.y, line.p1.y)));
+        first = Max(top - bounds.y0, 0) / BandRows;
+        last = Min(bottom - bounds.y0, bounds.Height() - 1) / BandRows;
+        return top < bounds.y1 && bottom >= bounds.y0;
+    };
+    std::vector<u32> offsets(static_cast<usize>(bandCount) + 1, 0);
+    for (const ScreenLine& line : lines)
+    {
+        i32 first, last;
+        if (!bandRange(line, first, last)) { continue; }
+        for (i32 band = first; band <= last; ++band)
+        {
+            ++offsets[band + 1];
+        }
+    }
+    for (i32 band = 0; band < bandCount; ++band)
+    {
+        offsets[band + 1] += offsets[band];
+    }
+    std::vector<u32> binned(offsets.back());
+    std::vector<u32> cursor(offsets.begin(), offsets.end() - 1);
+    for (usize i = 0; i < lines.size(); ++i)
+    {
+        i32 first, last;
+        if (!bandRange(lines[i], first, last)) { continue; }
+        for (i32 band = first; band <= last; ++band)
+        {
+            binned[cursor[band]++] = static_cast<u32>(i);
+        }
+    }
+
+    ThreadPool::Instance().ParallelFor(static_cast<usize>(bandCount), 1, [&](usize begin, usize end) {
+        for (usize band = begin; band < end; ++band)
+        {
+            i32 y0 = bounds.y0 + static_cast<i32>(band) * BandRows;
+            const Rect rows { bounds.x0, y0, bounds.x1, Min(y0 + BandRows, bounds.y1) };
+            for (u32 i = offsets[band]; i < offsets[band + 1]; ++i)
+            {
+                Rasterize<true>(image, lines[binned[i]], rows, depthWrite, depthBias);
+            }
+        }
+    });
+}
+
+}
\ No newline at end of file
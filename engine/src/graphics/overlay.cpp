@@ -0,0 +1,283 @@
+#include "graphics/overlay.hpp"
+#include "graphics/blit.hpp"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+#include <Tracy.hpp>
+#include <fmt/core.h>
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+namespace scsr
+{
+
+/// Panel border and the gap between text and graph
+static constexpr i32 Padding = 4;
+/// RGBA8888
+static constexpr u32 PanelColor = 0x000000A0u;
+static constexpr u32 GoodColor = 0x40E040FFu;
+static constexpr u32 SlowColor = 0xE0E040FFu;
+static constexpr u32 BadColor = 0xE04040FFu;
+static constexpr u32 BudgetColor = 0xFFFFFF60u;
+
+bool GlyphAtlas::Load(const std::string& path, f32 pixelHeight)
+{
+    ZoneScoped;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { return false; }
+    std::vector<u8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    stbtt_fontinfo info;
+    i32 offset = data.empty() ? -1 : stbtt_GetFontOffsetForIndex(data.data(), 0);
+    if (offset < 0 || !stbtt_InitFont(&info, data.data(), offset)) { return false; }
+
+    const f32 scale = stbtt_ScaleForPixelHeight(&info, pixelHeight);
+    i32 ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+    m_Ascent = static_cast<i32>(std::ceil(ascent * scale));
+    m_LineHeight = static_cast<i32>(std::ceil((ascent - descent + lineGap) * scale));
+
+    /// Shelf packing, glyphs one pixel apart so scaled sprites do not bleed
+    struct Box
+    {
+        i32 x0, y0, x1, y1;
+    };
+    std::vector<Box> boxes;
+    std::vector<Glyph> glyphs;
+    i32 x = 1, y = 1, shelf = 0;
+    for (i32 c = FirstChar; c <= LastChar; ++c)
+    {
+        i32 advance, bearing;
+        stbtt_GetCodepointHMetrics(&info, c, &advance, &bearing);
+        Box box;
+        stbtt_GetCodepointBitmapBox(&info, c, scale, scale, &box.x0, &box.y0, &box.x1, &box.y1);
+        Glyph glyph { .x0 = box.x0, .y0 = box.y0, .advance = static_cast<i32>(std::lround(advance * scale)) };
+        const i32 w = box.x1 - box.x0;
+        const i32 h = box.y1 - box.y0;
+        if (w > 0 && h > 0 && w + 2 <= AtlasWidth)
+        {
+            if (x + w + 1 > AtlasWidth)
+            {
+                x = 1;
+                y += shelf + 1;
+                shelf = 0;
+            }
+            glyph.region = static_cast<u32>(boxes.size());
+            boxes.push_back({ x, y, x + w, y + h });
+            x += w + 1;
+            shelf = Max(shelf, h);
+        }
+        glyphs.push_back(glyph);
+    }
+
+    const i32 height = y + shelf + 1;
+    std::vector<u8> coverage(static_cast<usize>(AtlasWidth) * height, 0);
+    for (i32 c = FirstChar; c <= LastChar; ++c)
+    {
+        const Glyph& glyph = glyphs[c - FirstChar];
+        if (glyph.region == ~0u) { continue; }
+        const Box& box = boxes[glyph.region];
+        stbtt_MakeCodepointBitmap(&info, coverage.data() + static_cast<usize>(box.y0) * AtlasWidth + box.x0,
+            box.x1 - box.x0, box.y1 - box.y0, AtlasWidth, scale, scale, c);
+    }
+
+    /// White, the coverage becomes alpha
+    auto image = MakeRef<Image>(ImageProp { .width = AtlasWidth, .height = height });
+    for (usize i = 0; i < coverage.size(); ++i)
+    {
+        image->Data()[i] = 0xFFFFFF00u | coverage[i];
+    }
+    m_Atlas = MakeRef<SpriteAtlas>(image);
+    for (const Box& box : boxes)
+    {
+        m_Atlas->AddRegion(Rect { box.x0, box.y0, box.x1, box.y1 });
+    }
+    m_Glyphs = std::move(glyphs);
+    return true;
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::Get(char c) const
+{
+    if (c < FirstChar || c > LastChar) { c = '?'; }
+    return m_Glyphs[c - FirstChar];
+}
+
+i32 GlyphAtlas::Measure(std::string_view text) const
+{
+    i32 width = 0;
+    for (char c : text)
+    {
+        width += Get(c).advance;
+    }
+    return width;
+}
+
+i32 GlyphAtlas::AddText(SpriteBatch& batch, std::string_view text, i32 x, i32 y, i32 layer) const
+{
+    const i32 baseline = y + m_Ascent;
+    for (char c : text)
+    {
+        const Glyph& glyph = Get(c);
+        if (glyph.region != ~0u)
+        {
+            batch.Add(Sprite {
+                .region = glyph.region,
+                .position = Vec2(static_cast<f32>(x + glyph.x0), static_cast<f32>(baseline + glyph.y0)),
+                .layer = layer,
+            });
+        }
+        x += glyph.advance;
+    }
+    return x;
+}
+
+PerfOverlay::PerfOverlay(Ref<GlyphAtlas> font, const OverlayProp& prop) :
+    m_Font(std::move(font)),
+    m_Prop(prop),
+    m_LastFrame(Clock::now())
+{
+}
+
+void PerfOverlay::AddFrame(f64 ms)
+{
+    Clock::time_point now = Clock::now();
+    m_Interval = m_Frames > 0 ? std::chrono::duration<f64, std::milli>(now - m_LastFrame).count() : 0.0;
+    m_LastFrame = now;
+    m_History[m_Frames % HistorySize] = ms;
+    ++m_Frames;
+}
+
+PerfOverlay::Stat& PerfOverlay::FindStat(std::string_view name)
+{
+    for (Stat& stat : m_Stats)
+    {
+        if (stat.name == name) { return stat; }
+    }
+    return m_Stats.emplace_back(Stat { .name = std::string(name) });
+}
+
+void PerfOverlay::SetTime(std::string_view name, f64 ms)
+{
+    Stat& stat = FindStat(name);
+    stat.ms = ms;
+    stat.time = true;
+}
+
+void PerfOverlay::SetCounter(std::string_view name, u64 value)
+{
+    Stat& stat = FindStat(name);
+    stat.count = value;
+    stat.time = false;
+}
+
+Rect PerfOverlay::Bounds() const
+{
+    std::lock_guard<std::mutex> lock(m_BoundsMutex);
+    return m_Bounds;
+}
+
+void PerfOverlay::Fill(Image& target, const Rect& rect, u32 color)
+{
+    const Rect area = Intersect(rect, target.Bounds());
+    if (area.Empty()) { return; }
+    u32 pixel;
+    SwizzlePixels(&color, &pixel, 1, PixelFormat::RGBA8888, target.Format());
+    m_Span.assign(area.Width(), pixel);
+    for (i32 y = area.y0; y < area.y1; ++y)
+    {
+        BlendPixels(m_Span.data(), target.Data() + static_cast<usize>(y) * target.Width() + area.x0, area.Width(), BlendMode::Alpha, target.Format());
+    }
+}
+
+void PerfOverlay::Draw(Image& target)
+{
+    ZoneScoped;
+    Clock::time_point start = Clock::now();
+    const bool text = m_Font && m_Font->IsLoaded();
+    if (text && !m_Batch)
+    {
+        m_Batch = MakeRef<SpriteBatch>(m_Font->Atlas());
+    }
+
+    /// Lines keep their buffers between frames
+    usize lines = 0;
+    auto line = [&]() -> std::string& {
+        if (lines == m_Lines.size()) { m_Lines.emplace_back(); }
+        std::string& out = m_Lines[lines++];
+        out.clear();
+        return out;
+    };
+    const usize history = Min(m_Frames, HistorySize);
+    if (text)
+    {
+        if (history > 0)
+        {
+            f64 sum = 0.0;
+            for (usize i = 0; i < history; ++i)
+            {
+                sum += m_History[i];
+            }
+            fmt::format_to(std::back_inserter(line()), "frame {:.2f} ms  avg {:.2f} ms  {:.0f} fps",
+                m_History[(m_Frames - 1) % HistorySize], sum / history, m_Interval > 0.0 ? 1000.0 / m_Interval : 0.0);
+        }
+        for (const Stat& stat : m_Stats)
+        {
+            if (stat.time)
+            {
+                fmt::format_to(std::back_inserter(line()), "{:<12}{:8.2f} ms", stat.name, stat.ms);
+            }
+            else
+            {
+                fmt::format_to(std::back_inserter(line()), "{:<12}{:8}", stat.name, stat.count);
+            }
+        }
+        fmt::format_to(std::back_inserter(line()), "{:<12}{:8.3f} ms", "overlay", m_DrawMs);
+    }
+
+    const i32 lineHeight = text ? m_Font->LineHeight() : 0;
+    i32 width = static_cast<i32>(HistorySize);
+    for (usize i = 0; i < lines; ++i)
+    {
+        width = Max(width, m_Font->Measure(m_Lines[i]));
+    }
+    const i32 x = m_Prop.x;
+    const i32 y = m_Prop.y;
+    const i32 graphTop = y + Padding + static_cast<i32>(lines) * lineHeight + (lines ? Padding : 0);
+    const i32 graphBottom = graphTop + m_Prop.graphHeight;
+    /// `Draw` alone writes the bounds, reading them here needs no lock
+    const Rect panel = Union(m_Bounds, Rect { x, y, x + width + 2 * Padding, graphBottom + Padding });
+    Fill(target, panel, PanelColor);
+
+    /// Oldest frame on the left
+    const i32 graphX = x + Padding;
+    for (usize i = 0; i < history; ++i)
+    {
+        f64 ms = m_History[(m_Frames - history + i) % HistorySize];
+        i32 h = Clamp(static_cast<i32>(std::lround(ms / m_Prop.graphMaxMs * m_Prop.graphHeight)), 1, m_Prop.graphHeight);
+        u32 color = ms <= m_Prop.budgetMs ? GoodColor : (ms <= 2.0 * m_Prop.budgetMs ? SlowColor : BadColor);
+        i32 column = graphX + static_cast<i32>(i);
+        Fill(target, Rect { column, graphBottom - h, column + 1, graphBottom }, color);
+    }
+    if (m_Prop.budgetMs < m_Prop.graphMaxMs)
+    {
+        i32 budgetY = graphBottom - static_cast<i32>(std::lround(m_Prop.budgetMs / m_Prop.graphMaxMs * m_Prop.graphHeight));
+        Fill(target, Rect { graphX, budgetY, graphX + static_cast<i32>(HistorySize), budgetY + 1 }, BudgetColor);
+    }
+
+    if (text)
+    {
+        for (usize i = 0; i < lines; ++i)
+        {
+            m_Font->AddText(*m_Batch, m_Lines[i], x + Padding, y + Padding + static_cast<i32>(i) * lineHeight);
+        }
+        m_Batch->Flush(target);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_BoundsMutex);
+        m_Bounds = Intersect(panel, target.Bounds());
+    }
+    m_DrawMs = std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+}
+
+}
\ No newline at end of file
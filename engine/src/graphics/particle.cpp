@@ -0,0 +1,547 @@
+#include "graphics/particle.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+static_assert(ParticleSystem::ParticleGrain % 8 == 0, "Chunks hold whole groups of eight");
+
+/// Random attributes drawn per particle, in this order
+static constexpr i32 RandomAttributes = 7;
+
+/// Seed of one random stream, neighbouring inputs give unrelated outputs
+static inline u32 HashSeed(u32 x)
+{
+    x = x * 747796405u + 2891336453u;
+    x = ((x >> ((x >> 28) + 4)) ^ x) * 277803737u;
+    return (x >> 22) ^ x;
+}
+
+/// Advance `state` and map it to [-1, 1)
+static inline f32 NextSigned(u32& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return static_cast<f32>(state >> 8) * (2.0f / static_cast<f32>(1u << 24)) - 1.0f;
+}
+
+/// Run `fn(chunk, begin, end)` over `count` particles in chunks of
+/// `ParticleGrain`, the same chunks whatever the thread count
+template <typename Fn>
+static void ForEachChunk(usize count, Fn&& fn)
+{
+    const usize grain = ParticleSystem::ParticleGrain;
+    ThreadPool::Instance().ParallelFor((count + grain - 1) / grain, 1, [&](usize begin, usize end) {
+        for (usize chunk = begin; chunk < end; ++chunk)
+        {
+            fn(chunk, chunk * grain, Min(count, (chunk + 1) * grain));
+        }
+    });
+}
+
+#ifdef SCSR_AVX2
+static inline __m256 NextSigned(__m256i& state)
+{
+    state = _mm256_add_epi32(_mm256_mullo_epi32(state, _mm256_set1_epi32(1664525)), _mm256_set1_epi32(1013904223));
+    __m256 r = _mm256_cvtepi32_ps(_mm256_srli_epi32(state, 8));
+    return _mm256_sub_ps(_mm256_mul_ps(r, _mm256_set1_ps(2.0f / static_cast<f32>(1u << 24))), _mm256_set1_ps(1.0f));
+}
+
+/// Lane indices moving the set lanes of each 8-bit mask to the front
+static const std::array<u64, 256> LeftPackTable = [] {
+    std::array<u64, 256> table {};
+    for (u32 mask = 0; mask < 256; ++mask)
+    {
+        u64 packed = 0;
+        u32 slot = 0;
+        for (u32 lane = 0; lane < 8; ++lane)
+        {
+            if (mask & (1u << lane)) { packed |= static_cast<u64>(lane) << (slot++ * 8); }
+        }
+        table[mask] = packed;
+    }
+    return table;
+}();
+
+static inline __m256i LeftPackIndices(u32 mask)
+{
+    return _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<i64>(LeftPackTable[mask])));
+}
+#endif
+
+void ParticleArrays::Resize(usize size)
+{
+    for (std::vector<f32>* array : { &x, &y, &z, &vx, &vy, &vz, &life, &invLifetime })
+    {
+        array->resize(size);
+    }
+    color.resize(size);
+}
+
+void ParticleReach(const ParticleEmitter& emitter, const Vec3& gravity, f32 dt, f32 size, Vec3& min, Vec3& max)
+{
+    /// After n steps of `Update` a particle is at p + (v + g dt / 2) t + g t^2 / 2
+    /// with t = n dt, below the longest lifetime
+    const f32 lifetime = emitter.lifetime + emitter.lifetimeSpread;
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        const f32 g = gravity.data[axis];
+        f32 low = 0.0f;
+        f32 high = 0.0f;
+        for (f32 sign : { -1.0f, 1.0f })
+        {
+            const f32 v = emitter.velocity.data[axis] + sign * emitter.velocitySpread.data[axis] + 0.5f * g * dt;
+            auto extend = [&](f32 t) {
+                f32 offset = v * t + 0.5f * g * t * t;
+                low = Min(low, offset);
+                high = Max(high, offset);
+            };
+            extend(lifetime);
+            /// Where the particle turns around
+            if (g != 0.0f && -v / g > 0.0f && -v / g < lifetime) { extend(-v / g); }
+        }
+        min.data[axis] = emitter.position.data[axis] - emitter.positionSpread.data[axis] + low - size;
+        max.data[axis] = emitter.position.data[axis] + emitter.positionSpread.data[axis] + high + size;
+    }
+}
+
+ParticleSystem::ParticleSystem(usize capacity) :
+    m_Capacity(capacity)
+{
+    m_Particles.Resize(capacity);
+    m_Scratch.Resize(capacity);
+}
+
+usize ParticleSystem::Emit(const ParticleEmitter& emitter, usize count)
+{
+    ZoneScoped;
+    count = Min(count, m_Capacity - m_Count);
+    const usize first = m_Count;
+    const u32 seed = m_Seed;
+    ParticleArrays& p = m_Particles;
+    const f32 base[RandomAttributes] = {
+        emitter.position.x, emitter.position.y, emitter.position.z,
+        emitter.velocity.x, emitter.velocity.y, emitter.velocity.z, emitter.lifetime };
+    const f32 spread[RandomAttributes] = {
+        emitter.positionSpread.x, emitter.positionSpread.y, emitter.positionSpread.z,
+        emitter.velocitySpread.x, emitter.velocitySpread.y, emitter.velocitySpread.z, emitter.lifetimeSpread };
+    f32* const targets[RandomAttributes] = { p.x.data(), p.y.data(), p.z.data(), p.vx.data(), p.vy.data(), p.vz.data(), p.life.data() };
+
+    ForEachChunk(count, [&](usize, usize begin, usize end) {
+        /// Every lane of a chunk has its own stream, so both paths agree
+        alignas(32) u32 states[8];
+        for (u32 lane = 0; lane < 8; ++lane)
+        {
+            states[lane] = HashSeed(seed ^ HashSeed(static_cast<u32>(first + begin + lane)));
+        }
+        usize i = begin;
+#ifdef SCSR_AVX2
+        __m256i state = _mm256_load_si256(reinterpret_cast<const __m256i*>(states));
+        for (; i + 8 <= end; i += 8)
+        {
+            const usize at = first + i;
+            for (i32 k = 0; k < RandomAttributes; ++k)
+            {
+                __m256 value = _mm256_add_ps(_mm256_set1_ps(base[k]), _mm256_mul_ps(_mm256_set1_ps(spread[k]), NextSigned(state)));
+                _mm256_storeu_ps(targets[k] + at, value);
+            }
+            __m256 life = _mm256_max_ps(_mm256_loadu_ps(p.life.data() + at), _mm256_set1_ps(1e-3f));
+            _mm256_storeu_ps(p.life.data() + at, life);
+            _mm256_storeu_ps(p.invLifetime.data() + at, _mm256_div_ps(_mm256_set1_ps(1.0f), life));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.color.data() + at), _mm256_set1_epi32(static_cast<i32>(emitter.color)));
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(states), state);
+#endif
+        for (; i < end; i += 8)
+        {
+            for (usize lane = 0; lane < 8 && i + lane < end; ++lane)
+            {
+                const usize at = first + i + lane;
+                for (i32 k = 0; k < RandomAttributes; ++k)
+                {
+                    targets[k][at] = base[k] + spread[k] * NextSigned(states[lane]);
+                }
+                p.life[at] = Max(p.life[at], 1e-3f);
+                p.invLifetime[at] = 1.0f / p.life[at];
+                p.color[at] = emitter.color;
+            }
+        }
+    });
+
+    m_Count += count;
+    m_Seed = HashSeed(m_Seed + static_cast<u32>(count));
+    return count;
+}
+
+void ParticleSystem::Update(f32 dt)
+{
+    ZoneScoped;
+    const usize chunks = (m_Count + ParticleGrain - 1) / ParticleGrain;
+    m_ChunkAlive.assign(chunks, 0);
+    ParticleArrays& p = m_Particles;
+    const Vec3 g = m_Gravity * dt;
+
+    {
+        ZoneScopedN("Integrate");
+        ForEachChunk(m_Count, [&](usize chunk, usize begin, usize end) {
+            usize alive = 0;
+            usize i = begin;
+#ifdef SCSR_AVX2
+            const __m256 step = _mm256_set1_ps(dt);
+            const __m256 gx = _mm256_set1_ps(g.x), gy = _mm256_set1_ps(g.y), gz = _mm256_set1_ps(g.z);
+            const __m256 zero = _mm256_setzero_ps();
+            for (; i + 8 <= end; i += 8)
+            {
+                __m256 vx = _mm256_add_ps(_mm256_loadu_ps(p.vx.data() + i), gx);
+                __m256 vy = _mm256_add_ps(_mm256_loadu_ps(p.vy.data() + i), gy);
+                __m256 vz = _mm256_add_ps(_mm256_loadu_ps(p.vz.data() + i), gz);
+                _mm256_storeu_ps(p.vx.data() + i, vx);
+                _mm256_storeu_ps(p.vy.data() + i, vy);
+                _mm256_storeu_ps(p.vz.data() + i, vz);
+                _mm256_storeu_ps(p.x.data() + i, _mm256_add_ps(_mm256_loadu_ps(p.x.data() + i), _mm256_mul_ps(vx, step)));
+                _mm256_storeu_ps(p.y.data() + i, _mm256_add_ps(_mm256_loadu_ps(p.y.data() + i), _mm256_mul_ps(vy, step)));
+                _mm256_storeu_ps(p.z.data() + i, _mm256_add_ps(_mm256_loadu_ps(p.z.data() + i), _mm256_mul_ps(vz, step)));
+                __m256 life = _mm256_sub_ps(_mm256_loadu_ps(p.life.data() + i), step);
+                _mm256_storeu_ps(p.life.data() + i, life);
+                alive += std::popcount(static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ))));
+            }
+#endif
+            for (; i < end; ++i)
+            {
+                p.vx[i] += g.x;
+                p.vy[i] += g.y;
+                p.vz[i] += g.z;
+                p.x[i] += p.vx[i] * dt;
+                p.y[i] += p.vy[i] * dt;
+                p.z[i] += p.vz[i] * dt;
+                p.life[i] -= dt;
+                alive += p.life[i] > 0.0f;
+            }
+            m_ChunkAlive[chunk] = alive;
+        });
+    }
+
+    /// Survivors of a chunk start where those of the chunks before it end
+    usize total = 0;
+    for (usize& alive : m_ChunkAlive)
+    {
+        usize count = alive;
+        alive = total;
+        total += count;
+    }
+    if (total == m_Count) { return; }
+
+    ZoneScopedN("Compact");
+    ParticleArrays& out = m_Scratch;
+    f32* const from[8] = { p.x.data(), p.y.data(), p.z.data(), p.vx.data(), p.vy.data(), p.vz.data(), p.life.data(), p.invLifetime.data() };
+    f32* const to[8] = { out.x.data(), out.y.data(), out.z.data(), out.vx.data(), out.vy.data(), out.vz.data(), out.life.data(), out.invLifetime.data() };
+    ForEachChunk(m_Count, [&](usize chunk, usize begin, usize end) {
+        usize at = m_ChunkAlive[chunk];
+        const usize last = chunk + 1 < m_ChunkAlive.size() ? m_ChunkAlive[chunk + 1] : total;
+        usize i = begin;
+#ifdef SCSR_AVX2
+        const __m256 zero = _mm256_setzero_ps();
+        /// Full stores only while they stay inside this chunk's output
+        for (; i + 8 <= end && at + 8 <= last; i += 8)
+        {
+            u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p.life.data() + i), zero, _CMP_GT_OQ)));
+            if (mask == 0) { continue; }
+            __m256i indices = LeftPackIndices(mask);
+            for (usize k = 0; k < 8; ++k)
+            {
+                _mm256_storeu_ps(to[k] + at, _mm256_permutevar8x32_ps(_mm256_loadu_ps(from[k] + i), indices));
+            }
+            __m256i color = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.color.data() + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.color.data() + at), _mm256_permutevar8x32_epi32(color, indices));
+            at += std::popcount(mask);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            if (!(p.life[i] > 0.0f)) { continue; }
+            for (usize k = 0; k < 8; ++k)
+            {
+                to[k][at] = from[k][i];
+            }
+            out.color[at] = p.color[i];
+            ++at;
+        }
+    });
+    std::swap(m_Particles, m_Scratch);
+    m_Count = total;
+}
+
+/// Pixels whose centers are covered by a square of half size `hx` x `hy`,
+/// one pixel at least, clamped to the target. Works in floats so far away
+/// particles cannot overflow.
+static inline void QuadBounds(f32 sx, f32 sy, f32 hx, f32 hy, f32 width, f32 height, f32 bounds[4])
+{
+    f32 x0 = std::ceil(sx - hx - 0.5f);
+    f32 x1 = std::ceil(sx + hx - 0.5f);
+    f32 y0 = std::ceil(sy - hy - 0.5f);
+    f32 y1 = std::ceil(sy + hy - 0.5f);
+    if (!(x0 < x1)) { x0 = std::floor(sx); x1 = x0 + 1.0f; }
+    if (!(y0 < y1)) { y0 = std::floor(sy); y1 = y0 + 1.0f; }
+    bounds[0] = Max(x0, 0.0f);
+    bounds[1] = Max(y0, 0.0f);
+    bounds[2] = Min(x1, width);
+    bounds[3] = Min(y1, height);
+}
+
+/// RGBA8888 `color` in the layout of the target, alpha times `fade`
+static inline u32 FadeColor(u32 color, f32 fade, bool premultiplied, const PixelLayout& dst)
+{
+    const PixelLayout src = GetPixelLayout(PixelFormat::RGBA8888);
+    auto channel = [&](u32 shift, bool faded) {
+        u32 value = (color >> shift) & 0xFF;
+        return faded ? static_cast<u32>(static_cast<f32>(value) * fade + 0.5f) : value;
+    };
+    return channel(src.r, premultiplied) << dst.r | channel(src.g, premultiplied) << dst.g |
+        channel(src.b, premultiplied) << dst.b | channel(src.a, true) << dst.a;
+}
+
+usize ParticleSystem::Draw(Image& target, const Mat4& view, const Mat4& projection, const ParticleDrawProp& prop)
+{
+    ZoneScoped;
+    const i32 width = target.Width();
+    const i32 height = target.Height();
+    const i32 bands = (height + BandRows - 1) / BandRows;
+    const usize chunks = (m_Count + ParticleGrain - 1) / ParticleGrain;
+    if (m_Bins.size() < chunks * bands)
+    {
+        m_Bins.resize(chunks * bands);
+    }
+
+    const Mat4 m = projection * view;
+    const f32 w = static_cast<f32>(width);
+    const f32 h = static_cast<f32>(height);
+    /// Half the size in pixels at w = 1, same viewport as `Pipeline`
+    const f32 halfX = 0.25f * prop.size * projection.m00 * w;
+    const f32 halfY = 0.25f * prop.size * projection.m11 * h;
+    const PixelLayout dst = GetPixelLayout(target.Format());
+    const bool premultiplied = prop.blend == BlendMode::Premultiplied;
+    const ParticleArrays& p = m_Particles;
+    std::atomic<usize> drawn = 0;
+
+    ForEachChunk(m_Count, [&](usize chunk, usize begin, usize end) {
+        ZoneScopedN("Bin Particles");
+        std::vector<Billboard>* bins = m_Bins.data() + chunk * bands;
+        for (i32 band = 0; band < bands; ++band)
+        {
+            bins[band].clear();
+        }
+        usize visible = 0;
+        auto add = [&](const f32 bounds[4], f32 depth, u32 color) {
+            if (!(bounds[0] < bounds[2] && bounds[1] < bounds[3])) { return; }
+            Billboard quad {
+                static_cast<i16>(bounds[0]), static_cast<i16>(bounds[1]),
+                static_cast<i16>(bounds[2]), static_cast<i16>(bounds[3]), depth, color };
+            for (i32 band = quad.y0 / BandRows; band <= (quad.y1 - 1) / BandRows; ++band)
+            {
+                bins[band].push_back(quad);
+            }
+            ++visible;
+        };
+
+        usize i = begin;
+#ifdef SCSR_AVX2
+        const __m256 m00 = _mm256_set1_ps(m.m00), m01 = _mm256_set1_ps(m.m01), m02 = _mm256_set1_ps(m.m02), m03 = _mm256_set1_ps(m.m03);
+        const __m256 m10 = _mm256_set1_ps(m.m10), m11 = _mm256_set1_ps(m.m11), m12 = _mm256_set1_ps(m.m12), m13 = _mm256_set1_ps(m.m13);
+        const __m256 m20 = _mm256_set1_ps(m.m20), m21 = _mm256_set1_ps(m.m21), m22 = _mm256_set1_ps(m.m22), m23 = _mm256_set1_ps(m.m23);
+        const __m256 m30 = _mm256_set1_ps(m.m30), m31 = _mm256_set1_ps(m.m31), m32 = _mm256_set1_ps(m.m32), m33 = _mm256_set1_ps(m.m33);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 scaleX = _mm256_set1_ps(w);
+        const __m256 scaleY = _mm256_set1_ps(h);
+        const __m256 sizeX = _mm256_set1_ps(halfX);
+        const __m256 sizeY = _mm256_set1_ps(halfY);
+        const PixelLayout src = GetPixelLayout(PixelFormat::RGBA8888);
+        const __m256i byte = _mm256_set1_epi32(0xFF);
+        alignas(32) f32 bounds[4][8];
+        alignas(32) f32 depths[8];
+        alignas(32) u32 colors[8];
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(p.x.data() + i);
+            __m256 y = _mm256_loadu_ps(p.y.data() + i);
+            __m256 z = _mm256_loadu_ps(p.z.data() + i);
+            __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), _mm256_mul_ps(m02, z)), m03);
+            __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m12, z)), m13);
+            __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, x), _mm256_mul_ps(m21, y)), _mm256_mul_ps(m22, z)), m23);
+            __m256 cw = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m30, x), _mm256_mul_ps(m31, y)), _mm256_mul_ps(m32, z)), m33);
+
+            /// Only the depth range is clipped here, the sides by the rectangle
+            __m256 inside = _mm256_cmp_ps(cw, zero, _CMP_GT_OQ);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(cz, _mm256_sub_ps(zero, cw), _CMP_GT_OQ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(cz, cw, _CMP_LT_OQ));
+            if (_mm256_movemask_ps(inside) == 0) { continue; }
+
+            __m256 rw = _mm256_div_ps(one, cw);
+            __m256 sx = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, rw), one), half), scaleX);
+            __m256 sy = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(cy, rw)), half), scaleY);
+            __m256 hx = _mm256_mul_ps(sizeX, rw);
+            __m256 hy = _mm256_mul_ps(sizeY, rw);
+            __m256 x0 = _mm256_ceil_ps(_mm256_sub_ps(_mm256_sub_ps(sx, hx), half));
+            __m256 x1 = _mm256_ceil_ps(_mm256_sub_ps(_mm256_add_ps(sx, hx), half));
+            __m256 y0 = _mm256_ceil_ps(_mm256_sub_ps(_mm256_sub_ps(sy, hy), half));
+            __m256 y1 = _mm256_ceil_ps(_mm256_sub_ps(_mm256_add_ps(sy, hy), half));
+            __m256 thinX = _mm256_cmp_ps(x0, x1, _CMP_NLT_UQ);
+            __m256 thinY = _mm256_cmp_ps(y0, y1, _CMP_NLT_UQ);
+            x0 = _mm256_blendv_ps(x0, _mm256_floor_ps(sx), thinX);
+            x1 = _mm256_blendv_ps(x1, _mm256_add_ps(_mm256_floor_ps(sx), one), thinX);
+            y0 = _mm256_blendv_ps(y0, _mm256_floor_ps(sy), thinY);
+            y1 = _mm256_blendv_ps(y1, _mm256_add_ps(_mm256_floor_ps(sy), one), thinY);
+            x0 = _mm256_max_ps(x0, zero);
+            y0 = _mm256_max_ps(y0, zero);
+            x1 = _mm256_min_ps(x1, scaleX);
+            y1 = _mm256_min_ps(y1, scaleY);
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(x0, x1, _CMP_LT_OQ), _mm256_cmp_ps(y0, y1, _CMP_LT_OQ)));
+            u32 mask = static_cast<u32>(_mm256_movemask_ps(inside));
+            if (mask == 0) { continue; }
+
+            __m256i color = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.color.data() + i));
+            __m256 fade = one;
+            if (prop.fade)
+            {
+                fade = _mm256_mul_ps(_mm256_loadu_ps(p.life.data() + i), _mm256_loadu_ps(p.invLifetime.data() + i));
+                fade = _mm256_min_ps(_mm256_max_ps(fade, zero), one);
+            }
+            auto channel = [&](u32 from, u32 to, bool faded) {
+                __m256i value = _mm256_and_si256(_mm256_srl_epi32(color, _mm_cvtsi32_si128(static_cast<i32>(from))), byte);
+                if (faded)
+                {
+                    value = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(value), fade), half));
+                }
+                return _mm256_sll_epi32(value, _mm_cvtsi32_si128(static_cast<i32>(to)));
+            };
+            color = _mm256_or_si256(_mm256_or_si256(channel(src.r, dst.r, premultiplied), channel(src.g, dst.g, premultiplied)),
+                _mm256_or_si256(channel(src.b, dst.b, premultiplied), channel(src.a, dst.a, true)));
+
+            _mm256_store_ps(bounds[0], x0);
+            _mm256_store_ps(bounds[1], y0);
+            _mm256_store_ps(bounds[2], x1);
+            _mm256_store_ps(bounds[3], y1);
+            _mm256_store_ps(depths, _mm256_mul_ps(cz, rw));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(colors), color);
+            while (mask)
+            {
+                i32 lane = std::countr_zero(mask);
+                mask &= mask - 1;
+                const f32 quad[4] = { bounds[0][lane], bounds[1][lane], bounds[2][lane], bounds[3][lane] };
+                add(quad, depths[lane], colors[lane]);
+            }
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            f32 cx = m.m00 * p.x[i] + m.m01 * p.y[i] + m.m02 * p.z[i] + m.m03;
+            f32 cy = m.m10 * p.x[i] + m.m11 * p.y[i] + m.m12 * p.z[i] + m.m13;
+            f32 cz = m.m20 * p.x[i] + m.m21 * p.y[i] + m.m22 * p.z[i] + m.m23;
+            f32 cw = m.m30 * p.x[i] + m.m31 * p.y[i] + m.m32 * p.z[i] + m.m33;
+            if (!(cw > 0.0f && cz > -cw && cz < cw)) { continue; }
+
+            f32 rw = 1.0f / cw;
+            f32 bounds[4];
+            QuadBounds((cx * rw + 1.0f) * 0.5f * w, (1.0f - cy * rw) * 0.5f * h, halfX * rw, halfY * rw, w, h, bounds);
+            f32 fade = prop.fade ? Clamp(p.life[i] * p.invLifetime[i], 0.0f, 1.0f) : 1.0f;
+            add(bounds, cz * rw, FadeColor(p.color[i], fade, premultiplied, dst));
+        }
+        drawn += visible;
+    });
+
+    ThreadPool::Instance().ParallelFor(bands, 1, [&](usize begin, usize end) {
+        for (usize band = begin; band < end; ++band)
+        {
+            DrawBand(target, static_cast<i32>(band), chunks, prop);
+        }
+    });
+    return drawn;
+}
+
+void ParticleSystem::DrawBand(Image& target, i32 band, usize chunks, const ParticleDrawProp& prop) const
+{
+    ZoneScoped;
+    const i32 width = target.Width();
+    const i32 bands = (target.Height() + BandRows - 1) / BandRows;
+    const i32 top = band * BandRows;
+    const i32 bottom = Min(top + BandRows, target.Height());
+    const PixelLayout layout = GetPixelLayout(target.Format());
+    const BlendMode mode = prop.blend;
+    /// What blends into any pixel without changing it
+    const u32 neutral = mode == BlendMode::Multiply ? 0xFFFFFFFFu : 0u;
+    std::vector<u32> span(width);
+
+    for (usize chunk = 0; chunk < chunks; ++chunk)
+    {
+        for (const Billboard& quad : m_Bins[chunk * bands + band])
+        {
+            const i32 y0 = Max<i32>(quad.y0, top);
+            const i32 y1 = Min<i32>(quad.y1, bottom);
+            const i32 count = quad.x1 - quad.x0;
+
+            if (Color* hdr = target.HdrData())
+            {
+                u32 c = quad.color;
+                const Color color(((c >> layout.r) & 0xFF) / 255.0f, ((c >> layout.g) & 0xFF) / 255.0f,
+                    ((c >> layout.b) & 0xFF) / 255.0f, ((c >> layout.a) & 0xFF) / 255.0f);
+                for (i32 y = y0; y < y1; ++y)
+                {
+                    const usize row = static_cast<usize>(y) * width;
+                    const f32* depths = target.DepthData() + row;
+                    for (i32 x = quad.x0; x < quad.x1; ++x)
+                    {
+                        if (prop.depthTest && !(quad.depth < depths[x])) { continue; }
+                        hdr[row + x] = BlendColor(color, hdr[row + x], mode);
+                    }
+                }
+                continue;
+            }
+
+            for (i32 y = y0; y < y1; ++y)
+            {
+                const usize row = static_cast<usize>(y) * width + quad.x0;
+                u32* pixels = target.Data() + row;
+                const f32* depths = target.DepthData() + row;
+                /// Hidden pixels get a color that leaves them as they are
+                i32 x = 0;
+                if (prop.depthTest)
+                {
+#ifdef SCSR_AVX2
+                    const __m256 depth = _mm256_set1_ps(quad.depth);
+                    const __m256 color = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<i32>(quad.color)));
+                    const __m256 keep = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<i32>(neutral)));
+                    for (; x + 8 <= count; x += 8)
+                    {
+                        __m256 pass = _mm256_cmp_ps(depth, _mm256_loadu_ps(depths + x), _CMP_LT_OQ);
+                        __m256 other = mode == BlendMode::Opaque ? _mm256_loadu_ps(reinterpret_cast<const f32*>(pixels + x)) : keep;
+                        _mm256_storeu_ps(reinterpret_cast<f32*>(span.data() + x), _mm256_blendv_ps(other, color, pass));
+                    }
+#endif
+                    for (; x < count; ++x)
+                    {
+                        span[x] = quad.depth < depths[x] ? quad.color : mode == BlendMode::Opaque ? pixels[x] : neutral;
+                    }
+                }
+                else
+                {
+                    std::fill(span.begin(), span.begin() + count, quad.color);
+                }
+                BlendPixels(span.data(), pixels, count, mode, target.Format());
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -3,38 +3,76 @@
 #include "core/type.hpp"
 #include "graphics/obj_loader.hpp"
 #include "graphics/vertex.hpp"
+#include "graphics/blit.hpp"
+#include "graphics/frame_capture.hpp"
+#include "core/task/thread_pool.hpp"
 
 #include <Tracy.hpp>
 
+#include <bit>
+#include <chrono>
+#include <algorithm>
+
 namespace scsr
 {
 
+using PipelineClock = std::chrono::steady_clock;
+
+/// Shaded pixels are packed to the image format this many at a time
+static constexpr usize PixelBatch = 64;
+
+static f64 ElapsedMs(PipelineClock::time_point start)
+{
+    return std::chrono::duration<f64, std::milli>(PipelineClock::now() - start).count();
+}
+
 Pipeline::Pipeline()
 {}
 
-PrimitiveResult Pipeline::PrimitiveGeneration(Ref<Image> image, std::span<Vertex> vtxs)
+PrimitiveResult Pipeline::PrimitiveGeneration(const Image& image, std::span<Vertex> vtxs, std::span<Varyings> varyings,
+    GeometryChunk& out) const
 {
     ZoneScoped;
-    for (auto& vtx : vtxs)
+    for (usize i = 0; i < vtxs.size(); ++i)
     {
-        vtx.pos = m_VertexChanging(vtx);
+        auto& vtx = vtxs[i];
+        vtx.pos = m_VertexShader(vtx, varyings[i]);
+        if (!ProjectVertex(image, vtx)) { return PrimitiveResult::Discard; }
+    }
+    return PrimitiveSetup(vtxs, varyings, out);
+}
+
+bool Pipeline::ProjectVertex(const Image& image, Vertex& vtx) const
+{
+    // Homogeneous culling
+    if (vtx.pos.w <= 1.0f) { return false; }
+    if (vtx.pos.x <= -vtx.pos.w || vtx.pos.x >= vtx.pos.w) { return false; }
+    if (vtx.pos.y <= -vtx.pos.w || vtx.pos.y >= vtx.pos.w) { return false; }
+    if (vtx.pos.z <= -vtx.pos.w || vtx.pos.z >= vtx.pos.w) { return false; }
 
-        // Homogeneous culling
-        if (vtx.pos.w <= 1.0f) { return PrimitiveResult::Discard; }
-        if (vtx.pos.x <= -vtx.pos.w || vtx.pos.x >= vtx.pos.w) {  return PrimitiveResult::Discard; }
-        if (vtx.pos.y <= -vtx.pos.w || vtx.pos.y >= vtx.pos.w) { return PrimitiveResult::Discard; }
-        if (vtx.pos.z <= -vtx.pos.w || vtx.pos.z >= vtx.pos.w) { return PrimitiveResult::Discard; }
+    vtx.rhw = 1.0f / vtx.pos.w;
+    vtx.pos.x *= vtx.rhw;
+    vtx.pos.y *= vtx.rhw;
+    vtx.pos.z *= vtx.rhw;
+    vtx.pos.w = 1.0f;
 
-        vtx.rhw = 1.0f / vtx.pos.w;
-        vtx.pos.x *= vtx.rhw;
-        vtx.pos.y *= vtx.rhw;
-        vtx.pos.z *= vtx.rhw;
-        vtx.pos.w = 1.0f;
+    // viewport
+    vtx.pos.x = (vtx.pos.x + 1.0f) * 0.5f * image.Width();
+    vtx.pos.y = (1.0f - vtx.pos.y) * 0.5f * image.Height();
+    return true;
+}
+
+/// Twice the signed screen area of a triangle
+static f32 SignedArea(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+{
+    return (v1.pos.x - v0.pos.x) * (v2.pos.y - v0.pos.y) - (v2.pos.x - v0.pos.x) * (v1.pos.y - v0.pos.y);
+}
+
+PrimitiveResult Pipeline::PrimitiveSetup(std::span<Vertex> vtxs, std::span<Varyings> varyings, GeometryChunk& out) const
+{
+    /// Degenerate triangles cover nothing and are not counted as kept
+    if (Abs(SignedArea(vtxs[0], vtxs[1], vtxs[2])) < 1e-8f) { return PrimitiveResult::Discard; }
 
-        // viewport
-        vtx.pos.x = (vtx.pos.x + 1.0f) * 0.5f * image->Width();
-        vtx.pos.y = (1.0f - vtx.pos.y) * 0.5f * image->Height();
-    }
     // Face culling
     if (m_State.cullMode != FaceCullMode::None)
     {
@@ -47,94 +85,610 @@ PrimitiveResult Pipeline::PrimitiveGeneration(Ref<Image> image, std::span<Vertex
         if (m_State.cullMode == FaceCullMode::CW && dot > 0.0f) { return PrimitiveResult::Discard; }
     }
 
-    PrimitiveAssembly(vtxs);
+    PrimitiveAssembly(vtxs, varyings, out);
     return PrimitiveResult::Keep;
 }
 
-void Pipeline::PrimitiveAssembly(std::span<Vertex> vtxs)
+void Pipeline::PrimitiveAssembly(std::span<Vertex> vtxs, std::span<Varyings> varyings, GeometryChunk& out) const
 {
     if (vtxs.size() == 3)
     {
+        const Vertex& v0 = vtxs[0];
+        const Vertex& v1 = vtxs[1];
+        const Vertex& v2 = vtxs[2];
+        /// Never zero, `PrimitiveSetup` discards degenerate triangles
+        f32 area = SignedArea(v0, v1, v2);
+        f32 invArea = 1.0f / area;
+
+        if (m_State.wireframe)
+        {
+            const u32 color = m_WireframeColor;
+            const Color& linear = m_State.wireframeColor;
+            out.lines.push_back({ v0.pos.xyz(), v1.pos.xyz(), color, linear });
+            out.lines.push_back({ v1.pos.xyz(), v2.pos.xyz(), color, linear });
+            out.lines.push_back({ v2.pos.xyz(), v0.pos.xyz(), color, linear });
+            return;
+        }
+
+        /// Pixels whose centers are inside the bounds, with the rounding of
+        /// `Scanline`. Sub-pixel triangles between centers cover none
+        f32 minX = Min(v0.pos.x, Min(v1.pos.x, v2.pos.x));
+        f32 maxX = Max(v0.pos.x, Max(v1.pos.x, v2.pos.x));
+        f32 minY = Min(v0.pos.y, Min(v1.pos.y, v2.pos.y));
+        f32 maxY = Max(v0.pos.y, Max(v1.pos.y, v2.pos.y));
+        i32 x0 = static_cast<i32>(minX + 0.5f);
+        i32 x1 = static_cast<i32>(maxX + 0.5f);
+        i32 y0 = static_cast<i32>(minY + 0.5f);
+        i32 y1 = static_cast<i32>(maxY + 0.5f);
+        if (x0 >= x1 || y0 >= y1) { return; }
+        /// Blended draws are sorted back to front as trapezoids, keep them together
+        const bool small = x1 - x0 <= SmallTriangle::MaxSize && y1 - y0 <= SmallTriangle::MaxSize &&
+            m_State.blend == BlendMode::Opaque && m_State.depthWrite;
+
+        /// Depth and 1/w are linear in screen space, varyings are divided by w
+        /// so they can be too and are multiplied back per pixel.
+        /// Indices are local to the chunk until `MergeGeometry`
+        u32 primitive = static_cast<u32>(out.planes.size() / PlaneStride());
+        out.depths.push_back((v0.pos.z + v1.pos.z + v2.pos.z) / 3.0f);
+        out.planes.push_back(Plane::FromTriangle(v0, v1, v2, v0.pos.z, v1.pos.z, v2.pos.z, invArea));
+        out.planes.push_back(Plane::FromTriangle(v0, v1, v2, v0.rhw, v1.rhw, v2.rhw, invArea));
+        for (usize i = 0; i < m_VaryingCount; ++i)
+        {
+            out.planes.push_back(Plane::FromTriangle(v0, v1, v2,
+                varyings[0].data[i] * v0.rhw, varyings[1].data[i] * v1.rhw, varyings[2].data[i] * v2.rhw, invArea));
+        }
+
+        if (small)
+        {
+            SmallTriangle tri = SmallTriangle::FromPrimitive(v0, v1, v2, x0, y0, area);
+            tri.primitive = primitive;
+            out.smallTriangles.push_back(tri);
+            return;
+        }
+
+        /// Reorders `vtxs`, the planes above no longer depend on it
         auto trapezoids = Trapezoid::FromPrimitive(vtxs[0], vtxs[1], vtxs[2]);
+        trapezoids.first.first.primitive = primitive;
+        trapezoids.first.second.primitive = primitive;
         switch (trapezoids.second)
         {
         case 1:
-            m_DrawBuffer.trapezoids.emplace_back(std::move(trapezoids.first.first));
+            out.trapezoids.emplace_back(std::move(trapezoids.first.first));
             break;
         case 2:
-            m_DrawBuffer.trapezoids.emplace_back(std::move(trapezoids.first.first));
-            m_DrawBuffer.trapezoids.emplace_back(std::move(trapezoids.first.second));
+            out.trapezoids.emplace_back(std::move(trapezoids.first.first));
+            out.trapezoids.emplace_back(std::move(trapezoids.first.second));
             break;
         }
+        return;
     }
-    // other primitive types
+
+    /// A point is a line ending where it starts, one pixel
+    ScreenLine& line = out.lines.emplace_back();
+    line.p0 = vtxs[0].pos.xyz();
+    line.p1 = vtxs.back().pos.xyz();
+    ShadeFlat(varyings[0], line);
 }
 
-void Pipeline::Rasterize(Ref<Image> image, const Trapezoid& trap) const
+void Pipeline::ShadeFlat(const Varyings& varyings, ScreenLine& line) const
 {
-    ZoneScopedN("Draw Trapezoid");
-    i32 top = static_cast<i32>(trap.top + 0.5f);
-    i32 bottom = static_cast<i32>(trap.bottom + 0.5f);
+    /// HDR targets keep the float color, like `ShadeSpans`
+    if (m_TargetHdr)
+    {
+        line.linear = m_PixelShader(varyings);
+    }
+    else if (m_PackedPixelShader)
+    {
+        line.color = m_PackedPixelShader(varyings);
+        SwizzlePixels(&line.color, &line.color, 1, PixelFormat::RGBA8888, m_TargetFormat);
+    }
+    else
+    {
+        Color shaded = m_PixelShader(varyings);
+        PackColors(&shaded, &line.color, 1, m_TargetFormat, m_State.srgb);
+    }
+}
+
+void Pipeline::ShadeVertices(const Image& image, bool project)
+{
+    ZoneScopedN("Vertex Shading");
+    auto& vertices = m_DrawBuffer.vertices;
+    auto& varyings = m_DrawBuffer.varyings;
+    auto& visible = m_DrawBuffer.visible;
+    visible.resize(vertices.size());
+    ThreadPool::Instance().ParallelFor(vertices.size(), m_GeometryGrain * 3, [&](usize begin, usize end) {
+        for (usize i = begin; i < end; ++i)
+        {
+            vertices[i].pos = m_VertexShader(vertices[i], varyings[i]);
+            visible[i] = !project || ProjectVertex(image, vertices[i]);
+        }
+    });
+}
+
+template <typename ChunkFn>
+usize Pipeline::ForEachChunk(usize count, ChunkFn&& fn)
+{
+    /// Chunks are shaded in any order but merged in submission order,
+    /// so the output does not depend on the thread count
+    const usize chunkCount = (count + m_GeometryGrain - 1) / m_GeometryGrain;
+    if (m_DrawBuffer.chunks.size() < chunkCount)
+    {
+        m_DrawBuffer.chunks.resize(chunkCount);
+    }
+
+    ThreadPool::Instance().ParallelFor(chunkCount, 1, [&](usize begin, usize end) {
+        for (usize c = begin; c < end; ++c)
+        {
+            ZoneScopedN("Geometry Chunk");
+            GeometryChunk& chunk = m_DrawBuffer.chunks[c];
+            chunk.Clear();
+            fn(chunk, c * m_GeometryGrain, Min((c + 1) * m_GeometryGrain, count));
+        }
+    });
+    return chunkCount;
+}
+
+void Pipeline::MergeGeometry(usize count)
+{
+    ZoneScopedN("Geometry Merge");
+    struct Offsets
+    {
+        usize planes;
+        usize trapezoids;
+        usize smallTriangles;
+        usize lines;
+    };
+    std::vector<Offsets> offsets(count);
+    Offsets total {};
+    for (usize c = 0; c < count; ++c)
+    {
+        const GeometryChunk& chunk = m_DrawBuffer.chunks[c];
+        offsets[c] = total;
+        total.planes += chunk.planes.size();
+        total.trapezoids += chunk.trapezoids.size();
+        total.smallTriangles += chunk.smallTriangles.size();
+        total.lines += chunk.lines.size();
+    }
+
+    const usize stride = PlaneStride();
+    m_DrawBuffer.planes.resize(total.planes);
+    m_DrawBuffer.depths.resize(total.planes / stride);
+    m_DrawBuffer.trapezoids.resize(total.trapezoids);
+    m_DrawBuffer.smallTriangles.resize(total.smallTriangles);
+    m_DrawBuffer.lines.resize(total.lines);
+
+    ThreadPool::Instance().ParallelFor(count, 1, [&](usize begin, usize end) {
+        for (usize c = begin; c < end; ++c)
+        {
+            const GeometryChunk& chunk = m_DrawBuffer.chunks[c];
+            const Offsets& offset = offsets[c];
+            u32 primitiveBase = static_cast<u32>(offset.planes / stride);
+
+            std::copy(chunk.planes.begin(), chunk.planes.end(), m_DrawBuffer.planes.begin() + offset.planes);
+            std::copy(chunk.depths.begin(), chunk.depths.end(), m_DrawBuffer.depths.begin() + primitiveBase);
+            std::copy(chunk.lines.begin(), chunk.lines.end(), m_DrawBuffer.lines.begin() + offset.lines);
+            for (usize i = 0; i < chunk.trapezoids.size(); ++i)
+            {
+                Trapezoid& trap = m_DrawBuffer.trapezoids[offset.trapezoids + i];
+                trap = chunk.trapezoids[i];
+                trap.primitive += primitiveBase;
+            }
+            for (usize i = 0; i < chunk.smallTriangles.size(); ++i)
+            {
+                SmallTriangle& tri = m_DrawBuffer.smallTriangles[offset.smallTriangles + i];
+                tri = chunk.smallTriangles[i];
+                tri.primitive += primitiveBase;
+            }
+        }
+    });
+}
+
+void Pipeline::FlushPixels(Image& image, i32 y, const i32* xs, const Color* colors, u32* packed, usize count) const
+{
+    if (m_Overdraw)
+    {
+        u32* counts = m_Overdraw + static_cast<usize>(y) * image.Width();
+        for (usize i = 0; i < count; ++i)
+        {
+            ++counts[xs[i]];
+        }
+    }
+
+    if (Color* hdr = image.HdrData())
+    {
+        Color* row = hdr + static_cast<usize>(y) * image.Width();
+        for (usize i = 0; i < count; ++i)
+        {
+            row[xs[i]] = BlendColor(colors[i], row[xs[i]], m_State.blend);
+        }
+        return;
+    }
+
+    if (m_PackedPixelShader)
+    {
+        SwizzlePixels(packed, packed, count, PixelFormat::RGBA8888, image.Format());
+    }
+    else
+    {
+        PackColors(colors, packed, count, image.Format(), m_State.srgb);
+    }
+
+    /// Rows are tightly packed, see `Image`
+    u32* row = image.Data() + static_cast<usize>(y) * image.Width();
+    if (m_State.blend == BlendMode::Opaque)
+    {
+        for (usize i = 0; i < count; ++i)
+        {
+            row[xs[i]] = packed[i];
+        }
+        return;
+    }
+
+    /// Without depth rejections the batch is one run of the row, blend it in place
+    if (static_cast<usize>(xs[count - 1] - xs[0]) + 1 == count)
+    {
+        BlendPixels(packed, row + xs[0], count, m_State.blend, image.Format());
+        return;
+    }
+
+    u32 dst[PixelBatch];
+    for (usize i = 0; i < count; ++i)
+    {
+        dst[i] = row[xs[i]];
+    }
+    BlendPixels(packed, dst, count, m_State.blend, image.Format());
+    for (usize i = 0; i < count; ++i)
+    {
+        row[xs[i]] = dst[i];
+    }
+}
+
+template <typename SpanFn>
+void Pipeline::ShadeSpans(Image& image, u32 primitive, i32 top, i32 bottom, SpanFn&& span)
+{
+    const Plane* planes = m_DrawBuffer.planes.data() + static_cast<usize>(primitive) * PlaneStride();
+    const Plane& depth = planes[0];
+    const Plane& rhw = planes[1];
+    const Plane* varyingPlanes = planes + 2;
+    const usize count = m_VaryingCount;
+    /// HDR targets keep the float colors, packed shaders would clamp them
+    const bool packedShader = m_PackedPixelShader && !image.HdrData();
+    const bool depthWrite = m_State.depthWrite;
+
+    /// A rate image of another size, e.g. after a resolution change, is ignored
+    const ShadingRate drawRate = m_State.shadingRate;
+    const ShadingRateImage* rateImage = m_ShadingRateImage.get();
+    if (rateImage && (rateImage->Width() != image.Width() || rateImage->Height() != image.Height()))
+    {
+        rateImage = nullptr;
+    }
+    for (auto& cache : m_BlockCaches)
+    {
+        cache.row = -1;
+    }
+
+    Varyings varyings;
+    f32 numerators[MaxVaryings];
+    usize invocations = 0;
+    usize covered = 0;
+
+    i32 xs[PixelBatch];
+    Color colors[PixelBatch];
+    u32 packed[PixelBatch];
+    usize batched = 0;
+
+    /// Shade at a point of the triangle plane, away from the stepped pixel.
+    /// Inside the triangle 1/w lies in (0, 1) as vertices with w <= 1 are culled.
+    /// A point off a silhouette can extrapolate past that, even to or below
+    /// zero, and the covered pixel at `fallbackX, fallbackY` is shaded instead
+    auto shadeAt = [&](f32 sx, f32 sy, f32 fallbackX, f32 fallbackY, Color& color, u32& packedColor) {
+        f32 r = rhw.At(sx, sy);
+        if (!(r > 0.0f && r < 1.0f))
+        {
+            sx = fallbackX;
+            sy = fallbackY;
+            r = rhw.At(sx, sy);
+        }
+        f32 invW = 1.0f / r;
+        for (usize i = 0; i < count; ++i)
+        {
+            varyings.data[i] = varyingPlanes[i].At(sx, sy) * invW;
+        }
+        if (packedShader) { packedColor = m_PackedPixelShader(varyings); }
+        else { color = m_PixelShader(varyings); }
+        ++invocations;
+    };
+
+    const Rect clip = m_State.scissorTest ? Intersect(m_State.scissor, image.Bounds()) : image.Bounds();
+    top = Max(top, clip.y0);
+    bottom = Min(bottom, clip.y1);
     for (i32 y = top; y < bottom; ++y)
     {
-        if (y >= 0 && y < image->Height())
+        auto [spanBegin, spanEnd] = span(y);
+        i32 begin = Max(spanBegin, clip.x0);
+        i32 end = Min(spanEnd, clip.x1);
+        if (begin >= end) { continue; }
+
+        const ShadingRate* tiles = rateImage ? rateImage->Row(y) : nullptr;
+
+        /// Evaluate at the first pixel center, then step by the x gradients
+        f32 px = static_cast<f32>(begin) + 0.5f;
+        f32 py = static_cast<f32>(y) + 0.5f;
+        f32 z = depth.At(px, py);
+        f32 w = rhw.At(px, py);
+        for (usize i = 0; i < count; ++i)
+        {
+            numerators[i] = varyingPlanes[i].At(px, py);
+        }
+
+        for (i32 x = begin; x < end; ++x)
         {
-            Scanline scanline = Scanline::FromTrapezoid(trap, y);
-            for (i32 x = scanline.x; x < scanline.x + scanline.width; ++x)
+            Vec2i p(x, y);
+            if (image.TestDepth(p, z))
             {
-                if (x >= 0 && x < image->Width())
+                /// Pixels of one span never overlap, depth can be written before the color
+                if (depthWrite) { image.SetDepth(p, z); }
+                xs[batched] = x;
+
+                ShadingRate rate = tiles ? CombineRates(drawRate, tiles[x / ShadingRateImage::TileSize]) : drawRate;
+                if (rate == ShadingRate::Rate1x1)
                 {
-                    scanline.start.pos += scanline.step.pos;
-                    scanline.start.uv += scanline.step.uv;
-                    scanline.start.normal += scanline.step.normal;
-                    scanline.start.rhw += scanline.step.rhw;
-
-                    image->TestDepthAndSetPixel(
-                        scanline.start.ScreenPos(),
-                        scanline.start.pos.z,
-                        ColorToHex(m_PixelShading(scanline.start))    
-                    );
+                    f32 invW = 1.0f / w;
+                    for (usize i = 0; i < count; ++i)
+                    {
+                        varyings.data[i] = numerators[i] * invW;
+                    }
+                    if (packedShader) { packed[batched] = m_PackedPixelShader(varyings); }
+                    else { colors[batched] = m_PixelShader(varyings); }
+                    ++invocations;
                 }
-                if (x >= image->Width()) { break; }
+                else
+                {
+                    /// One invocation at the block center, reused by the covered pixels of the block
+                    i32 size = static_cast<i32>(rate);
+                    BlockCache& cache = m_BlockCaches[rate == ShadingRate::Rate2x2 ? 0 : 1];
+                    if (cache.row != y / size)
+                    {
+                        cache.row = y / size;
+                        if (++cache.stamp == 0)
+                        {
+                            std::fill(cache.stamps.begin(), cache.stamps.end(), 0);
+                            cache.stamp = 1;
+                        }
+                    }
+                    i32 block = x / size;
+                    if (cache.stamps[block] != cache.stamp)
+                    {
+                        cache.stamps[block] = cache.stamp;
+                        f32 half = static_cast<f32>(size) * 0.5f;
+                        shadeAt(static_cast<f32>(block * size) + half, static_cast<f32>(cache.row * size) + half,
+                            static_cast<f32>(x) + 0.5f, py, cache.colors[block], cache.packed[block]);
+                    }
+                    /// Only the buffer of the active shader was written
+                    if (packedShader) { packed[batched] = cache.packed[block]; }
+                    else { colors[batched] = cache.colors[block]; }
+                }
+
+                if (++batched == PixelBatch)
+                {
+                    FlushPixels(image, y, xs, colors, packed, batched);
+                    batched = 0;
+                }
+                ++covered;
+            }
+
+            z += depth.a;
+            w += rhw.a;
+            for (usize i = 0; i < count; ++i)
+            {
+                numerators[i] += varyingPlanes[i].a;
             }
         }
-        if (y >= image->Height()) { break; }
+
+        if (batched > 0)
+        {
+            FlushPixels(image, y, xs, colors, packed, batched);
+            batched = 0;
+        }
+    }
+
+    m_Stats.pixels += invocations;
+    m_Stats.pixelsCovered += covered;
+}
+
+void Pipeline::Rasterize(Image& image, const Trapezoid& trap)
+{
+    ZoneScopedN("Draw Trapezoid");
+    i32 top = static_cast<i32>(trap.top + 0.5f);
+    i32 bottom = static_cast<i32>(trap.bottom + 0.5f);
+    ShadeSpans(image, trap.primitive, top, bottom, [&trap](i32 y) {
+        Scanline scanline = Scanline::FromTrapezoid(trap, y);
+        return std::pair<i32, i32>(scanline.x, scanline.x + scanline.width);
+    });
+}
+
+void Pipeline::Rasterize(Image& image, const SmallTriangle& tri)
+{
+    u32 rows[SmallTriangle::MaxSize];
+    tri.Coverage(rows);
+    i32 top = SmallTriangle::MaxSize;
+    i32 bottom = 0;
+    for (i32 row = 0; row < SmallTriangle::MaxSize; ++row)
+    {
+        if (rows[row] == 0) { continue; }
+        top = Min(top, row);
+        bottom = row + 1;
     }
+    if (top >= bottom) { return; }
+
+    /// Covered centers of a row are contiguous, the triangle is convex
+    ShadeSpans(image, tri.primitive, tri.y + top, tri.y + bottom, [&tri, &rows](i32 y) {
+        u32 mask = rows[y - tri.y];
+        if (mask == 0) { return std::pair<i32, i32>(0, 0); }
+        return std::pair<i32, i32>(tri.x + std::countr_zero(mask), tri.x + std::bit_width(mask));
+    });
 }
 
-void Pipeline::Perform(Ref<Image> image, Mesh& mesh)
+void Pipeline::Perform(Ref<Image> image, const Mesh& mesh)
 {
     ZoneScopedN("Draw call");
+    if (m_Capture && m_Capture->IsRecording())
+    {
+        m_Capture->RecordDraw(*image, mesh, m_State, *m_Camera, m_ShadingRateImage.get());
+    }
+    ++m_Stats.drawCalls;
+    const Topology topology = mesh.topology;
+    const usize primitiveCount = PrimitiveCount(topology, mesh.vertices.size());
+    if (topology >= Topology::Triangles)
+    {
+        m_Stats.triangles += primitiveCount;
+    }
 
+    auto start = PipelineClock::now();
     {
         ZoneScopedN("Buffer initialization");
-        m_DrawBuffer.trapezoids.clear();
+        m_WireframeColor = PackColor(m_State.wireframeColor, image->Format());
+        m_TargetFormat = image->Format();
+        m_TargetHdr = image->HdrData() != nullptr;
+        const usize pixelCount = static_cast<usize>(image->Width()) * image->Height();
+        m_Overdraw = m_OverdrawCounts && m_OverdrawCounts->size() == pixelCount ? m_OverdrawCounts->data() : nullptr;
         m_DrawBuffer.vertices.clear();
 
         m_DrawBuffer.vertices = mesh.vertices;
+        m_DrawBuffer.varyings.resize(m_DrawBuffer.vertices.size());
     }
+    m_Stats.bufferTime += ElapsedMs(start);
+
     std::span<Vertex> vertice_view(m_DrawBuffer.vertices);
+    std::span<Varyings> varying_view(m_DrawBuffer.varyings);
+    start = PipelineClock::now();
     {
         ZoneScopedN("Vertex Pass");
-        for (usize i = 0; i < m_DrawBuffer.vertices.size(); i += 3)
+        usize chunkCount = 0;
+        if (topology == Topology::Triangles)
         {
-            switch(PrimitiveGeneration(image, vertice_view.subspan(i, 3)))
-            {
-            case PrimitiveResult::Discard:
-            case PrimitiveResult::Keep:
-                break;
-            case PrimitiveResult::Split:
-                break;
-            }
+            /// No vertex is shared, each is shaded with its triangle
+            chunkCount = ForEachChunk(primitiveCount, [&](GeometryChunk& chunk, usize first, usize last) {
+                for (usize i = first * 3; i < last * 3; i += 3)
+                {
+                    switch (PrimitiveGeneration(*image, vertice_view.subspan(i, 3), varying_view.subspan(i, 3), chunk))
+                    {
+                    case PrimitiveResult::Discard:
+                        break;
+                    case PrimitiveResult::Keep:
+                        ++chunk.kept;
+                        break;
+                    }
+                }
+            });
         }
+        else if (topology == Topology::TriangleStrip || topology == Topology::TriangleFan)
+        {
+            ShadeVertices(*image, true);
+            m_DrawBuffer.assembled.resize(primitiveCount * 3);
+            m_DrawBuffer.assembledVaryings.resize(primitiveCount * 3);
+            std::span<Vertex> assembled(m_DrawBuffer.assembled);
+            std::span<Varyings> assembledVaryings(m_DrawBuffer.assembledVaryings);
+            const auto& visible = m_DrawBuffer.visible;
+            chunkCount = ForEachChunk(primitiveCount, [&](GeometryChunk& chunk, usize first, usize last) {
+                for (usize t = first; t < last; ++t)
+                {
+                    usize indices[3];
+                    TriangleIndices(topology, t, indices);
+                    if (!visible[indices[0]] || !visible[indices[1]] || !visible[indices[2]]) { continue; }
+
+                    for (usize k = 0; k < 3; ++k)
+                    {
+                        assembled[t * 3 + k] = m_DrawBuffer.vertices[indices[k]];
+                        assembledVaryings[t * 3 + k] = m_DrawBuffer.varyings[indices[k]];
+                    }
+                    if (PrimitiveSetup(assembled.subspan(t * 3, 3), assembledVaryings.subspan(t * 3, 3), chunk) == PrimitiveResult::Keep)
+                    {
+                        ++chunk.kept;
+                    }
+                }
+            });
+        }
+        else if (topology == Topology::Points)
+        {
+            ShadeVertices(*image, true);
+            chunkCount = ForEachChunk(primitiveCount, [&](GeometryChunk& chunk, usize first, usize last) {
+                for (usize i = first; i < last; ++i)
+                {
+                    if (!m_DrawBuffer.visible[i]) { continue; }
+                    PrimitiveAssembly(vertice_view.subspan(i, 1), varying_view.subspan(i, 1), chunk);
+                }
+            });
+        }
+        else
+        {
+            /// Lines are clipped to the view volume rather than culled
+            ShadeVertices(*image, false);
+            const usize vertexCount = m_DrawBuffer.vertices.size();
+            chunkCount = ForEachChunk(primitiveCount, [&](GeometryChunk& chunk, usize first, usize last) {
+                for (usize l = first; l < last; ++l)
+                {
+                    usize i0 = topology == Topology::Lines ? l * 2 : l;
+                    usize i1 = topology == Topology::Lines ? l * 2 + 1 : (l + 1) % vertexCount;
+                    Vec4 a = m_DrawBuffer.vertices[i0].pos;
+                    Vec4 b = m_DrawBuffer.vertices[i1].pos;
+                    if (!ClipLine(a, b)) { continue; }
+
+                    Vertex ends[2] = { m_DrawBuffer.vertices[i0], m_DrawBuffer.vertices[i1] };
+                    ends[0].pos = Vec4(ClipToScreen(a, image->Width(), image->Height()), 1.0f);
+                    ends[1].pos = Vec4(ClipToScreen(b, image->Width(), image->Height()), 1.0f);
+                    Varyings endVaryings[2] = { m_DrawBuffer.varyings[i0], m_DrawBuffer.varyings[i1] };
+                    PrimitiveAssembly(ends, endVaryings, chunk);
+                }
+            });
+        }
+
+        MergeGeometry(chunkCount);
+        for (usize c = 0; c < chunkCount; ++c)
+        {
+            m_Stats.trianglesKept += m_DrawBuffer.chunks[c].kept;
+        }
+    }
+    m_Stats.vertexTime += ElapsedMs(start);
+    m_Stats.trapezoids += m_DrawBuffer.trapezoids.size();
+    m_Stats.smallTriangles += m_DrawBuffer.smallTriangles.size();
+
+    if (m_State.blend != BlendMode::Opaque)
+    {
+        ZoneScopedN("Blend Sort");
+        /// Farthest first, stable so coplanar triangles keep submission order
+        const auto& depths = m_DrawBuffer.depths;
+        std::stable_sort(m_DrawBuffer.trapezoids.begin(), m_DrawBuffer.trapezoids.end(),
+            [&depths](const Trapezoid& a, const Trapezoid& b) { return depths[a.primitive] > depths[b.primitive]; });
     }
+
+    start = PipelineClock::now();
     {
         ZoneScopedN("Pixel Pass");
+        if (m_State.shadingRate != ShadingRate::Rate1x1 || m_ShadingRateImage)
+        {
+            for (auto& cache : m_BlockCaches)
+            {
+                usize blocks = static_cast<usize>(image->Width());
+                if (cache.stamps.size() < blocks)
+                {
+                    cache.stamps.resize(blocks, 0);
+                    cache.colors.resize(blocks);
+                    cache.packed.resize(blocks);
+                }
+            }
+        }
         for (auto& trapezoid : m_DrawBuffer.trapezoids)
         {
-            Rasterize(image, trapezoid);
+            Rasterize(*image, trapezoid);
+        }
+        for (auto& tri : m_DrawBuffer.smallTriangles)
+        {
+            Rasterize(*image, tri);
         }
+        RasterizeLines(*image, m_DrawBuffer.lines, m_State.scissorTest ? m_State.scissor : image->Bounds(), m_State.depthWrite);
     }
+    m_Stats.pixelTime += ElapsedMs(start);
     return;
 }
 
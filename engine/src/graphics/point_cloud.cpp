@@ -0,0 +1,318 @@
+#include "graphics/point_cloud.hpp"
+#include "graphics/blit.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/log.hpp"
+
+#include <Tracy.hpp>
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+static_assert(sizeof(CloudPoint) == 16, "Point cloud files store 16 byte points");
+
+/// Depths as unsigned integers with the same order, negative ones included
+static inline u32 DepthKey(f32 depth)
+{
+    u32 bits = std::bit_cast<u32>(depth);
+    return bits ^ ((bits >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+}
+
+static inline f32 KeyDepth(u32 key)
+{
+    return std::bit_cast<f32>(key ^ ((key >> 31) ? 0x80000000u : 0xFFFFFFFFu));
+}
+
+/// Keep the smaller of `slot` and `value`, safe against concurrent writers
+static inline void AtomicMin(u64& slot, u64 value)
+{
+    std::atomic_ref<u64> ref(slot);
+    u64 current = ref.load(std::memory_order_relaxed);
+    while (value < current && !ref.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+static void Plot(u64* buffer, i32 width, i32 height, i32 x, i32 y, u64 value, i32 radius)
+{
+    if (radius == 0)
+    {
+        if (x < width && y < height) { AtomicMin(buffer[static_cast<usize>(y) * width + x], value); }
+        return;
+    }
+    for (i32 dy = -radius; dy <= radius; ++dy)
+    {
+        i32 py = y + dy;
+        if (py < 0 || py >= height) { continue; }
+        i32 span = radius * radius - dy * dy;
+        u64* row = buffer + static_cast<usize>(py) * width;
+        for (i32 dx = -radius; dx <= radius; ++dx)
+        {
+            i32 px = x + dx;
+            if (dx * dx <= span && px >= 0 && px < width) { AtomicMin(row[px], value); }
+        }
+    }
+}
+
+#ifdef SCSR_AVX2
+/// Eight points as columns of x, y, z and color
+static inline void LoadPoints(const CloudPoint* points, __m256& x, __m256& y, __m256& z, __m256i& color)
+{
+    const f32* f = reinterpret_cast<const f32*>(points);
+    /// Points i and i + 4 share a register, so the lanes end up in order
+    __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 0)), _mm_loadu_ps(f + 16), 1);
+    __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 4)), _mm_loadu_ps(f + 20), 1);
+    __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 8)), _mm_loadu_ps(f + 24), 1);
+    __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 12)), _mm_loadu_ps(f + 28), 1);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    x = _mm256_shuffle_ps(t0, t2, 0x44);
+    y = _mm256_shuffle_ps(t0, t2, 0xEE);
+    z = _mm256_shuffle_ps(t1, t3, 0x44);
+    color = _mm256_castps_si256(_mm256_shuffle_ps(t1, t3, 0xEE));
+}
+#endif
+
+bool WritePointCloud(const std::string& path, std::span<const CloudPoint> points)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) { return false; }
+    PointCloudHeader header;
+    header.count = points.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(points.data()), points.size_bytes());
+    return static_cast<bool>(file);
+}
+
+PointCloudReader::PointCloudReader(const std::string& path) :
+    m_File(path, std::ios::binary)
+{
+    if (!m_File) { return; }
+    m_File.read(reinterpret_cast<char*>(&m_Header), sizeof(m_Header));
+    m_Open = m_File && m_Header.magic == PointCloudHeader::Magic && m_Header.version == PointCloudHeader::Version;
+    if (!m_Open)
+    {
+        LOG_WARN("{} is not a point cloud", path);
+        m_Header = {};
+    }
+}
+
+bool PointCloudReader::Read(std::vector<CloudPoint>& out, usize maxPoints)
+{
+    ZoneScoped;
+    if (!m_Open || m_Next >= m_Header.count)
+    {
+        out.clear();
+        return false;
+    }
+    usize count = static_cast<usize>(Min<u64>(maxPoints, m_Header.count - m_Next));
+    out.resize(count);
+    m_File.read(reinterpret_cast<char*>(out.data()), count * sizeof(CloudPoint));
+    usize read = static_cast<usize>(m_File.gcount()) / sizeof(CloudPoint);
+    m_Next += count;
+    if (read < count)
+    {
+        LOG_WARN("Point cloud ends after {} of {} points", m_Next - count + read, m_Header.count);
+        out.resize(read);
+        m_Next = m_Header.count;
+    }
+    return read > 0;
+}
+
+void PointCloudReader::Rewind()
+{
+    if (!m_Open) { return; }
+    m_File.clear();
+    m_File.seekg(sizeof(PointCloudHeader));
+    m_Next = 0;
+}
+
+void PointSplatter::Begin(const Image& target)
+{
+    ZoneScoped;
+    m_Width = target.Width();
+    m_Height = target.Height();
+    m_Buffer.resize(static_cast<usize>(m_Width) * m_Height);
+    /// Color 0 at the depth of the target, only nearer points replace it
+    const f32* depths = target.DepthData();
+    ThreadPool::Instance().ParallelFor(m_Buffer.size(), PointGrain, [&](usize begin, usize end) {
+        for (usize i = begin; i < end; ++i)
+        {
+            m_Buffer[i] = static_cast<u64>(DepthKey(depths[i])) << 32;
+        }
+    });
+}
+
+usize PointSplatter::Splat(std::span<const CloudPoint> points, const Mat4& viewProjection, i32 radius)
+{
+    ZoneScoped;
+    const Mat4& m = viewProjection;
+    const f32 width = static_cast<f32>(m_Width);
+    const f32 height = static_cast<f32>(m_Height);
+    u64* buffer = m_Buffer.data();
+    std::atomic<usize> drawn = 0;
+
+    ThreadPool::Instance().ParallelFor(points.size(), PointGrain, [&](usize begin, usize end) {
+        usize visible = 0;
+        usize i = begin;
+#ifdef SCSR_AVX2
+        const __m256 m00 = _mm256_set1_ps(m.m00), m01 = _mm256_set1_ps(m.m01), m02 = _mm256_set1_ps(m.m02), m03 = _mm256_set1_ps(m.m03);
+        const __m256 m10 = _mm256_set1_ps(m.m10), m11 = _mm256_set1_ps(m.m11), m12 = _mm256_set1_ps(m.m12), m13 = _mm256_set1_ps(m.m13);
+        const __m256 m20 = _mm256_set1_ps(m.m20), m21 = _mm256_set1_ps(m.m21), m22 = _mm256_set1_ps(m.m22), m23 = _mm256_set1_ps(m.m23);
+        const __m256 m30 = _mm256_set1_ps(m.m30), m31 = _mm256_set1_ps(m.m31), m32 = _mm256_set1_ps(m.m32), m33 = _mm256_set1_ps(m.m33);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 scaleX = _mm256_set1_ps(width);
+        const __m256 scaleY = _mm256_set1_ps(height);
+        const __m256i signFlip = _mm256_set1_epi32(static_cast<i32>(0x80000000u));
+        alignas(32) i32 xs[8];
+        alignas(32) i32 ys[8];
+        alignas(32) u32 keys[8];
+        alignas(32) u32 colors[8];
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 x, y, z;
+            __m256i color;
+            LoadPoints(points.data() + i, x, y, z, color);
+            __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), _mm256_mul_ps(m02, z)), m03);
+            __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m12, z)), m13);
+            __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, x), _mm256_mul_ps(m21, y)), _mm256_mul_ps(m22, z)), m23);
+            __m256 cw = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m30, x), _mm256_mul_ps(m31, y)), _mm256_mul_ps(m32, z)), m33);
+
+            __m256 negW = _mm256_sub_ps(_mm256_setzero_ps(), cw);
+            __m256 inside = _mm256_cmp_ps(cw, _mm256_setzero_ps(), _CMP_GT_OQ);
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(cx, negW, _CMP_GT_OQ), _mm256_cmp_ps(cx, cw, _CMP_LT_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(cy, negW, _CMP_GT_OQ), _mm256_cmp_ps(cy, cw, _CMP_LT_OQ)));
+            inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(cz, negW, _CMP_GT_OQ), _mm256_cmp_ps(cz, cw, _CMP_LT_OQ)));
+            u32 mask = static_cast<u32>(_mm256_movemask_ps(inside));
+            if (mask == 0) { continue; }
+
+            /// Same viewport as `Pipeline`
+            __m256 rw = _mm256_div_ps(one, cw);
+            __m256 sx = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, rw), one), half), scaleX);
+            __m256 sy = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(cy, rw)), half), scaleY);
+            __m256i bits = _mm256_castps_si256(_mm256_mul_ps(cz, rw));
+            __m256i key = _mm256_xor_si256(bits, _mm256_or_si256(_mm256_srai_epi32(bits, 31), signFlip));
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(xs), _mm256_cvttps_epi32(sx));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(ys), _mm256_cvttps_epi32(sy));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(keys), key);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(colors), color);
+            while (mask)
+            {
+                i32 lane = std::countr_zero(mask);
+                mask &= mask - 1;
+                Plot(buffer, m_Width, m_Height, xs[lane], ys[lane], (static_cast<u64>(keys[lane]) << 32) | colors[lane], radius);
+                ++visible;
+            }
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            const CloudPoint& point = points[i];
+            const Vec3& p = point.position;
+            f32 cx = m.m00 * p.x + m.m01 * p.y + m.m02 * p.z + m.m03;
+            f32 cy = m.m10 * p.x + m.m11 * p.y + m.m12 * p.z + m.m13;
+            f32 cz = m.m20 * p.x + m.m21 * p.y + m.m22 * p.z + m.m23;
+            f32 cw = m.m30 * p.x + m.m31 * p.y + m.m32 * p.z + m.m33;
+            if (!(cw > 0.0f && cx > -cw && cx < cw && cy > -cw && cy < cw && cz > -cw && cz < cw)) { continue; }
+
+            f32 rw = 1.0f / cw;
+            i32 x = static_cast<i32>((cx * rw + 1.0f) * 0.5f * width);
+            i32 y = static_cast<i32>((1.0f - cy * rw) * 0.5f * height);
+            Plot(buffer, m_Width, m_Height, x, y, (static_cast<u64>(DepthKey(cz * rw)) << 32) | point.color, radius);
+            ++visible;
+        }
+        drawn += visible;
+    });
+    return drawn;
+}
+
+usize PointSplatter::SplatFile(PointCloudReader& reader, const Mat4& viewProjection, i32 radius)
+{
+    ZoneScoped;
+    std::vector<CloudPoint> current;
+    std::vector<CloudPoint> next;
+    usize drawn = 0;
+    bool more = reader.Read(current, StreamChunk);
+    while (more)
+    {
+        /// The next chunk is read on the pool. Whoever claims the read does
+        /// it, so a caller whose workers are all busy reads it itself
+        struct Pending
+        {
+            std::atomic<bool> claimed = false;
+            bool done = false;
+            bool more = false;
+            std::mutex mutex;
+            std::condition_variable cond;
+        };
+        auto pending = MakeRef<Pending>();
+        auto read = [pending, &reader, &next]() {
+            if (pending->claimed.exchange(true)) { return; }
+            bool result = reader.Read(next, StreamChunk);
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->more = result;
+            pending->done = true;
+            pending->cond.notify_one();
+        };
+        ThreadPool::Instance().Submit(read);
+        drawn += Splat(current, viewProjection, radius);
+        read();
+        {
+            std::unique_lock<std::mutex> lock(pending->mutex);
+            pending->cond.wait(lock, [&pending] { return pending->done; });
+            more = pending->more;
+        }
+        std::swap(current, next);
+    }
+    return drawn;
+}
+
+void PointSplatter::Resolve(Image& target) const
+{
+    ZoneScoped;
+    if (target.Width() != m_Width || target.Height() != m_Height) { return; }
+    const PixelLayout layout = GetPixelLayout(PixelFormat::RGBA8888);
+    ThreadPool::Instance().ParallelFor(m_Height, 8, [&](usize begin, usize end) {
+        std::vector<u32> colors(m_Width);
+        for (usize y = begin; y < end; ++y)
+        {
+            const u64* row = m_Buffer.data() + y * m_Width;
+            for (i32 x = 0; x < m_Width; ++x)
+            {
+                colors[x] = static_cast<u32>(row[x]);
+            }
+            SwizzlePixels(colors.data(), colors.data(), m_Width, PixelFormat::RGBA8888, target.Format());
+
+            u32* pixels = target.Data() + y * m_Width;
+            f32* depths = target.DepthData() + y * m_Width;
+            Color* hdr = target.HdrData() ? target.HdrData() + y * m_Width : nullptr;
+            for (i32 x = 0; x < m_Width; ++x)
+            {
+                /// Untouched pixels still hold the depth of the target and color 0
+                if (row[x] >= static_cast<u64>(DepthKey(depths[x])) << 32) { continue; }
+                pixels[x] = colors[x];
+                depths[x] = KeyDepth(static_cast<u32>(row[x] >> 32));
+                if (hdr)
+                {
+                    /// Point colors are sRGB, the HDR plane is linear and encoded again by the post chain
+                    u32 c = static_cast<u32>(row[x]);
+                    hdr[x] = Color(SrgbToLinear((c >> layout.r) & 0xFF), SrgbToLinear((c >> layout.g) & 0xFF),
+                        SrgbToLinear((c >> layout.b) & 0xFF), ((c >> layout.a) & 0xFF) / 255.0f);
+                }
+            }
+        }
+    });
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "graphics/post.hpp"
+#include "graphics/blit.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/assert.hpp"
+
+#include <Tracy.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+/// FXAA leaves pixels alone whose neighborhood contrast is below either threshold
+static constexpr f32 FxaaEdgeThreshold = 1.0f / 8.0f;
+static constexpr f32 FxaaEdgeThresholdMin = 1.0f / 16.0f;
+static constexpr f32 FxaaReduceMul = 1.0f / 8.0f;
+static constexpr f32 FxaaReduceMin = 1.0f / 128.0f;
+/// Longest blur along an edge in pixels
+static constexpr f32 FxaaSpanMax = 8.0f;
+
+static const Vec3 LumaWeights(0.299f, 0.587f, 0.114f);
+
+static usize RowGrain(i32 height)
+{
+    usize threads = ThreadPool::Instance().Concurrency();
+    return std::max<usize>(8, static_cast<usize>(height) / (threads * 4));
+}
+
+static inline f32 ToneMapChannel(f32 c, ToneMapper mapper)
+{
+    c = Max(c, 0.0f);
+    if (mapper == ToneMapper::Reinhard) { return c / (1.0f + c); }
+    return Clamp((c * (2.51f * c + 0.03f)) / (c * (2.43f * c + 0.59f) + 0.14f), 0.0f, 1.0f);
+}
+
+#ifdef SCSR_AVX2
+static inline __m256 ToneMap8(__m256 c, ToneMapper mapper)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    c = _mm256_max_ps(c, _mm256_setzero_ps());
+    if (mapper == ToneMapper::Reinhard) { return _mm256_div_ps(c, _mm256_add_ps(one, c)); }
+    __m256 num = _mm256_mul_ps(c, _mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(2.51f)), _mm256_set1_ps(0.03f)));
+    __m256 den = _mm256_add_ps(_mm256_mul_ps(c, _mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(2.43f)), _mm256_set1_ps(0.59f))), _mm256_set1_ps(0.14f));
+    return _mm256_min_ps(_mm256_div_ps(num, den), one);
+}
+#endif
+
+static inline Color Lerp(const Color& a, const Color& b, f32 t)
+{
+    return a + (b - a) * t;
+}
+
+/// Bilinear sample with pixel centers at +0.5, clamped to the edges
+static Color SampleBilinear(const Color* image, i32 width, i32 height, f32 fx, f32 fy)
+{
+    fx = Clamp(fx - 0.5f, 0.0f, static_cast<f32>(width - 1));
+    fy = Clamp(fy - 0.5f, 0.0f, static_cast<f32>(height - 1));
+    i32 x0 = static_cast<i32>(fx);
+    i32 y0 = static_cast<i32>(fy);
+    i32 x1 = Min(x0 + 1, width - 1);
+    i32 y1 = Min(y0 + 1, height - 1);
+    f32 tx = fx - x0;
+    f32 ty = fy - y0;
+    const Color* r0 = image + static_cast<usize>(y0) * width;
+    const Color* r1 = image + static_cast<usize>(y1) * width;
+    return Lerp(Lerp(r0[x0], r0[x1], tx), Lerp(r1[x0], r1[x1], tx), ty);
+}
+
+PostChain::PostChain(PostProp prop)
+{
+    SetProp(prop);
+}
+
+void PostChain::SetProp(const PostProp& prop)
+{
+    m_Prop = prop;
+
+    i32 radius = Max(prop.bloomRadius, 1);
+    f32 sigma = radius * 0.5f;
+    m_Weights.resize(static_cast<usize>(radius) * 2 + 1);
+    f32 sum = 0.0f;
+    for (i32 i = -radius; i <= radius; ++i)
+    {
+        f32 w = std::exp(-static_cast<f32>(i * i) / (2.0f * sigma * sigma));
+        m_Weights[i + radius] = w;
+        sum += w;
+    }
+    for (f32& w : m_Weights)
+    {
+        w /= sum;
+    }
+}
+
+void PostChain::Process(const Image& hdr, Image& out)
+{
+    ZoneScopedN("Post processing");
+    RT_ASSERT(hdr.HdrData(), "Post processing needs an HDR image");
+    RT_ASSERT(hdr.Width() == out.Width() && hdr.Height() == out.Height(), "Post processing needs equal sizes");
+
+    i32 width = hdr.Width();
+    i32 height = hdr.Height();
+    if (m_Prop.bloom)
+    {
+        m_HalfWidth = (width + 1) / 2;
+        m_HalfHeight = (height + 1) / 2;
+        usize half = static_cast<usize>(m_HalfWidth) * m_HalfHeight;
+        m_Bloom.resize(half);
+        m_BloomScratch.resize(half);
+        BrightPass(hdr);
+        Blur();
+    }
+    if (m_Prop.fxaa)
+    {
+        m_Mapped.resize(static_cast<usize>(width) * height);
+        m_Luma.resize(static_cast<usize>(width + 2) * height);
+    }
+
+    ToneMap(hdr, out);
+    if (m_Prop.fxaa)
+    {
+        Fxaa(out);
+    }
+}
+
+void PostChain::BrightPass(const Image& hdr)
+{
+    ZoneScopedN("Bloom bright pass");
+    const Color* src = hdr.HdrData();
+    i32 width = hdr.Width();
+    i32 height = hdr.Height();
+    f32 threshold = m_Prop.bloomThreshold;
+
+    ThreadPool::Instance().ParallelFor(m_HalfHeight, RowGrain(m_HalfHeight), [&](usize begin, usize end) {
+        for (usize y = begin; y < end; ++y)
+        {
+            const Color* r0 = src + static_cast<usize>(Min(static_cast<i32>(y) * 2, height - 1)) * width;
+            const Color* r1 = src + static_cast<usize>(Min(static_cast<i32>(y) * 2 + 1, height - 1)) * width;
+            Color* dst = m_Bloom.data() + y * m_HalfWidth;
+            for (i32 x = 0; x < m_HalfWidth; ++x)
+            {
+                i32 x0 = Min(x * 2, width - 1);
+                i32 x1 = Min(x * 2 + 1, width - 1);
+#ifdef SCSR_AVX2
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&r0[x0].x), _mm_loadu_ps(&r0[x1].x)),
+                    _mm_add_ps(_mm_loadu_ps(&r1[x0].x), _mm_loadu_ps(&r1[x1].x)));
+                sum = _mm_mul_ps(sum, _mm_set1_ps(0.25f));
+                f32 luma = _mm_cvtss_f32(_mm_dp_ps(sum, _mm_setr_ps(LumaWeights.x, LumaWeights.y, LumaWeights.z, 0.0f), 0x71));
+                f32 scale = Max(luma - threshold, 0.0f) / Max(luma, 1e-4f);
+                _mm_storeu_ps(&dst[x].x, _mm_mul_ps(sum, _mm_set1_ps(scale)));
+#else
+                Color c = (r0[x0] + r0[x1] + r1[x0] + r1[x1]) * 0.25f;
+                f32 luma = Dot(c.xyz(), LumaWeights);
+                /// Soft knee, only the part above the threshold glows
+                dst[x] = c * (Max(luma - threshold, 0.0f) / Max(luma, 1e-4f));
+#endif
+            }
+        }
+    });
+}
+
+void PostChain::Blur()
+{
+    ZoneScopedN("Bloom blur");
+    const i32 radius = static_cast<i32>(m_Weights.size() / 2);
+    const f32* weights = m_Weights.data();
+    const i32 hw = m_HalfWidth;
+    const i32 hh = m_HalfHeight;
+
+    /// Horizontal into the scratch, pixels away from the edges two at a time
+    ThreadPool::Instance().ParallelFor(hh, RowGrain(hh), [&](usize begin, usize end) {
+        for (usize y = begin; y < end; ++y)
+        {
+            const Color* in = m_Bloom.data() + y * hw;
+            Color* out = m_BloomScratch.data() + y * hw;
+            auto clamped = [&](i32 x) {
+                Color acc(0.0f, 0.0f, 0.0f, 0.0f);
+                for (i32 k = -radius; k <= radius; ++k)
+                {
+                    acc += in[Clamp(x + k, 0, hw - 1)] * weights[k + radius];
+                }
+                out[x] = acc;
+            };
+
+            i32 x = 0;
+            for (; x < Min(radius, hw); ++x) { clamped(x); }
+#ifdef SCSR_AVX2
+            for (; x + 1 + radius < hw; x += 2)
+            {
+                const f32* base = &in[x - radius].x;
+                __m256 acc = _mm256_setzero_ps();
+                for (i32 k = 0; k <= radius * 2; ++k)
+                {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(base + k * 4), _mm256_set1_ps(weights[k])));
+                }
+                _mm256_storeu_ps(&out[x].x, acc);
+            }
+#endif
+            for (; x < hw; ++x) { clamped(x); }
+        }
+    });
+
+    /// Vertical back, whole rows of floats at once
+    ThreadPool::Instance().ParallelFor(hh, RowGrain(hh), [&](usize begin, usize end) {
+        const usize floats = static_cast<usize>(hw) * 4;
+        for (usize y = begin; y < end; ++y)
+        {
+            f32* out = &m_Bloom[y * hw].x;
+            auto row = [&](i32 k) {
+                return &m_BloomScratch[static_cast<usize>(Clamp(static_cast<i32>(y) + k - radius, 0, hh - 1)) * hw].x;
+            };
+
+            usize i = 0;
+#ifdef SCSR_AVX2
+            for (; i + 8 <= floats; i += 8)
+            {
+                __m256 acc = _mm256_setzero_ps();
+                for (i32 k = 0; k <= radius * 2; ++k)
+                {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(row(k) + i), _mm256_set1_ps(weights[k])));
+                }
+                _mm256_storeu_ps(out + i, acc);
+            }
+#endif
+            for (; i < floats; ++i)
+            {
+                f32 acc = 0.0f;
+                for (i32 k = 0; k <= radius * 2; ++k)
+                {
+                    acc += row(k)[i] * weights[k];
+                }
+                out[i] = acc;
+            }
+        }
+    });
+}
+
+void PostChain::ToneMap(const Image& hdr, Image& out)
+{
+    ZoneScopedN("Tone mapping");
+    const i32 width = hdr.Width();
+    const i32 height = hdr.Height();
+    const bool bloom = m_Prop.bloom;
+    const bool fxaa = m_Prop.fxaa;
+    const f32 exposure = m_Prop.exposure;
+    const f32 intensity = m_Prop.bloomIntensity;
+    const ToneMapper mapper = m_Prop.toneMapper;
+
+    ThreadPool::Instance().ParallelFor(height, RowGrain(height), [&](usize begin, usize end) {
+        thread_local std::vector<Color> halfRow, bloomRow, mappedRow;
+        bloomRow.resize(width);
+        mappedRow.resize(width);
+        halfRow.resize(m_HalfWidth);
+
+        for (usize y = begin; y < end; ++y)
+        {
+            const Color* src = hdr.HdrData() + y * width;
+            Color* dst = fxaa ? m_Mapped.data() + y * width : mappedRow.data();
+
+            if (bloom)
+            {
+                /// Bilinear upsample of the half resolution bloom, rows first
+                f32 hy = Clamp((y + 0.5f) * 0.5f - 0.5f, 0.0f, static_cast<f32>(m_HalfHeight - 1));
+                i32 y0 = static_cast<i32>(hy);
+                f32 ty = hy - y0;
+                const f32* b0 = &m_Bloom[static_cast<usize>(y0) * m_HalfWidth].x;
+                const f32* b1 = &m_Bloom[static_cast<usize>(Min(y0 + 1, m_HalfHeight - 1)) * m_HalfWidth].x;
+                f32* half = &halfRow[0].x;
+                for (usize i = 0; i < static_cast<usize>(m_HalfWidth) * 4; ++i)
+                {
+                    half[i] = b0[i] + (b1[i] - b0[i]) * ty;
+                }
+                for (i32 x = 0; x < width; ++x)
+                {
+                    f32 hx = Clamp((x + 0.5f) * 0.5f - 0.5f, 0.0f, static_cast<f32>(m_HalfWidth - 1));
+                    i32 x0 = static_cast<i32>(hx);
+                    bloomRow[x] = Lerp(halfRow[x0], halfRow[Min(x0 + 1, m_HalfWidth - 1)], hx - x0) * intensity;
+                }
+            }
+
+            f32* luma = fxaa ? m_Luma.data() + y * (width + 2) + 1 : nullptr;
+            i32 x = 0;
+#ifdef SCSR_AVX2
+            const __m256 exposure8 = _mm256_set1_ps(exposure);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 lumaWeights = _mm256_setr_ps(LumaWeights.x, LumaWeights.y, LumaWeights.z, 0.0f, LumaWeights.x, LumaWeights.y, LumaWeights.z, 0.0f);
+            for (; x + 2 <= width; x += 2)
+            {
+                __m256 c = _mm256_mul_ps(_mm256_loadu_ps(&src[x].x), exposure8);
+                if (bloom) { c = _mm256_add_ps(c, _mm256_loadu_ps(&bloomRow[x].x)); }
+                /// Opaque output, alpha is the last lane of each pixel
+                __m256 mapped = _mm256_blend_ps(ToneMap8(c, mapper), one, 0x88);
+                _mm256_storeu_ps(&dst[x].x, mapped);
+                if (luma)
+                {
+                    __m256 dot = _mm256_dp_ps(mapped, lumaWeights, 0xF1);
+                    luma[x] = _mm256_cvtss_f32(dot);
+                    luma[x + 1] = _mm_cvtss_f32(_mm256_extractf128_ps(dot, 1));
+                }
+            }
+#endif
+            for (; x < width; ++x)
+            {
+                Color c = src[x] * exposure;
+                if (bloom) { c += bloomRow[x]; }
+                dst[x] = Color(ToneMapChannel(c.x, mapper), ToneMapChannel(c.y, mapper), ToneMapChannel(c.z, mapper), 1.0f);
+                if (luma) { luma[x] = Dot(dst[x].xyz(), LumaWeights); }
+            }
+
+            if (luma)
+            {
+                luma[-1] = luma[0];
+                luma[width] = luma[width - 1];
+            }
+            else
+            {
+                PackColors(dst, out.Data() + y * width, width, out.Format(), m_Prop.srgb);
+            }
+        }
+    });
+}
+
+void PostChain::Fxaa(Image& out)
+{
+    ZoneScopedN("FXAA");
+    const i32 width = out.Width();
+    const i32 height = out.Height();
+    const usize stride = static_cast<usize>(width) + 2;
+    const Color* mapped = m_Mapped.data();
+    const f32* lumaData = m_Luma.data();
+
+    /// Blend along the edge through the pixel, FXAA 2 style
+    auto antialias = [&](i32 x, i32 y) {
+        auto luma = [&](i32 px, i32 py) {
+            return lumaData[static_cast<usize>(Clamp(py, 0, height - 1)) * stride + Clamp(px, 0, width - 1) + 1];
+        };
+        f32 nw = luma(x - 1, y - 1), ne = luma(x + 1, y - 1);
+        f32 sw = luma(x - 1, y + 1), se = luma(x + 1, y + 1);
+        f32 m = luma(x, y);
+        f32 lumaMin = Min(m, Min(Min(nw, ne), Min(sw, se)));
+        f32 lumaMax = Max(m, Max(Max(nw, ne), Max(sw, se)));
+
+        f32 dx = -((nw + ne) - (sw + se));
+        f32 dy = (nw + sw) - (ne + se);
+        f32 reduce = Max((nw + ne + sw + se) * 0.25f * FxaaReduceMul, FxaaReduceMin);
+        f32 scale = 1.0f / (Min(Abs(dx), Abs(dy)) + reduce);
+        dx = Clamp(dx * scale, -FxaaSpanMax, FxaaSpanMax);
+        dy = Clamp(dy * scale, -FxaaSpanMax, FxaaSpanMax);
+
+        f32 px = x + 0.5f;
+        f32 py = y + 0.5f;
+        auto sample = [&](f32 t) { return SampleBilinear(mapped, width, height, px + dx * t, py + dy * t); };
+        Color a = (sample(1.0f / 3.0f - 0.5f) + sample(2.0f / 3.0f - 0.5f)) * 0.5f;
+        Color b = a * 0.5f + (sample(-0.5f) + sample(0.5f)) * 0.25f;
+        f32 lumaB = Dot(b.xyz(), LumaWeights);
+        /// The wider blend crossed another edge, keep the narrow one
+        return lumaB < lumaMin || lumaB > lumaMax ? a : b;
+    };
+
+    ThreadPool::Instance().ParallelFor(height, RowGrain(height), [&](usize begin, usize end) {
+        thread_local std::vector<Color> row;
+        row.resize(width);
+
+        for (usize y = begin; y < end; ++y)
+        {
+            const f32* lm = lumaData + y * stride + 1;
+            const f32* ln = lumaData + static_cast<usize>(y > 0 ? y - 1 : 0) * stride + 1;
+            const f32* ls = lumaData + static_cast<usize>(Min(static_cast<i32>(y) + 1, height - 1)) * stride + 1;
+            const Color* src = mapped + y * width;
+            i32 yi = static_cast<i32>(y);
+
+            /// Most pixels are flat, test eight at once and only resolve edges
+            i32 x = 0;
+#ifdef SCSR_AVX2
+            const __m256 edge = _mm256_set1_ps(FxaaEdgeThreshold);
+            const __m256 edgeMin = _mm256_set1_ps(FxaaEdgeThresholdMin);
+            for (; x + 8 <= width; x += 8)
+            {
+                __m256 c = _mm256_loadu_ps(lm + x);
+                __m256 n = _mm256_loadu_ps(ln + x);
+                __m256 s = _mm256_loadu_ps(ls + x);
+                __m256 w = _mm256_loadu_ps(lm + x - 1);
+                __m256 e = _mm256_loadu_ps(lm + x + 1);
+                __m256 hi = _mm256_max_ps(c, _mm256_max_ps(_mm256_max_ps(n, s), _mm256_max_ps(w, e)));
+                __m256 lo = _mm256_min_ps(c, _mm256_min_ps(_mm256_min_ps(n, s), _mm256_min_ps(w, e)));
+                __m256 threshold = _mm256_max_ps(edgeMin, _mm256_mul_ps(hi, edge));
+                i32 mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_sub_ps(hi, lo), threshold, _CMP_GE_OQ));
+                for (i32 i = 0; i < 8; ++i)
+                {
+                    row[x + i] = (mask >> i) & 1 ? antialias(x + i, yi) : src[x + i];
+                }
+            }
+#endif
+            for (; x < width; ++x)
+            {
+                f32 hi = Max(lm[x], Max(Max(ln[x], ls[x]), Max(lm[x - 1], lm[x + 1])));
+                f32 lo = Min(lm[x], Min(Min(ln[x], ls[x]), Min(lm[x - 1], lm[x + 1])));
+                row[x] = hi - lo >= Max(FxaaEdgeThresholdMin, hi * FxaaEdgeThreshold) ? antialias(x, yi) : src[x];
+            }
+
+            PackColors(row.data(), out.Data() + y * width, width, out.Format(), m_Prop.srgb);
+        }
+    });
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "graphics/ray_tracer.hpp"
+#include "graphics/blit.hpp"
+#include "graphics/camera.hpp"
+#include "core/task/thread_pool.hpp"
+
+#include <Tracy.hpp>
+
+#include <atomic>
+
+namespace scsr
+{
+
+/// Shadow rays start this far off the surface so they do not hit it again
+static constexpr f32 ShadowBias = 1e-3f;
+
+Ray ScreenRay(const Mat4& inverseViewProjection, f32 x, f32 y, i32 width, i32 height)
+{
+    f32 ndcX = x / width * 2.0f - 1.0f;
+    f32 ndcY = 1.0f - y / height * 2.0f;
+    Vec4 near = inverseViewProjection * Vec4(ndcX, ndcY, 0.0f, 1.0f);
+    Vec4 far = inverseViewProjection * Vec4(ndcX, ndcY, 1.0f, 1.0f);
+    Vec3 origin = near.xyz() / near.w;
+    return { origin, far.xyz() / far.w - origin, F32INF };
+}
+
+usize RayTracer::Render(const Bvh& bvh, const Camera& camera, Image& target, const Rect& region)
+{
+    ZoneScoped;
+    const Rect area = Intersect(region, target.Bounds());
+    if (area.Empty()) { return 0; }
+
+    const Mat4 viewProjection = camera.GetProjection() * camera.GetView();
+    const Mat4 inverse = Inverse(viewProjection);
+    const Vec3 toLight = Normalized(-m_Prop.lightDirection);
+    const i32 width = target.Width();
+    const i32 height = target.Height();
+    const i32 tilesX = (area.Width() + TileSize - 1) / TileSize;
+    const i32 tilesY = (area.Height() + TileSize - 1) / TileSize;
+    Color* hdr = target.HdrData();
+    u32* pixels = target.Data();
+    f32* depth = target.DepthData();
+    std::atomic<usize> hits = 0;
+
+    ThreadPool::Instance().ParallelFor(static_cast<usize>(tilesX) * tilesY, 1, [&](usize begin, usize end) {
+        RayPacket primary;
+        RayPacket shadow;
+        PacketHit hit;
+        Color colors[RayPacket::Size];
+        usize tileHits = 0;
+        for (usize tile = begin; tile < end; ++tile)
+        {
+            const i32 tx = area.x0 + static_cast<i32>(tile % tilesX) * TileSize;
+            const i32 ty = area.y0 + static_cast<i32>(tile / tilesX) * TileSize;
+            const i32 tx1 = Min(tx + TileSize, area.x1);
+            const i32 ty1 = Min(ty + TileSize, area.y1);
+            for (i32 y = ty; y < ty1; ++y)
+            {
+                for (i32 x = tx; x < tx1; x += RayPacket::Size)
+                {
+                    const i32 lanes = Min<i32>(RayPacket::Size, tx1 - x);
+                    const u32 mask = (1u << lanes) - 1;
+                    for (i32 lane = 0; lane < lanes; ++lane)
+                    {
+                        primary.Set(lane, ScreenRay(inverse, x + lane + 0.5f, y + 0.5f, width, height));
+                    }
+                    bvh.Intersect(primary, mask, hit);
+
+                    /// Shade lit hits after one shadow packet for all of them
+                    u32 lit = 0;
+                    Vec3 normals[RayPacket::Size];
+                    for (i32 lane = 0; lane < lanes; ++lane)
+                    {
+                        colors[lane] = m_Prop.background;
+                        if (hit.triangle[lane] == ~0u) { continue; }
+                        Vec3 direction(primary.dx[lane], primary.dy[lane], primary.dz[lane]);
+                        Vec3 normal = Normalized(bvh.Normal(hit.Get(lane)));
+                        /// Both sides of a triangle are lit the same
+                        if (Dot(normal, direction) > 0.0f) { normal = -normal; }
+                        normals[lane] = normal;
+                        if (Dot(normal, toLight) <= 0.0f) { continue; }
+                        Vec3 point = Vec3(primary.ox[lane], primary.oy[lane], primary.oz[lane]) + direction * hit.t[lane];
+                        shadow.Set(lane, { point + normal * ShadowBias, toLight, F32INF });
+                        lit |= 1u << lane;
+                    }
+                    const u32 shadowed = m_Prop.shadows ? bvh.Occluded(shadow, lit) : 0;
+
+                    usize index = static_cast<usize>(y) * width + x;
+                    for (i32 lane = 0; lane < lanes; ++lane)
+                    {
+                        if (hit.triangle[lane] == ~0u)
+                        {
+                            if (depth) { depth[index + lane] = 1.0f; }
+                            continue;
+                        }
+                        ++tileHits;
+                        Vec3 light = m_Prop.ambient;
+                        if (((lit & ~shadowed) >> lane) & 1)
+                        {
+                            light += m_Prop.lightColor * Dot(normals[lane], toLight);
+                        }
+                        colors[lane] = Color(m_Prop.albedo.x * light.x, m_Prop.albedo.y * light.y, m_Prop.albedo.z * light.z, 1.0f);
+                        if (depth)
+                        {
+                            Vec4 clip = viewProjection * Vec4(primary.ox[lane] + primary.dx[lane] * hit.t[lane],
+                                primary.oy[lane] + primary.dy[lane] * hit.t[lane], primary.oz[lane] + primary.dz[lane] * hit.t[lane], 1.0f);
+                            depth[index + lane] = clip.z / clip.w;
+                        }
+                    }
+                    if (hdr)
+                    {
+                        std::copy(colors, colors + lanes, hdr + index);
+                    }
+                    else
+                    {
+                        PackColors(colors, pixels + index, lanes, target.Format());
+                    }
+                }
+            }
+        }
+        hits += tileHits;
+    });
+    return hits;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "graphics/render_graph.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/assert.hpp"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace scsr
+{
+
+/// Frames a pooled image may go unused before it is freed
+static constexpr usize PoolIdleFrames = 8;
+
+static bool SameProp(const ImageProp& a, const ImageProp& b)
+{
+    return a.width == b.width && a.height == b.height && a.format == b.format && a.hdr == b.hdr;
+}
+
+static bool Contains(const std::vector<RenderResource>& list, RenderResource resource)
+{
+    return std::any_of(list.begin(), list.end(), [&](RenderResource r) { return r.index == resource.index; });
+}
+
+RenderResource RenderGraph::Import(const std::string& name, Ref<Image> image)
+{
+    RT_ASSERT(image, "Imported image is null");
+    m_Resources.push_back(Resource { .name = name, .prop = image->Prop(), .image = image, .imported = true });
+    m_Compiled = false;
+    return { static_cast<u32>(m_Resources.size() - 1) };
+}
+
+RenderResource RenderGraph::CreateTransient(const std::string& name, const ImageProp& prop)
+{
+    m_Resources.push_back(Resource { .name = name, .prop = prop });
+    m_Compiled = false;
+    return { static_cast<u32>(m_Resources.size() - 1) };
+}
+
+void RenderGraph::AddPass(RenderPassProp prop, PassFn fn)
+{
+    m_Passes.push_back(Pass { .prop = std::move(prop), .fn = std::move(fn) });
+    m_Compiled = false;
+}
+
+Ref<Image> RenderGraph::Get(RenderResource resource) const
+{
+    RT_ASSERT(resource.index < m_Resources.size(), "Render resource out of range");
+    return m_Resources[resource.index].image;
+}
+
+void RenderGraph::Reset()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_Order.clear();
+    m_Compiled = false;
+}
+
+void RenderGraph::Compile()
+{
+    if (m_Compiled) { return; }
+    ZoneScoped;
+
+    /// Dependencies follow declaration order: reads wait for the last writer,
+    /// writes for the last writer and every reader since
+    std::vector<u32> lastWriter(m_Resources.size(), ~0u);
+    std::vector<std::vector<u32>> readers(m_Resources.size());
+    for (u32 p = 0; p < m_Passes.size(); ++p)
+    {
+        Pass& pass = m_Passes[p];
+        pass.dependencies.clear();
+        for (RenderResource r : pass.prop.reads)
+        {
+            RT_ASSERT(r.index < m_Resources.size(), "Pass reads an unknown resource");
+            if (lastWriter[r.index] != ~0u) { pass.dependencies.push_back(lastWriter[r.index]); }
+            readers[r.index].push_back(p);
+        }
+        for (RenderResource w : pass.prop.writes)
+        {
+            RT_ASSERT(w.index < m_Resources.size(), "Pass writes an unknown resource");
+            if (lastWriter[w.index] != ~0u) { pass.dependencies.push_back(lastWriter[w.index]); }
+            for (u32 reader : readers[w.index])
+            {
+                if (reader != p) { pass.dependencies.push_back(reader); }
+            }
+            readers[w.index].clear();
+            lastWriter[w.index] = p;
+        }
+        std::sort(pass.dependencies.begin(), pass.dependencies.end());
+        pass.dependencies.erase(std::unique(pass.dependencies.begin(), pass.dependencies.end()), pass.dependencies.end());
+    }
+
+    Cull();
+    Schedule();
+    Allocate();
+    m_Compiled = true;
+}
+
+void RenderGraph::Cull()
+{
+    for (Pass& pass : m_Passes)
+    {
+        pass.culled = !pass.prop.sideEffects;
+        for (RenderResource w : pass.prop.writes)
+        {
+            if (m_Resources[w.index].imported) { pass.culled = false; }
+        }
+    }
+
+    /// Backwards, a kept pass keeps the passes producing what it uses. A pass
+    /// that only had to wait for a reader to finish does not keep that reader.
+    for (u32 p = static_cast<u32>(m_Passes.size()); p-- > 0;)
+    {
+        const Pass& pass = m_Passes[p];
+        if (pass.culled) { continue; }
+        for (u32 dep : pass.dependencies)
+        {
+            for (RenderResource w : m_Passes[dep].prop.writes)
+            {
+                if (Contains(pass.prop.reads, w) || Contains(pass.prop.writes, w))
+                {
+                    m_Passes[dep].culled = false;
+                }
+            }
+        }
+    }
+}
+
+void RenderGraph::Schedule()
+{
+    m_Order.clear();
+    for (u32 p = 0; p < m_Passes.size(); ++p)
+    {
+        Pass& pass = m_Passes[p];
+        pass.level = 0;
+        if (pass.culled) { continue; }
+        for (u32 dep : pass.dependencies)
+        {
+            if (!m_Passes[dep].culled) { pass.level = Max(pass.level, m_Passes[dep].level + 1); }
+        }
+        m_Order.push_back(p);
+    }
+    std::stable_sort(m_Order.begin(), m_Order.end(), [&](u32 a, u32 b) { return m_Passes[a].level < m_Passes[b].level; });
+}
+
+void RenderGraph::Allocate()
+{
+    for (Resource& resource : m_Resources)
+    {
+        resource.firstLevel = ~0u;
+        resource.lastLevel = 0;
+    }
+    for (u32 p : m_Order)
+    {
+        const Pass& pass = m_Passes[p];
+        for (const auto* list : { &pass.prop.reads, &pass.prop.writes })
+        {
+            for (RenderResource r : *list)
+            {
+                Resource& resource = m_Resources[r.index];
+                resource.firstLevel = Min(resource.firstLevel, pass.level);
+                resource.lastLevel = Max(resource.lastLevel, pass.level);
+            }
+        }
+    }
+
+    /// Transients in the order they come alive, each takes a pooled image of
+    /// its size that is free by then
+    std::vector<u32> transients;
+    for (u32 r = 0; r < m_Resources.size(); ++r)
+    {
+        Resource& resource = m_Resources[r];
+        if (resource.imported) { continue; }
+        resource.image = nullptr;
+        if (resource.firstLevel != ~0u) { transients.push_back(r); }
+    }
+    std::stable_sort(transients.begin(), transients.end(), [&](u32 a, u32 b) {
+        return m_Resources[a].firstLevel < m_Resources[b].firstLevel;
+    });
+
+    for (PooledImage& pooled : m_Pool)
+    {
+        pooled.used = false;
+    }
+    for (u32 r : transients)
+    {
+        Resource& resource = m_Resources[r];
+        auto free = std::find_if(m_Pool.begin(), m_Pool.end(), [&](const PooledImage& pooled) {
+            return SameProp(pooled.image->Prop(), resource.prop) && (!pooled.used || pooled.busyUntil < resource.firstLevel);
+        });
+        if (free == m_Pool.end())
+        {
+            m_Pool.push_back(PooledImage { .image = MakeRef<Image>(resource.prop) });
+            free = m_Pool.end() - 1;
+        }
+        free->used = true;
+        free->busyUntil = resource.lastLevel;
+        free->idleFrames = 0;
+        resource.image = free->image;
+    }
+
+    /// Sizes that stopped being used, e.g. after a resolution change
+    for (PooledImage& pooled : m_Pool)
+    {
+        if (!pooled.used) { ++pooled.idleFrames; }
+    }
+    std::erase_if(m_Pool, [](const PooledImage& pooled) { return pooled.idleFrames > PoolIdleFrames; });
+}
+
+void RenderGraph::Execute()
+{
+    Compile();
+    ZoneScoped;
+
+    for (usize begin = 0; begin < m_Order.size();)
+    {
+        usize end = begin + 1;
+        while (end < m_Order.size() && m_Passes[m_Order[end]].level == m_Passes[m_Order[begin]].level)
+        {
+            ++end;
+        }
+
+        auto run = [&](usize first, usize last) {
+            for (usize i = first; i < last; ++i)
+            {
+                Pass& pass = m_Passes[m_Order[i]];
+                ZoneScopedN("Render pass");
+                ZoneText(pass.prop.name.c_str(), pass.prop.name.size());
+                auto start = std::chrono::steady_clock::now();
+                pass.fn(*this);
+                pass.time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        };
+        if (end - begin == 1)
+        {
+            run(begin, end);
+        }
+        else
+        {
+            ThreadPool::Instance().ParallelFor(end - begin, 1, [&](usize first, usize last) {
+                run(begin + first, begin + last);
+            });
+        }
+        begin = end;
+    }
+}
+
+}
\ No newline at end of file
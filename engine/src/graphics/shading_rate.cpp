@@ -0,0 +1,64 @@
+#include "graphics/shading_rate.hpp"
+#include "core/assert.hpp"
+
+#include <algorithm>
+
+namespace scsr
+{
+
+ShadingRateImage::ShadingRateImage(i32 width, i32 height)
+{
+    Resize(width, height);
+}
+
+void ShadingRateImage::Resize(i32 width, i32 height)
+{
+    m_Width = width;
+    m_Height = height;
+    m_TilesX = (width + TileSize - 1) / TileSize;
+    m_TilesY = (height + TileSize - 1) / TileSize;
+    m_Rates.assign(static_cast<usize>(m_TilesX) * m_TilesY, ShadingRate::Rate1x1);
+}
+
+void ShadingRateImage::Fill(ShadingRate rate)
+{
+    std::fill(m_Rates.begin(), m_Rates.end(), rate);
+}
+
+void ShadingRateImage::SetTile(i32 tileX, i32 tileY, ShadingRate rate)
+{
+    RT_ASSERT(tileX >= 0 && tileX < m_TilesX && tileY >= 0 && tileY < m_TilesY, "Shading rate tile out of range");
+    m_Rates[static_cast<usize>(tileY) * m_TilesX + tileX] = rate;
+}
+
+void ShadingRateImage::FromDepth(const Image& image, f32 depth2x2, f32 depth4x4)
+{
+    if (image.Width() != m_Width || image.Height() != m_Height)
+    {
+        Resize(image.Width(), image.Height());
+    }
+
+    const f32* depth = image.DepthData();
+    for (i32 ty = 0; ty < m_TilesY; ++ty)
+    {
+        for (i32 tx = 0; tx < m_TilesX; ++tx)
+        {
+            f32 nearest = 1.0f;
+            i32 y1 = Min((ty + 1) * TileSize, m_Height);
+            i32 x0 = tx * TileSize;
+            i32 x1 = Min(x0 + TileSize, m_Width);
+            for (i32 y = ty * TileSize; y < y1; ++y)
+            {
+                const f32* row = depth + static_cast<usize>(y) * m_Width;
+                nearest = Min(nearest, *std::min_element(row + x0, row + x1));
+            }
+
+            ShadingRate rate = ShadingRate::Rate1x1;
+            if (nearest > depth4x4) { rate = ShadingRate::Rate4x4; }
+            else if (nearest > depth2x2) { rate = ShadingRate::Rate2x2; }
+            m_Rates[static_cast<usize>(ty) * m_TilesX + tx] = rate;
+        }
+    }
+}
+
+}
\ No newline at end of file
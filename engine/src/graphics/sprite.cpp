@@ -0,0 +1,198 @@
+#include "graphics/sprite.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/assert.hpp"
+#include "bilinear.hpp"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace scsr
+{
+
+/// `count` pixels of `row`, `width` wide, with centers at `u0 + du * i`
+static void SampleNearest(const u32* row, i32 width, f32 u0, f32 du, u32* out, i32 count)
+{
+    i32 i = 0;
+#ifdef SCSR_AVX2
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256i last = _mm256_set1_epi32(width - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 u = _mm256_add_ps(_mm256_set1_ps(u0), _mm256_mul_ps(_mm256_set1_ps(du), _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(i)), lanes)));
+        __m256i column = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(u)), zero), last);
+        __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(row), column, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), pixels);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        f32 u = u0 + du * static_cast<f32>(i);
+        out[i] = row[Clamp(static_cast<i32>(std::floor(u)), 0, width - 1)];
+    }
+}
+
+/// Like `SampleNearest` between two rows mixed by `wy`
+static void SampleBilinear(const u32* row0, const u32* row1, i32 width, f32 u0, f32 du, i32 wy, u32* out, i32 count)
+{
+    i32 i = 0;
+#ifdef SCSR_AVX2
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zeroPs = _mm256_setzero_ps();
+    const __m256 lastPs = _mm256_set1_ps(static_cast<f32>(width - 1));
+    const __m256 weightOne = _mm256_set1_ps(static_cast<f32>(WeightOne));
+    const __m256i last = _mm256_set1_epi32(width - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i wv = _mm256_set1_epi16(static_cast<i16>(wy));
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 u = _mm256_add_ps(_mm256_set1_ps(u0), _mm256_mul_ps(_mm256_set1_ps(du), _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(i)), lanes)));
+        __m256 s = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(u, half), zeroPs), lastPs);
+        __m256i i0 = _mm256_cvttps_epi32(s);
+        __m256i i1 = _mm256_min_epi32(_mm256_add_epi32(i0, one), last);
+        __m256i w = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(s, _mm256_cvtepi32_ps(i0)), weightOne), half));
+        __m256i pixels = BilinearGather8(row0, row1, i0, i1, w, wv);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), pixels);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        i32 s0, s1, w;
+        BilinearTap(u0 + du * static_cast<f32>(i), width, s0, s1, w);
+        out[i] = LerpPixel(LerpPixel(row0[s0], row0[s1], w), LerpPixel(row1[s0], row1[s1], w), wy);
+    }
+}
+
+SpriteAtlas::SpriteAtlas(Ref<Image> image) :
+    m_Image(std::move(image))
+{
+}
+
+u32 SpriteAtlas::AddRegion(const Rect& rect)
+{
+    m_Regions.push_back(Intersect(rect, m_Image->Bounds()));
+    return static_cast<u32>(m_Regions.size() - 1);
+}
+
+SpriteBatch::SpriteBatch(Ref<SpriteAtlas> atlas) :
+    m_Atlas(std::move(atlas))
+{
+}
+
+void SpriteBatch::Add(const Sprite& sprite)
+{
+    RT_ASSERT(sprite.region < m_Atlas->RegionCount(), "Sprite region not in the atlas");
+    m_Sprites.push_back(sprite);
+}
+
+void SpriteBatch::Flush(Image& target)
+{
+    ZoneScoped;
+    std::stable_sort(m_Sprites.begin(), m_Sprites.end(), [](const Sprite& a, const Sprite& b) { return a.layer < b.layer; });
+
+    const f32 width = static_cast<f32>(target.Width());
+    const f32 height = static_cast<f32>(target.Height());
+    m_Placements.clear();
+    for (const Sprite& sprite : m_Sprites)
+    {
+        const Rect& region = m_Atlas->Region(sprite.region);
+        if (region.Empty()) { continue; }
+        Vec2 size = sprite.size;
+        if (size.x <= 0.0f || size.y <= 0.0f)
+        {
+            size = Vec2(static_cast<f32>(region.Width()), static_cast<f32>(region.Height()));
+        }
+
+        /// Pixels whose centers are inside the sprite, clamped in floats so
+        /// far away sprites cannot overflow
+        f32 x0 = Clamp(std::ceil(sprite.position.x - 0.5f), 0.0f, width);
+        f32 y0 = Clamp(std::ceil(sprite.position.y - 0.5f), 0.0f, height);
+        f32 x1 = Clamp(std::ceil(sprite.position.x + size.x - 0.5f), 0.0f, width);
+        f32 y1 = Clamp(std::ceil(sprite.position.y + size.y - 0.5f), 0.0f, height);
+        if (!(x0 < x1 && y0 < y1)) { continue; }
+
+        Placement placement;
+        placement.target = Rect { static_cast<i32>(x0), static_cast<i32>(y0), static_cast<i32>(x1), static_cast<i32>(y1) };
+        placement.source = region;
+        placement.du = static_cast<f32>(region.Width()) / size.x;
+        placement.dv = static_cast<f32>(region.Height()) / size.y;
+        placement.u0 = (x0 + 0.5f - sprite.position.x) * placement.du;
+        placement.v0 = (y0 + 0.5f - sprite.position.y) * placement.dv;
+        /// Nearest and bilinear agree when pixel centers land on texel centers
+        const bool aligned = sprite.filter == BlitFilter::Nearest ||
+            (placement.u0 - 0.5f == std::floor(placement.u0) && placement.v0 - 0.5f == std::floor(placement.v0));
+        placement.copy = placement.du == 1.0f && placement.dv == 1.0f && aligned;
+        placement.filter = sprite.filter;
+        placement.blend = sprite.blend;
+        m_Placements.push_back(placement);
+    }
+    m_Sprites.clear();
+
+    const i32 bands = (target.Height() + BandRows - 1) / BandRows;
+    ThreadPool::Instance().ParallelFor(bands, 1, [&](usize begin, usize end) {
+        for (usize band = begin; band < end; ++band)
+        {
+            DrawBand(target, static_cast<i32>(band));
+        }
+    });
+}
+
+void SpriteBatch::DrawBand(Image& target, i32 band) const
+{
+    ZoneScoped;
+    const Image& atlas = m_Atlas->GetImage();
+    const i32 top = band * BandRows;
+    const i32 bottom = Min(top + BandRows, target.Height());
+    const bool swizzle = atlas.Format() != target.Format();
+    std::vector<u32> span(target.Width());
+
+    for (const Placement& p : m_Placements)
+    {
+        const i32 y0 = Max(p.target.y0, top);
+        const i32 y1 = Min(p.target.y1, bottom);
+        const i32 count = p.target.Width();
+        const i32 regionWidth = p.source.Width();
+        const i32 regionHeight = p.source.Height();
+        for (i32 y = y0; y < y1; ++y)
+        {
+            /// Same float steps for every band, so bands never show seams
+            const f32 v = p.v0 + p.dv * static_cast<f32>(y - p.target.y0);
+            const u32* pixels;
+            if (p.copy)
+            {
+                const i32 row = p.source.y0 + static_cast<i32>(std::floor(v));
+                pixels = atlas.Data() + static_cast<usize>(row) * atlas.Width() + p.source.x0 + static_cast<i32>(std::floor(p.u0));
+            }
+            else if (p.filter == BlitFilter::Nearest)
+            {
+                const i32 row = p.source.y0 + Clamp(static_cast<i32>(std::floor(v)), 0, regionHeight - 1);
+                SampleNearest(atlas.Data() + static_cast<usize>(row) * atlas.Width() + p.source.x0, regionWidth, p.u0, p.du, span.data(), count);
+                pixels = span.data();
+            }
+            else
+            {
+                i32 row0, row1, wy;
+                BilinearTap(v, regionHeight, row0, row1, wy);
+                const u32* base = atlas.Data() + p.source.x0;
+                SampleBilinear(base + static_cast<usize>(p.source.y0 + row0) * atlas.Width(), base + static_cast<usize>(p.source.y0 + row1) * atlas.Width(),
+                    regionWidth, p.u0, p.du, wy, span.data(), count);
+                pixels = span.data();
+            }
+            if (swizzle)
+            {
+                SwizzlePixels(pixels, span.data(), count, atlas.Format(), target.Format());
+                pixels = span.data();
+            }
+            BlendPixels(pixels, target.Data() + static_cast<usize>(y) * target.Width() + p.target.x0, count, p.blend, target.Format());
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "graphics/static_batch.hpp"
+#include "core/task/thread_pool.hpp"
+#include "core/assert.hpp"
+
+#include <Tracy.hpp>
+
+#include <limits>
+#include <unordered_map>
+
+namespace scsr
+{
+
+/// The list topology a mesh is merged as
+static Topology ListTopology(Topology topology)
+{
+    if (topology >= Topology::Triangles) { return Topology::Triangles; }
+    return topology == Topology::Points ? Topology::Points : Topology::Lines;
+}
+
+/// Vertex index of the `i`th vertex of `mesh` expanded to its list topology
+static usize ListIndex(const Mesh& mesh, usize i)
+{
+    switch (mesh.topology)
+    {
+    case Topology::LineLoop:
+    case Topology::LineStrip:
+        return (i / 2 + i % 2) % mesh.vertices.size();
+    case Topology::TriangleStrip:
+    case Topology::TriangleFan:
+    {
+        usize indices[3];
+        TriangleIndices(mesh.topology, i / 3, indices);
+        return indices[i % 3];
+    }
+    default:
+        return i;
+    }
+}
+
+StaticBatcher::Handle StaticBatcher::Add(Mesh mesh, const Mat4& transform, u32 key)
+{
+    Handle handle;
+    if (!m_Free.empty())
+    {
+        handle = m_Free.back();
+        m_Free.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_Entries.size());
+        m_Entries.emplace_back();
+    }
+
+    Entry& entry = m_Entries[handle];
+    entry.mesh = std::move(mesh);
+    entry.transform = transform;
+    entry.key = key;
+    entry.alive = true;
+    ++m_Count;
+    m_Dirty = true;
+    return handle;
+}
+
+void StaticBatcher::Remove(Handle handle)
+{
+    RT_ASSERT(handle < m_Entries.size() && m_Entries[handle].alive, "Removing a static mesh twice");
+    m_Entries[handle] = {};
+    m_Free.push_back(handle);
+    --m_Count;
+    m_Dirty = true;
+}
+
+void StaticBatcher::Clear()
+{
+    m_Entries.clear();
+    m_Free.clear();
+    m_Count = 0;
+    m_Dirty = true;
+}
+
+bool StaticBatcher::Update()
+{
+    if (!m_Dirty) { return false; }
+    ZoneScoped;
+    m_Dirty = false;
+    m_Batches.clear();
+
+    /// Lay out the entries in the batches in handle order
+    std::vector<Placement> placements;
+    std::unordered_map<u64, u32> open;
+    for (u32 e = 0; e < m_Entries.size(); ++e)
+    {
+        const Entry& entry = m_Entries[e];
+        if (!entry.alive) { continue; }
+        Topology topology = ListTopology(entry.mesh.topology);
+        usize perPrimitive = topology == Topology::Triangles ? 3 : topology == Topology::Lines ? 2 : 1;
+        usize count = PrimitiveCount(entry.mesh.topology, entry.mesh.vertices.size()) * perPrimitive;
+        if (count == 0) { continue; }
+
+        u64 group = (static_cast<u64>(entry.key) << 32) | static_cast<u64>(topology);
+        auto it = open.find(group);
+        if (it == open.end() || (m_Batches[it->second].mesh.vertices.size() + count > MaxBatchVertices))
+        {
+            StaticBatch& batch = m_Batches.emplace_back();
+            batch.key = entry.key;
+            batch.mesh.topology = topology;
+            it = open.insert_or_assign(group, static_cast<u32>(m_Batches.size() - 1)).first;
+        }
+
+        /// Sized now, filled below
+        auto& vertices = m_Batches[it->second].mesh.vertices;
+        placements.push_back({ e, it->second, vertices.size(), count });
+        vertices.resize(vertices.size() + count);
+    }
+
+    const f32 far = std::numeric_limits<f32>::max();
+    std::vector<Vec3> mins(placements.size());
+    std::vector<Vec3> maxs(placements.size());
+    ThreadPool::Instance().ParallelFor(placements.size(), 1, [&](usize begin, usize end) {
+        for (usize p = begin; p < end; ++p)
+        {
+            const Placement& placement = placements[p];
+            const Entry& entry = m_Entries[placement.entry];
+            Vertex* out = m_Batches[placement.batch].mesh.vertices.data() + placement.offset;
+            Vec3 lo(far, far, far);
+            Vec3 hi(-far, -far, -far);
+            for (usize i = 0; i < placement.count; ++i)
+            {
+                Vertex vtx = entry.mesh.vertices[ListIndex(entry.mesh, i)];
+                vtx.pos = entry.transform * Vec4(vtx.pos.xyz(), 1.0f);
+                Vec3 normal = (entry.transform * Vec4(vtx.normal, 0.0f)).xyz();
+                if (Dot(normal, normal) > 0.0f) { vtx.normal = Normalized(normal); }
+                lo = Min(lo, vtx.pos.xyz());
+                hi = Max(hi, vtx.pos.xyz());
+                out[i] = vtx;
+            }
+            mins[p] = lo;
+            maxs[p] = hi;
+        }
+    });
+
+    for (StaticBatch& batch : m_Batches)
+    {
+        batch.min = Vec3(far, far, far);
+        batch.max = Vec3(-far, -far, -far);
+    }
+    for (usize p = 0; p < placements.size(); ++p)
+    {
+        StaticBatch& batch = m_Batches[placements[p].batch];
+        batch.min = Min(batch.min, mins[p]);
+        batch.max = Max(batch.max, maxs[p]);
+    }
+    return true;
+}
+
+}
\ No newline at end of file
@@ -1,42 +1,297 @@
 #include "graphics/swapchain.hpp"
+#include "core/assert.hpp"
+#include "core/log.hpp"
 
 #include <Tracy.hpp>
 
+#include <algorithm>
+
 namespace scsr
 {
 
-Swapchain::Swapchain(ImageProp prop, usize count)
+Swapchain::Swapchain(ImageProp prop, usize count, usize maxFramesInFlight) :
+    m_Prop(prop),
+    m_MaxFramesInFlight(maxFramesInFlight)
 {
-    m_FrontBuffer.reserve(count);
-    m_BackBuffer.reserve(count);
+    RT_ASSERT(count > 0, "Swapchain needs at least one image");
 
+    m_Images.reserve(count);
+    m_States.resize(count, ImageState::Free);
+    m_Written.resize(count, 0);
+    m_Ages.resize(count, 0);
     for (usize i = 0; i < count; ++i)
     {
-        m_BackBuffer.push_back(MakeRef<Image>(prop));
+        m_Images.push_back(MakeRef<Image>(prop));
+    }
+
+    /// One image is held by the presenter and one by the latest written frame,
+    /// fewer than three images fall back to writing serially
+    usize limit = count > 2 ? count - 2 : 0;
+    if (m_MaxFramesInFlight > limit)
+    {
+        if (count > 1)
+        {
+            LOG_WARN("Swapchain with {} images allows at most {} frames in flight, requested {}",
+                count, limit, m_MaxFramesInFlight);
+        }
+        m_MaxFramesInFlight = limit;
+    }
+}
+
+Swapchain::~Swapchain()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Cond.notify_all();
+    if (m_RenderThread.joinable())
+    {
+        m_RenderThread.join();
     }
 }
 
 void Swapchain::PushWriteCommand(WriteCommand command)
 {
+    RT_ASSERT(!m_Running, "Write commands must be pushed before the first frame");
     m_WriteCommands.push_back(command);
 }
 
+void Swapchain::PushUpdateCommand(UpdateCommand command)
+{
+    RT_ASSERT(!m_Running, "Update commands must be pushed before the first frame");
+    m_UpdateCommands.push_back(command);
+}
+
 void Swapchain::AcquireAndWrite()
 {
     ZoneScoped;
-    auto available = m_BackBuffer.back();
-    
-    for (auto& command : m_WriteCommands)
+
+    /// No render thread, write and present serially on the calling thread
+    if (m_MaxFramesInFlight == 0)
+    {
+        bool resized;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            resized = ResizeImage(0);
+        }
+        Ref<Image> direct = m_Window ? m_Window->SurfaceImage(m_Images[0]->Prop()) : nullptr;
+        Ref<Image> previous = m_SerialTarget;
+        m_SerialTarget = direct ? direct : m_Images[0];
+        /// Switching between the surface and the own image loses the previous frame
+        MarkAcquired(0, resized || previous != m_SerialTarget);
+        m_SerialPending = true;
+
+        for (auto& command : m_UpdateCommands)
+        {
+            command(0);
+        }
+        Write(m_SerialTarget, 0);
+        return;
+    }
+
+    usize index = InvalidIndex;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (!m_Running)
+        {
+            m_Running = true;
+            m_RenderThread = std::thread(&Swapchain::RenderLoop, this);
+        }
+
+        m_Cond.wait(lock, [this] {
+            return m_InFlight < m_MaxFramesInFlight
+                && std::find(m_States.begin(), m_States.end(), ImageState::Free) != m_States.end();
+        });
+
+        /// Round-robin so images are reused in submission order
+        while (m_States[m_NextAcquire] != ImageState::Free)
+        {
+            m_NextAcquire = (m_NextAcquire + 1) % m_Images.size();
+        }
+        index = m_NextAcquire;
+        m_NextAcquire = (m_NextAcquire + 1) % m_Images.size();
+
+        m_States[index] = ImageState::Writing;
+        ++m_InFlight;
+        /// Nobody else holds an image between acquiring and queueing it
+        MarkAcquired(index, ResizeImage(index));
+    }
+
+    /// In-flight frames never touch state the update commands write when
+    /// `maxFramesInFlight` is 1, otherwise use `index` to pick a per-image slot
+    for (auto& command : m_UpdateCommands)
     {
-        command(available);
+        command(index);
     }
-};
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingQueue.push_back(index);
+    }
+    m_Cond.notify_all();
+}
 
 void Swapchain::Present(Window& window)
 {
     ZoneScoped;
-    auto available = m_BackBuffer.back();
-    window.OnUpdate(m_BackBuffer.back());
+    if (m_MaxFramesInFlight == 0)
+    {
+        /// Nothing new was written, the window still shows the last frame
+        if (m_SerialTarget && m_SerialPending)
+        {
+            window.OnUpdate(m_SerialTarget);
+            m_SerialPending = false;
+        }
+        return;
+    }
+
+    usize index = InvalidIndex;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        /// Only the very first frame waits, afterwards the previous image stays
+        /// on screen while the render thread catches up
+        m_Cond.wait(lock, [this] {
+            return !m_ReadyQueue.empty() || m_InFlight == 0 || m_Presenting != InvalidIndex;
+        });
+
+        if (m_ReadyQueue.empty())
+        {
+            return;
+        }
+
+        /// Latest frame wins, older written frames are dropped to keep latency low
+        if (m_Presenting != InvalidIndex && m_Presenting != m_ReadyQueue.back())
+        {
+            m_States[m_Presenting] = ImageState::Free;
+        }
+        while (m_ReadyQueue.size() > 1)
+        {
+            m_States[m_ReadyQueue.front()] = ImageState::Free;
+            m_ReadyQueue.pop_front();
+        }
+        m_Presenting = m_ReadyQueue.front();
+        m_ReadyQueue.pop_front();
+        m_States[m_Presenting] = ImageState::Presenting;
+        index = m_Presenting;
+    }
+    m_Cond.notify_all();
+
+    window.OnUpdate(m_Images[index]);
+}
+
+bool Swapchain::Represent(Window& window)
+{
+    ZoneScoped;
+    if (m_MaxFramesInFlight == 0)
+    {
+        if (!m_SerialTarget) { return false; }
+        /// A surface image is stale once the window got a new surface
+        bool owned = m_SerialTarget == m_Images[0];
+        if (!owned && (!m_Window || m_Window->SurfaceImage(m_SerialTarget->Prop()) != m_SerialTarget))
+        {
+            return false;
+        }
+        window.OnUpdate(m_SerialTarget);
+        m_SerialPending = false;
+        return true;
+    }
+
+    /// The presenting image is never written while it is held
+    usize index = InvalidIndex;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        index = m_Presenting;
+    }
+    if (index == InvalidIndex)
+    {
+        return false;
+    }
+    window.OnUpdate(m_Images[index]);
+    return true;
+}
+
+bool Swapchain::IsIdle()
+{
+    if (m_MaxFramesInFlight == 0) { return !m_SerialPending; }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_InFlight == 0 && m_ReadyQueue.empty();
+}
+
+void Swapchain::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Cond.wait(lock, [this] { return m_InFlight == 0; });
+}
+
+void Swapchain::Resize(ImageProp prop)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Prop = prop;
+}
+
+ImageProp Swapchain::GetImageProp()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Prop;
+}
+
+bool Swapchain::ResizeImage(usize index)
+{
+    const ImageProp& current = m_Images[index]->Prop();
+    if (current.width == m_Prop.width && current.height == m_Prop.height && current.format == m_Prop.format && current.hdr == m_Prop.hdr)
+    {
+        return false;
+    }
+
+    ZoneScopedN("Swapchain resize");
+    m_Images[index]->Resize(m_Prop);
+    return true;
+}
+
+void Swapchain::MarkAcquired(usize index, bool invalidated)
+{
+    m_Ages[index] = m_Written[index] != 0 && !invalidated ? m_Frame - m_Written[index] : 0;
+    m_Written[index] = m_Frame;
+    ++m_Frame;
+}
+
+void Swapchain::Write(Ref<Image> image, usize index)
+{
+    ZoneScopedN("Swapchain write");
+    for (auto& command : m_WriteCommands)
+    {
+        command(image, index);
+    }
+}
+
+void Swapchain::RenderLoop()
+{
+    while (true)
+    {
+        usize index = InvalidIndex;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cond.wait(lock, [this] { return !m_PendingQueue.empty() || !m_Running; });
+            if (m_PendingQueue.empty())
+            {
+                return;
+            }
+            index = m_PendingQueue.front();
+            m_PendingQueue.pop_front();
+        }
+
+        Write(m_Images[index], index);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_States[index] = ImageState::Ready;
+            m_ReadyQueue.push_back(index);
+            --m_InFlight;
+        }
+        m_Cond.notify_all();
+    }
 }
 
-}   
\ No newline at end of file
+}
\ No newline at end of file
@@ -3,25 +3,33 @@
 
 #include <Tracy.hpp>
 
+#ifdef SCSR_AVX2
+    #include <immintrin.h>
+#endif
+
 namespace scsr
 {
 
-Vertex FromInterpolation(const Vertex& v1, const Vertex& v2, f32 t)
+Vec2i Vertex::ScreenPos() const
 {
-    ZoneScopedN("Vertex interpolation");
-
-    Vertex vtx;
-    vtx.pos = LerpVec4(v1.pos, v2.pos, t);
-    vtx.uv = Lerp(v1.uv, v2.uv, t);
-    vtx.normal = Lerp(v1.normal, v2.normal, t);
-    vtx.rhw = Lerp(v1.rhw, v2.rhw, t);
-    // handle varying
-    return std::move(vtx);
+    return Vec2i(static_cast<i32>(pos.x + 0.5f), static_cast<i32>(pos.y + 0.5f));
 }
 
-Vec2i Vertex::ScreenPos() const
+Plane Plane::FromTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+    f32 f0, f32 f1, f32 f2, f32 invArea)
 {
-    return Vec2i(static_cast<i32>(pos.x + 0.5f), static_cast<i32>(pos.y + 0.5f));
+    f32 dx1 = v1.pos.x - v0.pos.x;
+    f32 dy1 = v1.pos.y - v0.pos.y;
+    f32 dx2 = v2.pos.x - v0.pos.x;
+    f32 dy2 = v2.pos.y - v0.pos.y;
+    f32 df1 = f1 - f0;
+    f32 df2 = f2 - f0;
+
+    Plane plane;
+    plane.a = (df1 * dy2 - df2 * dy1) * invArea;
+    plane.b = (df2 * dx1 - df1 * dx2) * invArea;
+    plane.c = f0 - plane.a * v0.pos.x - plane.b * v0.pos.y;
+    return plane;
 }
 
 std::pair<std::pair<Trapezoid, Trapezoid>, u32> Trapezoid::FromPrimitive(Vertex& v1, Vertex& v2, Vertex& v3)
@@ -48,8 +56,7 @@ std::pair<std::pair<Trapezoid, Trapezoid>, u32> Trapezoid::FromPrimitive(Vertex&
     if (v1.pos.y == v2.pos.y)
     {
         /// Make v1 is the left
-        // if (v1.pos.x > v2.pos.x) { std::swap(v1, v2); }
-        if (v1.pos.x > v2.pos.x) { return {{}, 0u}; }
+        if (v1.pos.x > v2.pos.x) { std::swap(v1, v2); }
         trap1.top = v1.pos.y;
         trap1.bottom = v3.pos.y;
         trap1.left.v1  = &v1;
@@ -64,8 +71,7 @@ std::pair<std::pair<Trapezoid, Trapezoid>, u32> Trapezoid::FromPrimitive(Vertex&
     if (v2.pos.y == v3.pos.y)
     {
         /// Make v2 is the left
-        // if (v2.pos.x > v3.pos.x) { std::swap(v2, v3); }
-        if (v2.pos.x > v3.pos.x) { return {{}, 0u}; }
+        if (v2.pos.x > v3.pos.x) { std::swap(v2, v3); }
 
         trap1.top = v1.pos.y;
         trap1.bottom = v3.pos.y;
@@ -111,33 +117,92 @@ std::pair<std::pair<Trapezoid, Trapezoid>, u32> Trapezoid::FromPrimitive(Vertex&
     return {{trap1, trap2}, 2u};
 }
 
-std::pair<Vertex, Vertex> Trapezoid::LineYEnds(f32 y) const
+std::pair<f32, f32> Trapezoid::LineXEnds(f32 y) const
 {
     f32 t1 = (y - left.v1->pos.y) / (left.v2->pos.y - left.v1->pos.y);
     f32 t2 = (y - right.v1->pos.y) / (right.v2->pos.y - right.v1->pos.y);
-    Vertex v1 = FromInterpolation(*left.v1, *left.v2, t1);
-    Vertex v2 = FromInterpolation(*right.v1, *right.v2, t2);
-    return {std::move(v1), std::move(v2)};
+    f32 x1 = left.v1->pos.x + (left.v2->pos.x - left.v1->pos.x) * t1;
+    f32 x2 = right.v1->pos.x + (right.v2->pos.x - right.v1->pos.x) * t2;
+    return {x1, x2};
 }
 
 Scanline Scanline::FromTrapezoid(const Trapezoid& trap, i32 y)
 {
-    auto [vl, vr] = trap.LineYEnds((f32)y + 0.5f);
-    f32 width = vr.pos.x - vl.pos.x;
+    auto [xl, xr] = trap.LineXEnds((f32)y + 0.5f);
 
     Scanline scanline;
-    scanline.x = (i32)(vl.pos.x + 0.5f);
-    scanline.width = (i32)(vr.pos.x + 0.5f) - scanline.x;
+    scanline.x = (i32)(xl + 0.5f);
+    scanline.width = (i32)(xr + 0.5f) - scanline.x;
     scanline.y = y;
-    scanline.start = std::move(vl);
+    return scanline;
+}
 
-    f32 inv = 1.0f / width;
-    scanline.step.pos = (vr.pos - vl.pos) * inv;
-    scanline.step.uv = (vr.uv - vl.uv) * inv;
-    scanline.step.normal = (vr.normal - vl.normal) * inv;
-    scanline.step.rhw = (vr.rhw - vl.rhw) * inv;
+SmallTriangle SmallTriangle::FromPrimitive(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+    i32 x, i32 y, f32 doubleArea)
+{
+    const Vertex* vtxs[3] = { &v0, &v1, &v2 };
+    f32 sign = doubleArea > 0.0f ? 1.0f : -1.0f;
+    /// Relative to the first pixel center so the values stay small
+    f32 cx = static_cast<f32>(x) + 0.5f;
+    f32 cy = static_cast<f32>(y) + 0.5f;
+
+    SmallTriangle tri;
+    tri.x = x;
+    tri.y = y;
+    for (usize i = 0; i < 3; ++i)
+    {
+        const Vec4& p = vtxs[i]->pos;
+        const Vec4& q = vtxs[(i + 1) % 3]->pos;
+        f32 dx = q.x - p.x;
+        f32 dy = q.y - p.y;
+        tri.a[i] = -dy * sign;
+        tri.b[i] = dx * sign;
+        tri.c[i] = (dx * (cy - p.y) - dy * (cx - p.x)) * sign;
+        /// Stepping right or down from the edge leaves the triangle
+        tri.inclusive[i] = tri.a[i] < 0.0f || (tri.a[i] == 0.0f && tri.b[i] < 0.0f);
+    }
+    return tri;
+}
 
-    return std::move(scanline);
+void SmallTriangle::Coverage(u32 rows[MaxSize]) const
+{
+#ifdef SCSR_AVX2
+    /// Two block rows per register
+    const __m256 columns = _mm256_setr_ps(0, 1, 2, 3, 0, 1, 2, 3);
+    const __m256 zero = _mm256_setzero_ps();
+    for (i32 row = 0; row < MaxSize; row += 2)
+    {
+        const __m256 rowOffsets = _mm256_setr_ps(
+            static_cast<f32>(row), static_cast<f32>(row), static_cast<f32>(row), static_cast<f32>(row),
+            static_cast<f32>(row + 1), static_cast<f32>(row + 1), static_cast<f32>(row + 1), static_cast<f32>(row + 1));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (usize i = 0; i < 3; ++i)
+        {
+            __m256 e = _mm256_add_ps(_mm256_set1_ps(c[i]),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[i]), columns), _mm256_mul_ps(_mm256_set1_ps(b[i]), rowOffsets)));
+            __m256 edge = inclusive[i] ? _mm256_cmp_ps(e, zero, _CMP_GE_OQ) : _mm256_cmp_ps(e, zero, _CMP_GT_OQ);
+            inside = _mm256_and_ps(inside, edge);
+        }
+        u32 mask = static_cast<u32>(_mm256_movemask_ps(inside));
+        rows[row] = mask & 0xF;
+        rows[row + 1] = mask >> 4;
+    }
+#else
+    for (i32 row = 0; row < MaxSize; ++row)
+    {
+        rows[row] = 0;
+        for (i32 column = 0; column < MaxSize; ++column)
+        {
+            bool inside = true;
+            for (usize i = 0; i < 3; ++i)
+            {
+                f32 e = c[i] + (a[i] * static_cast<f32>(column) + b[i] * static_cast<f32>(row));
+                inside = inside && (inclusive[i] ? e >= 0.0f : e > 0.0f);
+            }
+            rows[row] |= inside ? 1u << column : 0u;
+        }
+    }
+#endif
 }
 
-} // namespace scsr
+} // namespace scsr
\ No newline at end of file
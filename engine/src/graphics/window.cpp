@@ -1,16 +1,43 @@
 #include "graphics/window.hpp"
 #include "graphics/image.hpp"
+#include "graphics/image_io.hpp"
 #include "core/log.hpp"
 
 #include <SDL.h>
 #include <Tracy.hpp>
 
 namespace scsr
-{ 
+{
+
+/// Surface formats the blitter writes directly, anything else goes through SDL
+static bool PixelFormatFromSDL(Uint32 format, PixelFormat& out)
+{
+    switch (format)
+    {
+    case SDL_PIXELFORMAT_RGBA8888:  out = PixelFormat::RGBA8888; return true;
+    case SDL_PIXELFORMAT_ARGB8888:
+    case SDL_PIXELFORMAT_RGB888:    out = PixelFormat::ARGB8888; return true;
+    case SDL_PIXELFORMAT_ABGR8888:
+    case SDL_PIXELFORMAT_BGR888:    out = PixelFormat::ABGR8888; return true;
+    case SDL_PIXELFORMAT_BGRA8888:  out = PixelFormat::BGRA8888; return true;
+    default:                        return false;
+    }
+}
 
 Window::Window(WindowProp prop) :
     m_Prop(prop)
 {
+    if (m_Prop.headless)
+    {
+        /// Events only, SDL still turns SIGINT into a quit event
+        SDL_Init(SDL_INIT_EVENTS);
+        m_NativeHandle = nullptr;
+        m_Offscreen = MakeRef<Image>(ImageProp { .width = m_Prop.width, .height = m_Prop.height });
+        m_Status = true;
+        LOG_INFO("Headless context created");
+        return;
+    }
+
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
 
     m_NativeHandle = SDL_CreateWindow(
@@ -26,37 +53,102 @@ Window::Window(WindowProp prop) :
 
 Window::~Window()
 {
+    m_SurfaceImage.reset();
     if (m_Status)
     {
-        SDL_DestroyWindow(static_cast<SDL_Window*>(m_NativeHandle));
+        if (m_NativeHandle)
+        {
+            SDL_DestroyWindow(static_cast<SDL_Window*>(m_NativeHandle));
+        }
 
         SDL_Quit();
         LOG_INFO("SDL context destroyed");
     }
 }
 
+Vec2i Window::GetSize() const
+{
+    Vec2i size(m_Prop.width, m_Prop.height);
+    if (!m_Prop.headless)
+    {
+        SDL_GetWindowSize(static_cast<SDL_Window*>(m_NativeHandle), &size.x, &size.y);
+    }
+    return size;
+}
+
+Ref<Image> Window::SurfaceImage(const ImageProp& prop)
+{
+    if (m_Prop.headless)
+    {
+        bool matches = m_Offscreen->Width() == prop.width && m_Offscreen->Height() == prop.height;
+        return matches ? m_Offscreen : nullptr;
+    }
+
+    SDL_Surface* surface = SDL_GetWindowSurface(static_cast<SDL_Window*>(m_NativeHandle));
+    PixelFormat format;
+    if (!surface || SDL_MUSTLOCK(surface) || !PixelFormatFromSDL(surface->format->format, format))
+    {
+        return nullptr;
+    }
+    if (surface->w != prop.width || surface->h != prop.height || surface->pitch != prop.width * 4)
+    {
+        return nullptr;
+    }
+
+    /// Recreated when SDL hands out a new surface after a resize
+    if (!m_SurfaceImage || m_SurfaceImage->Data() != surface->pixels || m_SurfaceImage->Format() != format)
+    {
+        m_SurfaceImage = MakeRef<Image>(
+            ImageProp { .width = prop.width, .height = prop.height, .format = format },
+            static_cast<u32*>(surface->pixels)
+        );
+    }
+    return m_SurfaceImage;
+}
+
 void Window::OnUpdate(Ref<Image> image)
 {
     ZoneScopedN("Window::OnUpdate");
+    FrameImage(image->Data(), image->Width(), image->Height(), 0, false);
+
+    if (m_Prop.headless)
+    {
+        if (image->Data() != m_Offscreen->Data())
+        {
+            ScalePixels(MakePixelView(*image), MakePixelView(*m_Offscreen), m_PresentFilter);
+        }
+        return;
+    }
+
     SDL_Window* window = static_cast<SDL_Window*>(m_NativeHandle);
-    i32 w, h;
-    SDL_GetWindowSize(window, &w, &h);
-    SDL_Rect rect { .w = w, .h = h };
-    
+    SDL_Surface* surface = SDL_GetWindowSurface(window);
+    if (!surface) { return; }
+
+    /// Rendered in place, nothing to copy
+    if (image->Data() != surface->pixels)
     {
         ZoneScopedN("Image Blit");
-        SDL_FillRect(
-            SDL_GetWindowSurface(window),
-            &rect, 
-            SDL_MapRGB(SDL_GetWindowSurface(window)->format, 0, 0, 0)
-        );
-        FrameImage(image->Data(), image->Width(), image->Height(), 0, false);
-        SDL_BlitScaled(
-            static_cast<SDL_Surface*>(image->SurfaceHandle()),
-            nullptr, 
-            SDL_GetWindowSurface(window),
-            &rect
-        );
+        PixelFormat format;
+        if (PixelFormatFromSDL(surface->format->format, format))
+        {
+            if (SDL_MUSTLOCK(surface)) { SDL_LockSurface(surface); }
+            /// The whole surface is overwritten, no clear needed
+            PixelView dst { static_cast<u32*>(surface->pixels), surface->w, surface->h, surface->pitch / 4, format };
+            ScalePixels(MakePixelView(*image), dst, m_PresentFilter);
+            if (SDL_MUSTLOCK(surface)) { SDL_UnlockSurface(surface); }
+        }
+        else
+        {
+            PixelLayout layout = GetPixelLayout(image->Format());
+            SDL_Surface* source = SDL_CreateRGBSurfaceFrom(
+                image->Data(),
+                image->Width(), image->Height(), 32, image->Width() * 4,
+                0xFFu << layout.r, 0xFFu << layout.g, 0xFFu << layout.b, 0xFFu << layout.a
+            );
+            SDL_Rect rect { .x = 0, .y = 0, .w = surface->w, .h = surface->h };
+            SDL_BlitScaled(source, nullptr, surface, &rect);
+            SDL_FreeSurface(source);
+        }
     }
     {
         ZoneScopedN("SDL Update");
@@ -64,4 +156,25 @@ void Window::OnUpdate(Ref<Image> image)
     }
 }
 
+bool Window::SaveFrame(const std::string& path)
+{
+    if (m_Prop.headless)
+    {
+        return WriteImage(path, *m_Offscreen);
+    }
+
+    SDL_Surface* surface = SDL_GetWindowSurface(static_cast<SDL_Window*>(m_NativeHandle));
+    PixelFormat format;
+    if (!surface || !PixelFormatFromSDL(surface->format->format, format))
+    {
+        LOG_WARN("Window surface cannot be saved");
+        return false;
+    }
+
+    if (SDL_MUSTLOCK(surface)) { SDL_LockSurface(surface); }
+    bool written = WriteImage(path, PixelView { static_cast<u32*>(surface->pixels), surface->w, surface->h, surface->pitch / 4, format });
+    if (SDL_MUSTLOCK(surface)) { SDL_UnlockSurface(surface); }
+    return written;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/core.hpp"
+
+#include <fmt/core.h>
+#include <Tracy.hpp>
+
+using namespace scsr;
+
+/// Frame dumping and run length, set from the command line
+struct CaptureSettings
+{
+    /// Exit after this many frames, 0 runs until quit
+    usize frames = 0;
+    /// Output path, `{}` is replaced by the frame number, empty disables dumping
+    std::string path;
+};
+
+static void CapturePlugin(World& world, Storage& storage)
+{
+    if (auto& settings = storage.GetObject<CaptureSettings>(); !settings.path.empty() && !FormatsNumber(settings.path))
+    {
+        LOG_WARN("Dump path {} is not a valid pattern, frames are not dumped", settings.path);
+        settings.path.clear();
+    }
+    world.AddSystem([](Storage& storage, EventHandler& eventHandler) {
+        auto& settings = storage.GetObject<CaptureSettings>();
+        usize tick = storage.GetObject<Ticker>().tick;
+        if (settings.frames > 0 && tick >= settings.frames)
+        {
+            return;
+        }
+
+        if (!settings.path.empty())
+        {
+            ZoneScopedN("Capture frame");
+            storage.GetObject<Window>().SaveFrame(fmt::format(fmt::runtime(settings.path), tick));
+        }
+
+        if (settings.frames > 0 && tick + 1 == settings.frames)
+        {
+            Event event;
+            event.applicationQuit = AppExitEvent {};
+            eventHandler.Send(event);
+        }
+    });
+}
\ No newline at end of file
@@ -1,16 +1,117 @@
 #include "camera_controller.hpp"
+#include "capture.hpp"
 #include "render.hpp"
 
+#include <cstdlib>
+#include <cstring>
+
 using namespace scsr;
 
+/// --headless             render offscreen without SDL video
+/// --frames <count>       exit after `count` frames
+/// --dump <path>          write every frame, `{}` in `path` becomes the frame number
+/// --budget <ms>          frame time budget for dynamic resolution, 0 disables it,
+///                        defaults to 60 fps with a window and off when headless
+/// --lights <count>       point lights around the mesh, 128 by default
+/// --no-post              write the shaded colors directly, no HDR post chain
+/// --points <path>        splat a point cloud file over the mesh, streamed every frame
+/// --particles <count>    a fountain of up to `count` particles above the mesh
+/// --raytrace             ray trace the mesh with shadows instead of rasterizing it
+/// --overlay <font.ttf>   frame time, pass times and counters drawn over every frame
+/// --serial               render on the main thread in place into the window surface,
+///                        no render thread, always on when headless
+/// --capture <path>       write the draws of a frame for `replay_bench` when C is pressed,
+///                        of the first frame when headless, `{}` becomes the capture number
 int runtime(int argc, char* argv[])
 {
     WindowProp prop { .title = "scsr", .width = 800, .height = 600 };
+    CaptureSettings capture;
+    f64 budget = -1.0;
+    usize lights = 128;
+    bool post = true;
+    std::string points;
+    usize particles = 0;
+    bool raytrace = false;
+    std::string overlay;
+    std::string frameCapture;
+    bool serial = false;
+
+    for (i32 i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            prop.headless = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            capture.frames = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+        {
+            capture.path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+        {
+            budget = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+        {
+            lights = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--no-post") == 0)
+        {
+            post = false;
+        }
+        else if (std::strcmp(argv[i], "--points") == 0 && i + 1 < argc)
+        {
+            points = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+        {
+            particles = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--raytrace") == 0)
+        {
+            raytrace = true;
+        }
+        else if (std::strcmp(argv[i], "--overlay") == 0 && i + 1 < argc)
+        {
+            overlay = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--serial") == 0)
+        {
+            serial = true;
+        }
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+        {
+            frameCapture = argv[++i];
+        }
+        else
+        {
+            LOG_WARN("Unknown argument {}", argv[i]);
+        }
+    }
+
+    /// Dumped frames should not depend on timing
+    RenderSettings render {
+        .budgetMs = budget >= 0.0 ? budget : (prop.headless ? 0.0 : 1000.0 / 60.0),
+        .lights = lights,
+        .post = post,
+        .points = points,
+        .particles = particles,
+        .raytrace = raytrace,
+        .overlay = overlay,
+        .frameCapture = frameCapture,
+        .serial = serial,
+    };
 
     World()
         .RegisterObject<Window>(prop)
+        .RegisterObject<CaptureSettings>(capture)
+        .RegisterObject<RenderSettings>(render)
         .AddPlugin(CameraControllerPlugin)
         .AddPlugin(RenderPlugin)
+        .AddPlugin(CapturePlugin)
         .Run();
 
     return 0;
@@ -5,46 +5,478 @@
 #include "core/math/vector.hpp"
 
 #include <Tracy.hpp>
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 using namespace scsr;
 
+static constexpr usize SwapchainImageCount = 3;
+static constexpr usize MaxFramesInFlight = 1;
+/// Longest sleep while nothing changes, bounds the latency of timed updates
+static constexpr u32 IdleWaitMs = 100;
+
+/// Camera snapshots taken on the main thread, one per swapchain image
+struct RenderFrames
+{
+    std::vector<Ref<Camera>> cameras;
+    /// Region each image redraws, the rest still holds a valid older frame
+    std::vector<Rect> regions;
+    usize current = 0;
+
+    DamageHistory damage;
+    /// Camera of the last rendered frame, any change damages the whole screen
+    Mat4 lastView;
+    Mat4 lastProjection;
+    /// Whether the last tick rendered a frame
+    bool rendered = false;
+    /// World space box the fountain particles stay in, see `ParticleReach`
+    Vec3 particleMin;
+    Vec3 particleMax;
+
+    /// Set on the main thread, the next frame written is captured
+    std::atomic<bool> captureRequested = false;
+    /// Frame captures written so far, numbers their files
+    usize captures = 0;
+};
+
+static bool SameMatrix(const Mat4& a, const Mat4& b)
+{
+    return std::memcmp(a.data, b.data, sizeof(a.data)) == 0;
+}
+
+/// Pixels covered by a world space box, everything when it reaches behind the camera
+static Rect ScreenBounds(const Vec3& min, const Vec3& max, const Mat4& viewProjection, i32 width, i32 height)
+{
+    const Rect screen { 0, 0, width, height };
+    f32 x0 = static_cast<f32>(width), y0 = static_cast<f32>(height), x1 = 0.0f, y1 = 0.0f;
+    for (i32 corner = 0; corner < 8; ++corner)
+    {
+        Vec4 p = viewProjection * Vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+        if (p.w <= 1e-4f) { return screen; }
+        /// Same viewport as `Pipeline`
+        f32 x = (p.x / p.w + 1.0f) * 0.5f * width;
+        f32 y = (1.0f - p.y / p.w) * 0.5f * height;
+        x0 = Min(x0, x); y0 = Min(y0, y);
+        x1 = Max(x1, x); y1 = Max(y1, y);
+    }
+    /// A pixel of slack for rounding, billboards cover at least one
+    Rect rect {
+        static_cast<i32>(std::floor(Max(x0, -1.0f))) - 1, static_cast<i32>(std::floor(Max(y0, -1.0f))) - 1,
+        static_cast<i32>(std::ceil(Min(x1, width + 1.0f))) + 1, static_cast<i32>(std::ceil(Min(y1, height + 1.0f))) + 1 };
+    return Intersect(rect, screen);
+}
+
+/// Set from the command line
+struct RenderSettings
+{
+    /// Frame time budget for dynamic resolution in milliseconds, 0 keeps the size fixed
+    f64 budgetMs = 0.0;
+    /// Point lights scattered around the mesh
+    usize lights = 128;
+    /// Shade into an HDR target and tone map it with bloom and FXAA
+    bool post = true;
+    /// Point cloud file drawn with the mesh, none when empty
+    std::string points;
+    /// Particles in the fountain above the mesh, 0 disables it
+    usize particles = 0;
+    /// Ray trace the static meshes with one shadowed light instead of rasterizing them
+    bool raytrace = false;
+    /// TrueType font of the performance overlay, no overlay when empty
+    std::string overlay;
+    /// Frame capture file, `{}` is replaced by the capture number, captures are off when empty
+    std::string frameCapture;
+    /// Render on the main thread straight into the window surface instead of
+    /// pipelining frames on a render thread, always on when headless
+    bool serial = false;
+};
+
+/// Pixel height of the overlay text
+static constexpr f32 OverlayFontSize = 14.0f;
+
+/// Simulation step of the particles per rendered frame, so dumps do not depend on timing
+static constexpr f32 ParticleStep = 1.0f / 60.0f;
+
+/// Glowing sparks rising from the top of the mesh
+static const ParticleEmitter Fountain {
+    .position = Vec3(0.0f, 0.6f, 0.0f),
+    .positionSpread = Vec3(0.05f, 0.02f, 0.05f),
+    .velocity = Vec3(0.0f, 1.2f, 0.0f),
+    .velocitySpread = Vec3(0.6f, 0.4f, 0.6f),
+    .lifetime = 1.5f,
+    .lifetimeSpread = 0.5f,
+    .color = 0xFF903020u,
+};
+
+/// Dim light from the camera so unlit parts stay visible
+static constexpr f32 FillLight = 0.2f;
+
+/// Colored lights in a shell around the unit sized mesh at the origin
+static void ScatterLights(LightList& lights, usize count)
+{
+    u32 seed = 12345u;
+    auto random = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24);
+    };
+    for (usize i = 0; i < count; ++i)
+    {
+        Vec3 direction = Normalized(Vec3(random() * 2.0f - 1.0f, random() * 2.0f - 1.0f, random() * 2.0f - 1.0f) + Vec3(1e-3f, 0.0f, 0.0f));
+        lights.Add(PointLight {
+            .position = direction * (1.0f + random() * 0.5f),
+            .radius = 0.6f + random() * 0.6f,
+            .color = Vec3(random(), random(), random()),
+            .intensity = 0.3f,
+        });
+    }
+}
+
 static Mesh mesh("assets/meshes/african_head.obj");
 static void RenderPlugin(World& world, Storage& storage)
 {
 
     ImageProp prop { .width = 800, .height = 600 };
-    
+
     world.RegisterObject<Pipeline>();
-    world.RegisterObject<Swapchain>(prop, 1);
+    world.RegisterObject<RenderFrames>();
+    world.RegisterObject<LightList>();
+    world.RegisterObject<RenderGraph>();
+    world.RegisterObject<PostChain>();
+    world.RegisterObject<StaticBatcher>();
+    world.RegisterObject<PointSplatter>();
+    world.RegisterObject<Bvh>();
+    world.RegisterObject<RayTracer>();
+    /// Headless runs render serially in place, so frame N is always what tick N wrote
+    bool headless = storage.GetObject<Window>().IsHeadless();
+    /// Only serial frames can be rendered in place, see `Swapchain::BindWindow`
+    bool serial = headless || storage.GetObject<RenderSettings>().serial;
+    world.RegisterObject<Swapchain>(prop, SwapchainImageCount, serial ? 0 : MaxFramesInFlight);
 
     auto& pipeline = storage.GetObject<Pipeline>();
     auto& swapchain = storage.GetObject<Swapchain>();
+    auto& frames = storage.GetObject<RenderFrames>();
+    auto& lights = storage.GetObject<LightList>();
+    auto& graph = storage.GetObject<RenderGraph>();
+    auto& post = storage.GetObject<PostChain>();
+    auto& statics = storage.GetObject<StaticBatcher>();
+    auto& splatter = storage.GetObject<PointSplatter>();
+    auto& bvh = storage.GetObject<Bvh>();
+    auto& tracer = storage.GetObject<RayTracer>();
+    const std::string& points = storage.GetObject<RenderSettings>().points;
+    if (!points.empty())
+    {
+        world.RegisterObject<PointCloudReader>(points);
+        if (!storage.GetObject<PointCloudReader>().IsOpen())
+        {
+            LOG_WARN("Point cloud {} could not be opened", points);
+            storage.RemoveObject<PointCloudReader>();
+        }
+    }
+    PointCloudReader* cloud = storage.HasObject<PointCloudReader>() ? &storage.GetObject<PointCloudReader>() : nullptr;
+    ParticleSystem* particles = nullptr;
+    if (usize count = storage.GetObject<RenderSettings>().particles; count > 0)
+    {
+        world.RegisterObject<ParticleSystem>(count);
+        particles = &storage.GetObject<ParticleSystem>();
+        particles->SetGravity(Vec3(0.0f, -2.5f, 0.0f));
+        ParticleReach(Fountain, particles->GetGravity(), ParticleStep, ParticleDrawProp {}.size, frames.particleMin, frames.particleMax);
+    }
+    PerfOverlay* overlay = nullptr;
+    if (const std::string& font = storage.GetObject<RenderSettings>().overlay; !font.empty())
+    {
+        auto glyphs = MakeRef<GlyphAtlas>();
+        if (!glyphs->Load(font, OverlayFontSize))
+        {
+            LOG_WARN("Font {} could not be loaded, the overlay shows the graph only", font);
+        }
+        world.RegisterObject<PerfOverlay>(glyphs);
+        overlay = &storage.GetObject<PerfOverlay>();
+    }
+    /// Headless runs capture their first frame, windows whenever C is pressed
+    Ref<FrameCapture> frameCapture;
+    std::string capturePath = storage.GetObject<RenderSettings>().frameCapture;
+    if (!capturePath.empty() && !FormatsNumber(capturePath))
+    {
+        LOG_WARN("Frame capture path {} is not a valid pattern, captures are off", capturePath);
+        capturePath.clear();
+    }
+    if (!capturePath.empty())
+    {
+        frameCapture = MakeRef<FrameCapture>();
+        pipeline.SetCapture(frameCapture);
+        frames.captureRequested = headless;
+        world.RegisterEvent<KeyboardPressedEvent>([](Event event, Storage& storage) {
+            if (event.keyboardPressed.keyCode != KeyboardKeyCode::KeyC) { return; }
+            auto& frames = storage.GetObject<RenderFrames>();
+            frames.captureRequested = true;
+            frames.damage.MarkAll();
+        });
+    }
+    /// The mesh never moves, it is drawn from the static batches
+    statics.Add(mesh, Mat4::IDENTITY());
+    /// Rays hit the same world space triangles the batches draw
+    statics.Update();
+    std::vector<const Mesh*> batches;
+    for (const StaticBatch& batch : statics.Batches())
+    {
+        batches.push_back(&batch.mesh);
+    }
+    bvh.Build(batches);
+    bool raytrace = storage.GetObject<RenderSettings>().raytrace;
+    bool postEnabled = storage.GetObject<RenderSettings>().post;
     auto& camera = storage.GetObject<CameraController>().cam;
-    pipeline.SetCamera(camera);
-    
-    // Set shaders
-    pipeline.SetVertexChanging([&](Vertex& vtx) -> Vec4 {
-        ZoneScopedN("Vertex changing");
-        Vec4 position = camera->GetProjection() * camera->GetView() * vtx.pos;
-        return position;
+    ScatterLights(lights, storage.GetObject<RenderSettings>().lights);
+    lights.SetFillLight(FillLight);
+    if (serial)
+    {
+        swapchain.BindWindow(storage.GetObject<Window>());
+    }
+
+    f64 budget = storage.GetObject<RenderSettings>().budgetMs;
+    if (budget > 0.0)
+    {
+        world.RegisterObject<DynamicResolution>(prop, DynamicResolutionProp { .targetMs = budget });
+        /// Upscaled frames look better filtered
+        storage.GetObject<Window>().SetPresentFilter(BlitFilter::Bilinear);
+        world.AddSystem([](Storage& storage) {
+            auto& resolution = storage.GetObject<DynamicResolution>();
+            auto& frames = storage.GetObject<RenderFrames>();
+            f64 frameTime = storage.GetObject<Ticker>().frameTime;
+            /// Idle ticks measure the wait, not the renderer
+            if (frames.rendered && frameTime > 0.0 && resolution.Update(frameTime))
+            {
+                ImageProp render = resolution.RenderProp();
+                storage.GetObject<Swapchain>().Resize(render);
+                frames.damage.MarkAll();
+                LOG_INFO("Render resolution {}x{}", render.width, render.height);
+            }
+        });
+    }
+    for (usize i = 0; i < SwapchainImageCount; ++i)
+    {
+        frames.cameras.push_back(MakeRef<Camera>(*camera));
+    }
+    frames.regions.resize(SwapchainImageCount);
+    frames.lastView = camera->GetView();
+    frames.lastProjection = camera->GetProjection();
+
+    /// The window lost its contents, show the last frame again or redraw it
+    world.RegisterEvent<WindowExposeEvent>([](Event, Storage& storage) {
+        auto& frames = storage.GetObject<RenderFrames>();
+        if (!storage.GetObject<Swapchain>().Represent(storage.GetObject<Window>()))
+        {
+            frames.damage.MarkAll();
+        }
+    });
+    world.RegisterEvent<WindowResizeEvent>([](Event, Storage& storage) {
+        storage.GetObject<RenderFrames>().damage.MarkAll();
     });
-    pipeline.SetFragmentShading([](Vertex&vtx) -> Vec4 {
-        f32 theta = Abs(Dot(vtx.normal, Vec3::Z()));
-        return Vec4(Vec3::ONE() * theta, 1.0f);
+    /// Report the static batch and triangle under the cursor
+    world.RegisterEvent<MouseButtonPressedEvent>([](Event event, Storage& storage) {
+        const auto& cam = storage.GetObject<CameraController>().cam;
+        const auto& bvh = storage.GetObject<Bvh>();
+        i32 x = event.mouseButtonPressed.cx;
+        i32 y = event.mouseButtonPressed.cy;
+        /// The frame is stretched over the window, which may have been resized
+        Vec2i size = storage.GetObject<Window>().GetSize();
+        Ray ray = ScreenRay(Inverse(cam->GetProjection() * cam->GetView()), x + 0.5f, y + 0.5f, size.x, size.y);
+        RayHit hit = bvh.Intersect(ray);
+        if (!hit.Valid())
+        {
+            LOG_INFO("Picked nothing at {} {}", x, y);
+            return;
+        }
+        const BvhPrimitive& primitive = bvh.Primitive(hit.triangle);
+        Vec3 point = ray.origin + ray.direction * hit.t;
+        LOG_INFO("Picked batch {} triangle {} at {:.3f} {:.3f} {:.3f}", primitive.mesh, primitive.triangle, point.x, point.y, point.z);
     });
 
-    swapchain.PushWriteCommand([&](Ref<Image> image) {
-        image->Clear();
+    // Set shaders, shading happens in view space where the lights are clustered
+    struct LitVaryings { Vec3 normal; Vec3 viewPos; };
+    pipeline.SetShader(Shader<LitVaryings> {
+        .vertex = [&](const Vertex& vtx, LitVaryings& out) -> Vec4 {
+            ZoneScopedN("Vertex changing");
+            auto& cam = frames.cameras[frames.current];
+            Vec4 viewPos = cam->GetView() * vtx.pos;
+            out.normal = (cam->GetView() * Vec4(vtx.normal, 0.0f)).xyz();
+            out.viewPos = viewPos.xyz();
+            return cam->GetProjection() * viewPos;
+        },
+        .pixel = [&](const LitVaryings& in) -> Vec4 {
+            return Vec4(lights.Shade(Normalized(in.normal), in.viewPos), 1.0f);
+        },
     });
-    swapchain.PushWriteCommand([&](Ref<Image> image) {
-        pipeline.Perform(image, mesh);
+
+    // Main thread, camera may be moved by input while older frames are written
+    swapchain.PushUpdateCommand([&, overlay](usize frame) {
+        *frames.cameras[frame] = *camera;
+        ImageProp prop = swapchain.GetImageProp();
+        /// The image's last frame is written by now, so its panel is within the bounds
+        if (overlay)
+        {
+            frames.damage.Mark(overlay->Bounds());
+        }
+        frames.regions[frame] = frames.damage.Accumulated(swapchain.ImageAge(frame), Rect { 0, 0, prop.width, prop.height });
     });
 
-    world.AddSystem([](Storage& storage) {
+    // Render thread, the frame is described anew as a graph every time
+    swapchain.PushWriteCommand([&, postEnabled, raytrace, cloud, particles, overlay, frameCapture, capturePath](Ref<Image> image, usize frame) {
+        auto start = std::chrono::steady_clock::now();
+        frames.current = frame;
+        pipeline.ResetStats();
+        pipeline.SetCamera(frames.cameras[frame]);
+        /// Only draws through the pipeline are captured, not rays, points or particles
+        const bool capturing = frameCapture && frames.captureRequested.exchange(false);
+        if (capturing)
+        {
+            frameCapture->Begin();
+        }
+
+        graph.Reset();
+        RenderResource backbuffer = graph.Import("backbuffer", image);
+        RenderResource color = backbuffer;
+        if (postEnabled)
+        {
+            color = graph.CreateTransient("hdr", ImageProp { .width = image->Width(), .height = image->Height(), .hdr = true });
+        }
+
+        graph.AddPass({ .name = "main", .writes = { color } }, [&, color, frame, raytrace](const RenderGraph& resources) {
+            Ref<Image> target = resources.Get(color);
+            lights.Build(*frames.cameras[frame], target->Width(), target->Height());
+            /// The replay shades with the same clusters, see `replay_bench`
+            if (capturing)
+            {
+                frameCapture->SetShader(LightList::ShaderId, lights.Serialize());
+            }
+
+            /// Transients keep nothing between frames and post effects spread
+            /// beyond the damage, redraw everything then
+            const Rect region = postEnabled ? target->Bounds() : frames.regions[frame];
+            PipelineState state = pipeline.GetState();
+            state.scissorTest = region != target->Bounds();
+            state.scissor = region;
+            pipeline.SetState(state);
+            if (state.scissorTest)
+            {
+                target->Clear(region);
+            }
+            else
+            {
+                target->Clear();
+            }
+            if (raytrace)
+            {
+                tracer.Render(bvh, *frames.cameras[frame], *target, region);
+                return;
+            }
+            statics.Update();
+            for (const StaticBatch& batch : statics.Batches())
+            {
+                pipeline.Perform(target, batch.mesh);
+            }
+        });
+        /// Streamed from the file every frame, the cloud may not fit in memory
+        if (cloud)
+        {
+            graph.AddPass({ .name = "points", .writes = { color } }, [&, color, frame, cloud](const RenderGraph& resources) {
+                Ref<Image> target = resources.Get(color);
+                const auto& cam = frames.cameras[frame];
+                splatter.Begin(*target);
+                cloud->Rewind();
+                splatter.SplatFile(*cloud, cam->GetProjection() * cam->GetView());
+                splatter.Resolve(*target);
+            });
+        }
+        /// Emitted as fast as they die on average, so the pool stays about full
+        if (particles)
+        {
+            graph.AddPass({ .name = "particles", .writes = { color } }, [&, color, frame, particles](const RenderGraph& resources) {
+                const auto& cam = frames.cameras[frame];
+                particles->Emit(Fountain, static_cast<usize>(particles->Capacity() * ParticleStep / Fountain.lifetime));
+                particles->Update(ParticleStep);
+                particles->Draw(*resources.Get(color), cam->GetView(), cam->GetProjection());
+            });
+        }
+        if (postEnabled)
+        {
+            graph.AddPass({ .name = "post", .reads = { color }, .writes = { backbuffer } }, [&, color, backbuffer](const RenderGraph& resources) {
+                post.Process(*resources.Get(color), *resources.Get(backbuffer));
+            });
+        }
+        graph.Execute();
+        if (capturing)
+        {
+            frameCapture->End();
+            std::string path = fmt::format(fmt::runtime(capturePath), frames.captures++);
+            if (frameCapture->Save(path))
+            {
+                LOG_INFO("Captured {} draws to {}", frameCapture->Draws().size(), path);
+            }
+            else
+            {
+                LOG_WARN("Frame capture {} could not be written", path);
+            }
+        }
+
+        /// Drawn over the finished frame, it shows this frame's numbers
+        if (overlay)
+        {
+            for (u32 pass : graph.Order())
+            {
+                overlay->SetTime(graph.PassName(pass), graph.PassTime(pass));
+            }
+            const PipelineStats& stats = pipeline.GetStats();
+            overlay->SetCounter("draws", stats.drawCalls);
+            overlay->SetCounter("triangles", stats.triangles);
+            overlay->SetCounter("pixels", stats.pixelsCovered);
+            overlay->AddFrame(std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+            overlay->Draw(*image);
+        }
+    });
+
+    world.AddSystem([](Storage& storage, EventHandler& events) {
         auto& swapchain = storage.GetObject<Swapchain>();
         auto& window = storage.GetObject<Window>();
+        auto& frames = storage.GetObject<RenderFrames>();
+        auto& camera = storage.GetObject<CameraController>().cam;
+
+        if (!SameMatrix(camera->GetView(), frames.lastView) || !SameMatrix(camera->GetProjection(), frames.lastProjection))
+        {
+            frames.damage.MarkAll();
+            frames.lastView = camera->GetView();
+            frames.lastProjection = camera->GetProjection();
+        }
+        /// Particles move every frame, but only within the reach of the fountain
+        if (storage.HasObject<ParticleSystem>())
+        {
+            ImageProp prop = swapchain.GetImageProp();
+            frames.damage.Mark(ScreenBounds(frames.particleMin, frames.particleMax,
+                camera->GetProjection() * camera->GetView(), prop.width, prop.height));
+        }
+        /// The overlay panel changes every frame, frames in flight may still
+        /// grow it, the update command marks it again once an image is free
+        if (storage.HasObject<PerfOverlay>())
+        {
+            frames.damage.Mark(storage.GetObject<PerfOverlay>().Bounds());
+        }
 
-        swapchain.AcquireAndWrite();
+        frames.rendered = !frames.damage.IsClean();
+        if (frames.rendered)
+        {
+            swapchain.AcquireAndWrite();
+            frames.damage.EndFrame();
+        }
+        /// Still picks up frames finished since the last tick
         swapchain.Present(window);
+
+        /// Nothing to do until input arrives, sleep instead of spinning
+        if (!frames.rendered && !window.IsHeadless() && swapchain.IsIdle())
+        {
+            ZoneScopedN("Idle");
+            events.Wait(IdleWaitMs);
+        }
     });
 }
\ No newline at end of file
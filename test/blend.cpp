@@ -0,0 +1,92 @@
+#include "graphics/blend.hpp"
+#include "core/log.hpp"
+#include "test_util.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace scsr;
+
+/// Blend `src` over `dst` in 11 pixels, covering the SIMD path and a tail
+static bool Check(const char* name, BlendMode mode, PixelFormat format, u32 src, u32 dst, u32 expected)
+{
+    std::vector<u32> s(11, src);
+    std::vector<u32> d(11, dst);
+    BlendPixels(s.data(), d.data(), d.size(), mode, format);
+    for (usize i = 0; i < d.size(); ++i)
+    {
+        if (d[i] != expected)
+        {
+            PRINT("{} pixel {}: {:08x} != {:08x}", name, i, d[i], expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+struct ColorVaryings
+{
+    Vec3 color;
+};
+
+/// Half transparent red near and blue far over opaque black, both in one call
+/// and submitted near first, alpha blended without writing depth
+static bool CheckSortedDraw()
+{
+    const i32 size = 16;
+    Mesh mesh;
+    test::PushQuad(mesh, Vec2(-0.8f, -0.8f), Vec2(0.4f, 0.4f), 0.2f, Vec3(1.0f, 0.0f, 0.0f));
+    test::PushQuad(mesh, Vec2(-0.4f, -0.4f), Vec2(0.8f, 0.8f), 0.6f, Vec3(0.0f, 0.0f, 1.0f));
+    PipelineState state = test::TestState();
+    state.blend = BlendMode::Alpha;
+    state.depthWrite = false;
+    auto image = MakeRef<Image>(ImageProp { .width = size, .height = size });
+    image->Clear();
+    std::fill(image->Data(), image->Data() + size * size, 0x000000FFu);
+    std::vector<f32> cleared(image->DepthData(), image->DepthData() + size * size);
+
+    Pipeline pipeline;
+    test::SetupPipeline(pipeline, state);
+    pipeline.SetShader(Shader<ColorVaryings> {
+        .vertex = [](const Vertex& vtx, ColorVaryings& out) { out.color = vtx.normal; return vtx.pos; },
+        .pixel = [](const ColorVaryings& in) { return Vec4(in.color, 0.5f); },
+    });
+    pipeline.Perform(image, mesh);
+
+    /// Far then near: blue to 0x80, red over it to 0x80 with blue halved
+    PixelLayout layout = GetPixelLayout(image->Format());
+    u32 center = image->Data()[size / 2 * size + size / 2];
+    i32 red = static_cast<i32>((center >> layout.r) & 0xFF);
+    i32 blue = static_cast<i32>((center >> layout.b) & 0xFF);
+    if (Abs(red - 0x80) > 1 || Abs(blue - 0x40) > 1)
+    {
+        PRINT("overlap blended to red {:x} blue {:x}, not far then near", red, blue);
+        return false;
+    }
+    if (std::memcmp(cleared.data(), image->DepthData(), sizeof(f32) * size * size) != 0)
+    {
+        PRINT("depth written with depth writes off");
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    // Half transparent red over opaque blue
+    const u32 red = 0xFF000080;
+    const u32 blue = 0x0000FFFF;
+
+    bool ok = true;
+    ok &= Check("opaque", BlendMode::Opaque, PixelFormat::RGBA8888, red, blue, red);
+    ok &= Check("alpha", BlendMode::Alpha, PixelFormat::RGBA8888, red, blue, 0x80007FFF);
+    ok &= Check("alpha argb", BlendMode::Alpha, PixelFormat::ARGB8888, 0x80FF0000, 0xFF0000FF, 0xFF80007F);
+    ok &= Check("premultiplied", BlendMode::Premultiplied, PixelFormat::RGBA8888, 0x80000080, blue, 0x80007FFF);
+    ok &= Check("additive", BlendMode::Additive, PixelFormat::RGBA8888, red, blue, 0x8000FFFF);
+    ok &= Check("multiply", BlendMode::Multiply, PixelFormat::RGBA8888, red, blue, 0x00000080);
+    ok &= CheckSortedDraw();
+    if (!ok) { return 1; }
+
+    PRINT("blend ok");
+    return 0;
+}
\ No newline at end of file
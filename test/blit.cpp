@@ -0,0 +1,101 @@
+#include "graphics/blit.hpp"
+#include "core/log.hpp"
+
+#include <vector>
+
+using namespace scsr;
+
+int main()
+{
+    u32 red = PackColor(Color(1.0f, 0.0f, 0.0f, 1.0f), PixelFormat::RGBA8888);
+    u32 blue = PackColor(Color(0.0f, 0.0f, 1.0f, 1.0f), PixelFormat::RGBA8888);
+
+    {
+        // Channel reorder, wide enough for the SIMD path plus a tail
+        std::vector<u32> src(19, red);
+        std::vector<u32> dst(19, 0);
+        ConvertPixels(
+            PixelView { src.data(), 19, 1, 19, PixelFormat::RGBA8888 },
+            PixelView { dst.data(), 19, 1, 19, PixelFormat::ARGB8888 }
+        );
+        for (u32 pixel : dst)
+        {
+            if (pixel != 0xFFFF0000) { PRINT("convert: {:08x}", pixel); return 1; }
+        }
+    }
+    {
+        // 2x1 -> 4x1 nearest keeps hard edges
+        u32 src[2] = { red, blue };
+        u32 dst[4] = {};
+        ScalePixels(
+            PixelView { src, 2, 1, 2, PixelFormat::RGBA8888 },
+            PixelView { dst, 4, 1, 4, PixelFormat::RGBA8888 },
+            BlitFilter::Nearest
+        );
+        if (dst[0] != red || dst[1] != red || dst[2] != blue || dst[3] != blue)
+        {
+            PRINT("nearest: {:08x} {:08x} {:08x} {:08x}", dst[0], dst[1], dst[2], dst[3]);
+            return 1;
+        }
+    }
+    {
+        // 2x1 -> 16x1 bilinear blends between the two texel centers
+        u32 src[2] = { red, blue };
+        std::vector<u32> dst(16, 0);
+        ScalePixels(
+            PixelView { src, 2, 1, 2, PixelFormat::RGBA8888 },
+            PixelView { dst.data(), 16, 1, 16, PixelFormat::RGBA8888 },
+            BlitFilter::Bilinear
+        );
+        if (dst.front() != red || dst.back() != blue)
+        {
+            PRINT("bilinear ends: {:08x} {:08x}", dst.front(), dst.back());
+            return 1;
+        }
+        for (usize i = 1; i < dst.size(); ++i)
+        {
+            // Red never increases, blue never decreases along the row
+            if ((dst[i] >> 24) > (dst[i - 1] >> 24) || ((dst[i] >> 8) & 0xFF) < ((dst[i - 1] >> 8) & 0xFF))
+            {
+                PRINT("bilinear not monotonic at {}", i);
+                return 1;
+            }
+        }
+    }
+
+    {
+        // Batched packing matches the scalar path, 21 colors cover the SIMD path and a tail
+        std::vector<Color> colors;
+        for (i32 i = 0; i < 21; ++i)
+        {
+            f32 t = static_cast<f32>(i) / 20.0f;
+            colors.push_back(Color(t, 1.0f - t, t * 1.7f - 0.3f, 0.5f + t));
+        }
+        std::vector<u32> packed(colors.size());
+        for (PixelFormat format : { PixelFormat::RGBA8888, PixelFormat::ARGB8888, PixelFormat::ABGR8888, PixelFormat::BGRA8888 })
+        {
+            PackColors(colors.data(), packed.data(), colors.size(), format);
+            for (usize i = 0; i < colors.size(); ++i)
+            {
+                if (packed[i] != PackColor(colors[i], format))
+                {
+                    PRINT("pack {}: {:08x} != {:08x}", i, packed[i], PackColor(colors[i], format));
+                    return 1;
+                }
+            }
+        }
+    }
+    {
+        // sRGB encodes color channels only
+        std::vector<Color> colors(9, Color(0.5f, 0.0f, 1.0f, 0.5f));
+        std::vector<u32> packed(colors.size());
+        PackColors(colors.data(), packed.data(), colors.size(), PixelFormat::RGBA8888, true);
+        for (u32 pixel : packed)
+        {
+            if (pixel != 0xBC00FF80) { PRINT("srgb: {:08x}", pixel); return 1; }
+        }
+    }
+
+    PRINT("blit ok");
+    return 0;
+}
\ No newline at end of file
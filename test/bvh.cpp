@@ -0,0 +1,281 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <chrono>
+#include <cmath>
+
+using namespace scsr;
+
+static u32 s_Seed = 12345u;
+
+static f32 Random(f32 min, f32 max)
+{
+    s_Seed = s_Seed * 1664525u + 1013904223u;
+    return min + (max - min) * static_cast<f32>(s_Seed >> 8) / static_cast<f32>(1u << 24);
+}
+
+static Vec3 RandomPoint(f32 extent)
+{
+    return Vec3(Random(-extent, extent), Random(-extent, extent), Random(-extent, extent));
+}
+
+/// Small triangles scattered through a cube of half size `extent`
+static Mesh Soup(usize count, f32 extent, f32 size)
+{
+    Mesh mesh;
+    for (usize i = 0; i < count; ++i)
+    {
+        Vec3 center = RandomPoint(extent);
+        for (i32 k = 0; k < 3; ++k)
+        {
+            Vertex vtx {};
+            vtx.pos = Vec4(center + RandomPoint(size), 1.0f);
+            mesh.vertices.push_back(vtx);
+        }
+    }
+    return mesh;
+}
+
+/// Closest hit over every triangle, distance only
+static f32 BruteForce(const std::vector<const Mesh*>& meshes, const Ray& ray)
+{
+    f32 best = F32INF;
+    for (const Mesh* mesh : meshes)
+    {
+        if (mesh->topology != Topology::Triangles && mesh->topology != Topology::TriangleStrip) { continue; }
+        for (usize t = 0; t < PrimitiveCount(mesh->topology, mesh->vertices.size()); ++t)
+        {
+            usize index[3];
+            TriangleIndices(mesh->topology, t, index);
+            Vec3 v0 = mesh->vertices[index[0]].pos.xyz();
+            Vec3 e1 = mesh->vertices[index[1]].pos.xyz() - v0;
+            Vec3 e2 = mesh->vertices[index[2]].pos.xyz() - v0;
+            Vec3 p = Cross(ray.direction, e2);
+            f32 det = Dot(e1, p);
+            if (det == 0.0f) { continue; }
+            Vec3 s = ray.origin - v0;
+            f32 u = Dot(s, p) / det;
+            Vec3 q = Cross(s, e1);
+            f32 v = Dot(ray.direction, q) / det;
+            f32 d = Dot(e2, q) / det;
+            /// The same slack on the edges as the hierarchy
+            const f32 e = 1e-5f;
+            if (u >= -e && v >= -e && u + v <= 1.0f + e && d > 0.0f && d < best) { best = d; }
+        }
+    }
+    return best;
+}
+
+int main()
+{
+    /// A soup, a floor strip and points that are skipped
+    Mesh soup = Soup(2000, 1.0f, 0.15f);
+    Mesh floor;
+    floor.topology = Topology::TriangleStrip;
+    for (Vec2 c : { Vec2(-4.0f, -4.0f), Vec2(-4.0f, 4.0f), Vec2(4.0f, -4.0f), Vec2(4.0f, 4.0f) })
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(c.x, -1.5f, c.y, 1.0f);
+        vtx.normal = Vec3(0.0f, 1.0f, 0.0f);
+        floor.vertices.push_back(vtx);
+    }
+    Mesh points = Soup(10, 1.0f, 0.1f);
+    points.topology = Topology::Points;
+    std::vector<const Mesh*> meshes = { &soup, &floor, &points };
+
+    Bvh bvh;
+    bvh.Build(meshes);
+    if (bvh.TriangleCount() != 2002)
+    {
+        PRINT("bvh holds {} triangles", bvh.TriangleCount());
+        return 1;
+    }
+    for (const BvhNode& node : bvh.Nodes())
+    {
+        if (node.IsLeaf() && node.count > Bvh::MaxLeafSize * 4)
+        {
+            PRINT("leaf with {} triangles", node.count);
+            return 1;
+        }
+    }
+
+    /// Closest hits match testing every triangle
+    std::vector<Ray> rays;
+    for (i32 i = 0; i < 2000; ++i)
+    {
+        Vec3 origin = RandomPoint(3.0f);
+        rays.push_back({ origin, RandomPoint(1.0f) - origin, i % 4 == 0 ? 0.5f : F32INF });
+    }
+    i32 hits = 0;
+    for (const Ray& ray : rays)
+    {
+        RayHit hit = bvh.Intersect(ray);
+        f32 expected = BruteForce(meshes, ray);
+        if (expected >= ray.tMax) { expected = F32INF; }
+        if (hit.t != expected && Abs(hit.t - expected) > 1e-5f * expected)
+        {
+            PRINT("bvh hit at {} instead of {}", hit.t, expected);
+            return 1;
+        }
+        if (hit.Valid() != (expected != F32INF) || bvh.Occluded(ray) != hit.Valid())
+        {
+            PRINT("hit and occlusion disagree");
+            return 1;
+        }
+        if (hit.Valid())
+        {
+            const BvhPrimitive& primitive = bvh.Primitive(hit.triangle);
+            if (meshes[primitive.mesh] == &points || primitive.triangle >= PrimitiveCount(meshes[primitive.mesh]->topology, meshes[primitive.mesh]->vertices.size()))
+            {
+                PRINT("hit maps to mesh {} triangle {}", primitive.mesh, primitive.triangle);
+                return 1;
+            }
+            ++hits;
+        }
+    }
+    if (hits < 200)
+    {
+        PRINT("only {} of the rays hit", hits);
+        return 1;
+    }
+
+    /// Packets give what single rays give, lanes outside the mask miss
+    for (usize first = 0; first + RayPacket::Size <= rays.size(); first += RayPacket::Size)
+    {
+        RayPacket packet;
+        for (usize lane = 0; lane < RayPacket::Size; ++lane)
+        {
+            packet.Set(lane, rays[first + lane]);
+        }
+        const u32 mask = first % 16 ? 0xFFu : 0x6Du;
+        PacketHit hit;
+        bvh.Intersect(packet, mask, hit);
+        u32 occluded = bvh.Occluded(packet, mask);
+        for (usize lane = 0; lane < RayPacket::Size; ++lane)
+        {
+            RayHit single = (mask >> lane) & 1 ? bvh.Intersect(rays[first + lane]) : RayHit {};
+            if (hit.triangle[lane] != single.triangle || (single.Valid() && Abs(hit.t[lane] - single.t) > 1e-5f * single.t))
+            {
+                PRINT("packet lane {} hit {} at {}, single ray {} at {}", lane, hit.triangle[lane], hit.t[lane], single.triangle, single.t);
+                return 1;
+            }
+            if (((occluded >> lane) & 1) != single.Valid())
+            {
+                PRINT("packet lane {} occlusion differs", lane);
+                return 1;
+            }
+        }
+    }
+
+    /// The soup above the floor, seen by the camera of the runtime
+    Camera camera(Radians(30.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+    camera.SetPosition(Vec3(0.0f, 0.0f, 8.0f));
+    Image target(ImageProp { .width = 160, .height = 120 });
+    RayTracer tracer;
+    target.Clear();
+    usize covered = tracer.Render(bvh, camera, target, target.Bounds());
+    const u32 background = PackColor(tracer.Prop().background, target.Format());
+    std::vector<u32> first(target.Data(), target.Data() + 160 * 120);
+    usize drawn = 0;
+    for (i32 i = 0; i < 160 * 120; ++i)
+    {
+        drawn += first[i] != background;
+        f32 depth = target.DepthData()[i];
+        if (depth < 0.0f || depth > 1.0f || (first[i] == background) != (depth == 1.0f))
+        {
+            PRINT("pixel {} has depth {}", i, depth);
+            return 1;
+        }
+    }
+    if (covered < 1000 || drawn != covered)
+    {
+        PRINT("{} rays hit, {} pixels drawn", covered, drawn);
+        return 1;
+    }
+    /// The centre looks straight at the soup, the floor is below it
+    Ray centre = ScreenRay(Inverse(camera.GetProjection() * camera.GetView()), 80.0f, 60.0f, 160, 120);
+    if (Abs(centre.direction.x) > 1e-3f || Abs(centre.direction.y) > 1e-3f || centre.direction.z >= 0.0f)
+    {
+        PRINT("centre ray points at {} {} {}", centre.direction.x, centre.direction.y, centre.direction.z);
+        return 1;
+    }
+
+    /// Shadows only darken, the same frame renders the same pixels
+    tracer.Prop().shadows = false;
+    tracer.Render(bvh, camera, target, target.Bounds());
+    usize brighter = 0;
+    for (i32 i = 0; i < 160 * 120; ++i)
+    {
+        u32 lit = target.Data()[i];
+        if ((lit >> 24) < (first[i] >> 24))
+        {
+            PRINT("pixel {} darker without shadows", i);
+            return 1;
+        }
+        brighter += (lit >> 24) > (first[i] >> 24);
+    }
+    tracer.Prop().shadows = true;
+    tracer.Render(bvh, camera, target, target.Bounds());
+    if (brighter == 0 || !std::equal(first.begin(), first.end(), target.Data()))
+    {
+        PRINT("shadows changed {} pixels or the frame is not stable", brighter);
+        return 1;
+    }
+
+    /// Triangles at geometrically growing distances, SAH peels a few off per
+    /// level until the median splits below `SahMaxDepth` take over
+    Mesh chain;
+    const i32 links = 120;
+    for (i32 i = -links; i <= links; ++i)
+    {
+        f32 x = std::pow(1.5f, static_cast<f32>(i));
+        for (Vec3 p : { Vec3(x * 0.9f, -0.5f, 0.0f), Vec3(x * 1.1f, -0.5f, 0.0f), Vec3(x, 0.5f, 0.0f) })
+        {
+            Vertex vtx {};
+            vtx.pos = Vec4(p, 1.0f);
+            chain.vertices.push_back(vtx);
+        }
+    }
+    Bvh deep;
+    deep.Build(std::vector<const Mesh*> { &chain });
+    u32 maxDepth = 0;
+    std::vector<std::pair<u32, u32>> pending = { { 0, 0 } };
+    while (!pending.empty())
+    {
+        auto [index, depth] = pending.back();
+        pending.pop_back();
+        maxDepth = Max(maxDepth, depth);
+        const BvhNode& node = deep.Nodes()[index];
+        if (node.IsLeaf()) { continue; }
+        pending.push_back({ node.index, depth + 1 });
+        pending.push_back({ node.index + 1, depth + 1 });
+    }
+    if (maxDepth > Bvh::SahMaxDepth + 31)
+    {
+        PRINT("chain built {} levels deep", maxDepth);
+        return 1;
+    }
+    for (i32 i = -links; i <= links; ++i)
+    {
+        Ray ray { Vec3(std::pow(1.5f, static_cast<f32>(i)), 0.0f, 1.0f), Vec3(0.0f, 0.0f, -1.0f) };
+        RayHit hit = deep.Intersect(ray);
+        if (!hit.Valid() || deep.Primitive(hit.triangle).triangle != static_cast<u32>(i + links))
+        {
+            PRINT("chain triangle {} missed", i);
+            return 1;
+        }
+    }
+
+    /// A larger scene for timing
+    Mesh large = Soup(200000, 2.0f, 0.05f);
+    std::vector<const Mesh*> scene = { &large, &floor };
+    auto start = std::chrono::steady_clock::now();
+    bvh.Build(scene);
+    f64 buildMs = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Image frame(ImageProp { .width = 320, .height = 240 });
+    start = std::chrono::steady_clock::now();
+    tracer.Render(bvh, camera, frame, frame.Bounds());
+    f64 traceMs = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    PRINT("bvh ok: {} triangles in {} nodes built in {:.1f} ms, 320x240 traced in {:.1f} ms", bvh.TriangleCount(), bvh.Nodes().size(), buildMs, traceMs);
+    return 0;
+}
\ No newline at end of file
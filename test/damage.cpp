@@ -0,0 +1,108 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+#include <cstring>
+
+using namespace scsr;
+
+struct ColorVaryings
+{
+    Vec3 color;
+};
+
+static const i32 Size = 64;
+
+/// A flat background with a small box in front at `offset`
+static Mesh MakeScene(f32 offset)
+{
+    Mesh mesh;
+    test::PushQuad(mesh, Vec2(-test::FullScreen, -test::FullScreen), Vec2(test::FullScreen, test::FullScreen), 0.5f, Vec3(0.2f, 0.4f, 0.6f));
+    test::PushQuad(mesh, Vec2(offset, -0.1f), Vec2(offset + 0.2f, 0.1f), 0.0f, Vec3(1.0f, 0.5f, 0.0f));
+    return mesh;
+}
+
+/// Screen rectangle the box at `offset` may touch, a pixel of slack on each side
+static Rect BoxRect(f32 offset)
+{
+    auto toPixel = [](f32 ndc) { return static_cast<i32>((ndc * 0.5f + 0.5f) * Size); };
+    return Rect { toPixel(offset) - 1, toPixel(-0.1f) - 1, toPixel(offset + 0.2f) + 2, toPixel(0.1f) + 2 };
+}
+
+static void Draw(Pipeline& pipeline, Ref<Image> image, Mesh mesh, const Rect* region)
+{
+    PipelineState state = pipeline.GetState();
+    state.scissorTest = region != nullptr;
+    if (region)
+    {
+        state.scissor = *region;
+        image->Clear(*region);
+    }
+    else
+    {
+        image->Clear();
+    }
+    pipeline.SetState(state);
+    pipeline.Perform(image, mesh);
+}
+
+int main()
+{
+    /// Only what changed since an image was written is returned
+    DamageHistory history;
+    const Rect bounds { 0, 0, Size, Size };
+    history.EndFrame();
+    history.Mark(Rect { 4, 4, 8, 8 });
+    history.EndFrame();
+    history.Mark(Rect { 20, 10, 24, 12 });
+    if (history.IsClean() || history.Accumulated(1, bounds) != Rect { 20, 10, 24, 12 })
+    {
+        PRINT("age 1 damage wrong");
+        return 1;
+    }
+    if (history.Accumulated(2, bounds) != Rect { 4, 4, 24, 12 })
+    {
+        PRINT("age 2 damage wrong");
+        return 1;
+    }
+    /// The first frame drew everything
+    if (history.Accumulated(3, bounds) != bounds || history.Accumulated(0, bounds) != bounds)
+    {
+        PRINT("unknown content must be redrawn whole");
+        return 1;
+    }
+    history.EndFrame();
+    if (!history.IsClean())
+    {
+        PRINT("new frame should start clean");
+        return 1;
+    }
+
+    Pipeline pipeline;
+    test::SetupPipeline(pipeline);
+    pipeline.SetShader(Shader<ColorVaryings> {
+        .vertex = [](const Vertex& vtx, ColorVaryings& out) { out.color = vtx.normal; return vtx.pos; },
+        .pixel = [](const ColorVaryings& in) { return Vec4(in.color, 1.0f); },
+    });
+
+    /// Move the box and redraw only where it was and where it is now
+    auto partial = MakeRef<Image>(ImageProp { .width = Size, .height = Size });
+    auto full = MakeRef<Image>(ImageProp { .width = Size, .height = Size });
+    Draw(pipeline, partial, MakeScene(-0.5f), nullptr);
+    Rect damaged = Union(BoxRect(-0.5f), BoxRect(0.1f));
+    Draw(pipeline, partial, MakeScene(0.1f), &damaged);
+    Draw(pipeline, full, MakeScene(0.1f), nullptr);
+
+    if (std::memcmp(partial->Data(), full->Data(), sizeof(u32) * Size * Size) != 0)
+    {
+        PRINT("partial redraw differs from a full redraw");
+        return 1;
+    }
+    if (std::memcmp(partial->DepthData(), full->DepthData(), sizeof(f32) * Size * Size) != 0)
+    {
+        PRINT("partial redraw left different depths");
+        return 1;
+    }
+
+    PRINT("damage ok: redrew {}x{} of {}x{}", damaged.Width(), damaged.Height(), Size, Size);
+    return 0;
+}
\ No newline at end of file
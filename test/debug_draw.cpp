@@ -0,0 +1,52 @@
+#include "graphics/debug_draw.hpp"
+#include "core/log.hpp"
+
+using namespace scsr;
+
+int main()
+{
+    const i32 size = 64;
+    Image image(ImageProp { .width = size, .height = size });
+    image.Clear();
+    const u32 white = PackColor(Color(1.0f, 1.0f, 1.0f, 1.0f), image.Format());
+
+    /// Identity view projection, world space is clip space with w = 1
+    Mat4 identity = Mat4::IDENTITY();
+    DebugDraw debug;
+
+    // Horizontal line across the middle row, clipped at both sides
+    debug.Line(Vec3(-2.0f, 0.01f, 0.0f), Vec3(2.0f, 0.01f, 0.0f), Color(1.0f, 1.0f, 1.0f, 1.0f));
+    // Fully outside the view volume
+    debug.Line(Vec3(-2.0f, 3.0f, 0.0f), Vec3(2.0f, 3.0f, 0.0f), Color(1.0f, 1.0f, 1.0f, 1.0f));
+    debug.Flush(image, identity);
+
+    i32 row = size / 2 - 1;
+    for (i32 x = 0; x < size; ++x)
+    {
+        if (image.Data()[row * size + x] != white) { PRINT("line missing at {}", x); return 1; }
+    }
+    if (debug.LineCount() != 0) { PRINT("lines kept after flush"); return 1; }
+
+    // Vertical line behind existing depth is hidden
+    for (i32 y = 0; y < size; ++y) { image.SetDepth(Vec2i(10, y), -0.5f); }
+    debug.Line(Vec3(-0.67f, -1.0f, 0.0f), Vec3(-0.67f, 1.0f, 0.0f), Color(1.0f, 0.0f, 0.0f, 1.0f));
+    debug.Flush(image, identity);
+    for (i32 y = 0; y < size; ++y)
+    {
+        if (y != row && image.Data()[y * size + 10] != 0) { PRINT("hidden line drawn at {}", y); return 1; }
+    }
+
+    // HDR targets get the linear color, unclamped
+    Image hdr(ImageProp { .width = size, .height = size, .hdr = true });
+    hdr.Clear();
+    debug.Line(Vec3(-2.0f, 0.01f, 0.0f), Vec3(2.0f, 0.01f, 0.0f), Color(4.0f, 0.5f, 0.0f, 1.0f));
+    debug.Flush(hdr, identity);
+    for (i32 x = 0; x < size; ++x)
+    {
+        const Color& c = hdr.HdrData()[row * size + x];
+        if (c.x != 4.0f || c.y != 0.5f || c.z != 0.0f) { PRINT("HDR line missing at {}", x); return 1; }
+    }
+
+    PRINT("debug draw ok");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <cmath>
+
+using namespace scsr;
+
+static bool Near(f32 a, f32 b)
+{
+    return std::abs(a - b) < 1e-4f;
+}
+
+int main()
+{
+    /// No smoothing, so every update sees the frame time it is fed
+    const ImageProp output { .width = 800, .height = 600 };
+    DynamicResolution resolution(output, DynamicResolutionProp {
+        .targetMs = 10.0, .minScale = 0.5f, .maxScale = 1.0f, .smoothing = 1.0, .cooldown = 2 });
+    if (resolution.RenderProp().width != 800 || resolution.RenderProp().height != 600)
+    {
+        PRINT("does not start at the output size");
+        return 1;
+    }
+
+    /// Four times over budget would want half the size, one step shrinks by a quarter at most
+    if (!resolution.Update(40.0) || !Near(resolution.Scale(), 0.75f)
+        || resolution.RenderProp().width != 600 || resolution.RenderProp().height != 448)
+    {
+        PRINT("first step down to {} {}x{}", resolution.Scale(), resolution.RenderProp().width, resolution.RenderProp().height);
+        return 1;
+    }
+    /// Nothing changes while cooling down
+    if (resolution.Update(40.0) || resolution.Update(40.0) || resolution.RenderProp().width != 600)
+    {
+        PRINT("changed during the cooldown");
+        return 1;
+    }
+
+    /// Further over budget frames stop at the lower bound
+    for (i32 i = 0; i < 20; ++i)
+    {
+        f32 before = resolution.Scale();
+        resolution.Update(40.0);
+        if (resolution.Scale() < before * 0.75f - 1e-4f || resolution.Scale() < 0.5f)
+        {
+            PRINT("stepped down from {} to {}", before, resolution.Scale());
+            return 1;
+        }
+    }
+    ImageProp smallest = resolution.RenderProp();
+    if (!Near(resolution.Scale(), 0.5f) || smallest.width != 400 || smallest.height != 296)
+    {
+        PRINT("lower bound {} {}x{}", resolution.Scale(), smallest.width, smallest.height);
+        return 1;
+    }
+
+    /// Frames near the budget keep the size
+    for (i32 i = 0; i < 20; ++i)
+    {
+        if (resolution.Update(9.5))
+        {
+            PRINT("changed near the budget");
+            return 1;
+        }
+    }
+
+    /// Fast frames grow it back by at most 5% a step, up to the exact output size
+    usize steps = 0;
+    for (i32 i = 0; i < 200; ++i)
+    {
+        f32 before = resolution.Scale();
+        ImageProp previous = resolution.RenderProp();
+        if (!resolution.Update(2.0)) { continue; }
+        ++steps;
+        ImageProp render = resolution.RenderProp();
+        if (resolution.Scale() > before * 1.05f + 1e-4f || render.width < previous.width || render.height < previous.height
+            || render.width % 8 != 0 || render.height % 8 != 0)
+        {
+            PRINT("stepped up from {} {}x{} to {} {}x{}", before, previous.width, previous.height,
+                resolution.Scale(), render.width, render.height);
+            return 1;
+        }
+    }
+    if (steps < 5 || resolution.RenderProp().width != output.width || resolution.RenderProp().height != output.height
+        || !Near(resolution.Scale(), 1.0f))
+    {
+        PRINT("grew to {} {}x{} in {} steps", resolution.Scale(), resolution.RenderProp().width, resolution.RenderProp().height, steps);
+        return 1;
+    }
+
+    PRINT("dynamic resolution ok: {} steps up", steps);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace scsr;
+
+static const i32 Size = 64;
+/// Shades with the color in its uniforms
+static const u32 TintShader = 7;
+
+struct NormalVaryings
+{
+    Vec3 normal;
+};
+
+/// Axis aligned square facing +z
+static Mesh MakeQuad(f32 x0, f32 y0, f32 x1, f32 y1, f32 z)
+{
+    Mesh mesh;
+    const Vec2 corners[6] = { Vec2(x0, y0), Vec2(x1, y0), Vec2(x1, y1), Vec2(x0, y0), Vec2(x1, y1), Vec2(x0, y1) };
+    for (const Vec2& c : corners)
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(c.x, c.y, z, 1.0f);
+        vtx.normal = Vec3::Z();
+        mesh.vertices.push_back(vtx);
+    }
+    return mesh;
+}
+
+static u32 Count(const std::vector<u32>& counts, i32 x, i32 y)
+{
+    return counts[static_cast<usize>(y) * Size + x];
+}
+
+int main()
+{
+    auto image = MakeRef<Image>(ImageProp { .width = Size, .height = Size });
+    auto camera = MakeRef<Camera>(Radians(45.0f), 1.0f, 0.1f, 100.0f);
+    camera->SetPosition(Vec3(0.0f, 0.0f, 3.0f));
+
+    Pipeline pipeline;
+    pipeline.SetCamera(camera);
+    PipelineState state;
+    state.cullMode = FaceCullMode::None;
+    pipeline.SetState(state);
+    const Vec4 tint(1.0f, 0.5f, 0.0f, 1.0f);
+    pipeline.SetShader(Shader<NormalVaryings> {
+        .vertex = [&](const Vertex& vtx, NormalVaryings& out) {
+            out.normal = vtx.normal;
+            /// Same order of operations as the replay shaders, so depths match exactly
+            return camera->GetProjection() * (camera->GetView() * vtx.pos);
+        },
+        .pixel = [&](const NormalVaryings&) { return tint; },
+    });
+    std::vector<u8> tintBytes(sizeof(Vec4));
+    std::memcpy(tintBytes.data(), &tint, sizeof(Vec4));
+    auto capture = MakeRef<FrameCapture>();
+    pipeline.SetCapture(capture);
+
+    /// The far quad, a nearer one over its corner, then the far one again
+    /// behind both, which the depth test rejects where they are
+    Mesh far = MakeQuad(-1.0f, -1.0f, 0.2f, 0.2f, 0.0f);
+    Mesh nearQuad = MakeQuad(-0.2f, -0.2f, 1.0f, 1.0f, 0.5f);
+    Mesh behind = MakeQuad(-1.0f, -1.0f, 0.2f, 0.2f, -0.5f);
+    image->Clear();
+    std::fill(image->Data(), image->Data() + Size * Size, 0x202020FFu);
+    std::vector<u32> before(image->Data(), image->Data() + Size * Size);
+
+    /// The last draw is left untagged, it is replayed with the stand-in
+    capture->Begin();
+    capture->SetShader(TintShader, tintBytes);
+    pipeline.Perform(image, far);
+    auto rates = MakeRef<ShadingRateImage>(Size, Size);
+    rates->Fill(ShadingRate::Rate2x2);
+    pipeline.SetShadingRateImage(rates);
+    pipeline.Perform(image, nearQuad);
+    pipeline.SetShadingRateImage(nullptr);
+    capture->SetShader(0);
+    pipeline.Perform(image, behind);
+    capture->End();
+    pipeline.Perform(image, far);
+
+    /// The target is copied as the first captured draw found it
+    if (capture->Draws().size() != 3 || capture->Targets().size() != 1 || capture->Rates().size() != 1)
+    {
+        PRINT("captured {} draws {} targets {} rate images", capture->Draws().size(), capture->Targets().size(), capture->Rates().size());
+        return 1;
+    }
+    const CapturedTarget& target = capture->Targets()[0];
+    if (target.pixels.size() != before.size() || target.pixels[0] != before[0] || target.hdr.size() != 0)
+    {
+        PRINT("target not captured before the first draw");
+        return 1;
+    }
+    if (capture->Draws()[0].rates != ~0u || capture->Draws()[1].rates != 0 || capture->Draws()[2].rates != ~0u)
+    {
+        PRINT("rate images not bound to their draws");
+        return 1;
+    }
+    if (capture->Uniforms().size() != 1 || capture->Draws()[1].shader != TintShader || capture->Draws()[1].uniforms != 0
+        || capture->Draws()[2].shader != 0 || capture->Draws()[2].uniforms != ~0u)
+    {
+        PRINT("shaders not tagged on their draws");
+        return 1;
+    }
+
+    const std::string path = "frame_capture_test.bin";
+    if (!capture->Save(path))
+    {
+        PRINT("could not write {}", path);
+        return 1;
+    }
+    FrameCapture loaded;
+    if (!loaded.Load(path) || loaded.Draws().size() != 3 || loaded.Targets().size() != 1 || loaded.Rates().size() != 1)
+    {
+        PRINT("could not read {}", path);
+        return 1;
+    }
+    for (usize i = 0; i < loaded.Draws().size(); ++i)
+    {
+        const CapturedDraw& a = capture->Draws()[i];
+        const CapturedDraw& b = loaded.Draws()[i];
+        if (a.mesh.vertices.size() != b.mesh.vertices.size()
+            || std::memcmp(a.mesh.vertices.data(), b.mesh.vertices.data(), a.mesh.vertices.size() * sizeof(Vertex)) != 0
+            || std::memcmp(&a.camera, &b.camera, sizeof(CapturedCamera)) != 0 || a.rates != b.rates
+            || a.shader != b.shader || a.uniforms != b.uniforms
+            || a.state.cullMode != b.state.cullMode || a.mesh.topology != b.mesh.topology)
+        {
+            PRINT("draw {} changed by the round trip", i);
+            return 1;
+        }
+    }
+    if (loaded.Targets()[0].pixels != target.pixels || loaded.Targets()[0].depth != target.depth
+        || loaded.Rates()[0].tiles != capture->Rates()[0].tiles || loaded.Uniforms() != capture->Uniforms())
+    {
+        PRINT("target changed by the round trip");
+        return 1;
+    }
+
+    /// Truncated and foreign files are rejected
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(path, std::ios::binary);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 100));
+    }
+    FrameCapture broken;
+    if (broken.Load(path) || broken.Load("missing.bin") || !broken.Draws().empty())
+    {
+        PRINT("a broken capture loaded");
+        return 1;
+    }
+    std::remove(path.c_str());
+
+    /// Out of range enums are rejected rather than replayed
+    for (i32 field = 0; field < 4; ++field)
+    {
+        PipelineState bad = state;
+        Mesh mesh = far;
+        if (field == 0) { mesh.topology = static_cast<Topology>(7); }
+        if (field == 1) { bad.cullMode = static_cast<FaceCullMode>(3); }
+        if (field == 2) { bad.blend = static_cast<BlendMode>(5); }
+        if (field == 3) { bad.shadingRate = static_cast<ShadingRate>(3); }
+        FrameCapture corrupt;
+        corrupt.Begin();
+        corrupt.RecordDraw(*image, mesh, bad, *camera, nullptr);
+        corrupt.End();
+        if (!corrupt.Save(path) || broken.Load(path))
+        {
+            PRINT("a capture with a bad enum {} loaded", field);
+            return 1;
+        }
+    }
+    std::remove(path.c_str());
+
+    /// Replay covers what the captured draws covered, the tagged draws
+    /// shaded by the registered shader with their uniforms
+    Pipeline replayPipeline;
+    FrameReplay replay(loaded);
+    replay.SetShader(TintShader, [](Pipeline& pipeline, const CapturedDraw& draw, const std::vector<u8>& uniforms) {
+        if (uniforms.size() != sizeof(Vec4)) { return false; }
+        Vec4 color;
+        std::memcpy(&color, uniforms.data(), sizeof(Vec4));
+        pipeline.SetShader(Shader<NormalVaryings> {
+            .vertex = [&camera = draw.camera](const Vertex& vtx, NormalVaryings& out) {
+                out.normal = vtx.normal;
+                return camera.projection * (camera.view * vtx.pos);
+            },
+            .pixel = [color](const NormalVaryings&) { return color; },
+        });
+        return true;
+    });
+    std::vector<ReplayDrawStats> stats;
+    replay.Run(replayPipeline, stats);
+    replay.Run(replayPipeline, stats);
+    if (stats.size() != 3 || stats[0].pixels == 0 || stats[1].pixels == 0 || stats[0].triangles != 2 || stats[2].trianglesKept != 2)
+    {
+        PRINT("replay stats wrong");
+        return 1;
+    }
+    if (stats[0].standIn || stats[1].standIn || !stats[2].standIn)
+    {
+        PRINT("replay shaders not bound by their ids");
+        return 1;
+    }
+    /// The near quad is shaded at 2x2
+    if (stats[1].shaded * 2 > stats[1].pixels)
+    {
+        PRINT("rate image not replayed, {} shaded for {} pixels", stats[1].shaded, stats[1].pixels);
+        return 1;
+    }
+
+    std::vector<std::vector<u32>> counts;
+    replay.Overdraw(replayPipeline, counts);
+    if (counts.size() != 1 || counts[0].size() != static_cast<usize>(Size * Size))
+    {
+        PRINT("overdraw counts have the wrong size");
+        return 1;
+    }
+    usize total = 0;
+    for (u32 count : counts[0])
+    {
+        total += count;
+    }
+    if (total != stats[0].pixels + stats[1].pixels + stats[2].pixels)
+    {
+        PRINT("overdraw counts {} pixels, the draws wrote {}", total, stats[0].pixels + stats[1].pixels + stats[2].pixels);
+        return 1;
+    }
+    /// Center under both quads, corners under one or none, the quad behind adds nothing
+    if (Count(counts[0], 32, 32) != 2 || Count(counts[0], 8, 56) != 1 || Count(counts[0], 56, 8) != 1 || Count(counts[0], 56, 56) != 0)
+    {
+        PRINT("overdraw {} {} {} {}", Count(counts[0], 32, 32), Count(counts[0], 8, 56), Count(counts[0], 56, 8), Count(counts[0], 56, 56));
+        return 1;
+    }
+    /// The replayed depth and colors match the frame
+    const f32* depth = replay.Target(0)->DepthData();
+    if (std::memcmp(depth, image->DepthData(), Size * Size * sizeof(f32)) != 0)
+    {
+        PRINT("replayed depth differs from the frame");
+        return 1;
+    }
+    if (std::memcmp(replay.Target(0)->Data(), image->Data(), Size * Size * sizeof(u32)) != 0)
+    {
+        PRINT("replayed colors differ from the frame");
+        return 1;
+    }
+
+    /// Without the shader registered the stand-in draws them
+    FrameReplay standIn(loaded);
+    standIn.Run(replayPipeline, stats);
+    if (!stats[0].standIn || !stats[1].standIn
+        || std::memcmp(standIn.Target(0)->Data(), image->Data(), Size * Size * sizeof(u32)) == 0)
+    {
+        PRINT("unregistered shader not replaced by the stand-in");
+        return 1;
+    }
+
+    PRINT("frame capture ok: {:.3f} {:.3f} {:.3f} ms per draw", stats[0].ms, stats[1].ms, stats[2].ms);
+    return 0;
+}
\ No newline at end of file
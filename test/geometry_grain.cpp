@@ -0,0 +1,84 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+#include <cstring>
+
+using namespace scsr;
+
+static const i32 Size = 96;
+
+struct ColorVaryings
+{
+    Vec3 color;
+};
+
+/// Overlapping triangles at a few shared depths, so both the depth test
+/// and the submission order decide the pixels
+static Mesh Scatter(usize count)
+{
+    Mesh mesh;
+    u32 seed = 12345u;
+    auto next = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24);
+    };
+    for (usize t = 0; t < count; ++t)
+    {
+        Vec2 center(next() * 1.6f - 0.8f, next() * 1.6f - 0.8f);
+        f32 z = static_cast<f32>(t % 4) * 0.2f + 0.2f;
+        Vec3 color(next(), next(), next());
+        for (i32 k = 0; k < 3; ++k)
+        {
+            Vec2 p(center.x + next() * 0.3f - 0.15f, center.y + next() * 0.3f - 0.15f);
+            Vertex vtx = test::ClipVertex(p.x, p.y, z);
+            vtx.normal = color;
+            mesh.vertices.push_back(vtx);
+        }
+    }
+    return mesh;
+}
+
+static Ref<Image> Draw(const Mesh& mesh, usize grain, bool wireframe)
+{
+    PipelineState state = test::TestState();
+    state.wireframe = wireframe;
+    return test::Draw(ImageProp { .width = Size, .height = Size }, mesh, state, [grain](Pipeline& pipeline) {
+        pipeline.SetGeometryGrain(grain);
+        pipeline.SetShader(Shader<ColorVaryings> {
+            .vertex = [](const Vertex& vtx, ColorVaryings& out) {
+                out.color = vtx.normal;
+                return vtx.pos;
+            },
+            .pixel = [](const ColorVaryings& in) { return Vec4(in.color, 1.0f); },
+        });
+    });
+}
+
+static bool Same(const Image& a, const Image& b)
+{
+    usize pixels = static_cast<usize>(Size) * Size;
+    return std::memcmp(a.Data(), b.Data(), pixels * sizeof(u32)) == 0
+        && std::memcmp(a.DepthData(), b.DepthData(), pixels * sizeof(f32)) == 0;
+}
+
+int main()
+{
+    /// Chunk sizes from one triangle per job to the whole draw in one
+    Mesh mesh = Scatter(3000);
+    const usize grains[] = { 1, 7, 256, 1024, 1 << 20 };
+    for (bool wireframe : { false, true })
+    {
+        Ref<Image> reference = Draw(mesh, grains[0], wireframe);
+        for (usize grain : grains)
+        {
+            if (!Same(*reference, *Draw(mesh, grain, wireframe)))
+            {
+                PRINT("grain {} {} differs from grain {}", grain, wireframe ? "wireframe" : "fill", grains[0]);
+                return 1;
+            }
+        }
+    }
+
+    PRINT("geometry grain ok");
+    return 0;
+}
\ No newline at end of file
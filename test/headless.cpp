@@ -0,0 +1,109 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace scsr;
+
+static const i32 Width = 40;
+static const i32 Height = 30;
+
+/// Pixels of a binary PPM as R, G, B bytes, empty when the header is wrong
+static std::vector<u8> ReadPpm(const std::string& path, i32 width, i32 height)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    i32 w = 0, h = 0, maxValue = 0;
+    file >> magic >> w >> h >> maxValue;
+    file.get();
+    if (!file || magic != "P6" || w != width || h != height || maxValue != 255) { return {}; }
+    std::vector<u8> rgb((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (rgb.size() != static_cast<usize>(width) * height * 3) { return {}; }
+    return rgb;
+}
+
+int main()
+{
+    Window window(WindowProp { .title = "headless", .width = Width, .height = Height, .headless = true });
+    if (!window.IsHeadless())
+    {
+        PRINT("window not headless");
+        return 1;
+    }
+
+    /// A flat quad over the left half, rendered in place into the offscreen surface
+    Mesh mesh;
+    test::PushQuad(mesh, Vec2(-test::FullScreen, -test::FullScreen), Vec2(0.0f, test::FullScreen));
+    Pipeline pipeline;
+    test::SetupPipeline(pipeline);
+    pipeline.SetShader(Shader<NoVaryings> {
+        .vertex = [](const Vertex& vtx) { return vtx.pos; },
+        .pixel = []() { return Vec4(1.0f, 0.25f, 0.0f, 1.0f); },
+    });
+
+    const ImageProp prop { .width = Width, .height = Height };
+    Swapchain swapchain(prop, 1, 0);
+    swapchain.BindWindow(window);
+    std::vector<u32> rendered;
+    bool inPlace = false;
+    swapchain.PushWriteCommand([&](Ref<Image> image, usize) {
+        inPlace = image == window.SurfaceImage(prop);
+        image->Clear();
+        pipeline.Perform(image, mesh);
+        rendered.assign(image->Data(), image->Data() + Width * Height);
+    });
+    swapchain.AcquireAndWrite();
+    swapchain.Present(window);
+    if (!inPlace)
+    {
+        PRINT("headless frame not rendered in place");
+        return 1;
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / "scsr_headless_test.ppm").string();
+    if (!window.SaveFrame(path))
+    {
+        PRINT("could not write {}", path);
+        return 1;
+    }
+    std::vector<u8> rgb = ReadPpm(path, Width, Height);
+    if (rgb.empty())
+    {
+        PRINT("could not read {}", path);
+        return 1;
+    }
+    /// RGBA8888, red in the high byte
+    for (usize i = 0; i < rendered.size(); ++i)
+    {
+        u32 pixel = rendered[i];
+        if (rgb[i * 3] != (pixel >> 24) || rgb[i * 3 + 1] != ((pixel >> 16) & 0xFF) || rgb[i * 3 + 2] != ((pixel >> 8) & 0xFF))
+        {
+            PRINT("pixel {} saved as {} {} {}, rendered {:08x}", i, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], pixel);
+            return 1;
+        }
+    }
+    const usize left = (Height / 2 * Width + 5) * 3;
+    const usize right = (Height / 2 * Width + Width - 5) * 3;
+    if (rgb[left] != 255 || rgb[left + 1] < 60 || rgb[left + 1] > 68 || rgb[right] != 0)
+    {
+        PRINT("quad not in the left half");
+        return 1;
+    }
+
+    /// A smaller frame is scaled up to the window
+    Ref<Image> half = MakeRef<Image>(ImageProp { .width = Width / 2, .height = Height / 2 });
+    std::fill(half->Data(), half->Data() + half->Width() * half->Height(), 0x00FF00FFu);
+    window.OnUpdate(half);
+    if (!window.SaveFrame(path) || (rgb = ReadPpm(path, Width, Height)).empty() || rgb[right + 1] != 255 || rgb[right] != 0)
+    {
+        PRINT("scaled frame not saved");
+        return 1;
+    }
+    std::remove(path.c_str());
+
+    PRINT("headless ok");
+    return 0;
+}
\ No newline at end of file
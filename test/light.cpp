@@ -0,0 +1,102 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <algorithm>
+
+using namespace scsr;
+
+static u32 s_Seed = 7u;
+
+static f32 Random()
+{
+    s_Seed = s_Seed * 1664525u + 1013904223u;
+    return static_cast<f32>(s_Seed >> 8) / static_cast<f32>(1u << 24);
+}
+
+int main()
+{
+    const i32 width = 320;
+    const i32 height = 200;
+    Camera camera(Radians(60.0f), static_cast<f32>(width) / height, 0.1f, 50.0f);
+    camera.SetPosition(Vec3(0.0f, 1.0f, 8.0f));
+    camera.SetOrientation(Normalized(Vec3(0.0f, -0.1f, -1.0f)), Vec3::Y());
+
+    LightList lights;
+    const usize count = 500;
+    for (usize i = 0; i < count; ++i)
+    {
+        lights.Add(PointLight {
+            .position = Vec3(Random() * 20.0f - 10.0f, Random() * 6.0f - 3.0f, Random() * 20.0f - 14.0f),
+            .radius = 0.3f + Random() * 1.5f,
+        });
+    }
+    /// One light reaching through the near plane touches every tile
+    lights.Add(PointLight { .position = Vec3(0.0f, 1.0f, 8.2f), .radius = 0.5f });
+    lights.Build(camera, width, height);
+
+    /// Every light reaching a point inside the frustum is in its cluster
+    const Mat4& view = camera.GetView();
+    const Mat4& projection = camera.GetProjection();
+    usize visited = 0, reaching = 0;
+    for (i32 i = 0; i < 20000; ++i)
+    {
+        f32 depth = 0.1f + Random() * Random() * 49.9f;
+        Vec3 viewPos((Random() * 2.0f - 1.0f) * depth / projection.m00, (Random() * 2.0f - 1.0f) * depth / projection.m11, -depth);
+
+        LightSpan span = lights.Find(viewPos);
+        visited += span.count;
+        for (u32 index = 0; index < lights.Lights().size(); ++index)
+        {
+            const PointLight& light = lights.Lights()[index];
+            Vec3 lightPos = (view * Vec4(light.position, 1.0f)).xyz();
+            if (Length(lightPos - viewPos) >= light.radius) { continue; }
+
+            ++reaching;
+            if (std::find(span.begin(), span.end(), index) == span.end())
+            {
+                PRINT("light {} reaches ({}, {}, {}) but is not in its cluster", index, viewPos.x, viewPos.y, viewPos.z);
+                return 1;
+            }
+        }
+    }
+
+    /// Far fewer lights visited per point than the whole list
+    f64 perPoint = static_cast<f64>(visited) / 20000.0;
+    if (perPoint > count / 10.0)
+    {
+        PRINT("clusters hold {} lights per point on average", perPoint);
+        return 1;
+    }
+
+    /// Restored from bytes the clusters shade exactly alike, without the world space lights
+    lights.SetFillLight(0.2f);
+    std::vector<u8> bytes = lights.Serialize();
+    LightList restored;
+    if (!restored.Deserialize(bytes) || restored.FillLight() != 0.2f || !restored.Lights().empty())
+    {
+        PRINT("light list not restored from {} bytes", bytes.size());
+        return 1;
+    }
+    for (i32 i = 0; i < 1000; ++i)
+    {
+        f32 depth = 0.1f + Random() * 49.9f;
+        Vec3 viewPos((Random() * 2.0f - 1.0f) * depth / projection.m00, (Random() * 2.0f - 1.0f) * depth / projection.m11, -depth);
+        Vec3 normal = Normalized(Vec3(Random() - 0.5f, Random() - 0.5f, Random() - 0.5f) + Vec3(0.0f, 0.0f, 1e-3f));
+        Vec3 a = lights.Shade(normal, viewPos);
+        Vec3 b = restored.Shade(normal, viewPos);
+        if (a.x != b.x || a.y != b.y || a.z != b.z)
+        {
+            PRINT("restored lights shade ({}, {}, {}) differently", viewPos.x, viewPos.y, viewPos.z);
+            return 1;
+        }
+    }
+    bytes.pop_back();
+    if (restored.Deserialize(bytes) || restored.Deserialize({}))
+    {
+        PRINT("truncated light list bytes accepted");
+        return 1;
+    }
+
+    PRINT("light clusters ok: {:.2f} lights visited per point ({:.2f} reaching), {} assignments",
+        perPoint, reaching / 20000.0, lights.AssignedCount());
+    return 0;
+}
\ No newline at end of file
@@ -57,8 +57,43 @@ int main() {
     //     LOG_INFO("translation\t{}", FormatMath(t));
     // }
     {
-        auto lookto = Mat4LookTo(Vec3::ZERO(), Vec3 {1, 2, 3});
+        auto lookto = LookTo(Vec3::ZERO(), Vec3 {1, 2, 3}, Vec3::Y());
 
         PRINT("{}", FormatMath(lookto));
     }
+    {
+        // Mat4 determinant and inverse, against determinants worked out by hand
+        const Mat4 a(1, 2, 3, 4, 0, 1, 2, 3, 1, 0, 1, 2, 2, 1, 0, 1);
+        const Mat4 b(2, -1, 0, 3, 1, 3, -2, 0, 0, 4, 1, -1, 5, 0, 2, 1);
+        const Mat4 transform = FromScaleRotationTranslation(Vec3(1.0f, 2.0f, 3.0f), Quat::FromAxisAngle(Normalized(Vec3(1, 2, 3)), Radians(40.0f)), Vec3(4.0f, -5.0f, 6.0f));
+        const Mat4 projection = ProjectionPerspective(Radians(60.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+        const f32 dets[] = { 4.0f, -142.0f, -568.0f, 6.0f };
+        const Mat4 mats[] = { a, b, a * b, transform, projection * LookAt(Vec3(1, 2, 3), Vec3::ZERO(), Vec3::Y()) * transform };
+        for (usize i = 0; i < 5; ++i)
+        {
+            const Mat4& m = mats[i];
+            if (i < 4 && Abs(Determinant(m) - dets[i]) > 1e-3f * Abs(dets[i]))
+            {
+                PRINT("determinant {} is {}, expected {}", i, Determinant(m), dets[i]);
+                return 1;
+            }
+            Mat4 product = m * Inverse(m);
+            for (i32 k = 0; k < 16; ++k)
+            {
+                f32 expected = k % 5 == 0 ? 1.0f : 0.0f;
+                if (Abs(product.data[k] - expected) > 1e-4f)
+                {
+                    PRINT("matrix {} times its inverse is {}", i, FormatMath(product));
+                    return 1;
+                }
+            }
+            if (Abs(Determinant(Inverse(m)) * Determinant(m) - 1.0f) > 1e-4f)
+            {
+                PRINT("determinant of the inverse of {} is {}", i, Determinant(Inverse(m)));
+                return 1;
+            }
+        }
+    }
+    PRINT("math ok");
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <chrono>
+
+using namespace scsr;
+
+static const i32 Width = 320;
+static const i32 Height = 200;
+static const u32 Gray = 0x808080FFu;
+
+static u32 Pixel(const Image& image, i32 x, i32 y)
+{
+    return image.Data()[y * image.Width() + x];
+}
+
+static void FillGray(Image& image)
+{
+    std::fill(image.Data(), image.Data() + Width * Height, Gray);
+}
+
+/// Usage: overlay font.ttf
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        PRINT("usage: overlay font.ttf");
+        return 1;
+    }
+    auto font = MakeRef<GlyphAtlas>();
+    if (font->Load("missing.ttf", 14.0f) || font->IsLoaded())
+    {
+        PRINT("missing font loaded");
+        return 1;
+    }
+
+    /// Without a font only the panel and the graph are drawn
+    Image target(ImageProp { .width = Width, .height = Height });
+    PerfOverlay overlay(font, OverlayProp { .x = 10, .y = 20, .graphHeight = 40, .graphMaxMs = 40.0, .budgetMs = 10.0 });
+    if (!overlay.Bounds().Empty())
+    {
+        PRINT("bounds before the first draw");
+        return 1;
+    }
+    overlay.AddFrame(5.0);
+    overlay.AddFrame(15.0);
+    overlay.AddFrame(80.0);
+    FillGray(target);
+    overlay.Draw(target);
+    /// A column per frame of history and the padding around the graph
+    const Rect graphOnly { 10, 20, 10 + static_cast<i32>(PerfOverlay::HistorySize) + 8, 68 };
+    if (overlay.Bounds() != graphOnly)
+    {
+        PRINT("bounds {} {} {} {}", overlay.Bounds().x0, overlay.Bounds().y0, overlay.Bounds().x1, overlay.Bounds().y1);
+        return 1;
+    }
+    /// Panel from (10, 20), graph from (14, 24) to its bottom at y 64
+    if (Pixel(target, 9, 30) != Gray || Pixel(target, 10, 19) != Gray || Pixel(target, 200, 30) != Gray)
+    {
+        PRINT("overlay drawn outside its panel");
+        return 1;
+    }
+    if ((Pixel(target, 100, 30) >> 24) >= 0x80)
+    {
+        PRINT("panel not darkened, {:x}", Pixel(target, 100, 30));
+        return 1;
+    }
+    auto red = [&](i32 x, i32 y) { return static_cast<i32>(Pixel(target, x, y) >> 24); };
+    auto green = [&](i32 x, i32 y) { return static_cast<i32>((Pixel(target, x, y) >> 16) & 0xFF); };
+    /// 5 ms is green and 5 pixels high, 15 ms yellow, 80 ms red and clamped to the top
+    if (green(14, 63) <= red(14, 63) || green(14, 59) <= red(14, 59) || green(14, 58) > 0x80)
+    {
+        PRINT("fast frame column wrong");
+        return 1;
+    }
+    if (green(15, 63) < 0xC0 || red(15, 63) < 0xC0 || red(16, 24) <= green(16, 24) || red(16, 63) <= green(16, 63))
+    {
+        PRINT("slow frame columns wrong");
+        return 1;
+    }
+    /// The budget line crosses empty columns at 10 ms
+    if ((Pixel(target, 60, 54) >> 24) <= (Pixel(target, 60, 53) >> 24))
+    {
+        PRINT("budget line missing");
+        return 1;
+    }
+
+    /// Text of the frame time and stats goes above the graph
+    if (!font->Load(argv[1], 14.0f) || font->LineHeight() <= 0 || font->Measure("frame") <= 0 || font->Get('\n').advance != font->Get('?').advance)
+    {
+        PRINT("font {} not loaded", argv[1]);
+        return 1;
+    }
+    overlay.SetTime("main", 12.5);
+    overlay.SetCounter("triangles", 12345);
+    FillGray(target);
+    overlay.Draw(target);
+    usize bright = 0;
+    for (i32 y = 20; y < 24 + 4 * font->LineHeight(); ++y)
+    {
+        for (i32 x = 14; x < Width; ++x)
+        {
+            bright += (Pixel(target, x, y) >> 24) > 0xA0;
+        }
+    }
+    if (bright == 0)
+    {
+        PRINT("no text drawn");
+        return 1;
+    }
+    /// Everything drawn is within the bounds, and they grew with the text
+    const Rect withText = overlay.Bounds();
+    if (Union(withText, graphOnly) != withText || withText.y1 <= graphOnly.y1)
+    {
+        PRINT("bounds did not grow with the text");
+        return 1;
+    }
+    for (i32 y = 0; y < Height; ++y)
+    {
+        for (i32 x = 0; x < Width; ++x)
+        {
+            bool inside = x >= withText.x0 && x < withText.x1 && y >= withText.y0 && y < withText.y1;
+            if (!inside && Pixel(target, x, y) != Gray)
+            {
+                PRINT("pixel {} {} drawn outside the bounds", x, y);
+                return 1;
+            }
+        }
+    }
+    /// Fewer lines keep the panel, damage of the bounds still covers the old one
+    overlay.ClearStats();
+    FillGray(target);
+    overlay.Draw(target);
+    if (overlay.Bounds() != withText || (Pixel(target, withText.x0, withText.y1 - 1) >> 24) >= 0x80)
+    {
+        PRINT("panel shrank");
+        return 1;
+    }
+
+    /// A full history with stats, timed for the report only
+    overlay.SetTime("main", 12.5);
+    overlay.SetCounter("triangles", 12345);
+    overlay.SetTime("post", 3.0);
+    for (usize i = 0; i < PerfOverlay::HistorySize; ++i)
+    {
+        overlay.AddFrame(static_cast<f64>(i % 30));
+    }
+    Image frame(ImageProp { .width = 800, .height = 600 });
+    const i32 frames = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < frames; ++i)
+    {
+        overlay.Draw(frame);
+    }
+    f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    PRINT("overlay ok: drawn in {:.3f} ms", ms);
+    return 0;
+}
\ No newline at end of file
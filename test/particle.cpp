@@ -0,0 +1,138 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <chrono>
+
+using namespace scsr;
+
+static const i32 Width = 256;
+static const i32 Height = 160;
+
+static usize Covered(const Image& image)
+{
+    return static_cast<usize>(std::count_if(image.Data(), image.Data() + Width * Height, [](u32 pixel) { return pixel != 0; }));
+}
+
+int main()
+{
+    /// Emitted attributes stay within their spread
+    ParticleSystem particles(100000);
+    particles.SetGravity(Vec3(0.0f, 0.0f, 0.0f));
+    ParticleEmitter emitter {
+        .position = Vec3(0.0f, 0.0f, -5.0f),
+        .positionSpread = Vec3(2.0f, 1.0f, 0.5f),
+        .velocity = Vec3(0.0f, 1.0f, 0.0f),
+        .velocitySpread = Vec3(0.5f, 0.5f, 0.5f),
+        .lifetime = 1.0f,
+        .lifetimeSpread = 0.5f,
+        .color = 0xFF0000FFu,
+    };
+    if (particles.Emit(emitter, 70001) != 70001 || particles.Emit(emitter, 70000) != 29999 || particles.Count() != 100000)
+    {
+        PRINT("emission past capacity: {}", particles.Count());
+        return 1;
+    }
+    const ParticleArrays& p = particles.Particles();
+    for (usize i = 0; i < particles.Count(); ++i)
+    {
+        if (Abs(p.x[i]) > 2.0f || Abs(p.y[i]) > 1.0f || Abs(p.z[i] + 5.0f) > 0.5f ||
+            Abs(p.vy[i] - 1.0f) > 0.5f || p.life[i] < 0.5f || p.life[i] > 1.5f || p.color[i] != emitter.color)
+        {
+            PRINT("particle {} emitted outside the emitter", i);
+            return 1;
+        }
+    }
+
+    /// Integration moves every survivor and compaction keeps their order
+    ParticleArrays before = p;
+    const f32 dt = 1.0f;
+    particles.Update(dt);
+    usize survivor = 0;
+    for (usize i = 0; i < 100000; ++i)
+    {
+        if (!(before.life[i] - dt > 0.0f)) { continue; }
+        if (survivor >= particles.Count() || Abs(p.x[survivor] - (before.x[i] + before.vx[i] * dt)) > 1e-5f ||
+            Abs(p.life[survivor] - (before.life[i] - dt)) > 1e-5f)
+        {
+            PRINT("survivor {} of particle {} is wrong", survivor, i);
+            return 1;
+        }
+        ++survivor;
+    }
+    if (survivor != particles.Count() || survivor < 40000 || survivor > 60000)
+    {
+        PRINT("{} survivors, {} expected", particles.Count(), survivor);
+        return 1;
+    }
+
+    /// A billboard covers a square of its size, across band boundaries
+    Camera camera(Radians(60.0f), static_cast<f32>(Width) / Height, 0.1f, 50.0f);
+    Image image(ImageProp { .width = Width, .height = Height });
+    ParticleSystem single(1);
+    single.Emit(ParticleEmitter { .position = Vec3(0.0f, 0.0f, -5.0f), .lifetime = 10.0f }, 1);
+    ParticleDrawProp prop { .size = 1.0f, .blend = BlendMode::Opaque, .fade = false };
+    image.Clear();
+    single.Draw(image, camera.GetView(), camera.GetProjection(), prop);
+    const f32 side = camera.GetProjection().m11 * Height / 2.0f / 5.0f;
+    if (Abs(static_cast<f32>(Covered(image)) - side * side) > 2.0f * side + 1.0f)
+    {
+        PRINT("billboard covers {} pixels, about {} expected", Covered(image), side * side);
+        return 1;
+    }
+    /// Depth tested against the target without writing it
+    image.Clear();
+    std::fill(image.DepthData(), image.DepthData() + Width * Height / 2, 0.0f);
+    single.Draw(image, camera.GetView(), camera.GetProjection(), prop);
+    if (Covered(image) == 0 || std::count_if(image.Data(), image.Data() + Width * Height / 2, [](u32 pixel) { return pixel != 0; }) != 0 ||
+        image.DepthData()[Width * Height - 1] != 1.0f)
+    {
+        PRINT("billboard not depth tested");
+        return 1;
+    }
+
+    /// Additive particles give the same image in any thread count, a
+    /// particle per job here
+    ParticleSystem cloud(1000000);
+    cloud.SetGravity(Vec3(0.0f, -2.0f, 0.0f));
+    ParticleEmitter fountain {
+        .position = Vec3(0.0f, -1.0f, -5.0f),
+        .positionSpread = Vec3(0.2f, 0.1f, 0.2f),
+        .velocity = Vec3(0.0f, 2.0f, 0.0f),
+        .velocitySpread = Vec3(1.0f, 0.5f, 1.0f),
+        .lifetime = 2.0f,
+        .lifetimeSpread = 1.0f,
+        .color = 0x40201010u,
+    };
+    cloud.Emit(fountain, 500000);
+    cloud.Update(0.5f);
+    Image first(ImageProp { .width = Width, .height = Height });
+    Image second(ImageProp { .width = Width, .height = Height });
+    first.Clear();
+    second.Clear();
+    ParticleDrawProp additive { .size = 0.01f };
+    usize visible = cloud.Draw(first, camera.GetView(), camera.GetProjection(), additive);
+    cloud.Draw(second, camera.GetView(), camera.GetProjection(), additive);
+    if (visible == 0 || Covered(first) < 500 || !std::equal(first.Data(), first.Data() + Width * Height, second.Data()))
+    {
+        PRINT("{} particles drew {} pixels", visible, Covered(first));
+        return 1;
+    }
+
+    /// A million particles every frame
+    cloud.Clear();
+    cloud.Emit(fountain, 1000000);
+    Image frame(ImageProp { .width = 800, .height = 600 });
+    Camera wide(Radians(60.0f), 800.0f / 600.0f, 0.1f, 50.0f);
+    const i32 frames = 10;
+    auto start = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < frames; ++i)
+    {
+        cloud.Emit(fountain, cloud.Capacity() - cloud.Count());
+        cloud.Update(1.0f / 60.0f);
+        frame.Clear();
+        cloud.Draw(frame, wide.GetView(), wide.GetProjection(), additive);
+    }
+    f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    PRINT("particles ok: 1M particles in {:.2f} ms per frame", ms);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+using namespace scsr;
+
+static u32 s_Seed = 11u;
+
+static f32 Random()
+{
+    s_Seed = s_Seed * 1664525u + 1013904223u;
+    return static_cast<f32>(s_Seed >> 8) / static_cast<f32>(1u << 24);
+}
+
+static std::vector<CloudPoint> Scatter(usize count)
+{
+    std::vector<CloudPoint> points(count);
+    for (CloudPoint& point : points)
+    {
+        point.position = Vec3(Random() * 16.0f - 8.0f, Random() * 10.0f - 5.0f, -2.0f - Random() * 12.0f);
+        point.color = (s_Seed & 0xFFFFFF00u) | 0xFFu;
+    }
+    return points;
+}
+
+/// One point at a time, nearest wins and ties keep the smaller color
+static void Reference(Image& image, const std::vector<CloudPoint>& points, const Mat4& m)
+{
+    std::vector<f32> depths(image.DepthData(), image.DepthData() + image.Width() * image.Height());
+    std::vector<u32> colors(depths.size(), 0);
+    for (const CloudPoint& point : points)
+    {
+        const Vec3& p = point.position;
+        f32 cx = m.m00 * p.x + m.m01 * p.y + m.m02 * p.z + m.m03;
+        f32 cy = m.m10 * p.x + m.m11 * p.y + m.m12 * p.z + m.m13;
+        f32 cz = m.m20 * p.x + m.m21 * p.y + m.m22 * p.z + m.m23;
+        f32 cw = m.m30 * p.x + m.m31 * p.y + m.m32 * p.z + m.m33;
+        if (!(cw > 0.0f && cx > -cw && cx < cw && cy > -cw && cy < cw && cz > -cw && cz < cw)) { continue; }
+        f32 rw = 1.0f / cw;
+        i32 x = static_cast<i32>((cx * rw + 1.0f) * 0.5f * image.Width());
+        i32 y = static_cast<i32>((1.0f - cy * rw) * 0.5f * image.Height());
+        if (x >= image.Width() || y >= image.Height()) { continue; }
+        usize index = static_cast<usize>(y) * image.Width() + x;
+        f32 z = cz * rw;
+        if (z < depths[index] || (z == depths[index] && colors[index] != 0 && point.color < colors[index]))
+        {
+            depths[index] = z;
+            colors[index] = point.color;
+        }
+    }
+    SwizzlePixels(colors.data(), colors.data(), colors.size(), PixelFormat::RGBA8888, image.Format());
+    for (usize i = 0; i < colors.size(); ++i)
+    {
+        if (colors[i] != 0) { image.Data()[i] = colors[i]; }
+    }
+}
+
+int main()
+{
+    const i32 width = 256;
+    const i32 height = 160;
+    Camera camera(Radians(60.0f), static_cast<f32>(width) / height, 0.1f, 50.0f);
+    const Mat4 viewProjection = camera.GetProjection() * camera.GetView();
+
+    /// Splatting on all cores matches drawing the points one by one
+    std::vector<CloudPoint> points = Scatter(200000);
+    Image splatted(ImageProp { .width = width, .height = height });
+    Image expected(ImageProp { .width = width, .height = height });
+    splatted.Clear();
+    expected.Clear();
+    PointSplatter splatter;
+    splatter.Begin(splatted);
+    usize visible = splatter.Splat(points, viewProjection);
+    splatter.Resolve(splatted);
+    Reference(expected, points, viewProjection);
+    if (visible == 0 || visible == points.size() ||
+        !std::equal(splatted.Data(), splatted.Data() + width * height, expected.Data()))
+    {
+        PRINT("splatted {} points unlike the reference", visible);
+        return 1;
+    }
+
+    /// Points behind the depth already in the target stay hidden
+    splatted.Clear();
+    std::fill(splatted.DepthData(), splatted.DepthData() + width * height / 2, 0.0f);
+    splatter.Begin(splatted);
+    splatter.Splat(points, viewProjection);
+    splatter.Resolve(splatted);
+    if (std::any_of(splatted.Data(), splatted.Data() + width * height / 2, [](u32 c) { return c != 0; }))
+    {
+        PRINT("hidden points drawn");
+        return 1;
+    }
+
+    /// A disk of radius 2 covers 13 pixels
+    splatted.Clear();
+    splatter.Begin(splatted);
+    CloudPoint single { Vec3(0.0f, 0.0f, -5.0f), 0xFF0000FFu };
+    splatter.Splat(std::span<const CloudPoint>(&single, 1), viewProjection, 2);
+    splatter.Resolve(splatted);
+    usize covered = std::count_if(splatted.Data(), splatted.Data() + width * height, [](u32 c) { return c != 0; });
+    if (covered != 13)
+    {
+        PRINT("disk covered {} pixels", covered);
+        return 1;
+    }
+
+    /// HDR targets get the point color decoded to linear, which the post
+    /// chain's sRGB encoding turns back into the packed color
+    Image hdr(ImageProp { .width = width, .height = height, .hdr = true });
+    hdr.Clear();
+    splatter.Begin(hdr);
+    CloudPoint gray { Vec3(0.0f, 0.0f, -5.0f), 0x804020FFu };
+    splatter.Splat(std::span<const CloudPoint>(&gray, 1), viewProjection);
+    splatter.Resolve(hdr);
+    auto lit = std::find_if(hdr.Data(), hdr.Data() + width * height, [](u32 c) { return c != 0; });
+    if (lit == hdr.Data() + width * height)
+    {
+        PRINT("point not splatted into the HDR target");
+        return 1;
+    }
+    const Color& linear = hdr.HdrData()[lit - hdr.Data()];
+    u32 encoded = 0;
+    PackColors(&linear, &encoded, 1, hdr.Format(), true);
+    if (Abs(linear.x - 0.2158605f) > 1e-4f || encoded != *lit)
+    {
+        PRINT("HDR splat {} encodes to {:08x}, packed {:08x}", linear.x, encoded, *lit);
+        return 1;
+    }
+
+    /// Streaming a file over several chunks draws the same frame
+    std::vector<CloudPoint> many = Scatter(PointSplatter::StreamChunk * 2 + 1000);
+    const std::string path = (std::filesystem::temp_directory_path() / "scsr_point_cloud_test.bin").string();
+    if (!WritePointCloud(path, many))
+    {
+        PRINT("could not write {}", path);
+        return 1;
+    }
+    PointCloudReader reader(path);
+    if (!reader.IsOpen() || reader.Count() != many.size())
+    {
+        PRINT("could not read {}", path);
+        return 1;
+    }
+    Image streamed(ImageProp { .width = width, .height = height });
+    streamed.Clear();
+    splatter.Begin(streamed);
+    usize streamedCount = splatter.SplatFile(reader, viewProjection);
+    splatter.Resolve(streamed);
+    std::remove(path.c_str());
+
+    splatted.Clear();
+    splatter.Begin(splatted);
+    auto start = std::chrono::steady_clock::now();
+    usize inMemoryCount = splatter.Splat(many, viewProjection);
+    f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    splatter.Resolve(splatted);
+    if (streamedCount != inMemoryCount || !std::equal(splatted.Data(), splatted.Data() + width * height, streamed.Data()))
+    {
+        PRINT("streamed {} points, {} in memory", streamedCount, inMemoryCount);
+        return 1;
+    }
+
+    PRINT("point cloud ok: {:.1f}M points/s", many.size() / seconds / 1e6);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+using namespace scsr;
+
+static const i32 Size = 64;
+
+static i32 Red(const Image& image, i32 x, i32 y)
+{
+    return static_cast<i32>((image.Data()[y * Size + x] >> GetPixelLayout(image.Format()).r) & 0xFF);
+}
+
+static void Fill(Image& image, const Color& color)
+{
+    std::fill(image.HdrData(), image.HdrData() + Size * Size, color);
+}
+
+int main()
+{
+    Image hdr(ImageProp { .width = Size, .height = Size, .hdr = true });
+    Image out(ImageProp { .width = Size, .height = Size });
+
+    /// Tone mapping is monotonic and keeps very bright colors below white
+    PostChain post(PostProp { .bloom = false, .fxaa = false });
+    i32 previous = -1;
+    for (f32 value : { 0.0f, 0.05f, 0.2f, 0.5f, 1.0f, 4.0f, 100.0f })
+    {
+        Fill(hdr, Color(value, value, value, 1.0f));
+        post.Process(hdr, out);
+        i32 red = Red(out, Size / 2, Size / 2);
+        if (red <= previous && value > 0.0f)
+        {
+            PRINT("tone mapping not increasing at {}: {} after {}", value, red, previous);
+            return 1;
+        }
+        previous = red;
+    }
+    if (previous < 250)
+    {
+        PRINT("bright colors map to {}", previous);
+        return 1;
+    }
+
+    /// A bright spot glows into its dark surroundings with bloom only
+    Fill(hdr, Color(0.0f, 0.0f, 0.0f, 1.0f));
+    for (i32 y = 28; y < 36; ++y)
+    {
+        for (i32 x = 28; x < 36; ++x)
+        {
+            hdr.HdrData()[y * Size + x] = Color(20.0f, 20.0f, 20.0f, 1.0f);
+        }
+    }
+    post.Process(hdr, out);
+    if (Red(out, 24, 32) != 0)
+    {
+        PRINT("glow without bloom");
+        return 1;
+    }
+    post.SetProp(PostProp { .bloom = true, .fxaa = false });
+    post.Process(hdr, out);
+    if (Red(out, 24, 32) == 0 || Red(out, 24, 32) >= Red(out, 27, 32) || Red(out, 2, 2) != 0)
+    {
+        PRINT("bloom falloff wrong: {} {} {}", Red(out, 27, 32), Red(out, 24, 32), Red(out, 2, 2));
+        return 1;
+    }
+
+    /// FXAA softens a hard diagonal edge and leaves flat areas alone
+    for (i32 y = 0; y < Size; ++y)
+    {
+        for (i32 x = 0; x < Size; ++x)
+        {
+            f32 value = x > y ? 4.0f : 0.0f;
+            hdr.HdrData()[y * Size + x] = Color(value, value, value, 1.0f);
+        }
+    }
+    post.SetProp(PostProp { .bloom = false, .fxaa = true });
+    post.Process(hdr, out);
+    i32 softened = 0;
+    for (i32 y = 1; y + 1 < Size; ++y)
+    {
+        for (i32 x = 1; x + 1 < Size; ++x)
+        {
+            i32 red = Red(out, x, y);
+            bool edge = Abs(x - y) <= 1;
+            if (!edge && red != Red(out, x > y ? Size - 1 : 0, x > y ? 0 : Size - 1))
+            {
+                PRINT("flat pixel {} {} changed to {}", x, y, red);
+                return 1;
+            }
+            if (edge && red > 0 && red < 240) { ++softened; }
+        }
+    }
+    if (softened < Size / 2)
+    {
+        PRINT("only {} edge pixels softened", softened);
+        return 1;
+    }
+
+    PRINT("post ok: {} edge pixels softened", softened);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <mutex>
+
+using namespace scsr;
+
+static const ImageProp Prop { .width = 16, .height = 16 };
+
+int main()
+{
+    RenderGraph graph;
+    std::mutex mutex;
+    std::vector<std::string> executed;
+    auto record = [&](const std::string& name) {
+        return [&, name](const RenderGraph&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            executed.push_back(name);
+        };
+    };
+
+    /// Two independent inputs feeding a chain into the imported target
+    auto target = MakeRef<Image>(Prop);
+    RenderResource output = graph.Import("output", target);
+    RenderResource shadow = graph.CreateTransient("shadow", Prop);
+    RenderResource color = graph.CreateTransient("color", Prop);
+    RenderResource unused = graph.CreateTransient("unused", Prop);
+    RenderResource blurred = graph.CreateTransient("blurred", Prop);
+    RenderResource graded = graph.CreateTransient("graded", Prop);
+
+    graph.AddPass({ .name = "debug", .writes = { unused } }, record("debug"));
+    graph.AddPass({ .name = "shadow", .writes = { shadow } }, record("shadow"));
+    graph.AddPass({ .name = "main", .writes = { color } }, record("main"));
+    graph.AddPass({ .name = "lighting", .reads = { shadow, color }, .writes = { blurred } }, record("lighting"));
+    graph.AddPass({ .name = "grade", .reads = { blurred }, .writes = { graded } }, record("grade"));
+    /// Passes may run on workers, checked after `Execute`
+    bool bound = false;
+    graph.AddPass({ .name = "present", .reads = { graded }, .writes = { output } }, [&](const RenderGraph& g) {
+        bound = g.Get(output) == target;
+        record("present")(g);
+    });
+    graph.Execute();
+
+    if (!bound)
+    {
+        PRINT("imported image not bound");
+        return 1;
+    }
+
+    if (!graph.IsCulled(0))
+    {
+        PRINT("pass writing an unread transient should be culled");
+        return 1;
+    }
+    const std::vector<std::string> expected { "lighting", "grade", "present" };
+    if (executed.size() != 5 || !std::equal(expected.begin(), expected.end(), executed.begin() + 2))
+    {
+        PRINT("unexpected execution of {} passes", executed.size());
+        return 1;
+    }
+    /// Shadow and main have no dependency and share a level
+    if (graph.Level(1) != 0 || graph.Level(2) != 0 || graph.Level(3) != 1 || graph.Level(5) != 3)
+    {
+        PRINT("unexpected levels {} {} {} {}", graph.Level(1), graph.Level(2), graph.Level(3), graph.Level(5));
+        return 1;
+    }
+    /// Shadow, color and blurred are alive together in lighting, graded
+    /// comes after shadow is done and takes its image
+    if (graph.PooledImageCount() != 3 || graph.Get(unused))
+    {
+        PRINT("{} pooled images for 4 live transients", graph.PooledImageCount());
+        return 1;
+    }
+    if (graph.Get(graded) != graph.Get(shadow) || graph.Get(blurred) == graph.Get(shadow) || graph.Get(shadow) == graph.Get(color))
+    {
+        PRINT("transients not aliased by lifetime");
+        return 1;
+    }
+
+    /// A later writer keeps the earlier one, it only draws on top
+    graph.Reset();
+    executed.clear();
+    output = graph.Import("output", target);
+    color = graph.CreateTransient("color", Prop);
+    graph.AddPass({ .name = "base", .writes = { color } }, record("base"));
+    graph.AddPass({ .name = "decals", .writes = { color } }, record("decals"));
+    graph.AddPass({ .name = "present", .reads = { color }, .writes = { output } }, record("present"));
+    graph.Execute();
+    if (executed != std::vector<std::string> { "base", "decals", "present" } || graph.PooledImageCount() != 3)
+    {
+        PRINT("overwritten pass culled or pool dropped");
+        return 1;
+    }
+
+    PRINT("render graph ok");
+    return 0;
+}
\ No newline at end of file
@@ -3,7 +3,105 @@
 
 using namespace scsr;
 
+/// Barycentric weights as varyings, so the interpolation can be checked per pixel
+struct WeightVaryings
+{
+    Vec3 weights;
+};
+
 int main()
 {
+    const i32 size = 64;
+    auto image = MakeRef<Image>(ImageProp { .width = size, .height = size });
+    auto camera = MakeRef<Camera>(Radians(60.0f), 1.0f, 0.1f, 100.0f);
+
+    /// Clip space positions given directly, with very different w per vertex
+    const f32 w[3] = { 2.0f, 8.0f, 2.0f };
+    Mesh mesh;
+    const Vec2 corners[3] = { Vec2(-0.8f, -0.8f), Vec2(0.8f, -0.8f), Vec2(0.0f, 0.8f) };
+    for (i32 i = 0; i < 3; ++i)
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(corners[i].x * w[i], corners[i].y * w[i], 0.0f, w[i]);
+        vtx.uv = Vec2(static_cast<f32>(i), 0.0f);
+        mesh.vertices.push_back(vtx);
+    }
+
+    Pipeline pipeline;
+    pipeline.SetCamera(camera);
+    pipeline.SetShader(Shader<WeightVaryings> {
+        .vertex = [](const Vertex& vtx, WeightVaryings& out) {
+            i32 i = static_cast<i32>(vtx.uv.x);
+            out.weights = Vec3(i == 0 ? 1.0f : 0.0f, i == 1 ? 1.0f : 0.0f, i == 2 ? 1.0f : 0.0f);
+            return vtx.pos;
+        },
+        .pixel = [](const WeightVaryings& in) {
+            return Vec4(in.weights, 1.0f);
+        },
+    });
+    image->Clear();
+    pipeline.Perform(image, mesh);
+
+    /// Screen positions as the viewport transform places them
+    Vec2 screen[3];
+    for (i32 i = 0; i < 3; ++i)
+    {
+        screen[i] = Vec2((corners[i].x + 1.0f) * 0.5f * size, (1.0f - corners[i].y) * 0.5f * size);
+    }
+    auto cross = [](Vec2 a, Vec2 b, Vec2 c) { return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y); };
+    f32 area = cross(screen[0], screen[1], screen[2]);
+
+    usize covered = 0;
+    f32 maxError = 0.0f;
+    f32 maxAffineError = 0.0f;
+    for (i32 y = 0; y < size; ++y)
+    {
+        for (i32 x = 0; x < size; ++x)
+        {
+            u32 pixel = image->Data()[y * size + x];
+            if (pixel == 0) { continue; }
+            ++covered;
+
+            Vec2 p(x + 0.5f, y + 0.5f);
+            f32 l[3] = {
+                cross(screen[1], screen[2], p) / area,
+                cross(screen[2], screen[0], p) / area,
+                cross(screen[0], screen[1], p) / area,
+            };
+            f32 sum = l[0] / w[0] + l[1] / w[1] + l[2] / w[2];
+            PixelLayout layout = GetPixelLayout(image->Format());
+            const u32 shifts[3] = { layout.r, layout.g, layout.b };
+            for (i32 i = 0; i < 3; ++i)
+            {
+                f32 value = ((pixel >> shifts[i]) & 0xFF) / 255.0f;
+                f32 expected = (l[i] / w[i]) / sum;
+                maxError = Max(maxError, Abs(value - expected));
+                maxAffineError = Max(maxAffineError, Abs(value - l[i]));
+            }
+        }
+    }
+
+    PRINT("covered {} max error {} (affine would be off by {})", covered, maxError, maxAffineError);
+    if (covered < 100 || maxError > 3.0f / 255.0f || maxAffineError < 0.1f)
+    {
+        PRINT("perspective-correct interpolation failed");
+        return 1;
+    }
 
+    /// A triangle along a line covers nothing and is not kept
+    Mesh line;
+    for (i32 i = 0; i < 3; ++i)
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(-0.8f + 0.6f * i, -0.4f + 0.3f * i, 0.0f, 2.0f);
+        line.vertices.push_back(vtx);
+    }
+    pipeline.ResetStats();
+    pipeline.Perform(image, line);
+    if (pipeline.GetStats().triangles != 1 || pipeline.GetStats().trianglesKept != 0)
+    {
+        PRINT("degenerate triangle kept");
+        return 1;
+    }
+    return 0;
 }
\ No newline at end of file
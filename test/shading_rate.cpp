@@ -0,0 +1,106 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+using namespace scsr;
+
+struct UvVaryings
+{
+    Vec2 uv;
+};
+
+/// Draw a full screen quad with a horizontal gradient at `rate`
+static Ref<Image> Draw(ShadingRate rate, Ref<ShadingRateImage> rates, PipelineStats& stats)
+{
+    const i32 size = 64;
+    PipelineState state = test::TestState();
+    state.shadingRate = rate;
+    return test::Draw(ImageProp { .width = size, .height = size }, test::FullScreenQuad(), state, [&](Pipeline& pipeline) {
+        pipeline.SetShadingRateImage(rates);
+        pipeline.SetShader(Shader<UvVaryings> {
+            .vertex = [](const Vertex& vtx, UvVaryings& out) { out.uv = vtx.uv; return vtx.pos; },
+            .pixel = [](const UvVaryings& in) { return Vec4(in.uv.x, 0.0f, 0.0f, 1.0f); },
+        });
+    }, &stats);
+}
+
+int main()
+{
+    PipelineStats full, coarse, tiled;
+    Ref<Image> reference = Draw(ShadingRate::Rate1x1, nullptr, full);
+    Ref<Image> blocks = Draw(ShadingRate::Rate2x2, nullptr, coarse);
+
+    if (coarse.pixelsCovered != full.pixelsCovered)
+    {
+        PRINT("coverage differs: {} != {}", coarse.pixelsCovered, full.pixelsCovered);
+        return 1;
+    }
+    /// Blocks on the diagonal are shaded once per triangle
+    if (coarse.pixels * 3 > full.pixels)
+    {
+        PRINT("2x2 shaded {} of {} pixels", coarse.pixels, full.pixels);
+        return 1;
+    }
+
+    /// Every 2x2 block holds one color, close to the per pixel result. The
+    /// gradient is continuous, so blocks the diagonal splits are shaded alike by both triangles
+    const i32 size = reference->Width();
+    i32 red = static_cast<i32>(GetPixelLayout(reference->Format()).r);
+    for (i32 y = 0; y + 1 < size; y += 2)
+    {
+        for (i32 x = 0; x + 1 < size; x += 2)
+        {
+            const u32* row0 = blocks->Data() + y * size;
+            const u32* row1 = row0 + size;
+            if (row0[x] != row0[x + 1] || row0[x] != row1[x] || row0[x] != row1[x + 1])
+            {
+                PRINT("block {} {} not uniform", x, y);
+                return 1;
+            }
+            i32 a = (reference->Data()[y * size + x] >> red) & 0xFF;
+            i32 b = (row0[x] >> red) & 0xFF;
+            if (Abs(a - b) > 4) { PRINT("block {} {}: {} vs {}", x, y, b, a); return 1; }
+        }
+    }
+
+    /// Rate image coarsens only its tiles
+    auto rates = MakeRef<ShadingRateImage>(size, size);
+    rates->SetTile(0, 0, ShadingRate::Rate4x4);
+    Draw(ShadingRate::Rate1x1, rates, tiled);
+    if (tiled.pixels >= full.pixels || tiled.pixels < full.pixels - 256)
+    {
+        PRINT("rate image shaded {} of {} pixels", tiled.pixels, full.pixels);
+        return 1;
+    }
+
+    /// A triangle whose tip is far away, its last block row centered past the
+    /// tip where 1/w extrapolates below zero. The HDR target keeps the shaded
+    /// value, which must stay in the range the triangle interpolates
+    Mesh tip;
+    auto screenVertex = [size](f32 x, f32 y, f32 w, f32 u) {
+        Vertex vtx {};
+        vtx.pos = Vec4((x / size * 2.0f - 1.0f) * w, (1.0f - y / size * 2.0f) * w, 0.0f, w);
+        vtx.uv = Vec2(u, 0.0f);
+        return vtx;
+    };
+    tip.vertices = { screenVertex(8.2f, 8.2f, 2.0f, 0.0f), screenVertex(40.3f, 8.2f, 2.0f, 0.0f), screenVertex(24.1f, 13.1f, 200.0f, 1.0f) };
+    PipelineState state = test::TestState();
+    state.shadingRate = ShadingRate::Rate4x4;
+    Ref<Image> silhouette = test::Draw(ImageProp { .width = size, .height = size, .hdr = true }, tip, state, [](Pipeline& pipeline) {
+        pipeline.SetShader(Shader<UvVaryings> {
+            .vertex = [](const Vertex& vtx, UvVaryings& out) { out.uv = vtx.uv; return vtx.pos; },
+            .pixel = [](const UvVaryings& in) { return Vec4(in.uv.x, 0.0f, 0.0f, 1.0f); },
+        });
+    });
+    for (i32 i = 0; i < size * size; ++i)
+    {
+        const Color& color = silhouette->HdrData()[i];
+        if (color.w != 0.0f && !(color.x >= -1e-3f && color.x <= 1.0f + 1e-3f))
+        {
+            PRINT("pixel {} {} shaded off the triangle: {}", i % size, i / size, color.x);
+            return 1;
+        }
+    }
+
+    PRINT("shading rate ok: {} / {} / {} invocations", full.pixels, coarse.pixels, tiled.pixels);
+    return 0;
+}
\ No newline at end of file
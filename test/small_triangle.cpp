@@ -0,0 +1,92 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+using namespace scsr;
+
+static const i32 Size = 64;
+
+/// Vertex at screen position `x, y`, nearer for larger `z`
+static Vertex ScreenVertex(f32 x, f32 y, f32 z)
+{
+    return test::ClipVertex(x / Size * 2.0f - 1.0f, 1.0f - y / Size * 2.0f, 0.5f - z);
+}
+
+/// The quad [x0, x1] x [y0, y1] as `cells` x `cells` pairs of triangles,
+/// later ones nearer so pixels covered twice are counted twice
+static Mesh Grid(f32 x0, f32 y0, f32 x1, f32 y1, i32 cells)
+{
+    Mesh mesh;
+    f32 step = (x1 - x0) / cells;
+    f32 stepY = (y1 - y0) / cells;
+    f32 z = 0.0f;
+    for (i32 j = 0; j < cells; ++j)
+    {
+        for (i32 i = 0; i < cells; ++i)
+        {
+            f32 l = x0 + step * i;
+            f32 r = i + 1 == cells ? x1 : x0 + step * (i + 1);
+            f32 t = y0 + stepY * j;
+            f32 b = j + 1 == cells ? y1 : y0 + stepY * (j + 1);
+            for (Vec2 p : { Vec2(l, t), Vec2(r, t), Vec2(r, b), Vec2(l, t), Vec2(r, b), Vec2(l, b) })
+            {
+                mesh.vertices.push_back(ScreenVertex(p.x, p.y, z));
+            }
+            z += 1e-4f;
+        }
+    }
+    return mesh;
+}
+
+static Ref<Image> Draw(const Mesh& mesh, PipelineStats& stats)
+{
+    return test::Draw(ImageProp { .width = Size, .height = Size }, mesh, test::TestState(), [](Pipeline& pipeline) {
+        pipeline.SetShader(Shader<NoVaryings> {
+            .vertex = [](const Vertex& vtx) { return vtx.pos; },
+            .pixel = []() { return Vec4(1.0f, 1.0f, 1.0f, 1.0f); },
+        });
+    }, &stats);
+}
+
+int main()
+{
+    /// Tiny triangles cover the same pixels as the two triangles of their quad, each once
+    PipelineStats large, small;
+    Ref<Image> reference = Draw(Grid(8.3f, 9.7f, 55.6f, 52.2f, 1), large);
+    Ref<Image> tiled = Draw(Grid(8.3f, 9.7f, 55.6f, 52.2f, 16), small);
+    if (small.smallTriangles != 16 * 16 * 2 || small.trapezoids != 0 || large.smallTriangles != 0)
+    {
+        PRINT("{} small triangles and {} trapezoids", small.smallTriangles, small.trapezoids);
+        return 1;
+    }
+    if (small.pixelsCovered != large.pixelsCovered)
+    {
+        PRINT("covered {} pixels instead of {}", small.pixelsCovered, large.pixelsCovered);
+        return 1;
+    }
+    for (i32 i = 0; i < Size * Size; ++i)
+    {
+        if (reference->Data()[i] != tiled->Data()[i])
+        {
+            PRINT("pixel {} {} differs", i % Size, i / Size);
+            return 1;
+        }
+    }
+
+    /// Slivers between pixel centers are dropped before setup
+    PipelineStats sliver;
+    Mesh slivers;
+    for (Vec2 p : { Vec2(10.6f, 10.6f), Vec2(10.9f, 10.7f), Vec2(10.8f, 10.9f),
+             Vec2(20.1f, 30.2f), Vec2(23.4f, 30.3f), Vec2(21.0f, 30.45f) })
+    {
+        slivers.vertices.push_back(ScreenVertex(p.x, p.y, 0.0f));
+    }
+    Draw(slivers, sliver);
+    if (sliver.trianglesKept != 2 || sliver.smallTriangles != 0 || sliver.trapezoids != 0 || sliver.pixelsCovered != 0)
+    {
+        PRINT("slivers drew {} pixels", sliver.pixelsCovered);
+        return 1;
+    }
+
+    PRINT("small triangle ok: {} pixels from {} triangles", small.pixelsCovered, small.smallTriangles);
+    return 0;
+}
\ No newline at end of file
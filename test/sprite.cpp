@@ -0,0 +1,153 @@
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <chrono>
+
+using namespace scsr;
+
+static const i32 Width = 96;
+static const i32 Height = 80;
+
+static u32 Pixel(const Image& image, i32 x, i32 y)
+{
+    return image.Data()[y * image.Width() + x];
+}
+
+int main()
+{
+    /// An opaque checker, a translucent square and a horizontal ramp side by side
+    auto image = MakeRef<Image>(ImageProp { .width = 32, .height = 8, .format = PixelFormat::ARGB8888 });
+    for (i32 y = 0; y < 8; ++y)
+    {
+        for (i32 x = 0; x < 8; ++x)
+        {
+            image->SetPixel(x, y, (x + y) % 2 ? 0xFFFF0000u : 0xFF0000FFu);
+            image->SetPixel(x + 8, y, 0x8000FF00u);
+            image->SetPixel(x + 16, y, 0xFF000000u | static_cast<u32>(x * 32) << 16);
+        }
+    }
+    auto atlas = MakeRef<SpriteAtlas>(image);
+    u32 checker = atlas->AddRegion(Rect { 0, 0, 8, 8 });
+    u32 glass = atlas->AddRegion(Rect { 8, 0, 16, 8 });
+    u32 ramp = atlas->AddRegion(Rect { 16, 0, 24, 8 });
+    /// Clipped to the atlas
+    if (atlas->Region(atlas->AddRegion(Rect { 28, 4, 40, 20 })) != Rect { 28, 4, 32, 8 })
+    {
+        PRINT("region not clipped to the atlas");
+        return 1;
+    }
+
+    Image target(ImageProp { .width = Width, .height = Height });
+    SpriteBatch batch(atlas);
+
+    /// Unscaled sprites are copied pixel for pixel, converted to the target format
+    target.Clear();
+    batch.Add(Sprite { .region = checker, .position = Vec2(10.0f, 30.0f), .blend = BlendMode::Opaque });
+    batch.Flush(target);
+    for (i32 y = 0; y < 8; ++y)
+    {
+        for (i32 x = 0; x < 8; ++x)
+        {
+            u32 expected = (x + y) % 2 ? PackColor(Color(1.0f, 0.0f, 0.0f, 1.0f), target.Format()) : PackColor(Color(0.0f, 0.0f, 1.0f, 1.0f), target.Format());
+            if (Pixel(target, 10 + x, 30 + y) != expected)
+            {
+                PRINT("copied pixel {} {} is {:x}", x, y, Pixel(target, 10 + x, 30 + y));
+                return 1;
+            }
+        }
+    }
+    if (batch.Count() != 0 || Pixel(target, 9, 30) != 0 || Pixel(target, 18, 30) != 0 || Pixel(target, 10, 38) != 0)
+    {
+        PRINT("sprite drawn outside its rectangle or kept after flush");
+        return 1;
+    }
+
+    /// Nearest scaling by two repeats every texel in a 2x2 block, across a band boundary
+    target.Clear();
+    batch.Add(Sprite { .region = checker, .position = Vec2(4.0f, 24.0f), .size = Vec2(16.0f, 16.0f), .blend = BlendMode::Opaque });
+    batch.Flush(target);
+    for (i32 y = 0; y < 16; ++y)
+    {
+        for (i32 x = 0; x < 16; ++x)
+        {
+            if (Pixel(target, 4 + x, 24 + y) != Pixel(target, 4 + x / 2 * 2, 24 + y / 2 * 2) ||
+                Pixel(target, 4 + x, 24 + y) == Pixel(target, 4 + (x / 2 * 2 + 2) % 16, 24 + y / 2 * 2))
+            {
+                PRINT("scaled texel at {} {} not a 2x2 block", x, y);
+                return 1;
+            }
+        }
+    }
+
+    /// Higher layers cover lower ones whatever order they were added in
+    target.Clear();
+    batch.Add(Sprite { .region = glass, .position = Vec2(40.0f, 8.0f), .layer = 1 });
+    batch.Add(Sprite { .region = checker, .position = Vec2(40.0f, 8.0f), .blend = BlendMode::Opaque });
+    batch.Flush(target);
+    u32 under = PackColor(Color(0.0f, 0.0f, 1.0f, 1.0f), target.Format());
+    u32 over = PackColor(Color(0.0f, 1.0f, 0.0f, 128.0f / 255.0f), target.Format());
+    u32 blended = under;
+    BlendPixels(&over, &blended, 1, BlendMode::Alpha, target.Format());
+    if (Pixel(target, 40, 8) != blended)
+    {
+        PRINT("glass blended to {:x} instead of {:x}", Pixel(target, 40, 8), blended);
+        return 1;
+    }
+
+    /// Bilinear stretching of the ramp rises smoothly from its first to its last texel
+    target.Clear();
+    batch.Add(Sprite { .region = ramp, .position = Vec2(0.0f, 60.0f), .size = Vec2(64.0f, 4.0f), .filter = BlitFilter::Bilinear, .blend = BlendMode::Opaque });
+    batch.Flush(target);
+    const u32 redShift = GetPixelLayout(target.Format()).r;
+    u32 previous = 0;
+    for (i32 x = 0; x < 64; ++x)
+    {
+        u32 red = (Pixel(target, x, 61) >> redShift) & 0xFF;
+        if (red < previous || (x > 0 && x < 63 && red > 224))
+        {
+            PRINT("ramp at {} is {} after {}", x, red, previous);
+            return 1;
+        }
+        previous = red;
+    }
+    if (((Pixel(target, 0, 61) >> redShift) & 0xFF) != 0 || previous != 224)
+    {
+        PRINT("ramp ends are not the edge texels");
+        return 1;
+    }
+
+    /// Sprites partly off the target are clipped
+    target.Clear();
+    batch.Add(Sprite { .region = checker, .position = Vec2(-4.5f, Height - 3.0f), .size = Vec2(12.0f, 12.0f), .filter = BlitFilter::Bilinear });
+    batch.Add(Sprite { .region = checker, .position = Vec2(1e9f, -1e9f) });
+    batch.Flush(target);
+    usize covered = std::count_if(target.Data(), target.Data() + Width * Height, [](u32 pixel) { return pixel != 0; });
+    if (covered != 7 * 3)
+    {
+        PRINT("clipped sprite covers {} pixels", covered);
+        return 1;
+    }
+
+    /// A HUD worth of scaled sprites
+    Image frame(ImageProp { .width = 800, .height = 600 });
+    const i32 sprites = 4000;
+    const i32 frames = 10;
+    auto start = std::chrono::steady_clock::now();
+    for (i32 f = 0; f < frames; ++f)
+    {
+        for (i32 i = 0; i < sprites; ++i)
+        {
+            batch.Add(Sprite {
+                .region = static_cast<u32>(i % 3),
+                .position = Vec2(static_cast<f32>(i * 37 % 760), static_cast<f32>(i * 53 % 560)),
+                .size = Vec2(24.0f, 24.0f),
+                .layer = i % 4,
+                .filter = i % 2 ? BlitFilter::Bilinear : BlitFilter::Nearest,
+            });
+        }
+        batch.Flush(frame);
+    }
+    f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    PRINT("sprites ok: {} sprites in {:.2f} ms", sprites, ms);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+
+using namespace scsr;
+
+static const i32 Size = 64;
+
+/// A quad of side `s` around the origin, as a list or a strip
+static Mesh Quad(f32 s, Topology topology)
+{
+    Mesh mesh;
+    mesh.topology = topology;
+    std::vector<Vec2> corners = topology == Topology::TriangleStrip ?
+        std::vector<Vec2> { Vec2(-s, s), Vec2(-s, -s), Vec2(s, s), Vec2(s, -s) } :
+        std::vector<Vec2> { Vec2(-s, s), Vec2(-s, -s), Vec2(s, s), Vec2(s, s), Vec2(-s, -s), Vec2(s, -s) };
+    for (const Vec2& c : corners)
+    {
+        Vertex vtx {};
+        vtx.pos = Vec4(c.x, c.y, 0.0f, 1.0f);
+        vtx.normal = Vec3(0.0f, 0.0f, 1.0f);
+        mesh.vertices.push_back(vtx);
+    }
+    return mesh;
+}
+
+static Mat4 Translation(f32 x, f32 y)
+{
+    return FromScaleRotationTranslation(Vec3::ONE(), Quat(1.0f, 0.0f, 0.0f, 0.0f), Vec3(x, y, 0.0f));
+}
+
+static void Draw(Pipeline& pipeline, Ref<Image> image, const std::vector<const Mesh*>& meshes)
+{
+    image->Clear();
+    for (const Mesh* mesh : meshes)
+    {
+        pipeline.Perform(image, *mesh);
+    }
+}
+
+int main()
+{
+    StaticBatcher batcher;
+    std::vector<Mesh> world;
+    std::vector<StaticBatcher::Handle> handles;
+    for (i32 i = 0; i < 100; ++i)
+    {
+        f32 x = -0.9f + 0.18f * (i % 10);
+        f32 y = -0.9f + 0.18f * (i / 10);
+        Mesh quad = Quad(0.05f, i % 7 == 0 ? Topology::TriangleStrip : Topology::Triangles);
+        u32 key = i % 10 == 9 ? 1 : 0;
+        handles.push_back(batcher.Add(quad, Translation(x, y), key));
+
+        /// The same quad moved by hand, drawn one by one for reference
+        for (Vertex& vtx : quad.vertices)
+        {
+            vtx.pos = Vec4(vtx.pos.x + x, vtx.pos.y + y, 0.0f, 1.0f);
+        }
+        world.push_back(quad);
+    }
+    if (!batcher.Update() || batcher.Update())
+    {
+        PRINT("batches rebuilt without a change");
+        return 1;
+    }
+    const auto& batches = batcher.Batches();
+    if (batches.size() != 2 || batches[0].key != 0 || batches[1].key != 1 ||
+        batches[0].mesh.vertices.size() != 90 * 6 || batches[0].mesh.topology != Topology::Triangles)
+    {
+        PRINT("{} batches", batches.size());
+        return 1;
+    }
+    if (Abs(batches[0].min.x + 0.95f) > 1e-4f || Abs(batches[0].max.y - 0.77f) > 1e-4f || Abs(batches[1].min.x - 0.67f) > 1e-4f)
+    {
+        PRINT("bounds {} {} to {} {}", batches[0].min.x, batches[0].min.y, batches[0].max.x, batches[0].max.y);
+        return 1;
+    }
+
+    /// Batches draw the same pixels in far fewer calls
+    Pipeline pipeline;
+    test::SetupPipeline(pipeline);
+    pipeline.SetShader(Shader<NoVaryings> {
+        /// Meshes are moved with w = 1, the clip position is taken after
+        .vertex = [](const Vertex& vtx) { return test::ClipPosition(Vec3(vtx.pos.x, vtx.pos.y, 0.0f)); },
+        .pixel = []() { return Vec4(1.0f, 1.0f, 1.0f, 1.0f); },
+    });
+    auto separate = MakeRef<Image>(ImageProp { .width = Size, .height = Size });
+    auto batched = MakeRef<Image>(ImageProp { .width = Size, .height = Size });
+    std::vector<const Mesh*> meshes;
+    for (const Mesh& mesh : world) { meshes.push_back(&mesh); }
+    Draw(pipeline, separate, meshes);
+    usize separateCalls = pipeline.GetStats().drawCalls;
+    pipeline.ResetStats();
+    meshes.clear();
+    for (const StaticBatch& batch : batches) { meshes.push_back(&batch.mesh); }
+    Draw(pipeline, batched, meshes);
+    if (pipeline.GetStats().drawCalls != 2 || separateCalls != 100 ||
+        !std::equal(separate->Data(), separate->Data() + Size * Size, batched->Data()))
+    {
+        PRINT("batched draw differs");
+        return 1;
+    }
+
+    /// Removing a mesh rebuilds, a mesh too large to share a batch gets its own.
+    /// It takes the freed handle, so it comes first
+    batcher.Remove(handles[0]);
+    Mesh large;
+    large.vertices.resize(StaticBatcher::MaxBatchVertices);
+    batcher.Add(std::move(large), Mat4::IDENTITY());
+    batcher.Add(Quad(0.1f, Topology::Triangles), Mat4::IDENTITY());
+    if (!batcher.Update() || batches.size() != 3 || batches[0].mesh.vertices.size() != StaticBatcher::MaxBatchVertices ||
+        batches[1].mesh.vertices.size() != 90 * 6 || batches[2].key != 1)
+    {
+        PRINT("{} batches after the change", batches.size());
+        return 1;
+    }
+
+    PRINT("static batch ok: {} meshes in {} batches", batcher.MeshCount(), batches.size());
+    return 0;
+}
\ No newline at end of file
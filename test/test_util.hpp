@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core/core.hpp" // IWYU pragma: keep
+
+#include <functional>
+
+/// What the pipeline tests share: shapes given straight in clip space, the
+/// camera and state they are drawn with, and a draw into a cleared target
+namespace scsr::test
+{
+
+/// Test vertices are placed in clip space with this w. The homogeneous
+/// culling drops any vertex with w <= 1 or on the edge of the view volume,
+/// so w = 1 draws nothing and shapes meant to cover the whole target
+/// stay `FullScreen` inside its edges.
+inline constexpr f32 ClipW = 2.0f;
+inline constexpr f32 FullScreen = 0.9995f;
+
+/// Clip position of the NDC point `ndc`
+inline Vec4 ClipPosition(const Vec3& ndc)
+{
+    return Vec4(ndc.x * ClipW, ndc.y * ClipW, ndc.z * ClipW, ClipW);
+}
+
+/// Vertex at NDC `x, y, z`, with the uv running from 0 to 1 across the target
+inline Vertex ClipVertex(f32 x, f32 y, f32 z = 0.0f)
+{
+    Vertex vtx {};
+    vtx.pos = ClipPosition(Vec3(x, y, z));
+    vtx.uv = Vec2(x * 0.5f + 0.5f, y * 0.5f + 0.5f);
+    return vtx;
+}
+
+/// Append the quad from `lo` to `hi` in NDC at depth `z` as two triangles
+/// split along the `lo` to `hi` diagonal, `normal` is free for a color
+inline void PushQuad(Mesh& mesh, Vec2 lo, Vec2 hi, f32 z = 0.0f, Vec3 normal = Vec3::Z())
+{
+    const Vec2 corners[6] = { Vec2(lo.x, lo.y), Vec2(hi.x, lo.y), Vec2(hi.x, hi.y), Vec2(lo.x, lo.y), Vec2(hi.x, hi.y), Vec2(lo.x, hi.y) };
+    for (const Vec2& c : corners)
+    {
+        Vertex vtx = ClipVertex(c.x, c.y, z);
+        vtx.normal = normal;
+        mesh.vertices.push_back(vtx);
+    }
+}
+
+/// A quad covering every pixel of the target
+inline Mesh FullScreenQuad(f32 z = 0.0f)
+{
+    Mesh mesh;
+    PushQuad(mesh, Vec2(-FullScreen, -FullScreen), Vec2(FullScreen, FullScreen), z);
+    return mesh;
+}
+
+/// Default state except for face culling, which is off so winding does not matter
+inline PipelineState TestState()
+{
+    PipelineState state;
+    state.cullMode = FaceCullMode::None;
+    return state;
+}
+
+/// The camera only takes part in face culling, positions skip its transforms
+inline void SetupPipeline(Pipeline& pipeline, const PipelineState& state = TestState())
+{
+    auto camera = MakeRef<Camera>(Radians(60.0f), 1.0f, 0.1f, 100.0f);
+    pipeline.SetCamera(camera);
+    pipeline.SetState(state);
+}
+
+/// Draw `mesh` with a new pipeline into a new cleared target. `configure`
+/// sets the shader and anything else the test varies, `stats` receives the
+/// counters of the draw when given
+inline Ref<Image> Draw(const ImageProp& prop, const Mesh& mesh, const PipelineState& state,
+    const std::function<void(Pipeline&)>& configure, PipelineStats* stats = nullptr)
+{
+    auto image = MakeRef<Image>(prop);
+    Pipeline pipeline;
+    SetupPipeline(pipeline, state);
+    configure(pipeline);
+    image->Clear();
+    pipeline.Perform(image, mesh);
+    if (stats) { *stats = pipeline.GetStats(); }
+    return image;
+}
+
+}
\ No newline at end of file
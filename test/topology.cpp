@@ -0,0 +1,173 @@
+#include "core/core.hpp" // IWYU pragma: keep
+#include "test_util.hpp"
+#include "graphics/gltf.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+
+using namespace scsr;
+
+static const i32 Size = 32;
+
+struct UvVaryings
+{
+    Vec2 uv;
+};
+
+static Mesh MakeMesh(Topology topology, std::initializer_list<Vec2> points)
+{
+    Mesh mesh;
+    mesh.topology = topology;
+    for (const Vec2& p : points)
+    {
+        mesh.vertices.push_back(test::ClipVertex(p.x, p.y));
+    }
+    return mesh;
+}
+
+static Ref<Image> Draw(const Mesh& mesh, PipelineStats& stats, usize& invocations, bool hdr = false)
+{
+    std::atomic<usize> vertices = 0;
+    Ref<Image> image = test::Draw(ImageProp { .width = Size, .height = Size, .hdr = hdr }, mesh, test::TestState(), [&vertices](Pipeline& pipeline) {
+        pipeline.SetShader(Shader<UvVaryings> {
+            .vertex = [&vertices](const Vertex& vtx, UvVaryings& out) { ++vertices; out.uv = vtx.uv; return vtx.pos; },
+            .pixel = [](const UvVaryings& in) { return Vec4(1.0f, in.uv.x, in.uv.y, 1.0f); },
+        });
+    }, &stats);
+    invocations = vertices;
+    return image;
+}
+
+static usize CountSet(const Image& image)
+{
+    usize count = 0;
+    for (i32 i = 0; i < Size * Size; ++i)
+    {
+        count += (image.HdrData() ? image.HdrData()[i].w != 0.0f : image.Data()[i] != 0) ? 1 : 0;
+    }
+    return count;
+}
+
+/// A GLB with one position accessor used by a strip, a line loop and two point lists
+static void WriteGlb(const std::string& path)
+{
+    const std::string primitive = R"({"attributes":{"POSITION":0},"mode":)";
+    std::string json = R"({"scenes":[{"nodes":[0]}],"nodes":[{"mesh":0}],"meshes":[{"primitives":[)" +
+        primitive + "5}," + primitive + "2}," + primitive + "0}," + primitive + "0}]}]," +
+        R"("buffers":[{"byteLength":48}],"bufferViews":[{"buffer":0,"byteLength":48}],)" +
+        R"("accessors":[{"bufferView":0,"componentType":5126,"count":4,"type":"VEC3"}]})";
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+    const f32 positions[12] = { -1, 1, 0, -1, -1, 0, 1, 1, 0, 1, -1, 0 };
+
+    std::ofstream out(path, std::ios::binary);
+    auto write = [&out](u32 value) { out.write(reinterpret_cast<const char*>(&value), sizeof(u32)); };
+    write(GLTF::Magic);
+    write(2);
+    write(static_cast<u32>(12 + 8 + json.size() + 8 + sizeof(positions)));
+    write(static_cast<u32>(json.size()));
+    write(0x4E4F534A);
+    out.write(json.data(), json.size());
+    write(sizeof(positions));
+    write(GLTF::Bin);
+    out.write(reinterpret_cast<const char*>(positions), sizeof(positions));
+}
+
+int main()
+{
+    /// The same quad as a list, a strip and a fan, shared vertices are shaded once
+    const f32 e = 0.8f;
+    PipelineStats listStats, stripStats, fanStats;
+    usize listVertices, stripVertices, fanVertices;
+    Ref<Image> list = Draw(MakeMesh(Topology::Triangles,
+        { Vec2(-e, e), Vec2(-e, -e), Vec2(e, e), Vec2(e, e), Vec2(-e, -e), Vec2(e, -e) }), listStats, listVertices);
+    Ref<Image> strip = Draw(MakeMesh(Topology::TriangleStrip,
+        { Vec2(-e, e), Vec2(-e, -e), Vec2(e, e), Vec2(e, -e) }), stripStats, stripVertices);
+    Ref<Image> fan = Draw(MakeMesh(Topology::TriangleFan,
+        { Vec2(-e, e), Vec2(-e, -e), Vec2(e, -e), Vec2(e, e) }), fanStats, fanVertices);
+    if (listVertices != 6 || stripVertices != 4 || fanVertices != 4)
+    {
+        PRINT("shaded {} / {} / {} vertices", listVertices, stripVertices, fanVertices);
+        return 1;
+    }
+    if (stripStats.triangles != 2 || fanStats.trianglesKept != 2 ||
+        stripStats.pixelsCovered != listStats.pixelsCovered || fanStats.pixelsCovered != listStats.pixelsCovered)
+    {
+        PRINT("covered {} / {} / {} pixels", listStats.pixelsCovered, stripStats.pixelsCovered, fanStats.pixelsCovered);
+        return 1;
+    }
+    /// Either diagonal splits the quad into the same pixels
+    if (CountSet(*strip) != CountSet(*list) || CountSet(*fan) != CountSet(*list))
+    {
+        PRINT("strip or fan drew other pixels");
+        return 1;
+    }
+
+    /// A line loop outlines the quad and leaves its inside alone
+    PipelineStats stats;
+    usize invocations;
+    Ref<Image> loop = Draw(MakeMesh(Topology::LineLoop,
+        { Vec2(-e, e), Vec2(-e, -e), Vec2(e, -e), Vec2(e, e) }), stats, invocations);
+    usize outline = CountSet(*loop);
+    if (outline < 4 * 24 || loop->Data()[Size / 2 * Size + Size / 2] != 0 || invocations != 4)
+    {
+        PRINT("line loop drew {} pixels", outline);
+        return 1;
+    }
+    Ref<Image> strip2 = Draw(MakeMesh(Topology::LineStrip,
+        { Vec2(-e, e), Vec2(-e, -e), Vec2(e, -e), Vec2(e, e) }), stats, invocations);
+    if (CountSet(*strip2) >= outline)
+    {
+        PRINT("line strip closed");
+        return 1;
+    }
+
+    /// Points take one pixel each, colored by their own varyings
+    Ref<Image> points = Draw(MakeMesh(Topology::Points, { Vec2(-0.5f, 0.5f), Vec2(0.25f, 0.0f), Vec2(0.5f, -0.5f), Vec2(3.0f, 0.0f) }),
+        stats, invocations);
+    if (CountSet(*points) != 3 || points->Data()[8 * Size + 8] == points->Data()[24 * Size + 24])
+    {
+        PRINT("points drew {} pixels", CountSet(*points));
+        return 1;
+    }
+
+    /// HDR targets get the same lines and points as float colors
+    for (Topology topology : { Topology::LineLoop, Topology::Points })
+    {
+        Mesh mesh = MakeMesh(topology, { Vec2(-e, e), Vec2(-e, -e), Vec2(e, -e), Vec2(e, e) });
+        Ref<Image> packed = Draw(mesh, stats, invocations);
+        Ref<Image> hdr = Draw(mesh, stats, invocations, true);
+        for (i32 i = 0; i < Size * Size; ++i)
+        {
+            const Color& c = hdr->HdrData()[i];
+            if ((packed->Data()[i] != 0) != (c.w != 0.0f) || hdr->Data()[i] != 0 || (c.w != 0.0f && c.x != 1.0f))
+            {
+                PRINT("HDR {} differs at pixel {}", topology == Topology::Points ? "points" : "line loop", i);
+                return 1;
+            }
+        }
+    }
+
+    /// Loader keeps the modes, merging only list primitives
+    const std::string path = "topology_test.glb";
+    WriteGlb(path);
+    GLTF gltf(path);
+    gltf.Load();
+    std::vector<Mesh> meshes = gltf.ToMeshes();
+    if (meshes.size() != 3 || meshes[0].topology != Topology::TriangleStrip || meshes[1].topology != Topology::LineLoop ||
+        meshes[2].topology != Topology::Points || meshes[2].vertices.size() != 8)
+    {
+        PRINT("loaded {} meshes", meshes.size());
+        return 1;
+    }
+    Mesh triangles = gltf.ToMesh();
+    if (triangles.topology != Topology::Triangles || triangles.vertices.size() != 6)
+    {
+        PRINT("strip expanded to {} vertices", triangles.vertices.size());
+        return 1;
+    }
+    std::remove(path.c_str());
+
+    PRINT("topology ok: {} outline pixels", outline);
+    return 0;
+}
\ No newline at end of file